@@ -0,0 +1,250 @@
+/*
+
+  ESP-IDF Benchmark
+
+  This example measures the performance of the DMX driver so that releases of
+  this library can be compared with each other. Two DMX ports are connected to
+  each other in a loopback: the transmit pin of each port is wired to the
+  receive pin of the other port. RS-485 transceivers are not required. The
+  controller port sends DMX and RDM while the responder port receives DMX and
+  responds to RDM requests.
+
+  The following are measured:
+    - The CPU cycles spent in the DMX interrupt handlers per DMX packet. This
+      includes sending the packet on the controller port and receiving it on
+      the responder port.
+    - The latency from the end of a received DMX packet until dmx_receive()
+      returns.
+    - The maximum refresh rate of dmx_send_num() for several packet sizes.
+    - The round-trip time of an RDM request sent with rdm_send_request().
+    - The time taken to discover the RDM responders on the loopback.
+
+  Each result is printed on its own line as a JSON object so that the output
+  can be parsed by a script. Log messages are disabled while benchmarking.
+
+  Note: this example is for use with the ESP-IDF. It will not work on Arduino!
+  It requires a target with at least three UARTs, such as the ESP32.
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+
+#include "esp_dmx.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "rdm/controller.h"
+#include "rdm/responder.h"
+
+#define CONTROLLER_TX_PIN 17  // The transmit pin of the controller port.
+#define CONTROLLER_RX_PIN 16  // The receive pin of the controller port.
+#define RESPONDER_TX_PIN 4    // The transmit pin of the responder port.
+#define RESPONDER_RX_PIN 5    // The receive pin of the responder port.
+
+#define BENCHMARK_MS 2000       // The duration of each timed benchmark.
+#define PACKET_PERIOD_US 25000  // The period of continuously sent packets.
+#define RDM_REQUEST_COUNT 100   // The number of RDM round trips to measure.
+#define DISCOVERY_COUNT 10      // The number of discoveries to measure.
+#define RECEIVE_LATENCY_COUNT 200  // The number of packets to measure.
+
+static const dmx_port_t controller_num = DMX_NUM_1;
+static const dmx_port_t responder_num = DMX_NUM_2;
+
+static volatile uint32_t spin_count;
+static volatile bool responder_is_running;
+
+static void spin_task(void *arg) {
+  /* Count as fast as possible at the idle priority. The rate at which this task
+    counts is reduced by the time spent in interrupt handlers on this core. */
+  while (true) {
+    ++spin_count;
+  }
+}
+
+static void responder_task(void *arg) {
+  // Respond to RDM requests until the benchmarks are done with the responder
+  dmx_packet_t packet;
+  while (true) {
+    if (!responder_is_running) {
+      vTaskDelay(1);
+      continue;
+    }
+    if (dmx_receive(responder_num, &packet, dmx_ms_to_ticks(10)) &&
+        packet.is_rdm) {
+      rdm_send_response(responder_num);
+    }
+  }
+}
+
+static uint32_t count_spins(int ms) {
+  const uint32_t start = spin_count;
+  vTaskDelay(pdMS_TO_TICKS(ms));
+  return spin_count - start;
+}
+
+static void benchmark_isr_cycles(int size) {
+  // Measure the spin rate without any DMX traffic
+  const uint32_t baseline = count_spins(BENCHMARK_MS);
+
+  // Measure the spin rate while DMX is sent continuously in the background
+  dmx_stats_t before, after;
+  dmx_get_stats(responder_num, &before);
+  dmx_continuous_start(controller_num, size, PACKET_PERIOD_US);
+  const uint32_t loaded = count_spins(BENCHMARK_MS);
+  dmx_continuous_stop(controller_num);
+  dmx_get_stats(responder_num, &after);
+
+  // Convert the lost spins into CPU cycles per DMX packet
+  const uint32_t packets = after.rx_packets - before.rx_packets;
+  const double busy_fraction =
+      loaded < baseline ? (double)(baseline - loaded) / baseline : 0.0;
+  const double busy_cycles = busy_fraction * esp_rom_get_cpu_ticks_per_us() *
+                             1000.0 * BENCHMARK_MS;
+  printf(
+      "{\"benchmark\": \"isr_cycles_per_packet\", \"size\": %i, \"value\": "
+      "%.0f, \"packets\": %lu, \"unit\": \"cycles\"}\n",
+      size, packets > 0 ? busy_cycles / packets : 0.0, (unsigned long)packets);
+}
+
+static void benchmark_receive_latency(int size) {
+  // Send DMX in the background and measure how late dmx_receive() returns
+  dmx_continuous_start(controller_num, size, PACKET_PERIOD_US);
+  int64_t sum = 0;
+  int64_t max = 0;
+  int count = 0;
+  dmx_packet_t packet;
+  for (int i = 0; i < RECEIVE_LATENCY_COUNT; ++i) {
+    if (!dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK) ||
+        packet.err != DMX_OK || packet.eop_timestamp == 0) {
+      continue;
+    }
+    const int64_t latency = esp_timer_get_time() - packet.eop_timestamp;
+    sum += latency;
+    if (latency > max) {
+      max = latency;
+    }
+    ++count;
+  }
+  dmx_continuous_stop(controller_num);
+
+  printf(
+      "{\"benchmark\": \"receive_latency\", \"size\": %i, \"avg\": %.1f, "
+      "\"max\": %lli, \"packets\": %i, \"unit\": \"us\"}\n",
+      size, count > 0 ? (double)sum / count : 0.0, max, count);
+}
+
+static void benchmark_refresh_rate(int size) {
+  // Send DMX packets back-to-back for a fixed time
+  int packets = 0;
+  const int64_t start = esp_timer_get_time();
+  const int64_t stop = start + BENCHMARK_MS * 1000;
+  while (esp_timer_get_time() < stop) {
+    if (dmx_send_num(controller_num, size)) {
+      ++packets;
+    }
+    dmx_wait_sent(controller_num, DMX_TIMEOUT_TICK);
+  }
+  const int64_t elapsed = esp_timer_get_time() - start;
+
+  printf(
+      "{\"benchmark\": \"refresh_rate\", \"size\": %i, \"value\": %.2f, "
+      "\"unit\": \"Hz\"}\n",
+      size, packets * 1000000.0 / elapsed);
+}
+
+static void benchmark_rdm_round_trip(const rdm_uid_t *uid) {
+  // Send RDM GET IDENTIFY_DEVICE requests and time each response
+  int64_t sum = 0;
+  int64_t min = INT64_MAX;
+  int64_t max = 0;
+  int count = 0;
+  for (int i = 0; i < RDM_REQUEST_COUNT; ++i) {
+    bool identify;
+    rdm_ack_t ack;
+    const int64_t start = esp_timer_get_time();
+    if (!rdm_send_get_identify_device(controller_num, uid, RDM_SUB_DEVICE_ROOT,
+                                      &identify, &ack)) {
+      continue;
+    }
+    const int64_t round_trip = esp_timer_get_time() - start;
+    sum += round_trip;
+    if (round_trip < min) {
+      min = round_trip;
+    }
+    if (round_trip > max) {
+      max = round_trip;
+    }
+    ++count;
+  }
+
+  printf(
+      "{\"benchmark\": \"rdm_round_trip\", \"min\": %lli, \"avg\": %.1f, "
+      "\"max\": %lli, \"responses\": %i, \"requests\": %i, \"unit\": "
+      "\"us\"}\n",
+      count > 0 ? min : 0, count > 0 ? (double)sum / count : 0.0, max, count,
+      RDM_REQUEST_COUNT);
+}
+
+static int benchmark_discovery(rdm_uid_t *uid) {
+  // Run a full discovery several times and time each one
+  int64_t sum = 0;
+  int devices_found = 0;
+  for (int i = 0; i < DISCOVERY_COUNT; ++i) {
+    const int64_t start = esp_timer_get_time();
+    devices_found = rdm_discover_devices_simple(controller_num, uid, 1);
+    sum += esp_timer_get_time() - start;
+  }
+
+  printf(
+      "{\"benchmark\": \"discovery\", \"responders\": %i, \"avg\": %.1f, "
+      "\"unit\": \"us\"}\n",
+      devices_found, (double)sum / DISCOVERY_COUNT);
+  return devices_found;
+}
+
+void app_main() {
+  // Install both DMX ports in a loopback
+  dmx_config_t config = DMX_CONFIG_DEFAULT;
+  dmx_driver_install(controller_num, &config, NULL, 0);
+  dmx_set_pin(controller_num, CONTROLLER_TX_PIN, CONTROLLER_RX_PIN,
+              DMX_PIN_NO_CHANGE);
+  dmx_personality_t personalities[] = {{1, "Default Personality"}};
+  dmx_driver_install(responder_num, &config, personalities, 1);
+  dmx_set_pin(responder_num, RESPONDER_TX_PIN, RESPONDER_RX_PIN,
+              DMX_PIN_NO_CHANGE);
+
+  // Logging would skew the results
+  esp_log_level_set("*", ESP_LOG_NONE);
+
+  // Count idle CPU time on the core which handles the DMX interrupts
+  xTaskCreatePinnedToCore(spin_task, "spin", 2048, NULL, tskIDLE_PRIORITY,
+                          NULL, xPortGetCoreID());
+  xTaskCreate(responder_task, "responder", 4096, NULL, 5, NULL);
+
+  printf("{\"benchmark\": \"version\", \"value\": \"%s\"}\n",
+         ESP_DMX_VERSION_LABEL);
+
+  const int sizes[] = {25, 129, 257, DMX_PACKET_SIZE_MAX};
+  const int size_count = sizeof(sizes) / sizeof(sizes[0]);
+  for (int i = 0; i < size_count; ++i) {
+    benchmark_isr_cycles(sizes[i]);
+  }
+  for (int i = 0; i < size_count; ++i) {
+    benchmark_receive_latency(sizes[i]);
+  }
+  for (int i = 0; i < size_count; ++i) {
+    benchmark_refresh_rate(sizes[i]);
+  }
+
+  // The responder task must be running to respond to RDM
+  responder_is_running = true;
+  rdm_uid_t uid;
+  if (benchmark_discovery(&uid) > 0) {
+    benchmark_rdm_round_trip(&uid);
+  }
+  responder_is_running = false;
+
+  printf("{\"benchmark\": \"done\"}\n");
+}
@@ -0,0 +1,240 @@
+/*
+
+  ESP-IDF Host Simulation
+
+  This example tests the DMX driver on a computer with the host HAL. Two DMX
+  ports are attached to the same simulated RS-485 bus. The first port is an
+  RDM controller and the second port is an RDM responder. A virtual device
+  which is not a DMX port also sends packets on the bus.
+
+  The following are tested:
+    - A DMX packet which is sent by the controller is received by the
+      responder.
+    - The responder reads the RDM header of each request with
+      rdm_read_header() and answers a GET and a SET request from the
+      controller, whose parameter data is encoded and decoded by the RDM
+      format functions.
+    - DISC_MUTE parameter data which does not include the optional binding
+      UID is decoded with a null binding UID.
+    - A malformed RDM packet from the virtual device does not stop the
+      responder from answering a valid RDM request from the virtual device
+      afterwards. The response is captured from the bus and checked.
+
+  The same UART, timer, and sniffer interrupt handlers as on the ESP32 move the
+  slots on the simulated bus. The example prints one line per test and exits
+  with a non-zero status if a test fails.
+
+  Note: this example is for use with the ESP-IDF linux target. Build it with
+  `idf.py --preview set-target linux build` and run it with `idf.py monitor`.
+
+  https://github.com/someweisguy/esp_dmx
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx/hal/host/include/sim.h"
+#include "esp_dmx.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "rdm/controller.h"
+#include "rdm/include/driver.h"
+#include "rdm/include/uid.h"
+#include "rdm/responder.h"
+
+#define SIM_STEP_US 1000  // The virtual time which passes each FreeRTOS tick.
+#define TEST_TIMEOUT_TICKS pdMS_TO_TICKS(1000)  // The timeout of each test.
+
+static const dmx_port_t controller_num = DMX_NUM_1;
+static const dmx_port_t responder_num = DMX_NUM_2;
+static const int bus = 0;
+
+static SemaphoreHandle_t dmx_received;  // Given when a DMX packet is received.
+static uint8_t dmx_data[DMX_PACKET_SIZE];  // The last received DMX packet.
+static size_t dmx_size;  // The size of the last received DMX packet.
+static rdm_header_t rdm_header;  // The header of the last RDM request.
+static int rdm_count;  // The number of RDM requests which were received.
+
+static uint8_t bus_packet[DMX_PACKET_SIZE];  // The last packet on the bus.
+static size_t bus_size;  // The number of slots in the last packet on the bus.
+
+static int failures;
+
+static void check(bool passed, const char *name) {
+  printf("%s: %s\n", passed ? "PASS" : "FAIL", name);
+  if (!passed) {
+    ++failures;
+  }
+}
+
+static void sim_task(void *arg) {
+  while (true) {
+    dmx_sim_advance(SIM_STEP_US);
+    vTaskDelay(1);
+  }
+}
+
+// Captures the slots of the last packet on the bus. Each DMX break begins a
+// new packet.
+static void bus_monitor(int bus, dmx_sim_event_t event, uint8_t value,
+                        int64_t timestamp, void *context) {
+  if (event == DMX_SIM_EVENT_BREAK) {
+    bus_size = 0;
+  } else if (event == DMX_SIM_EVENT_SLOT && bus_size < sizeof(bus_packet)) {
+    bus_packet[bus_size++] = value;
+  }
+}
+
+static void responder_task(void *arg) {
+  dmx_packet_t packet;
+  while (true) {
+    if (!dmx_receive(responder_num, &packet, DMX_TIMEOUT_TICK)) {
+      continue;
+    }
+    if (packet.is_rdm) {
+      rdm_header_t header;
+      if (rdm_read_header(responder_num, &header)) {
+        rdm_header = header;
+        ++rdm_count;
+      }
+      rdm_send_response(responder_num);
+    } else if (packet.sc == DMX_SC && packet.err == DMX_OK) {
+      dmx_size = dmx_read(responder_num, dmx_data, packet.size);
+      xSemaphoreGive(dmx_received);
+    }
+  }
+}
+
+// Writes a UID into a packet in network byte order.
+static void write_uid(uint8_t *data, const rdm_uid_t *uid) {
+  data[0] = uid->man_id >> 8;
+  data[1] = uid->man_id;
+  data[2] = uid->dev_id >> 24;
+  data[3] = uid->dev_id >> 16;
+  data[4] = uid->dev_id >> 8;
+  data[5] = uid->dev_id;
+}
+
+// Checks that the RDM checksum at the end of a packet is valid.
+static bool checksum_is_valid(const uint8_t *data, size_t size) {
+  if (size < 3) {
+    return false;
+  }
+  uint16_t checksum = 0;
+  for (size_t i = 0; i < size - 2; ++i) {
+    checksum += data[i];
+  }
+  return checksum == ((data[size - 2] << 8) | data[size - 1]);
+}
+
+static void test_dmx() {
+  uint8_t data[DMX_PACKET_SIZE] = {DMX_SC};
+  for (int i = 1; i < DMX_PACKET_SIZE; ++i) {
+    data[i] = i;
+  }
+  dmx_write(controller_num, data, sizeof(data));
+  dmx_send(controller_num);
+  const bool received = xSemaphoreTake(dmx_received, TEST_TIMEOUT_TICKS);
+  check(received && dmx_size == sizeof(data) &&
+            memcmp(dmx_data, data, sizeof(data)) == 0,
+        "DMX packet is received");
+}
+
+static void test_rdm_controller() {
+  const rdm_uid_t *uid = rdm_uid_get(responder_num);
+  const int count = rdm_count;
+  rdm_ack_t ack;
+
+  uint16_t address = 0;
+  rdm_send_get_dmx_start_address(controller_num, uid, RDM_SUB_DEVICE_ROOT,
+                                 &address, &ack);
+  check(ack.type == RDM_RESPONSE_TYPE_ACK && address == 1,
+        "RDM GET DMX_START_ADDRESS is acknowledged");
+  check(rdm_count == count + 1 &&
+            rdm_uid_is_eq(&rdm_header.dest_uid, uid) &&
+            rdm_header.cc == RDM_CC_GET_COMMAND &&
+            rdm_header.pid == RDM_PID_DMX_START_ADDRESS,
+        "RDM header of the request is read by the responder");
+
+  rdm_send_set_dmx_start_address(controller_num, uid, RDM_SUB_DEVICE_ROOT, 42,
+                                 &ack);
+  address = 0;
+  rdm_get_dmx_start_address(responder_num, &address);
+  check(ack.type == RDM_RESPONSE_TYPE_ACK && address == 42,
+        "RDM SET DMX_START_ADDRESS is applied");
+}
+
+static void test_rdm_disc_mute() {
+  // Devices with one port do not include a binding UID in the response
+  const uint8_t pd[] = {0x00, 0x02};
+  rdm_disc_mute_t mute;
+  memset(&mute, 0xaa, sizeof(mute));
+  const size_t pdl = rdm_decode_pd("wv", &mute, sizeof(mute), pd, sizeof(pd));
+  check(pdl == sizeof(pd) && mute.control_field == 0x0002 &&
+            rdm_uid_is_null(&mute.binding_uid),
+        "RDM DISC_MUTE without a binding UID is decoded as a null UID");
+}
+
+static void test_rdm_injected() {
+  const rdm_uid_t *const uid = rdm_uid_get(responder_num);
+  const rdm_uid_t controller_uid = {0x05e0, 0x12345678};
+
+  // A truncated RDM packet must be ignored
+  const uint8_t malformed[] = {RDM_SC, RDM_SUB_SC, 3};
+  dmx_sim_inject(bus, malformed, sizeof(malformed), 176, 12);
+
+  // Build a GET DMX_START_ADDRESS request from the virtual device
+  uint8_t request[26] = {RDM_SC, RDM_SUB_SC, 24};
+  write_uid(&request[3], uid);
+  write_uid(&request[9], &controller_uid);
+  request[15] = 7;  // Transaction number
+  request[16] = 1;  // Port ID
+  request[20] = RDM_CC_GET_COMMAND;
+  request[21] = RDM_PID_DMX_START_ADDRESS >> 8;
+  request[22] = RDM_PID_DMX_START_ADDRESS & 0xff;
+  uint16_t checksum = 0;
+  for (int i = 0; i < 24; ++i) {
+    checksum += request[i];
+  }
+  request[24] = checksum >> 8;
+  request[25] = checksum & 0xff;
+
+  dmx_sim_set_monitor(bus, bus_monitor, NULL);
+  dmx_sim_inject(bus, request, sizeof(request), 176, 12);
+  vTaskDelay(pdMS_TO_TICKS(100));
+  dmx_sim_set_monitor(bus, NULL, NULL);
+
+  // The response is the last packet on the bus
+  uint8_t controller_uid_data[6];
+  write_uid(controller_uid_data, &controller_uid);
+  const bool is_response =
+      bus_size == 28 && bus_packet[0] == RDM_SC &&
+      checksum_is_valid(bus_packet, bus_size) &&
+      memcmp(&bus_packet[3], controller_uid_data, 6) == 0 &&
+      bus_packet[15] == 7 && bus_packet[16] == RDM_RESPONSE_TYPE_ACK &&
+      bus_packet[20] == RDM_CC_GET_COMMAND_RESPONSE &&
+      bus_packet[23] == 2 && ((bus_packet[24] << 8) | bus_packet[25]) == 42;
+  check(is_response, "RDM response to an injected request is sent");
+}
+
+void app_main() {
+  dmx_config_t config = DMX_CONFIG_DEFAULT;
+  dmx_personality_t personalities[] = {{1, "Default Personality"}};
+  dmx_driver_install(controller_num, &config, personalities, 1);
+  dmx_driver_install(responder_num, &config, personalities, 1);
+  dmx_received = xSemaphoreCreateBinary();
+
+  xTaskCreate(sim_task, "sim_task", 4096, NULL, configMAX_PRIORITIES - 1,
+              NULL);
+  xTaskCreate(responder_task, "responder_task", 4096, NULL, 2, NULL);
+
+  test_dmx();
+  test_rdm_controller();
+  test_rdm_disc_mute();
+  test_rdm_injected();
+
+  printf("%d test(s) failed\n", failures);
+  exit(failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
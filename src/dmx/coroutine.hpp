@@ -0,0 +1,340 @@
+/**
+ * @file dmx/coroutine.hpp
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This header contains an optional C++ layer which exposes DMX packet
+ * reception and send completion as C++20 awaitables. The awaitables are
+ * resumed by a dmx_loop from the callbacks of the DMX driver, so that many DMX
+ * ports can be served by coroutines which all run on one FreeRTOS task. RDM
+ * controller requests can be awaited with the awaitables in the header
+ * rdm/coroutine.hpp. This header requires C++20.
+ */
+#pragma once
+
+#if !defined(__cplusplus) || __cplusplus < 202002L
+#error "dmx/coroutine.hpp requires C++20 or later"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <coroutine>
+#include <exception>
+
+#include "dmx/include/driver.h"
+#include "dmx/include/types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+namespace esp_dmx {
+
+class dmx_loop;
+class rdm_request_awaitable;
+
+/**
+ * @brief A coroutine type which may be used for coroutines which await the
+ * DMX driver. The coroutine starts as soon as it is called and its frame is
+ * freed when it returns. The coroutine must not throw.
+ */
+struct dmx_coroutine {
+  struct promise_type {
+    dmx_coroutine get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+/**
+ * @brief An awaitable which resumes when a DMX packet is received or when the
+ * timeout elapses. It is created with dmx_loop::receive(). The result of the
+ * co_await expression is the received packet, which is the same as the packet
+ * that dmx_receive() would have received. The packet data can then be read with
+ * dmx_read().
+ */
+class dmx_receive_awaitable {
+ public:
+  dmx_receive_awaitable(dmx_loop &loop, dmx_port_t dmx_num,
+                        TickType_t wait_ticks) noexcept
+      : loop_(loop), dmx_num_(dmx_num), wait_ticks_(wait_ticks) {}
+
+  bool await_ready() noexcept {
+    return is_received() || wait_ticks_ == 0;
+  }
+  bool await_suspend(std::coroutine_handle<> handle) noexcept;
+  dmx_packet_t await_resume() noexcept { return packet_; }
+
+ private:
+  friend class dmx_loop;
+
+  // Receives the DMX packet without blocking. Returns true if the DMX packet
+  // was received or if an error occurred.
+  bool is_received() noexcept {
+    // The packet is not written if the arguments of dmx_receive() are invalid
+    packet_ = {};
+    packet_.err = DMX_ERR_TIMEOUT;
+    packet_.sc = -1;
+    return dmx_receive(dmx_num_, &packet_, 0) > 0 ||
+           packet_.err != DMX_ERR_TIMEOUT;
+  }
+
+  dmx_loop &loop_;
+  dmx_port_t dmx_num_;
+  TickType_t wait_ticks_;
+  TickType_t deadline_ = 0;
+  std::coroutine_handle<> handle_;
+  dmx_packet_t packet_ = {};
+};
+
+/**
+ * @brief An awaitable which queues a DMX packet with dmx_send_async() and
+ * resumes when the DMX packet is done being sent. It is created with
+ * dmx_loop::send(). The result of the co_await expression is the size of the
+ * sent packet, or 0 if the packet could not be queued.
+ */
+class dmx_send_awaitable {
+ public:
+  dmx_send_awaitable(dmx_loop &loop, dmx_port_t dmx_num, size_t size) noexcept
+      : loop_(loop), dmx_num_(dmx_num), size_(size) {}
+
+  bool await_ready() noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) noexcept {
+    handle_ = handle;
+    if (!dmx_send_async(dmx_num_, size_, on_sent, this)) {
+      size_ = 0;
+      return false;  // Resume right away if the packet was not queued
+    }
+    return true;
+  }
+  size_t await_resume() noexcept { return size_; }
+
+ private:
+  static bool on_sent(dmx_port_t dmx_num, size_t size, void *context);
+
+  dmx_loop &loop_;
+  dmx_port_t dmx_num_;
+  size_t size_;
+  std::coroutine_handle<> handle_;
+};
+
+/**
+ * @brief Resumes the coroutines which are awaiting the DMX driver. The DMX
+ * driver posts an event to the queue of the loop from its callbacks each time
+ * an awaited packet is received or sent, and the loop resumes the coroutine on
+ * the task which calls run() or run_once(). Every coroutine which awaits the
+ * loop must be started and resumed on that task.
+ *
+ * Only one coroutine at a time may await a received packet on each DMX port.
+ * While it is waiting, the receive callback of the DMX port is replaced by the
+ * loop and it is removed when the coroutine is resumed. The queue must be large
+ * enough to hold an event for each DMX port which is awaited and for each
+ * packet and RDM request which is in flight. If the queue is full, the events
+ * of sent packets are lost and their coroutines are never resumed.
+ *
+ * @note The callbacks of the loop run in the DMX interrupt handler. If the DMX
+ * driver is placed in IRAM, packets should not be awaited while the flash cache
+ * may be disabled.
+ */
+class dmx_loop {
+ public:
+  /**
+   * @brief Constructs a loop.
+   *
+   * @param queue_size The number of events which may be queued.
+   */
+  explicit dmx_loop(size_t queue_size = 16) noexcept
+      : queue_(xQueueCreate(queue_size, sizeof(event))) {}
+  ~dmx_loop() {
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      if (receivers_[i] != nullptr) {
+        dmx_set_rx_callback(i, nullptr, nullptr);
+      }
+    }
+    if (queue_ != nullptr) {
+      vQueueDelete(queue_);
+    }
+  }
+  dmx_loop(const dmx_loop &) = delete;
+  dmx_loop &operator=(const dmx_loop &) = delete;
+
+  /**
+   * @brief Checks if the queue of the loop could be allocated.
+   *
+   * @return true if the loop may be used.
+   * @return false if the queue could not be allocated.
+   */
+  bool is_valid() const noexcept { return queue_ != nullptr; }
+
+  /**
+   * @brief Awaits a DMX packet. This is the awaitable equivalent of
+   * dmx_receive().
+   *
+   * @param dmx_num The DMX port number.
+   * @param wait_ticks The number of FreeRTOS ticks to wait before the packet
+   * times out.
+   * @return An awaitable which resumes with the received dmx_packet_t.
+   */
+  dmx_receive_awaitable receive(dmx_port_t dmx_num,
+                                TickType_t wait_ticks) noexcept {
+    return dmx_receive_awaitable(*this, dmx_num, wait_ticks);
+  }
+
+  /**
+   * @brief Awaits sending a DMX packet. This is the awaitable equivalent of
+   * dmx_send_async() followed by dmx_wait_sent().
+   *
+   * @param dmx_num The DMX port number.
+   * @param size The size of the packet to send, or 0 to send the same size
+   * as dmx_send_async().
+   * @return An awaitable which resumes with the size of the sent packet.
+   */
+  dmx_send_awaitable send(dmx_port_t dmx_num, size_t size = 0) noexcept {
+    return dmx_send_awaitable(*this, dmx_num, size);
+  }
+
+  /**
+   * @brief Waits for the next event and resumes the coroutines which are ready.
+   * Coroutines awaiting a received packet are also resumed when their timeout
+   * elapses.
+   *
+   * @param wait_ticks The number of FreeRTOS ticks to wait for an event.
+   * @return The number of coroutines which were resumed.
+   */
+  size_t run_once(TickType_t wait_ticks) noexcept {
+    // Block until an event is posted or the next receive times out
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      const dmx_receive_awaitable *const r = receivers_[i];
+      if (r == nullptr || r->wait_ticks_ == portMAX_DELAY) {
+        continue;
+      }
+      const int32_t remaining = static_cast<int32_t>(r->deadline_ - now);
+      if (remaining <= 0) {
+        wait_ticks = 0;
+      } else if (static_cast<TickType_t>(remaining) < wait_ticks) {
+        wait_ticks = remaining;
+      }
+    }
+    size_t resumed = 0;
+    event e;
+    if (xQueueReceive(queue_, &e, wait_ticks) == pdTRUE) {
+      resumed += dispatch(e);
+    }
+
+    // Resume the coroutines whose receive timed out
+    now = xTaskGetTickCount();
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      dmx_receive_awaitable *const r = receivers_[i];
+      if (r == nullptr || r->wait_ticks_ == portMAX_DELAY ||
+          static_cast<int32_t>(now - r->deadline_) < 0) {
+        continue;
+      }
+      r->is_received();  // The packet err is DMX_ERR_TIMEOUT if not received
+      receivers_[i] = nullptr;
+      dmx_set_rx_callback(i, nullptr, nullptr);
+      r->handle_.resume();
+      ++resumed;
+    }
+
+    return resumed;
+  }
+
+  /** @brief Resumes the coroutines which are awaiting the loop forever.*/
+  [[noreturn]] void run() noexcept {
+    while (true) {
+      run_once(portMAX_DELAY);
+    }
+  }
+
+ private:
+  friend class dmx_receive_awaitable;
+  friend class dmx_send_awaitable;
+  friend class rdm_request_awaitable;
+
+  // An event which is posted by the DMX driver. The address of the coroutine
+  // is null if a packet was received on the DMX port.
+  struct event {
+    dmx_port_t dmx_num;
+    void *address;
+  };
+
+  static bool on_received(dmx_port_t dmx_num, [[maybe_unused]] size_t size,
+                          [[maybe_unused]] int sc,
+                          [[maybe_unused]] dmx_err_t err, void *context) {
+    return static_cast<dmx_loop *>(context)->post_from_isr(dmx_num, nullptr);
+  }
+
+  bool post_from_isr(dmx_port_t dmx_num, void *address) noexcept {
+    const event e = {dmx_num, address};
+    BaseType_t task_awoken = pdFALSE;
+    xQueueSendFromISR(queue_, &e, &task_awoken);
+    return task_awoken == pdTRUE;
+  }
+
+  bool post(dmx_port_t dmx_num, void *address) noexcept {
+    const event e = {dmx_num, address};
+    return xQueueSend(queue_, &e, portMAX_DELAY) == pdTRUE;
+  }
+
+  bool add_receiver(dmx_receive_awaitable *r) noexcept {
+    if (r->dmx_num_ >= DMX_NUM_MAX || receivers_[r->dmx_num_] != nullptr ||
+        !dmx_set_rx_callback(r->dmx_num_, on_received, this)) {
+      return false;
+    }
+    receivers_[r->dmx_num_] = r;
+    return true;
+  }
+
+  size_t dispatch(const event &e) noexcept {
+    if (e.address != nullptr) {
+      std::coroutine_handle<>::from_address(e.address).resume();
+      return 1;
+    }
+
+    if (e.dmx_num >= DMX_NUM_MAX) {
+      return 0;
+    }
+
+    // Stale events are posted for packets which have already been received
+    dmx_receive_awaitable *const r = receivers_[e.dmx_num];
+    if (r == nullptr || !r->is_received()) {
+      return 0;
+    }
+    receivers_[e.dmx_num] = nullptr;
+    dmx_set_rx_callback(e.dmx_num, nullptr, nullptr);
+    r->handle_.resume();
+    return 1;
+  }
+
+  QueueHandle_t queue_;
+  dmx_receive_awaitable *receivers_[DMX_NUM_MAX] = {};
+};
+
+inline bool dmx_receive_awaitable::await_suspend(
+    std::coroutine_handle<> handle) noexcept {
+  handle_ = handle;
+  deadline_ = xTaskGetTickCount() + wait_ticks_;
+  if (!loop_.add_receiver(this)) {
+    packet_ = {};
+    packet_.err = DMX_ERR_TIMEOUT;
+    packet_.sc = -1;
+    return false;  // Another coroutine is awaiting the DMX port
+  }
+
+  // A packet may have been received before the callback was set
+  if (is_received()) {
+    loop_.receivers_[dmx_num_] = nullptr;
+    dmx_set_rx_callback(dmx_num_, nullptr, nullptr);
+    return false;
+  }
+  return true;
+}
+
+inline bool dmx_send_awaitable::on_sent(dmx_port_t dmx_num, size_t size,
+                                        void *context) {
+  dmx_send_awaitable *const self = static_cast<dmx_send_awaitable *>(context);
+  self->size_ = size;
+  return self->loop_.post_from_isr(dmx_num, self->handle_.address());
+}
+
+}  // namespace esp_dmx
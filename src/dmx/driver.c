@@ -9,10 +9,13 @@
 #include "dmx/include/service.h"
 #include "dmx/sniffer.h"
 #include "endian.h"
+#include "rdm/controller/include/discovery.h"
 #include "rdm/include/types.h"
 #include "rdm/responder/include/utils.h"
 
-#if ESP_IDF_VERSION_MAJOR >= 5
+#if defined(CONFIG_IDF_TARGET_LINUX)
+#include "dmx/hal/host/include/sim.h"
+#elif ESP_IDF_VERSION_MAJOR >= 5
 #include "esp_mac.h"  // TODO: Make this hardware agnostic
 #endif
 
@@ -67,19 +70,113 @@ static void rdm_default_identify_cb(dmx_port_t dmx_num, rdm_header_t *request,
   }
 }
 
+// Arguments used to initialize the DMX hardware from a task on another core
+struct dmx_driver_hal_init_args_t {
+  dmx_port_t dmx_num;
+  const dmx_config_t *config;
+  int interrupt_flags;
+  TaskHandle_t caller;
+  bool result;
+};
+
+static bool dmx_driver_hal_init(dmx_port_t dmx_num, const dmx_config_t *config,
+                                int interrupt_flags) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Initialize the UART peripheral
+  if (!dmx_uart_init(dmx_num, driver, interrupt_flags)) {
+    DMX_ERR("UART init error");
+    return false;
+  }
+  if (config->tx_mode == DMX_TX_MODE_DMA) {
+    if (dmx_uart_dma_init(dmx_num)) {
+      driver->tx_mode = DMX_TX_MODE_DMA;
+    } else {
+      DMX_WARN("DMA is unavailable, tx_mode updated to DMX_TX_MODE_FIFO");
+    }
+  }
+  if (config->rx_mode == DMX_RX_MODE_DMA) {
+    if (dmx_uart_dma_rx_init(dmx_num, driver, driver->dmx.data,
+                             driver->packet_size_max)) {
+      driver->rx_mode = DMX_RX_MODE_DMA;
+    } else {
+      DMX_WARN("DMA is unavailable, rx_mode updated to DMX_RX_MODE_FIFO");
+    }
+  }
+  dmx_uart_set_rx_threshold(dmx_num, driver->rx_intr_threshold);
+  driver->dmx.rx_threshold = driver->rx_intr_threshold;
+
+  // Initialize the timer peripheral
+  if (!dmx_timer_init(dmx_num, driver, interrupt_flags)) {
+    DMX_ERR("timer init error");
+    return false;
+  }
+
+  return true;
+}
+
+#if portNUM_PROCESSORS > 1 && !defined(CONFIG_FREERTOS_UNICORE)
+static void dmx_driver_hal_init_task(void *arg) {
+  struct dmx_driver_hal_init_args_t *args = arg;
+  args->result =
+      dmx_driver_hal_init(args->dmx_num, args->config, args->interrupt_flags);
+  xTaskNotifyGive(args->caller);
+  vTaskDelete(NULL);
+}
+#endif
+
+static int dmx_driver_get_isr_core(dmx_port_t dmx_num, int isr_core) {
+#if portNUM_PROCESSORS > 1 && !defined(CONFIG_FREERTOS_UNICORE)
+  if (isr_core == DMX_ISR_CORE_0) {
+    return 0;
+  } else if (isr_core == DMX_ISR_CORE_1) {
+    return 1;
+  } else if (isr_core == DMX_ISR_CORE_AUTO) {
+    // Count the DMX ports which are serviced by each core
+    int port_count[2] = {0, 0};
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      if (i != dmx_num && dmx_driver_is_installed(i)) {
+        ++port_count[dmx_driver[i]->isr_core];
+      }
+    }
+    return port_count[1] <= port_count[0] ? 1 : 0;
+  }
+  return xPortGetCoreID();
+#else
+  return 0;
+#endif
+}
+
 bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config,
                         const dmx_personality_t *personalities,
                         int personality_count) {
-  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_num < DMX_NUM_UART_MAX, false, "dmx_num error");
   DMX_CHECK(config != NULL, false, "config is null");
   DMX_CHECK(personality_count >= 0 && personality_count <= 255, false,
             "personality_count error");
   DMX_CHECK(!dmx_driver_is_installed(dmx_num), false,
             "driver is already installed");
+
+  // Ensure the maximum packet size is valid
+  int packet_size_max = config->packet_size_max;
+  if (packet_size_max == 0) {
+    packet_size_max = DMX_PACKET_SIZE_MAX;
+  } else if (packet_size_max > DMX_PACKET_SIZE_MAX) {
+    DMX_WARN("packet_size_max must be no more than %i, "
+             "packet_size_max updated to %i",
+             DMX_PACKET_SIZE_MAX, DMX_PACKET_SIZE_MAX);
+    packet_size_max = DMX_PACKET_SIZE_MAX;
+  } else if (packet_size_max < DMX_PACKET_SIZE_MIN) {
+    DMX_WARN("packet_size_max must be at least %i, "
+             "packet_size_max updated to %i",
+             DMX_PACKET_SIZE_MIN, DMX_PACKET_SIZE_MIN);
+    packet_size_max = DMX_PACKET_SIZE_MIN;
+  }
+
   bool uses_dmx = false;
   for (int i = 0; i < personality_count; ++i) {
     DMX_CHECK((personalities[i].footprint > 0 &&
-               personalities[i].footprint < DMX_PACKET_SIZE_MAX),
+               personalities[i].footprint < packet_size_max),
               false, "footprint error");
     if (personalities[i].footprint > 0) {
       uses_dmx = true;
@@ -106,16 +203,69 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config,
     root_param_count = required_parameter_count;
   }
 
+  // Ensure the receive interrupt threshold is valid
+  uint32_t rx_intr_threshold = config->rx_intr_threshold;
+  if (rx_intr_threshold == 0) {
+    rx_intr_threshold = 1;
+  } else if (rx_intr_threshold > DMX_RX_INTR_THRESHOLD_MAX) {
+    DMX_WARN("rx_intr_threshold must be no more than %i, "
+             "rx_intr_threshold updated to %i",
+             DMX_RX_INTR_THRESHOLD_MAX, DMX_RX_INTR_THRESHOLD_MAX);
+    rx_intr_threshold = DMX_RX_INTR_THRESHOLD_MAX;
+  }
+
   // Initialize NVS
   dmx_nvs_init(dmx_num);
 
-  // Allocate the DMX driver
+  // Get the memory in which to allocate the DMX driver
+  uint32_t driver_caps =
+      config->memory_caps != 0 ? config->memory_caps : MALLOC_CAP_8BIT;
+  if (config->tx_mode == DMX_TX_MODE_DMA ||
+      config->rx_mode == DMX_RX_MODE_DMA) {
+    // Slot data must be in DMA-capable memory in order to be used by DMA
+    driver_caps |= MALLOC_CAP_DMA;
+  }
+#ifdef DMX_ISR_IN_IRAM
+  // The driver ISR may run while the cache, and external RAM, is disabled
+  if (driver_caps & MALLOC_CAP_SPIRAM) {
+    driver_caps = (driver_caps & ~MALLOC_CAP_SPIRAM) | MALLOC_CAP_INTERNAL;
+    DMX_WARN("DMX driver ISR is in IRAM, memory_caps updated to internal RAM");
+  }
+#endif
+
+  // Allocate the DMX driver, its root device parameters, and its packet
+  // buffers as a single block of memory
+  const size_t buffer_size = DMX_BUFFER_SIZE(packet_size_max);
+  const size_t buffers_offset =
+      (sizeof(dmx_driver_t) + DMX_DEVICE_PARAMETERS_SIZE(root_param_count) +
+       3) & ~3;
   const size_t driver_size =
-      sizeof(dmx_driver_t) + (sizeof(dmx_parameter_t) * root_param_count);
-  dmx_driver_t *driver = heap_caps_malloc(driver_size, MALLOC_CAP_8BIT);
+      buffers_offset + (buffer_size * (DMX_RX_BUFFER_COUNT + 1));
+  dmx_driver_t *driver = heap_caps_malloc(driver_size, driver_caps);
   DMX_CHECK(driver != NULL, false, "DMX driver malloc error");
   dmx_driver[dmx_num] = driver;
   driver->mux = NULL;
+  driver->schedule.grant = NULL;
+  driver->async.requests = NULL;
+  driver->async.task = NULL;
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+  driver->commit.task = NULL;
+#endif
+  driver->tod = NULL;
+  driver->cache = NULL;
+  dmx_device_reset(&driver->device.root, root_param_count);
+  driver->device.sub_devices.table = NULL;
+  driver->device.sub_devices.max = 0;
+  driver->responders.table = NULL;
+  driver->responders.index = NULL;
+  driver->responders.max = 0;
+  driver->responders.count = 0;
+  for (int i = 0; i < RDM_RESPONDER_SELECT_MAX + 1; ++i) {
+    driver->responders.selected[i].task = NULL;
+    driver->responders.selected[i].num = 0;
+  }
+  driver->device.memory.arena = NULL;
+  driver->device.memory.size = 0;
 #ifdef DMX_USE_SPINLOCK
   driver->spinlock = (dmx_spinlock_t)DMX_SPINLOCK_INIT;
 #endif
@@ -126,11 +276,21 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config,
     dmx_driver_delete(dmx_num);
     DMX_CHECK(driver->mux != NULL, false, "DMX driver mutex malloc error");
   }
+  xSemaphoreTakeRecursive(driver->mux, 0);  // Held until the driver is ready
+  driver->schedule.grant = xSemaphoreCreateBinary();
+  if (driver->schedule.grant == NULL) {
+    dmx_driver_delete(dmx_num);
+    DMX_CHECK(driver->schedule.grant != NULL, false,
+              "DMX driver semaphore malloc error");
+  }
 
   // Driver configuration
   driver->dmx_num = dmx_num;
   driver->uid.man_id = RDM_UID_MANUFACTURER_ID;
-#if RDM_UID_DEVICE_ID == 0xffffffff
+#if RDM_UID_DEVICE_ID == 0xffffffff && defined(CONFIG_IDF_TARGET_LINUX)
+  // The host has no MAC address so a fixed device ID is used
+  driver->uid.dev_id = DMX_SIM_DEVICE_ID;
+#elif RDM_UID_DEVICE_ID == 0xffffffff
   // Set the device ID based on the device's MAC address
   uint8_t mac[8];
   esp_efuse_mac_get_default(mac);
@@ -142,47 +302,262 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config,
   *(uint8_t *)(&driver->uid.dev_id) += dmx_num;  // Increment last octect
   driver->break_len = RDM_BREAK_LEN_US;
   driver->mab_len = RDM_MAB_LEN_US;
+  driver->tx_mode = DMX_TX_MODE_FIFO;  // Updated after the UART is initialized
+  driver->rx_mode = DMX_RX_MODE_FIFO;
+  driver->rx_intr_threshold = rx_intr_threshold;
+  driver->break_mode = config->break_mode;
+  driver->packet_size_max = packet_size_max;
+  driver->memory_caps = driver_caps;
 
   // Set the default values for the root device
   driver->device.root.num = RDM_SUB_DEVICE_ROOT;
-  driver->device.root.next = NULL;
-  for (int i = 0; i < config->root_device_parameter_count; ++i) {
+  for (int i = 0; i < root_param_count; ++i) {
     driver->device.root.parameters[i].pid = 0;
   }
 
   // Set the default values for the DMX device
-  driver->device.parameter_count.root = config->root_device_parameter_count;
+  driver->device.parameter_count.root = root_param_count;
   driver->device.parameter_count.sub_devices =
       config->sub_device_parameter_count;
   driver->device.parameter_count.staged = 0;
+  driver->device.generation = 0;
+
+  // Allocate the sub-device table. Entries are zeroed so none are in use.
+  driver->device.sub_devices.stride =
+      DMX_DEVICE_STRIDE(dmx_device_t, config->sub_device_parameter_count);
+  driver->device.sub_devices.count = 0;
+  if (config->sub_device_count > 0) {
+    const uint16_t max = config->sub_device_count < RDM_SUB_DEVICE_MAX
+                             ? config->sub_device_count
+                             : RDM_SUB_DEVICE_MAX - 1;
+    driver->device.sub_devices.table =
+        calloc(max, driver->device.sub_devices.stride);
+    if (driver->device.sub_devices.table == NULL) {
+      dmx_driver_delete(dmx_num);
+      DMX_CHECK(false, false, "sub-device table malloc error");
+    }
+    driver->device.sub_devices.max = max;
+  }
+
+  // Allocate the virtual responder table and the index which is read by the
+  // DMX ISR. Entries are zeroed so none are in use.
+  driver->responders.stride =
+      DMX_DEVICE_STRIDE(dmx_responder_t, root_param_count);
+  if (config->virtual_responder_count > 0) {
+    const uint16_t max =
+        config->virtual_responder_count < RDM_VIRTUAL_RESPONDER_MAX
+            ? config->virtual_responder_count
+            : RDM_VIRTUAL_RESPONDER_MAX;
+    driver->responders.table = calloc(max, driver->responders.stride);
+    driver->responders.index =
+        heap_caps_calloc(max, sizeof(dmx_responder_index_t),
+                         MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (driver->responders.table == NULL || driver->responders.index == NULL) {
+      dmx_driver_delete(dmx_num);
+      DMX_CHECK(false, false, "virtual responder table malloc error");
+    }
+    driver->responders.max = max;
+  }
+
+  // Allocate the memory from which parameter data is allocated
+  driver->device.memory.size =
+      config->parameter_memory_size > 0
+          ? config->parameter_memory_size
+          : root_param_count * DMX_PARAMETER_SIZE_AVERAGE;
+  driver->device.memory.used = 0;
+  driver->device.memory.heap = 0;
+  driver->device.memory.cache = 0;
+  if (driver->device.memory.size > 0) {
+    driver->device.memory.arena =
+        heap_caps_malloc(driver->device.memory.size, MALLOC_CAP_8BIT);
+    if (driver->device.memory.arena == NULL) {
+      dmx_driver_delete(dmx_num);
+      DMX_CHECK(false, false, "parameter memory malloc error");
+    }
+  }
   driver->is_controller = false;  // Assume false until dmx_send_num()
   driver->is_enabled = true;
 
   // Synchronization state
   driver->task_waiting = NULL;
+  driver->any_waiting = NULL;
+  driver->rx_callback = NULL;
+  driver->rx_callback_context = NULL;
+  memset(driver->sc_filter.actions, 0, sizeof(driver->sc_filter.actions));
+  driver->sc_filter.handler = NULL;
+  driver->sc_filter.context = NULL;
+  for (int i = 0; i < DMX_SUBSCRIBERS_MAX; ++i) {
+    driver->subscribers[i] = NULL;
+  }
 
   // Data buffer
+  driver->dmx.seq = 0;
   driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
-  driver->dmx.size = DMX_PACKET_SIZE_MAX;
-  memset(driver->dmx.data, 0, sizeof(driver->dmx.data));
+  driver->dmx.size = packet_size_max;
+  uint8_t *const buffers = (uint8_t *)driver + buffers_offset;
+  memset(buffers, 0, buffer_size * (DMX_RX_BUFFER_COUNT + 1));
+  driver->dmx.data = buffers;
+#if DMX_RX_BUFFER_COUNT > 1
+  driver->dmx.ready = buffers + buffer_size;
+  driver->dmx.front = buffers + (buffer_size * 2);
+  driver->dmx.ready_is_fresh = false;
+  driver->dmx.latest_size = 0;
+  driver->dmx.latest_timestamp = 0;
+  driver->dmx.sc = -1;
+#endif
   driver->dmx.status = DMX_STATUS_IDLE;
   driver->dmx.progress = DMX_PROGRESS_STALE;
+  driver->dmx.rx_threshold = 1;  // Updated after the UART is initialized
+  driver->dmx.rx_intr_count = 0;
+  driver->dmx.last_rx_intr_count = 0;
+  driver->dmx.rx_err_flags = 0;
+  driver->dmx.tx_break_bits = 0;
+  driver->dmx.tx_mab_bits = 0;
+  driver->dmx.tx_break_was_sent = false;
   driver->dmx.last_controller_pid = 0;
   driver->dmx.controller_eop_timestamp = 0;
+  driver->dmx.rx_break_timestamp = 0;
+  driver->dmx.last_break_timestamp = 0;
+  driver->dmx.last_eop_timestamp = 0;
+  driver->dmx.last_err = DMX_OK;
   driver->dmx.last_responder_pid = 0;
   driver->dmx.responder_sent_last = false;
+  driver->dmx.rdm_header_is_cached = false;
+  driver->dmx.rdm_header_is_valid = false;
+  driver->dmx.rx_checksum = 0;
+  driver->dmx.rx_checksum_len = 0;
   driver->dmx.last_request_pid = 0;
   driver->dmx.last_request_pid_repeats = 0;
+  driver->dmx.last_response_was_overflow = false;
 
   // RDM responder configuration
   driver->rdm.tn = 0;
+  driver->rdm.data = buffers + (buffer_size * DMX_RX_BUFFER_COUNT);
+  driver->rdm.request_is_active = false;
+  driver->rdm.deferred_pid = 0;
+  driver->rdm.deferred_timestamp = 0;
+  driver->rdm.queue = NULL;
+  driver->rdm.status = NULL;
+  driver->rdm.disc_is_active = false;
+
+  // Driver statistics
+  memset(&driver->stats, 0, sizeof(driver->stats));
+
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+  // Receive timing statistics
+  memset(&driver->timing.stats, 0, sizeof(driver->timing.stats));
+  driver->timing.last_break_timestamp = 0;
+#endif
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  // RDM latency statistics
+  memset(&driver->latency, 0, sizeof(driver->latency));
+#endif
+
+#ifdef CONFIG_DMX_TRACE
+  // Interrupt event trace
+  driver->trace.head = 0;
+  driver->trace.tail = 0;
+#endif
+
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+  // RDM discovery responses which are sent by the DMX interrupt
+  memset(&driver->disc_isr, 0, sizeof(driver->disc_isr));
+#endif
+
+  // Zero-copy buffer leases
+  driver->lease.read_is_leased = false;
+  driver->lease.write_is_leased = false;
+  driver->lease.write_is_pending = false;
+  driver->lease.back = NULL;
+  driver->lease.memory = NULL;
+
+  // Receive change detection
+  driver->change.last = NULL;
+  driver->change.last_size = 0;
+
+  // Continuous transmit configuration
+  driver->continuous.is_running = false;
+  driver->continuous.is_paused = false;
+  driver->continuous.is_dirty = false;
+  driver->continuous.size = 0;
+  driver->continuous.is_auto_sized = false;
+  driver->continuous.period = 0;
+  driver->continuous.frame_timestamp = 0;
+  driver->continuous.staging = NULL;
+
+  // Asynchronous transmit queue
+  driver->tx_async.is_queued = false;
+  driver->tx_async.size = 0;
+  driver->tx_async.tx_break_bits = 0;
+  driver->tx_async.tx_mab_bits = 0;
+  driver->tx_async.queued_callback = NULL;
+  driver->tx_async.queued_context = NULL;
+  driver->tx_async.callback = NULL;
+  driver->tx_async.context = NULL;
+
+  // Automatic transmit size configuration
+  driver->auto_size.min_size = 0;
+  driver->auto_size.full_period = 0;
+  driver->auto_size.full_timestamp = 0;
+
+  // Fade configuration
+  driver->fade.active = 0;
+  driver->fade.buffer = NULL;
+
+#if DMX_RX_BUFFER_COUNT > 1
+  // Merge configuration
+  driver->merge.is_running = false;
+  driver->merge.buffer = NULL;
+#endif
+
+  // Repeater configuration
+  driver->repeater.outputs = 0;
+  driver->repeater.active = 0;
+  driver->repeater.forwards_rdm = false;
+  driver->repeater.source = DMX_NUM_MAX;
+  driver->repeater.available = 0;
+  driver->repeater.is_pending = false;
+  driver->repeater.next = NULL;
+
+  // Synchronized send configuration
+  driver->sync.group = 0;
+  driver->sync.skew = 0;
+
+  // RDM transaction scheduler
+  driver->schedule.dmx_frames_per_rdm = 0;
+  driver->schedule.min_refresh_rate = 0;
+  driver->schedule.dmx_frames = 0;
+  driver->schedule.dmx_period = 0;
+  driver->schedule.dmx_timestamp = 0;
+  driver->schedule.rdm_is_waiting = false;
+
+  // Asynchronous RDM controller requests
+  driver->async.next_handle = 1;
+  driver->async.pending = 0;
 
   // DMX sniffer configuration
   driver->sniffer.is_enabled = false;
+  driver->sniffer.uses_capture = false;
   driver->sniffer.buffer_index = 0;
   // The driver->metadata field is left uninitialized
   driver->sniffer.last_pos_edge_ts = -1;
   driver->sniffer.last_neg_edge_ts = -1;
+  driver->sniffer.stream.ring = NULL;
+  driver->sniffer.stream.size = 0;
+  driver->sniffer.stream.head = 0;
+  driver->sniffer.stream.tail = 0;
+  driver->sniffer.stream.dropped = 0;
+  driver->sniffer.stream.reported = 0;
+
+  // Receive frame queue
+  driver->rx_queue.frames = NULL;
+  driver->rx_queue.size = 0;
+  driver->rx_queue.head = 0;
+  driver->rx_queue.tail = 0;
+  driver->rx_queue.dropped = 0;
+  driver->rx_queue.reported = 0;
+  driver->rx_queue.task_waiting = NULL;
 
   // Add the personality numbers to the DMX personalities
   rdm_dmx_personality_description_t *personality_description =
@@ -222,22 +597,49 @@ bool dmx_driver_install(dmx_port_t dmx_num, const dmx_config_t *config,
   rdm_register_supported_parameters(dmx_num, NULL, NULL);
   rdm_register_parameter_description(dmx_num, NULL, NULL);
 
-  // Initialize the UART peripheral
-  if (!dmx_uart_init(dmx_num, driver, interrupt_flags)) {
+  // Initialize the hardware on the core which will service its interrupts
+  bool hal_init_ok;
+  driver->isr_core = dmx_driver_get_isr_core(dmx_num, config->isr_core);
+#if portNUM_PROCESSORS > 1 && !defined(CONFIG_FREERTOS_UNICORE)
+  if (driver->isr_core != xPortGetCoreID()) {
+    struct dmx_driver_hal_init_args_t args = {
+        .dmx_num = dmx_num,
+        .config = config,
+        .interrupt_flags = interrupt_flags,
+        .caller = xTaskGetCurrentTaskHandle(),
+        .result = false,
+    };
+    if (xTaskCreatePinnedToCore(dmx_driver_hal_init_task, "dmx_init", 4096,
+                                &args, uxTaskPriorityGet(NULL), NULL,
+                                driver->isr_core) != pdPASS) {
+      dmx_driver_delete(dmx_num);
+      DMX_CHECK(false, false, "DMX init task malloc error");
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    hal_init_ok = args.result;
+  } else
+#endif
+  {
+    hal_init_ok = dmx_driver_hal_init(dmx_num, config, interrupt_flags);
+  }
+  if (!hal_init_ok) {
     dmx_driver_delete(dmx_num);
-    DMX_CHECK(false, false, "UART init error");
+    return false;
   }
 
-  // Initialize the timer peripheral
-  if (!dmx_timer_init(dmx_num, driver, interrupt_flags)) {
+  // Start committing non-volatile parameters in the background
+  if ((root_param_count > 0 || config->sub_device_parameter_count > 0) &&
+      !dmx_parameter_commit_start(dmx_num)) {
     dmx_driver_delete(dmx_num);
-    DMX_CHECK(false, false, "timer init error");
+    DMX_CHECK(false, false, "DMX commit task malloc error");
   }
 
   // Enable reading on the DMX port
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
   xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
-  dmx_uart_enable_interrupt(dmx_num, DMX_INTR_RX_ALL);
+  dmx_uart_enable_interrupt(dmx_num, driver->rx_mode == DMX_RX_MODE_DMA
+                                         ? DMX_INTR_RX_DMA
+                                         : DMX_INTR_RX_ALL);
   dmx_uart_set_rts(dmx_num, 1);
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
@@ -252,12 +654,62 @@ bool dmx_driver_delete(dmx_port_t dmx_num) {
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+  // Stop background discovery so that it releases the mutex
+  rdm_tod_stop(dmx_num);
+
+  // Stop the commit task once it has committed any staged parameters
+  dmx_parameter_commit_stop(dmx_num);
+
   // Take the mutex
   if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
     return false;
   }
   SemaphoreHandle_t mux = driver->mux;
 
+#if DMX_RX_BUFFER_COUNT > 1
+  // Stop merging into this port and stop any merge which reads from it
+  for (dmx_port_t num = 0; num < DMX_NUM_MAX; ++num) {
+    const dmx_driver_t *const output = dmx_driver[num];
+    if (output != NULL && output->merge.is_running &&
+        (num == dmx_num || output->merge.inputs[0] == dmx_num ||
+         output->merge.inputs[1] == dmx_num)) {
+      dmx_merge_stop(num);
+    }
+  }
+#endif
+
+  // Stop repeating from this port and stop any repeater which sends on it
+  if (driver->repeater.outputs != 0) {
+    dmx_repeater_stop(dmx_num);
+  } else if (driver->repeater.source < DMX_NUM_MAX) {
+    dmx_repeater_stop(driver->repeater.source);
+  }
+
+  // Stop sending continuously
+  if (driver->continuous.is_running) {
+    dmx_continuous_stop(dmx_num);
+  }
+
+  // Free the receive queue
+  if (driver->rx_queue.frames != NULL) {
+    dmx_rx_queue_disable(dmx_num);
+  }
+
+  // Free the write lease buffer
+  if (driver->lease.memory != NULL) {
+    heap_caps_free(driver->lease.memory);
+  }
+
+  // Free the fade buffer
+  if (driver->fade.buffer != NULL) {
+    heap_caps_free(driver->fade.buffer);
+  }
+
+  // Free the change detection buffer
+  if (driver->change.last != NULL) {
+    heap_caps_free(driver->change.last);
+  }
+
   // Uninstall sniffer ISR
   if (dmx_sniffer_is_enabled(dmx_num)) {
     dmx_sniffer_disable(dmx_num);
@@ -270,29 +722,53 @@ bool dmx_driver_delete(dmx_port_t dmx_num) {
   dmx_uart_deinit(dmx_num);
 
   // Free parameters
-  dmx_device_t *device = &driver->device.root;
-  do {
-    int param_count = device->num == RDM_SUB_DEVICE_ROOT
-                          ? driver->device.parameter_count.root
-                          : driver->device.parameter_count.sub_devices;
-    for (int i = 0; i < param_count; ++i) {
-      if (device->parameters[i].pid == 0) {
-        break;  // No more parameters remaining
-      } else if (device->parameters[i].type != DMX_PARAMETER_TYPE_DYNAMIC) {
+  const int device_count = dmx_device_count(dmx_num);
+  for (int index = 0; index < device_count; ++index) {
+    const dmx_device_t *device = dmx_device_at(dmx_num, index);
+    if (device == NULL) {
+      continue;  // Sub-device does not exist
+    }
+    for (int i = 0; i < device->parameter_count; ++i) {
+      free(device->parameters[i].cache);
+      if (device->parameters[i].type == DMX_PARAMETER_TYPE_STATIC ||
+          device->parameters[i].type == DMX_PARAMETER_TYPE_NULL) {
         continue;  // Nothing to free
       }
+      const uint8_t *data = device->parameters[i].data;
+      if (data >= driver->device.memory.arena &&
+          data < driver->device.memory.arena + driver->device.memory.size) {
+        continue;  // Freed with the parameter arena
+      }
       free(device->parameters[i].data);
     }
-    device = device->next;   
-  } while (device != NULL);
+  }
+  heap_caps_free(driver->device.memory.arena);
+
+  // Free the sub-device table
+  free(driver->device.sub_devices.table);
+
+  // Free the virtual responder tables
+  free(driver->responders.table);
+  heap_caps_free(driver->responders.index);
+
+  // Free the RDM controller response cache
+  free(driver->cache);
+
+  // Stop the asynchronous RDM request task
+  if (driver->async.task != NULL) {
+    vTaskDelete(driver->async.task);
+  }
+  if (driver->async.requests != NULL) {
+    vQueueDelete(driver->async.requests);
+  }
+
+  // Free the RDM scheduler semaphore
+  if (driver->schedule.grant != NULL) {
+    vSemaphoreDelete(driver->schedule.grant);
+  }
 
-  // Free devices
-  device = driver->device.root.next;  // Can't free root device
-  while (device != NULL) {
-    dmx_device_t *next_device = device->next;
-    free(device);
-    device = next_device;
-  } 
+  // Free the parameters which were loaded from NVS
+  dmx_nvs_deinit(dmx_num);
 
   // Free driver
   heap_caps_free(driver);
@@ -337,11 +813,15 @@ bool dmx_driver_enable(dmx_port_t dmx_num) {
 
   // Initialize driver flags and reenable interrupts
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_STATE_WRITE_BEGIN(driver);
   driver->dmx.head = -1;  // Wait for DMX break before reading data
+  DMX_STATE_WRITE_END(driver);
   driver->is_enabled = true;
   dmx_uart_rxfifo_reset(dmx_num);
   dmx_uart_txfifo_reset(dmx_num);
-  dmx_uart_enable_interrupt(dmx_num, DMX_INTR_RX_ALL);
+  dmx_uart_enable_interrupt(dmx_num, driver->rx_mode == DMX_RX_MODE_DMA
+                                         ? DMX_INTR_RX_DMA
+                                         : DMX_INTR_RX_ALL);
   dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
@@ -464,6 +944,352 @@ uint32_t dmx_set_mab_len(dmx_port_t dmx_num, uint32_t mab_len) {
   return mab_len;
 }
 
+uint32_t dmx_get_rx_intr_threshold(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  uint32_t rx_intr_threshold;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  rx_intr_threshold = dmx_driver[dmx_num]->rx_intr_threshold;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return rx_intr_threshold;
+}
+
+uint32_t dmx_set_rx_intr_threshold(dmx_port_t dmx_num,
+                                   uint32_t rx_intr_threshold) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  // Clamp the threshold to the size of the UART RX FIFO
+  if (rx_intr_threshold < 1) {
+    rx_intr_threshold = 1;
+  } else if (rx_intr_threshold > DMX_RX_INTR_THRESHOLD_MAX) {
+    rx_intr_threshold = DMX_RX_INTR_THRESHOLD_MAX;
+  }
+
+  // The new threshold is applied by the DMX ISR on the next DMX break
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  dmx_driver[dmx_num]->rx_intr_threshold = rx_intr_threshold;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return rx_intr_threshold;
+}
+
+uint32_t dmx_get_rx_intr_count(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  uint32_t rx_intr_count;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  rx_intr_count = dmx_driver[dmx_num]->dmx.last_rx_intr_count;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return rx_intr_count;
+}
+
+bool dmx_set_rx_change_detection(dmx_port_t dmx_num, bool enable) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Take the mutex so that the buffer isn't changed while receiving
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    return false;
+  }
+
+  bool ret = true;
+  if (enable && driver->change.last == NULL) {
+    driver->change.last = heap_caps_malloc(
+        DMX_BUFFER_SIZE(driver->packet_size_max), MALLOC_CAP_8BIT);
+    if (driver->change.last == NULL) {
+      DMX_ERR("change detection buffer malloc error");
+      ret = false;
+    }
+    driver->change.last_size = 0;  // The next packet is always changed
+  } else if (!enable && driver->change.last != NULL) {
+    heap_caps_free(driver->change.last);
+    driver->change.last = NULL;
+  }
+
+  xSemaphoreGiveRecursive(driver->mux);
+  return ret;
+}
+
+bool dmx_set_tx_auto_size(dmx_port_t dmx_num, size_t min_size,
+                          uint32_t full_period_us) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(min_size <= driver->packet_size_max, false, "min_size error");
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->auto_size.min_size = min_size;
+  driver->auto_size.full_period = full_period_us;
+  driver->auto_size.full_timestamp = 0;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_get_rx_timing(dmx_port_t dmx_num, dmx_rx_timing_t *timing) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(timing != NULL, false, "timing is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(timing, &driver->timing.stats, sizeof(*timing));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("receive timing statistics are disabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool dmx_reset_rx_timing(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memset(&driver->timing.stats, 0, sizeof(driver->timing.stats));
+  driver->timing.last_break_timestamp = 0;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("receive timing statistics are disabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool dmx_get_stats(dmx_port_t dmx_num, dmx_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(stats, &driver->stats, sizeof(*stats));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_reset_stats(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memset(&driver->stats, 0, sizeof(driver->stats));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+size_t dmx_trace_drain(dmx_port_t dmx_num, dmx_trace_event_t *events,
+                       size_t count, uint32_t *dropped) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(events != NULL || count == 0, 0, "events is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+#ifdef CONFIG_DMX_TRACE
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Skip the events which were overwritten since the last drain
+  uint32_t tail = driver->trace.tail;
+  const uint32_t head = __atomic_load_n(&driver->trace.head, __ATOMIC_ACQUIRE);
+  uint32_t lost = 0;
+  if (head - tail > DMX_TRACE_EVENTS) {
+    lost = head - tail - DMX_TRACE_EVENTS;
+    tail = head - DMX_TRACE_EVENTS;
+  }
+
+  // Copy the events without blocking the DMX interrupt handlers
+  size_t copied = head - tail;
+  if (copied > count) {
+    copied = count;
+  }
+  for (size_t i = 0; i < copied; ++i) {
+    events[i] = driver->trace.events[(tail + i) & (DMX_TRACE_EVENTS - 1)];
+  }
+  driver->trace.tail = tail + copied;
+
+  // Discard the events which were overwritten while they were being copied
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  const uint32_t new_head =
+      __atomic_load_n(&driver->trace.head, __ATOMIC_ACQUIRE);
+  size_t overwritten = 0;
+  if (new_head + 1 - tail > DMX_TRACE_EVENTS) {
+    overwritten = new_head + 1 - tail - DMX_TRACE_EVENTS;
+    if (overwritten > copied) {
+      overwritten = copied;
+    }
+    memmove(events, &events[overwritten],
+            (copied - overwritten) * sizeof(*events));
+  }
+  if (dropped != NULL) {
+    *dropped = lost + overwritten;
+  }
+
+  return copied - overwritten;
+#else
+  DMX_WARN("interrupt event tracing is disabled in the Kconfig");
+  if (dropped != NULL) {
+    *dropped = 0;
+  }
+  return 0;
+#endif
+}
+
+bool dmx_subscribe(dmx_port_t dmx_num, QueueHandle_t queue) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(queue != NULL, false, "queue is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Add the queue to the first free subscriber slot
+  bool ret = false;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  for (int i = 0; i < DMX_SUBSCRIBERS_MAX; ++i) {
+    if (driver->subscribers[i] == queue) {
+      ret = true;  // The queue is already subscribed
+      break;
+    } else if (driver->subscribers[i] == NULL) {
+      driver->subscribers[i] = queue;
+      ret = true;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(ret, false, "no subscriber slots available");
+
+  return ret;
+}
+
+bool dmx_unsubscribe(dmx_port_t dmx_num, QueueHandle_t queue) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(queue != NULL, false, "queue is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  bool ret = false;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  for (int i = 0; i < DMX_SUBSCRIBERS_MAX; ++i) {
+    if (driver->subscribers[i] == queue) {
+      driver->subscribers[i] = NULL;
+      ret = true;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return ret;
+}
+
+bool dmx_set_rx_callback(dmx_port_t dmx_num, dmx_rx_callback_t callback,
+                         void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->rx_callback = callback;
+  driver->rx_callback_context = context;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_set_sc_action(dmx_port_t dmx_num, int sc, dmx_sc_action_t action) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(sc >= 0 && sc <= 255, false, "sc error");
+  DMX_CHECK(!dmx_start_code_is_rdm(sc) || action == DMX_SC_ACTION_DELIVER,
+            false, "RDM start codes must be delivered");
+  DMX_CHECK(action >= DMX_SC_ACTION_DELIVER && action <= DMX_SC_ACTION_ROUTE,
+            false, "action error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const int shift = (sc & 15) * 2;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  uint32_t *const actions = &driver->sc_filter.actions[sc >> 4];
+  *actions = (*actions & ~(3 << shift)) | ((uint32_t)action << shift);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+dmx_sc_action_t dmx_get_sc_action(dmx_port_t dmx_num, int sc) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, DMX_SC_ACTION_DELIVER, "dmx_num error");
+  DMX_CHECK(sc >= 0 && sc <= 255, DMX_SC_ACTION_DELIVER, "sc error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), DMX_SC_ACTION_DELIVER,
+            "driver is not installed");
+
+  return DMX_SC_FILTER_GET(dmx_driver[dmx_num], sc);
+}
+
+bool dmx_set_sc_handler(dmx_port_t dmx_num, dmx_sc_handler_t handler,
+                        void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->sc_filter.handler = handler;
+  driver->sc_filter.context = context;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+void dmx_driver_get_state(const dmx_driver_t *driver,
+                          dmx_driver_state_t *state) {
+  assert(driver != NULL);
+  assert(state != NULL);
+
+  uint32_t seq;
+  do {
+    // Wait for any update which is in progress on the other core to finish
+    while ((seq = __atomic_load_n(&driver->dmx.seq, __ATOMIC_ACQUIRE)) & 1) {
+    }
+    state->head = driver->dmx.head;
+    state->size = driver->dmx.size;
+    state->status = driver->dmx.status;
+    state->progress = driver->dmx.progress;
+    state->controller_eop_timestamp = driver->dmx.controller_eop_timestamp;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (seq != __atomic_load_n(&driver->dmx.seq, __ATOMIC_RELAXED));
+}
+
 const rdm_uid_t *rdm_uid_get(dmx_port_t dmx_num) {
-  return dmx_driver_is_installed(dmx_num) ? &dmx_driver[dmx_num]->uid : NULL;
+  if (!dmx_driver_is_installed(dmx_num)) {
+    return NULL;
+  }
+  const dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const uint16_t selected = dmx_responder_get_selected(driver);
+  if (selected > 0) {
+    return &((const dmx_responder_t *)(driver->responders.table +
+                                       (selected - 1) *
+                                           driver->responders.stride))
+                ->uid;
+  }
+  return &driver->uid;
 }
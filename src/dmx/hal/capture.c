@@ -0,0 +1,232 @@
+#include "include/capture.h"
+
+#include "dmx/hal/include/timer.h"
+#include "dmx/include/service.h"
+#include "driver/gpio.h"
+#include "soc/soc_caps.h"
+
+#if ESP_IDF_VERSION_MAJOR >= 5 && SOC_MCPWM_SUPPORTED && \
+    !SOC_MCPWM_CAPTURE_CLK_FROM_GROUP
+#include "esp_private/esp_clk.h"
+#include "esp_private/periph_ctrl.h"
+#include "esp_rom_gpio.h"
+#include "hal/mcpwm_ll.h"
+#include "soc/mcpwm_periph.h"
+/** @brief This macro is defined when the target is able to timestamp the DMX
+ * sniffer edges using the MCPWM capture timer, which is clocked by the APB.*/
+#define DMX_CAPTURE_SUPPORTED
+#endif
+
+#ifdef DMX_CAPTURE_SUPPORTED
+#if defined(CONFIG_DMX_ISR_IN_IRAM)
+#define DMX_CAPTURE_INTR_FLAGS (ESP_INTR_FLAG_IRAM)
+#else
+#define DMX_CAPTURE_INTR_FLAGS (0)
+#endif
+
+enum {
+  DMX_CAPTURE_NEGEDGE = 0,  // The capture channel which latches falling edges.
+  DMX_CAPTURE_POSEDGE = 1,  // The capture channel which latches rising edges.
+
+  DMX_CAPTURE_NEGEDGE_INTR = MCPWM_LL_EVENT_CAPTURE(DMX_CAPTURE_NEGEDGE),
+  DMX_CAPTURE_POSEDGE_INTR = MCPWM_LL_EVENT_CAPTURE(DMX_CAPTURE_POSEDGE),
+  DMX_CAPTURE_INTR_ALL = DMX_CAPTURE_NEGEDGE_INTR | DMX_CAPTURE_POSEDGE_INTR,
+};
+
+static struct dmx_capture_t {
+  mcpwm_dev_t *const dev;
+  int owner;  // The DMX port which is using the MCPWM group, or -1 if unused.
+  int sniffer_pin;
+  intr_handle_t isr_handle;
+  uint32_t ticks_per_us;  // The number of capture timer ticks per microsecond.
+  uint32_t break_start;  // The capture timer value at the start of the DMX break.
+  uint32_t break_end;  // The capture timer value at the end of the DMX break.
+  int64_t break_timestamp;  // The timestamp in microseconds since boot of the start of the DMX break.
+} dmx_capture_context[SOC_MCPWM_GROUPS] = {
+    {.dev = MCPWM_LL_GET_HW(0), .owner = -1},
+#if SOC_MCPWM_GROUPS > 1
+    {.dev = MCPWM_LL_GET_HW(1), .owner = -1},
+#endif
+};
+
+static int dmx_capture_group[DMX_NUM_MAX] = {
+    -1,
+    -1,
+#if DMX_NUM_MAX > 2
+    -1,
+#endif
+};
+
+// Publishes the measured DMX break and mark-after-break to the sniffer. Must be
+// called from within a critical section.
+static void DMX_ISR_ATTR dmx_capture_publish(dmx_driver_t *const driver,
+                                             struct dmx_capture_t *capture,
+                                             uint32_t mab_end) {
+  driver->sniffer.buffer_index = !driver->sniffer.buffer_index;
+  dmx_metadata_t *const metadata =
+      &driver->sniffer.metadata[driver->sniffer.buffer_index];
+  metadata->break_len =
+      (capture->break_end - capture->break_start) / capture->ticks_per_us;
+  metadata->mab_len = (mab_end - capture->break_end) / capture->ticks_per_us;
+  metadata->break_timestamp = capture->break_timestamp;
+  dmx_sniffer_push(driver);
+}
+
+static void DMX_ISR_ATTR dmx_capture_isr(void *arg) {
+  dmx_driver_t *const driver = (dmx_driver_t *)arg;
+  const dmx_port_t dmx_num = driver->dmx_num;
+  struct dmx_capture_t *capture =
+      &dmx_capture_context[dmx_capture_group[dmx_num]];
+  mcpwm_dev_t *const dev = capture->dev;
+
+  const uint32_t intr_flags =
+      mcpwm_ll_intr_get_status(dev) & DMX_CAPTURE_INTR_ALL;
+  mcpwm_ll_intr_clear_status(dev, intr_flags);
+
+  taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  if (intr_flags & DMX_CAPTURE_POSEDGE_INTR) {
+    // The DMX break has ended
+    DMX_TRACE(driver, DMX_TRACE_GPIO_EDGE, 1,
+              dmx_timer_get_micros_since_boot());
+    capture->break_end = mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_POSEDGE);
+    mcpwm_ll_intr_enable(dev, DMX_CAPTURE_POSEDGE_INTR, false);
+
+    // The mark-after-break may have already ended if this ISR was delayed
+    const uint32_t negedge =
+        mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_NEGEDGE);
+    if (negedge - capture->break_start >
+        capture->break_end - capture->break_start) {
+      dmx_capture_publish(driver, capture, negedge);
+    } else {
+      mcpwm_ll_intr_clear_status(dev, DMX_CAPTURE_NEGEDGE_INTR);
+      mcpwm_ll_intr_enable(dev, DMX_CAPTURE_NEGEDGE_INTR, true);
+    }
+  } else if (intr_flags & DMX_CAPTURE_NEGEDGE_INTR) {
+    // The DMX mark-after-break has ended
+    DMX_TRACE(driver, DMX_TRACE_GPIO_EDGE, 0,
+              dmx_timer_get_micros_since_boot());
+    mcpwm_ll_intr_enable(dev, DMX_CAPTURE_NEGEDGE_INTR, false);
+    dmx_capture_publish(
+        driver, capture, mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_NEGEDGE));
+  }
+  taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+}
+#endif
+
+bool dmx_capture_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin) {
+#ifdef DMX_CAPTURE_SUPPORTED
+  // Find an MCPWM group which is not in use
+  int group = 0;
+  for (; group < SOC_MCPWM_GROUPS; ++group) {
+    if (dmx_capture_context[group].owner == -1) {
+      break;
+    }
+  }
+  if (group == SOC_MCPWM_GROUPS) {
+    return false;
+  }
+  struct dmx_capture_t *capture = &dmx_capture_context[group];
+  mcpwm_dev_t *const dev = capture->dev;
+
+  periph_module_enable(mcpwm_periph_signals.groups[group].module);
+  gpio_set_direction(sniffer_pin, GPIO_MODE_INPUT);
+
+  // Latch falling edges on one channel and rising edges on the other
+  mcpwm_ll_capture_enable_timer(dev, true);
+  const int channels[] = {DMX_CAPTURE_NEGEDGE, DMX_CAPTURE_POSEDGE};
+  for (int i = 0; i < sizeof(channels) / sizeof(channels[0]); ++i) {
+    const int channel = channels[i];
+    esp_rom_gpio_connect_in_signal(
+        sniffer_pin, mcpwm_periph_signals.groups[group].captures[channel].cap_sig,
+        false);
+    mcpwm_ll_capture_enable_channel(dev, channel, true);
+    mcpwm_ll_capture_set_prescale(dev, channel, 1);
+    mcpwm_ll_capture_enable_negedge(dev, channel,
+                                    channel == DMX_CAPTURE_NEGEDGE);
+    mcpwm_ll_capture_enable_posedge(dev, channel,
+                                    channel == DMX_CAPTURE_POSEDGE);
+  }
+
+  // Interrupts are only enabled while a DMX break or mark-after-break is read
+  mcpwm_ll_intr_enable(dev, DMX_CAPTURE_INTR_ALL, false);
+  mcpwm_ll_intr_clear_status(dev, DMX_CAPTURE_INTR_ALL);
+  if (esp_intr_alloc(mcpwm_periph_signals.groups[group].irq_id,
+                     DMX_CAPTURE_INTR_FLAGS, dmx_capture_isr, isr_context,
+                     &capture->isr_handle)) {
+    mcpwm_ll_capture_enable_timer(dev, false);
+    periph_module_disable(mcpwm_periph_signals.groups[group].module);
+    return false;
+  }
+
+  capture->ticks_per_us = esp_clk_apb_freq() / 1000000;
+  capture->sniffer_pin = sniffer_pin;
+  capture->owner = dmx_num;
+  dmx_capture_group[dmx_num] = group;
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+void dmx_capture_deinit(dmx_port_t dmx_num) {
+#ifdef DMX_CAPTURE_SUPPORTED
+  const int group = dmx_capture_group[dmx_num];
+  if (group == -1) {
+    return;
+  }
+  struct dmx_capture_t *capture = &dmx_capture_context[group];
+  mcpwm_dev_t *const dev = capture->dev;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  dmx_capture_group[dmx_num] = -1;
+  mcpwm_ll_intr_enable(dev, DMX_CAPTURE_INTR_ALL, false);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  esp_intr_free(capture->isr_handle);
+
+  const int channels[] = {DMX_CAPTURE_NEGEDGE, DMX_CAPTURE_POSEDGE};
+  for (int i = 0; i < sizeof(channels) / sizeof(channels[0]); ++i) {
+    const int channel = channels[i];
+    mcpwm_ll_capture_enable_channel(dev, channel, false);
+    esp_rom_gpio_connect_in_signal(
+        GPIO_MATRIX_CONST_ZERO_INPUT,
+        mcpwm_periph_signals.groups[group].captures[channel].cap_sig, false);
+  }
+  mcpwm_ll_capture_enable_timer(dev, false);
+  periph_module_disable(mcpwm_periph_signals.groups[group].module);
+  capture->sniffer_pin = -1;
+  capture->owner = -1;
+#endif
+}
+
+void DMX_ISR_ATTR dmx_capture_arm(dmx_port_t dmx_num, int64_t now) {
+#ifdef DMX_CAPTURE_SUPPORTED
+  const int group = dmx_capture_group[dmx_num];
+  if (group == -1) {
+    return;
+  }
+  struct dmx_capture_t *capture = &dmx_capture_context[group];
+  mcpwm_dev_t *const dev = capture->dev;
+
+  // The last falling edge was the start of the DMX break
+  const uint32_t break_start =
+      mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_NEGEDGE);
+  const uint32_t posedge = mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_POSEDGE);
+
+  // Latch the current capture timer value to convert it to a timestamp
+  mcpwm_ll_trigger_soft_capture(dev, DMX_CAPTURE_POSEDGE);
+  const uint32_t elapsed =
+      mcpwm_ll_capture_get_value(dev, DMX_CAPTURE_POSEDGE) - break_start;
+  capture->break_start = break_start;
+  capture->break_timestamp = now - elapsed / capture->ticks_per_us;
+
+  // Wait for the end of the DMX break unless it has already ended
+  mcpwm_ll_intr_clear_status(dev, DMX_CAPTURE_INTR_ALL);
+  if (posedge != break_start && posedge - break_start < elapsed) {
+    capture->break_end = posedge;
+    mcpwm_ll_intr_enable(dev, DMX_CAPTURE_NEGEDGE_INTR, true);
+  } else {
+    mcpwm_ll_intr_enable(dev, DMX_CAPTURE_POSEDGE_INTR, true);
+  }
+#endif
+}
@@ -0,0 +1,12 @@
+#include "dmx/hal/include/capture.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+
+bool dmx_capture_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin) {
+  return false;  // The DMX sniffer uses the simulated GPIO on the host
+}
+
+void dmx_capture_deinit(dmx_port_t dmx_num) {}
+
+void dmx_capture_arm(dmx_port_t dmx_num, int64_t now) {}
+#endif
@@ -0,0 +1,38 @@
+#include "dmx/hal/include/gpio.h"
+
+#include "dmx/hal/host/include/host.h"
+#include "dmx/include/isr.h"
+#include "dmx/include/service.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+
+static struct dmx_sim_gpio_t {
+  void *isr_context;  // The context of the DMX sniffer ISR, or NULL if unused.
+  int level;  // The level of the bus the DMX port is attached to.
+} dmx_sim_gpio[DMX_NUM_MAX] = {
+    {NULL, 1},
+    {NULL, 1},
+#if DMX_NUM_MAX > 2
+    {NULL, 1},
+#endif
+};
+
+void dmx_sim_gpio_edge(dmx_port_t dmx_num, int level) {
+  struct dmx_sim_gpio_t *gpio = &dmx_sim_gpio[dmx_num];
+  gpio->level = level;
+  if (gpio->isr_context != NULL) {
+    dmx_gpio_isr(gpio->isr_context);
+  }
+}
+
+bool dmx_gpio_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin) {
+  dmx_sim_gpio[dmx_num].isr_context = isr_context;
+  return true;
+}
+
+void dmx_gpio_deinit(dmx_port_t dmx_num) {
+  dmx_sim_gpio[dmx_num].isr_context = NULL;
+}
+
+int dmx_gpio_read(dmx_port_t dmx_num) { return dmx_sim_gpio[dmx_num].level; }
+#endif
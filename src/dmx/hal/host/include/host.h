@@ -0,0 +1,37 @@
+/**
+ * @file dmx/hal/host/include/host.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the functions which are shared between the modules
+ * of the host Hardware Abstraction Layer (HAL) of esp_dmx. This file is not
+ * considered part of the API and should not be included by the user.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Advances the simulated timers by one microsecond and calls the DMX
+ * timer ISR of each timer whose alarm is reached. Must be called from within
+ * the simulation's critical section.
+ */
+void dmx_sim_timer_tick();
+
+/**
+ * @brief Notifies the simulated GPIO that the level of a DMX port's bus has
+ * changed. The DMX sniffer ISR is called if the DMX port's sniffer is enabled.
+ * Must be called from within the simulation's critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @param level The new level of the bus.
+ */
+void dmx_sim_gpio_edge(dmx_port_t dmx_num, int level);
+
+#ifdef __cplusplus
+}
+#endif
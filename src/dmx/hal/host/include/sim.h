@@ -0,0 +1,120 @@
+/**
+ * @file dmx/hal/host/include/sim.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file is the interface to the host Hardware Abstraction Layer
+ * (HAL) of esp_dmx. The host HAL replaces the UART, timer, GPIO, and NVS
+ * hardware with an in-memory simulation of an RS-485 bus which is driven by a
+ * virtual clock. It allows the DMX and RDM logic of this library to be
+ * benchmarked and fuzzed on the ESP-IDF linux target. This file should only be
+ * included by test harnesses.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The RDM device ID used by the DMX driver on the host. The DMX port
+ * number is added to the device ID so that each port has a unique UID.*/
+#define DMX_SIM_DEVICE_ID (0x00000100)
+
+/** @brief The number of simulated RS-485 buses. Each DMX port is attached to
+ * exactly one bus.*/
+#define DMX_SIM_BUS_MAX (DMX_NUM_MAX)
+
+/** @brief The events which may be observed on a simulated bus.*/
+typedef enum dmx_sim_event_t {
+  DMX_SIM_EVENT_BREAK,  // A DMX break has started on the bus.
+  DMX_SIM_EVENT_MARK,   // The bus has returned to the mark state.
+  DMX_SIM_EVENT_SLOT,   // A slot has been sent on the bus.
+  DMX_SIM_EVENT_COLLISION,  // Slots from multiple devices collided on the bus.
+} dmx_sim_event_t;
+
+/**
+ * @brief A function which is called for each event that occurs on a simulated
+ * bus. It is called from the context of dmx_sim_advance().
+ *
+ * @param bus The bus on which the event occurred.
+ * @param event The event which occurred.
+ * @param value The value of the slot for DMX_SIM_EVENT_SLOT, otherwise 0.
+ * @param timestamp The virtual time of the event in microseconds.
+ * @param[in] context The context which was passed to dmx_sim_set_monitor().
+ */
+typedef void (*dmx_sim_monitor_t)(int bus, dmx_sim_event_t event,
+                                  uint8_t value, int64_t timestamp,
+                                  void *context);
+
+/**
+ * @brief Gets the current virtual time. This is the time returned by the DMX
+ * driver's timer HAL.
+ *
+ * @return The virtual time in microseconds.
+ */
+int64_t dmx_sim_get_time();
+
+/**
+ * @brief Advances the virtual clock. Slots on each bus are moved between the
+ * simulated UARTs, timer alarms are fired, and the DMX interrupt handlers are
+ * called exactly as they would be on the hardware. This function should be
+ * called from a dedicated task which has a higher priority than the tasks
+ * which use the DMX driver.
+ *
+ * @param us The number of microseconds to advance the virtual clock.
+ */
+void dmx_sim_advance(uint32_t us);
+
+/**
+ * @brief Attaches a DMX port to a simulated bus. All DMX ports are attached to
+ * bus 0 by default, so that they may communicate with each other.
+ *
+ * @param dmx_num The DMX port number.
+ * @param bus The bus to attach the DMX port to.
+ * @return true on success.
+ * @return false if the bus number is invalid.
+ */
+bool dmx_sim_set_bus(dmx_port_t dmx_num, int bus);
+
+/**
+ * @brief Sends a packet on a simulated bus from a virtual device which is not
+ * a DMX port. The packet is sent the next time the bus is idle. This may be
+ * used to fuzz the DMX driver with arbitrary packets.
+ *
+ * @param bus The bus to send the packet on.
+ * @param[in] data The slots of the packet, beginning with the start code.
+ * @param size The number of slots to send.
+ * @param break_len The length of the DMX break in microseconds to send before
+ * the packet, or 0 to not send a DMX break.
+ * @param mab_len The length of the DMX mark-after-break in microseconds.
+ * @return true if the packet was queued.
+ * @return false if the bus number is invalid or there is not enough space to
+ * queue the packet.
+ */
+bool dmx_sim_inject(int bus, const void *data, size_t size, uint32_t break_len,
+                    uint32_t mab_len);
+
+/**
+ * @brief Sets a function to be called for each event on a simulated bus. This
+ * may be used to capture the packets which are sent by the DMX driver.
+ *
+ * @param bus The bus to monitor.
+ * @param monitor The function to call, or NULL to stop monitoring the bus.
+ * @param[in] context A context to pass to the monitor function.
+ * @return true on success.
+ * @return false if the bus number is invalid.
+ */
+bool dmx_sim_set_monitor(int bus, dmx_sim_monitor_t monitor, void *context);
+
+/**
+ * @brief Erases the simulated NVS of all DMX ports.
+ */
+void dmx_sim_nvs_erase();
+
+#ifdef __cplusplus
+}
+#endif
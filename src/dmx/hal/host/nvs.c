@@ -0,0 +1,145 @@
+#include "dmx/hal/include/nvs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx/hal/host/include/sim.h"
+#include "dmx/include/service.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+
+// A parameter stored in the simulated NVS.
+struct dmx_sim_nvs_entry_t {
+  struct dmx_sim_nvs_entry_t *next;
+  dmx_port_t dmx_num;
+  rdm_sub_device_t sub_device;
+  rdm_pid_t pid;
+  size_t size;
+  uint8_t data[];
+};
+
+static struct dmx_sim_nvs_entry_t *dmx_sim_nvs = NULL;
+static SemaphoreHandle_t dmx_sim_nvs_mux = NULL;
+static dmx_spinlock_t dmx_sim_nvs_spinlock = DMX_SPINLOCK_INIT;
+
+static struct dmx_sim_nvs_entry_t **dmx_sim_nvs_find(
+    dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid) {
+  struct dmx_sim_nvs_entry_t **entry = &dmx_sim_nvs;
+  for (; *entry != NULL; entry = &(*entry)->next) {
+    if ((*entry)->dmx_num == dmx_num && (*entry)->sub_device == sub_device &&
+        (*entry)->pid == pid) {
+      break;
+    }
+  }
+  return entry;
+}
+
+void dmx_sim_nvs_erase() {
+  if (dmx_sim_nvs_mux == NULL) {
+    return;
+  }
+  xSemaphoreTake(dmx_sim_nvs_mux, portMAX_DELAY);
+  while (dmx_sim_nvs != NULL) {
+    struct dmx_sim_nvs_entry_t *next = dmx_sim_nvs->next;
+    free(dmx_sim_nvs);
+    dmx_sim_nvs = next;
+  }
+  xSemaphoreGive(dmx_sim_nvs_mux);
+}
+
+void dmx_nvs_init(dmx_port_t dmx_num) {
+  // The mutex is created outside of the critical section
+  SemaphoreHandle_t mux = xSemaphoreCreateMutex();
+  taskENTER_CRITICAL(&dmx_sim_nvs_spinlock);
+  if (dmx_sim_nvs_mux == NULL) {
+    dmx_sim_nvs_mux = mux;
+    mux = NULL;
+  }
+  taskEXIT_CRITICAL(&dmx_sim_nvs_spinlock);
+  if (mux != NULL) {
+    vSemaphoreDelete(mux);
+  }
+}
+
+void dmx_nvs_deinit(dmx_port_t dmx_num) {}
+
+size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                   rdm_pid_t pid, void *param, size_t size) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(pid > 0);
+  assert(sub_device < RDM_SUB_DEVICE_MAX + RDM_VIRTUAL_RESPONDER_MAX);
+  assert(param != NULL);
+
+  if (size == 0 || dmx_sim_nvs_mux == NULL) {
+    return 0;
+  }
+
+  xSemaphoreTake(dmx_sim_nvs_mux, portMAX_DELAY);
+  const struct dmx_sim_nvs_entry_t *entry =
+      *dmx_sim_nvs_find(dmx_num, sub_device, pid);
+  if (entry == NULL || entry->size > size) {
+    size = 0;
+  } else {
+    size = entry->size;
+    memcpy(param, entry->data, size);
+  }
+  xSemaphoreGive(dmx_sim_nvs_mux);
+
+  return size;
+}
+
+bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid,
+                 const void *param, size_t size) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(pid > 0);
+  assert(sub_device < RDM_SUB_DEVICE_MAX + RDM_VIRTUAL_RESPONDER_MAX);
+  assert(param != NULL);
+
+  if (size == 0) {
+    return true;
+  } else if (dmx_sim_nvs_mux == NULL) {
+    return false;
+  }
+
+  xSemaphoreTake(dmx_sim_nvs_mux, portMAX_DELAY);
+  struct dmx_sim_nvs_entry_t **entry =
+      dmx_sim_nvs_find(dmx_num, sub_device, pid);
+  if (*entry != NULL && (*entry)->size != size) {
+    // Replace the entry because its size has changed
+    struct dmx_sim_nvs_entry_t *next = (*entry)->next;
+    free(*entry);
+    *entry = next;
+    entry = dmx_sim_nvs_find(dmx_num, sub_device, pid);
+  }
+  if (*entry == NULL) {
+    *entry = malloc(sizeof(**entry) + size);
+    if (*entry != NULL) {
+      (*entry)->next = NULL;
+      (*entry)->dmx_num = dmx_num;
+      (*entry)->sub_device = sub_device;
+      (*entry)->pid = pid;
+      (*entry)->size = size;
+    }
+  }
+  const bool success = (*entry != NULL);
+  if (success) {
+    memcpy((*entry)->data, param, size);
+  }
+  xSemaphoreGive(dmx_sim_nvs_mux);
+
+  return success;
+}
+
+bool dmx_nvs_set_batch(dmx_port_t dmx_num, const dmx_nvs_item_t *items,
+                       size_t count) {
+  assert(items != NULL || count == 0);
+
+  bool success = true;
+  for (size_t i = 0; i < count && success; ++i) {
+    success = dmx_nvs_set(dmx_num, items[i].sub_device, items[i].pid,
+                          items[i].param, items[i].size);
+  }
+
+  return success;
+}
+#endif
@@ -0,0 +1,83 @@
+#include "dmx/hal/include/timer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx/hal/host/include/host.h"
+#include "dmx/hal/host/include/sim.h"
+#include "dmx/include/isr.h"
+#include "dmx/include/service.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+
+static struct dmx_sim_timer_t {
+  void *isr_context;  // The context of the DMX timer ISR, or NULL if unused.
+  bool is_running;
+  bool alarm_is_enabled;  // False once a one-shot alarm has fired.
+  bool auto_reload;
+  uint64_t counter;  // The timer counter in microseconds.
+  uint64_t alarm;  // The timer alarm in microseconds.
+} dmx_sim_timer[DMX_NUM_MAX] = {};
+
+void dmx_sim_timer_tick() {
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    struct dmx_sim_timer_t *timer = &dmx_sim_timer[i];
+    if (timer->isr_context == NULL || !timer->is_running) {
+      continue;
+    }
+    ++timer->counter;
+    if (timer->alarm_is_enabled && timer->counter >= timer->alarm) {
+      if (timer->auto_reload) {
+        timer->counter = 0;
+      } else {
+        timer->alarm_is_enabled = false;
+      }
+      dmx_timer_isr(timer->isr_context);
+    }
+  }
+}
+
+bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+  struct dmx_sim_timer_t *timer = &dmx_sim_timer[dmx_num];
+  timer->is_running = false;
+  timer->alarm_is_enabled = false;
+  timer->auto_reload = false;
+  timer->counter = 0;
+  timer->alarm = 0;
+  timer->isr_context = isr_context;
+
+  return true;
+}
+
+void dmx_timer_deinit(dmx_port_t dmx_num) {
+  struct dmx_sim_timer_t *timer = &dmx_sim_timer[dmx_num];
+  timer->isr_context = NULL;
+  timer->is_running = false;
+}
+
+void dmx_timer_stop(dmx_port_t dmx_num) {
+  struct dmx_sim_timer_t *timer = &dmx_sim_timer[dmx_num];
+  if (timer->is_running) {
+    timer->counter = 0;
+    timer->is_running = false;
+  }
+}
+
+void dmx_timer_set_counter(dmx_port_t dmx_num, uint64_t counter) {
+  dmx_sim_timer[dmx_num].counter = counter;
+}
+
+void dmx_timer_set_alarm(dmx_port_t dmx_num, uint64_t alarm,
+                         bool auto_reload) {
+  struct dmx_sim_timer_t *timer = &dmx_sim_timer[dmx_num];
+  timer->alarm = alarm;
+  timer->auto_reload = auto_reload;
+  timer->alarm_is_enabled = true;
+}
+
+void dmx_timer_start(dmx_port_t dmx_num) {
+  dmx_sim_timer[dmx_num].is_running = true;
+}
+
+int64_t dmx_timer_get_micros_since_boot() { return dmx_sim_get_time(); }
+#endif
@@ -0,0 +1,506 @@
+#include "dmx/hal/include/uart.h"
+
+#include <string.h>
+
+#include "dmx/hal/host/include/host.h"
+#include "dmx/hal/host/include/sim.h"
+#include "dmx/include/isr.h"
+#include "dmx/include/service.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+
+#define DMX_SIM_FIFO_LEN 128  // The size of the simulated UART FIFOs.
+#define DMX_SIM_TXFIFO_EMPTY_THR 8  // The TX FIFO length which raises an interrupt.
+#define DMX_SIM_RX_TOUT_SLOTS 2  // Idle slot times which flush the RX FIFO.
+#define DMX_SIM_SLOT_BITS 11  // One start bit, eight data bits, two stop bits.
+#define DMX_SIM_INJECT_QUEUE_LEN 4  // The number of packets which may be injected.
+#define DMX_SIM_INJECT_SIZE_MAX 1024  // The maximum size of an injected packet.
+#define DMX_SIM_CLOCK_START 1000000  // The virtual time at boot.
+
+enum {
+  DMX_SIM_TX_IDLE = 0,  // The transmitter is not sending.
+  DMX_SIM_TX_SLOT,      // The transmitter is sending a slot.
+  DMX_SIM_TX_BREAK,     // The transmitter is sending a UART break.
+  DMX_SIM_TX_MAB,       // The transmitter is sending a UART mark-after-break.
+};
+
+// The state of a device which is able to drive a simulated bus.
+struct dmx_sim_tx_t {
+  int state;  // The state of the transmitter.
+  uint32_t elapsed;  // The microseconds elapsed in the current state.
+  uint32_t duration;  // The duration in microseconds of the current state.
+  uint8_t slot;  // The value of the slot being sent.
+  bool collided;  // True if another device drove the bus during this slot.
+};
+
+static struct dmx_sim_uart_t {
+  bool is_installed;
+  void *isr_context;
+  int bus;  // The simulated bus the UART is attached to.
+
+  uint32_t intr_raw;
+  uint32_t intr_ena;
+  uint32_t baud_rate;
+  int invert_tx;
+  int rts;  // 1 if the RS-485 receiver is enabled, 0 if the driver is enabled.
+  int break_bits;  // The length of the UART break to send after the TX FIFO.
+  int idle_bits;  // The length of the UART mark-after-break.
+
+  uint8_t rx_fifo[DMX_SIM_FIFO_LEN];
+  int rx_read;  // The index of the next slot to read from the RX FIFO.
+  int rx_len;  // The number of slots in the RX FIFO.
+  int rx_threshold;  // The RX FIFO length which raises an interrupt.
+  bool rx_tout_en;  // True if the RX FIFO timeout interrupt is enabled.
+  uint32_t rx_idle;  // The microseconds since the RX FIFO last received slots.
+  uint32_t rx_low;  // The microseconds that the bus has been low.
+
+  uint8_t tx_fifo[DMX_SIM_FIFO_LEN];
+  int tx_read;  // The index of the next slot to send from the TX FIFO.
+  int tx_len;  // The number of slots in the TX FIFO.
+  bool tx_was_sending;  // True if the transmitter just sent a slot.
+  struct dmx_sim_tx_t tx;
+} dmx_sim_uart[DMX_NUM_MAX] = {};
+
+static struct dmx_sim_bus_t {
+  int level;  // The level of the bus during the last microsecond.
+  dmx_sim_monitor_t monitor;
+  void *monitor_context;
+
+  // A virtual device which sends injected packets
+  struct dmx_sim_inject_t {
+    uint32_t break_len;
+    uint32_t mab_len;
+    size_t size;
+    uint8_t data[DMX_SIM_INJECT_SIZE_MAX];
+  } queue[DMX_SIM_INJECT_QUEUE_LEN];
+  int queue_read;
+  int queue_len;
+  size_t inject_head;  // The index of the next injected slot to send.
+  struct dmx_sim_tx_t inject;
+} dmx_sim_bus[DMX_SIM_BUS_MAX] = {};
+
+static int64_t dmx_sim_now = DMX_SIM_CLOCK_START;
+static dmx_spinlock_t dmx_sim_spinlock = DMX_SPINLOCK_INIT;
+
+static uint32_t dmx_sim_bits_to_us(const struct dmx_sim_uart_t *uart,
+                                   uint32_t bits) {
+  return (bits * 1000000 + uart->baud_rate / 2) / uart->baud_rate;
+}
+
+static void dmx_sim_notify(int bus, dmx_sim_event_t event, uint8_t value) {
+  if (dmx_sim_bus[bus].monitor != NULL) {
+    dmx_sim_bus[bus].monitor(bus, event, value, dmx_sim_now,
+                             dmx_sim_bus[bus].monitor_context);
+  }
+}
+
+// Returns the level that a transmitter is driving onto the bus.
+static int dmx_sim_tx_level(const struct dmx_sim_tx_t *tx, uint32_t bit_us) {
+  if (tx->state == DMX_SIM_TX_BREAK) {
+    return 0;
+  } else if (tx->state == DMX_SIM_TX_SLOT) {
+    return tx->elapsed >= bit_us;  // Only the start bit is low
+  }
+  return 1;
+}
+
+// Delivers a slot which was sent on a bus to each listening UART on the bus.
+static void dmx_sim_deliver(int bus, uint8_t slot, bool collided) {
+  dmx_sim_notify(bus, collided ? DMX_SIM_EVENT_COLLISION : DMX_SIM_EVENT_SLOT,
+                 slot);
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    struct dmx_sim_uart_t *uart = &dmx_sim_uart[i];
+    if (!uart->is_installed || uart->bus != bus || uart->rts == 0) {
+      continue;
+    }
+    if (collided) {
+      uart->intr_raw |= UART_INTR_FRAM_ERR;
+    }
+    if (uart->rx_len == DMX_SIM_FIFO_LEN) {
+      uart->intr_raw |= UART_INTR_RXFIFO_OVF;
+      continue;
+    }
+    uart->rx_fifo[(uart->rx_read + uart->rx_len) % DMX_SIM_FIFO_LEN] = slot;
+    ++uart->rx_len;
+    uart->rx_idle = 0;
+    if (uart->rx_len >= uart->rx_threshold) {
+      uart->intr_raw |= UART_INTR_RXFIFO_FULL;
+    }
+  }
+}
+
+// Advances a UART's transmitter by one microsecond.
+static void dmx_sim_uart_tx_tick(struct dmx_sim_uart_t *uart) {
+  struct dmx_sim_tx_t *tx = &uart->tx;
+  if (tx->state != DMX_SIM_TX_IDLE && ++tx->elapsed < tx->duration) {
+    return;
+  }
+
+  switch (tx->state) {
+    case DMX_SIM_TX_SLOT:
+      if (uart->rts == 0) {
+        dmx_sim_deliver(uart->bus, tx->slot, tx->collided);
+      }
+      uart->tx_was_sending = true;
+      break;
+    case DMX_SIM_TX_BREAK:
+      tx->state = DMX_SIM_TX_MAB;
+      tx->elapsed = 0;
+      tx->duration = dmx_sim_bits_to_us(uart, uart->idle_bits);
+      if (tx->duration > 0) {
+        return;
+      }
+      // Fall through
+    case DMX_SIM_TX_MAB:
+      uart->intr_raw |= UART_INTR_TX_BRK_IDLE;
+      break;
+  }
+  tx->state = DMX_SIM_TX_IDLE;
+
+  // Start sending the next slot in the TX FIFO
+  if (uart->tx_len > 0) {
+    tx->state = DMX_SIM_TX_SLOT;
+    tx->elapsed = 0;
+    tx->duration = dmx_sim_bits_to_us(uart, DMX_SIM_SLOT_BITS);
+    tx->slot = uart->tx_fifo[uart->tx_read];
+    tx->collided = false;
+    uart->tx_read = (uart->tx_read + 1) % DMX_SIM_FIFO_LEN;
+    --uart->tx_len;
+  } else if (uart->tx_was_sending) {
+    uart->tx_was_sending = false;
+    uart->intr_raw |= UART_INTR_TX_DONE;
+    if (uart->break_bits > 0) {
+      tx->state = DMX_SIM_TX_BREAK;
+      tx->elapsed = 0;
+      tx->duration = dmx_sim_bits_to_us(uart, uart->break_bits);
+    }
+  }
+}
+
+// Advances the virtual device which sends injected packets by one microsecond.
+static void dmx_sim_inject_tick(struct dmx_sim_bus_t *bus, int bus_num,
+                                bool bus_is_idle) {
+  struct dmx_sim_tx_t *tx = &bus->inject;
+  if (tx->state == DMX_SIM_TX_IDLE) {
+    if (bus->queue_len == 0 || !bus_is_idle) {
+      return;  // Wait for the bus to be idle before sending
+    }
+    bus->inject_head = 0;
+    tx->state = DMX_SIM_TX_BREAK;
+    tx->elapsed = 0;
+    tx->duration = bus->queue[bus->queue_read].break_len;
+    if (tx->duration > 0) {
+      return;
+    }
+  } else if (++tx->elapsed < tx->duration) {
+    return;
+  }
+
+  const struct dmx_sim_inject_t *packet = &bus->queue[bus->queue_read];
+  if (tx->state == DMX_SIM_TX_SLOT) {
+    dmx_sim_deliver(bus_num, tx->slot, tx->collided);
+  } else if (tx->state == DMX_SIM_TX_BREAK) {
+    tx->state = DMX_SIM_TX_MAB;
+    tx->elapsed = 0;
+    tx->duration = packet->mab_len;
+    if (tx->duration > 0) {
+      return;
+    }
+  }
+
+  // Send the next injected slot or finish the packet
+  if (bus->inject_head < packet->size) {
+    tx->state = DMX_SIM_TX_SLOT;
+    tx->elapsed = 0;
+    tx->duration = DMX_SIM_SLOT_BITS * 1000000 / DMX_BAUD_RATE;
+    tx->slot = packet->data[bus->inject_head];
+    tx->collided = false;
+    ++bus->inject_head;
+  } else {
+    tx->state = DMX_SIM_TX_IDLE;
+    bus->queue_read = (bus->queue_read + 1) % DMX_SIM_INJECT_QUEUE_LEN;
+    --bus->queue_len;
+  }
+}
+
+// Advances the simulation by one microsecond. Must be called from within the
+// simulation's critical section.
+static void dmx_sim_tick() {
+  ++dmx_sim_now;
+
+  // Advance each transmitter
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    if (dmx_sim_uart[i].is_installed) {
+      dmx_sim_uart_tx_tick(&dmx_sim_uart[i]);
+    }
+  }
+  for (int b = 0; b < DMX_SIM_BUS_MAX; ++b) {
+    struct dmx_sim_bus_t *bus = &dmx_sim_bus[b];
+
+    // Determine which devices are driving the bus
+    int level = 1;
+    int senders = 0;
+    struct dmx_sim_tx_t *txs[DMX_NUM_MAX + 1];
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      struct dmx_sim_uart_t *uart = &dmx_sim_uart[i];
+      if (!uart->is_installed || uart->bus != b || uart->rts != 0) {
+        continue;
+      }
+      const uint32_t bit_us = dmx_sim_bits_to_us(uart, 1);
+      level &= !uart->invert_tx && dmx_sim_tx_level(&uart->tx, bit_us);
+      if (uart->tx.state == DMX_SIM_TX_SLOT) {
+        txs[senders++] = &uart->tx;
+      }
+    }
+    dmx_sim_inject_tick(bus, b, level && senders == 0 && bus->level);
+    level &= dmx_sim_tx_level(&bus->inject, 1000000 / DMX_BAUD_RATE);
+    if (bus->inject.state == DMX_SIM_TX_SLOT) {
+      txs[senders++] = &bus->inject;
+    }
+    if (senders > 1) {
+      for (int i = 0; i < senders; ++i) {
+        txs[i]->collided = true;
+      }
+    }
+
+    // Report changes to the level of the bus
+    if (level != bus->level) {
+      bus->level = level;
+      for (int i = 0; i < DMX_NUM_MAX; ++i) {
+        if (dmx_sim_uart[i].is_installed && dmx_sim_uart[i].bus == b) {
+          dmx_sim_gpio_edge(i, level);
+        }
+      }
+      if (senders == 0) {
+        dmx_sim_notify(b, level ? DMX_SIM_EVENT_MARK : DMX_SIM_EVENT_BREAK, 0);
+      }
+    }
+  }
+
+  // Advance each receiver
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    struct dmx_sim_uart_t *uart = &dmx_sim_uart[i];
+    if (!uart->is_installed) {
+      continue;
+    }
+    if (uart->rts != 0) {
+      // The UART detects a break when the bus is low for longer than a slot
+      if (dmx_sim_bus[uart->bus].level == 0) {
+        if (++uart->rx_low == dmx_sim_bits_to_us(uart, DMX_SIM_SLOT_BITS)) {
+          if (uart->rx_len < DMX_SIM_FIFO_LEN) {
+            uart->rx_fifo[(uart->rx_read + uart->rx_len) % DMX_SIM_FIFO_LEN] =
+                0;
+            ++uart->rx_len;
+          }
+          uart->intr_raw |= UART_INTR_BRK_DET;
+        }
+      } else {
+        uart->rx_low = 0;
+      }
+      if (uart->rx_tout_en && uart->rx_len > 0 &&
+          ++uart->rx_idle ==
+              dmx_sim_bits_to_us(uart, DMX_SIM_RX_TOUT_SLOTS *
+                                           DMX_SIM_SLOT_BITS)) {
+        uart->intr_raw |= UART_INTR_RXFIFO_TOUT;
+      }
+    }
+    if (uart->tx_len < DMX_SIM_TXFIFO_EMPTY_THR) {
+      uart->intr_raw |= UART_INTR_TXFIFO_EMPTY;
+    }
+  }
+
+  // Call the interrupt handlers
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    struct dmx_sim_uart_t *uart = &dmx_sim_uart[i];
+    if (uart->is_installed && (uart->intr_raw & uart->intr_ena)) {
+      dmx_uart_isr(uart->isr_context);
+    }
+  }
+  dmx_sim_timer_tick();
+}
+
+int64_t dmx_sim_get_time() { return dmx_sim_now; }
+
+void dmx_sim_advance(uint32_t us) {
+  for (uint32_t i = 0; i < us; ++i) {
+    taskENTER_CRITICAL(&dmx_sim_spinlock);
+    dmx_sim_tick();
+    taskEXIT_CRITICAL(&dmx_sim_spinlock);
+  }
+}
+
+bool dmx_sim_set_bus(dmx_port_t dmx_num, int bus) {
+  if (dmx_num >= DMX_NUM_MAX || bus < 0 || bus >= DMX_SIM_BUS_MAX) {
+    return false;
+  }
+  taskENTER_CRITICAL(&dmx_sim_spinlock);
+  dmx_sim_uart[dmx_num].bus = bus;
+  taskEXIT_CRITICAL(&dmx_sim_spinlock);
+  return true;
+}
+
+bool dmx_sim_inject(int bus, const void *data, size_t size, uint32_t break_len,
+                    uint32_t mab_len) {
+  if (bus < 0 || bus >= DMX_SIM_BUS_MAX || data == NULL ||
+      size > DMX_SIM_INJECT_SIZE_MAX) {
+    return false;
+  }
+  struct dmx_sim_bus_t *b = &dmx_sim_bus[bus];
+  bool is_queued = false;
+  taskENTER_CRITICAL(&dmx_sim_spinlock);
+  if (b->queue_len < DMX_SIM_INJECT_QUEUE_LEN) {
+    struct dmx_sim_inject_t *packet =
+        &b->queue[(b->queue_read + b->queue_len) % DMX_SIM_INJECT_QUEUE_LEN];
+    packet->break_len = break_len;
+    packet->mab_len = mab_len;
+    packet->size = size;
+    memcpy(packet->data, data, size);
+    ++b->queue_len;
+    is_queued = true;
+  }
+  taskEXIT_CRITICAL(&dmx_sim_spinlock);
+  return is_queued;
+}
+
+bool dmx_sim_set_monitor(int bus, dmx_sim_monitor_t monitor, void *context) {
+  if (bus < 0 || bus >= DMX_SIM_BUS_MAX) {
+    return false;
+  }
+  taskENTER_CRITICAL(&dmx_sim_spinlock);
+  dmx_sim_bus[bus].monitor = monitor;
+  dmx_sim_bus[bus].monitor_context = context;
+  taskEXIT_CRITICAL(&dmx_sim_spinlock);
+  return true;
+}
+
+bool dmx_uart_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  const int bus = uart->bus;
+  taskENTER_CRITICAL(&dmx_sim_spinlock);
+  memset(uart, 0, sizeof(*uart));
+  uart->bus = bus;
+  uart->isr_context = isr_context;
+  uart->baud_rate = DMX_BAUD_RATE;
+  uart->rts = 1;
+  uart->rx_threshold = 1;
+  uart->is_installed = true;
+  dmx_sim_bus[bus].level = 1;
+  taskEXIT_CRITICAL(&dmx_sim_spinlock);
+  return true;
+}
+
+void dmx_uart_deinit(dmx_port_t dmx_num) {
+  taskENTER_CRITICAL(&dmx_sim_spinlock);
+  dmx_sim_uart[dmx_num].is_installed = false;
+  taskEXIT_CRITICAL(&dmx_sim_spinlock);
+}
+
+bool dmx_uart_set_pin(dmx_port_t dmx_num, int tx, int rx, int rts) {
+  return true;  // The simulated UART is always attached to its bus
+}
+
+uint32_t dmx_uart_get_baud_rate(dmx_port_t dmx_num) {
+  return dmx_sim_uart[dmx_num].baud_rate;
+}
+
+void dmx_uart_set_baud_rate(dmx_port_t dmx_num, uint32_t baud_rate) {
+  dmx_sim_uart[dmx_num].baud_rate = baud_rate;
+}
+
+void dmx_uart_invert_tx(dmx_port_t dmx_num, int invert) {
+  dmx_sim_uart[dmx_num].invert_tx = invert;
+}
+
+int dmx_uart_get_rts(dmx_port_t dmx_num) { return dmx_sim_uart[dmx_num].rts; }
+
+void dmx_uart_set_tx_break(dmx_port_t dmx_num, int break_bits, int mab_bits) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  uart->break_bits = break_bits;
+  uart->idle_bits = break_bits > 0 ? mab_bits : 0;
+}
+
+int dmx_uart_get_interrupt_status(dmx_port_t dmx_num) {
+  const struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  return uart->intr_raw & uart->intr_ena;
+}
+
+void dmx_uart_enable_interrupt(dmx_port_t dmx_num, int mask) {
+  dmx_sim_uart[dmx_num].intr_ena |= mask;
+}
+
+void dmx_uart_disable_interrupt(dmx_port_t dmx_num, int mask) {
+  dmx_sim_uart[dmx_num].intr_ena &= ~mask;
+}
+
+void dmx_uart_clear_interrupt(dmx_port_t dmx_num, int mask) {
+  dmx_sim_uart[dmx_num].intr_raw &= ~mask;
+}
+
+uint32_t dmx_uart_get_rxfifo_len(dmx_port_t dmx_num) {
+  return dmx_sim_uart[dmx_num].rx_len;
+}
+
+void dmx_uart_read_rxfifo(dmx_port_t dmx_num, uint8_t *buf, int *size) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  if (*size > uart->rx_len) {
+    *size = uart->rx_len;
+  }
+  for (int i = 0; i < *size; ++i) {
+    buf[i] = uart->rx_fifo[uart->rx_read];
+    uart->rx_read = (uart->rx_read + 1) % DMX_SIM_FIFO_LEN;
+  }
+  uart->rx_len -= *size;
+}
+
+void dmx_uart_set_rts(dmx_port_t dmx_num, int set) {
+  dmx_sim_uart[dmx_num].rts = set;
+}
+
+void dmx_uart_set_rx_threshold(dmx_port_t dmx_num, int threshold) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  uart->rx_threshold = threshold;
+  uart->rx_tout_en = threshold > 1;
+}
+
+void dmx_uart_rxfifo_reset(dmx_port_t dmx_num) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  uart->rx_read = 0;
+  uart->rx_len = 0;
+}
+
+uint32_t dmx_uart_get_txfifo_len(dmx_port_t dmx_num) {
+  return DMX_SIM_FIFO_LEN - dmx_sim_uart[dmx_num].tx_len;
+}
+
+void dmx_uart_write_txfifo(dmx_port_t dmx_num, const void *buf, int *size) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  const int txfifo_len = DMX_SIM_FIFO_LEN - uart->tx_len;
+  if (*size > txfifo_len) *size = txfifo_len;
+  for (int i = 0; i < *size; ++i) {
+    uart->tx_fifo[(uart->tx_read + uart->tx_len) % DMX_SIM_FIFO_LEN] =
+        ((const uint8_t *)buf)[i];
+    ++uart->tx_len;
+  }
+}
+
+void dmx_uart_txfifo_reset(dmx_port_t dmx_num) {
+  struct dmx_sim_uart_t *uart = &dmx_sim_uart[dmx_num];
+  uart->tx_read = 0;
+  uart->tx_len = 0;
+}
+
+bool dmx_uart_dma_init(dmx_port_t dmx_num) {
+  return false;  // The host does not simulate DMA
+}
+
+void dmx_uart_dma_deinit(dmx_port_t dmx_num) {}
+
+void dmx_uart_dma_write(dmx_port_t dmx_num, const void *buf, int size) {}
+
+bool dmx_uart_dma_rx_init(dmx_port_t dmx_num, void *isr_context, void *buf,
+                          int size) {
+  return false;  // The host does not simulate DMA
+}
+
+void dmx_uart_dma_stop(dmx_port_t dmx_num) {}
+#endif
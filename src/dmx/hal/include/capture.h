@@ -0,0 +1,52 @@
+/**
+ * @file dmx/hal/include/capture.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file is the capture Hardware Abstraction Layer (HAL) of esp_dmx.
+ * It contains low-level functions to timestamp edges on the DMX sniffer pin
+ * using the MCPWM capture hardware. This file is not considered part of the API
+ * and should not be included by the user.
+ */
+#pragma once
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes the MCPWM capture hardware for the DMX sniffer. Falling
+ * and rising edges on the sniffer pin are latched by the hardware, so the
+ * capture interrupt only needs to run at the end of each DMX break and
+ * mark-after-break.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] isr_context Context to be used in the DMX capture ISR.
+ * @param sniffer_pin The sniffer pin GPIO number.
+ * @return true if the capture hardware was initialized.
+ * @return false if the capture hardware is not supported on this target or if
+ * no MCPWM group is available.
+ */
+bool dmx_capture_init(dmx_port_t dmx_num, void *isr_context, int sniffer_pin);
+
+/**
+ * @brief De-initializes the MCPWM capture hardware for the DMX sniffer.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_capture_deinit(dmx_port_t dmx_num);
+
+/**
+ * @brief Arms the MCPWM capture interrupt to measure the DMX break and
+ * mark-after-break of the packet which is being received. This function should
+ * be called from the DMX UART ISR when a DMX break is detected. It does nothing
+ * if the DMX port is not using the capture hardware.
+ *
+ * @param dmx_num The DMX port number.
+ * @param now The current timestamp in microseconds since boot.
+ */
+void dmx_capture_arm(dmx_port_t dmx_num, int64_t now);
+
+#ifdef __cplusplus
+}
+#endif
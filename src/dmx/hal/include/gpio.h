@@ -9,12 +9,25 @@
 #pragma once
 
 #include "dmx/include/types.h"
+
+#ifndef CONFIG_IDF_TARGET_LINUX
 #include "driver/gpio.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#ifdef CONFIG_IDF_TARGET_LINUX
+// The host HAL accepts any pin number
+#define dmx_tx_pin_is_valid(tx) (true)
+
+#define dmx_rx_pin_is_valid(rx) (true)
+
+#define dmx_rts_pin_is_valid(rts) (true)
+
+#define dmx_sniffer_pin_is_valid(sniffer) ((sniffer) >= 0)
+#else
 /**
  * @brief Evaluates to true if the pin number used for TX is valid.
  */
@@ -34,6 +47,7 @@ extern "C" {
  * @brief Evaluates to true if the pin number used for the DMX sniffer is valid.
  */
 #define dmx_sniffer_pin_is_valid(sniffer) (GPIO_IS_VALID_GPIO(sniffer))
+#endif
 
 /**
  * @brief Initializes the GPIO for the DMX sniffer.
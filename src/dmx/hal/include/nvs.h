@@ -16,18 +16,39 @@
 extern "C" {
 #endif
 
+/** @brief A parameter which is written to non-volatile storage with
+ * dmx_nvs_set_batch().*/
+typedef struct dmx_nvs_item_t {
+  rdm_sub_device_t sub_device;  // The sub-device which owns the parameter. The root device of a virtual responder is RDM_SUB_DEVICE_MAX plus its responder number minus one.
+  rdm_pid_t pid;  // The parameter ID to set.
+  const void *param;  // A pointer to the parameter data to copy to NVS.
+  size_t size;  // The size of the parameter data.
+} dmx_nvs_item_t;
+
 /**
- * @brief Initialize non-volatile storage.
+ * @brief Initialize non-volatile storage. Every parameter of the DMX port is
+ * loaded from non-volatile storage in a single pass so that dmx_nvs_get() does
+ * not need to open non-volatile storage for each parameter.
  *
  * @param dmx_num The DMX port number.
  */
 void dmx_nvs_init(dmx_port_t dmx_num);
 
+/**
+ * @brief Frees the parameters which were loaded from non-volatile storage when
+ * the DMX driver was installed.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_nvs_deinit(dmx_port_t dmx_num);
+
 /**
  * @brief Gets parameter data from non-volatile storage.
  *
  * @param dmx_num The DMX port number.
- * @param sub_device The sub-device which owns the parameter.
+ * @param sub_device The sub-device which owns the parameter. The root device
+ * of a virtual responder is RDM_SUB_DEVICE_MAX plus its responder number minus
+ * one.
  * @param pid The parameter ID to get.
  * @param[out] param A pointer into which to copy the parameter data.
  * @param size The size of the param pointer.
@@ -40,7 +61,9 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
  * @brief Sets the parameter data to non-volatile storage.
  *
  * @param dmx_num The DMX port number.
- * @param sub_device The sub-device which owns the parameter.
+ * @param sub_device The sub-device which owns the parameter. The root device
+ * of a virtual responder is RDM_SUB_DEVICE_MAX plus its responder number minus
+ * one.
  * @param pid The parameter ID to set.
  * @param[in] param A pointer to the parameter data to copy to NVS.
  * @param size The size of the parameter data.
@@ -50,6 +73,20 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid,
                  const void *param, size_t size);
 
+/**
+ * @brief Sets many parameters to non-volatile storage in a single transaction.
+ * NVS is opened and committed once, and the DMX drivers are disabled only once
+ * for the whole batch when the DMX ISR is not placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] items An array of the parameters to copy to NVS.
+ * @param count The number of items.
+ * @return true if every parameter was written.
+ * @return false on failure.
+ */
+bool dmx_nvs_set_batch(dmx_port_t dmx_num, const dmx_nvs_item_t *items,
+                       size_t count);
+
 #ifdef __cplusplus
 }
 #endif
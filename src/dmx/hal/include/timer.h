@@ -12,7 +12,9 @@
 
 #include "dmx/include/types.h"
 
-#if ESP_IDF_VERSION_MAJOR >= 5
+#if defined(CONFIG_IDF_TARGET_LINUX)
+// The host HAL uses a virtual clock
+#elif ESP_IDF_VERSION_MAJOR >= 5
 #include "driver/gptimer.h"
 #include "esp_timer.h"
 #else
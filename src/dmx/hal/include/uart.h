@@ -11,7 +11,21 @@
 #pragma once
 
 #include "dmx/include/types.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+// The host HAL simulates the UART interrupt bits of the ESP32
+#define UART_INTR_RXFIFO_FULL (1 << 0)
+#define UART_INTR_TXFIFO_EMPTY (1 << 1)
+#define UART_INTR_PARITY_ERR (1 << 2)
+#define UART_INTR_FRAM_ERR (1 << 3)
+#define UART_INTR_RXFIFO_OVF (1 << 4)
+#define UART_INTR_BRK_DET (1 << 7)
+#define UART_INTR_RXFIFO_TOUT (1 << 8)
+#define UART_INTR_TX_BRK_IDLE (1 << 13)
+#define UART_INTR_TX_DONE (1 << 14)
+#else
 #include "hal/uart_hal.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,12 +37,14 @@ enum dmx_interrupt_mask_t {
   DMX_INTR_RX_ERR = DMX_INTR_RX_FIFO_OVERFLOW | DMX_INTR_RX_FRAMING_ERR,
 
   DMX_INTR_RX_BREAK = UART_INTR_BRK_DET,
-  DMX_INTR_RX_DATA = UART_INTR_RXFIFO_FULL,
+  DMX_INTR_RX_DATA = UART_INTR_RXFIFO_FULL | UART_INTR_RXFIFO_TOUT,
   DMX_INTR_RX_ALL = DMX_INTR_RX_DATA | DMX_INTR_RX_BREAK | DMX_INTR_RX_ERR,
+  DMX_INTR_RX_DMA = DMX_INTR_RX_BREAK | DMX_INTR_RX_ERR,
 
   DMX_INTR_TX_DATA = UART_INTR_TXFIFO_EMPTY,
   DMX_INTR_TX_DONE = UART_INTR_TX_DONE,
   DMX_INTR_TX_ALL = DMX_INTR_TX_DATA | DMX_INTR_TX_DONE,
+  DMX_INTR_TX_BREAK_DONE = UART_INTR_TX_BRK_IDLE,
 };
 
 /**
@@ -82,6 +98,17 @@ void dmx_uart_set_baud_rate(dmx_port_t dmx_num, uint32_t baud_rate);
  */
 void dmx_uart_invert_tx(dmx_port_t dmx_num, int invert);
 
+/**
+ * @brief Sets the UART to send a break and mark-after-break once the data in
+ * the TX FIFO has been sent. The DMX_INTR_TX_BREAK_DONE interrupt is raised
+ * when the mark-after-break is done.
+ *
+ * @param dmx_num The DMX port number.
+ * @param break_bits The length of the break in bits, or 0 to disable the break.
+ * @param mab_bits The length of the mark-after-break in bits.
+ */
+void dmx_uart_set_tx_break(dmx_port_t dmx_num, int break_bits, int mab_bits);
+
 /**
  * @brief Gets the level of the UART RTS line.
  *
@@ -91,6 +118,17 @@ void dmx_uart_invert_tx(dmx_port_t dmx_num, int invert);
  */
 int dmx_uart_get_rts(dmx_port_t dmx_num);
 
+/**
+ * @brief Sets the number of slots the UART RX FIFO must hold before a receive
+ * interrupt is raised. When the threshold is greater than 1 the UART receive
+ * timeout is enabled so that the remaining slots at the end of a packet are
+ * still read.
+ *
+ * @param dmx_num The DMX port number.
+ * @param threshold The RX FIFO threshold.
+ */
+void dmx_uart_set_rx_threshold(dmx_port_t dmx_num, int threshold);
+
 /**
  * @brief Gets the interrupt status mask from the UART.
  *
@@ -182,6 +220,61 @@ void dmx_uart_write_txfifo(dmx_port_t dmx_num, const void *buf, int *size);
  */
 void dmx_uart_txfifo_reset(dmx_port_t dmx_num);
 
+/**
+ * @brief Initializes the UHCI and a GDMA channel so that the UART can send
+ * DMX packets using DMA. Only one DMX port may use DMA at a time.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false if DMA is not supported on this target or DMA is already in
+ * use by another DMX port.
+ */
+bool dmx_uart_dma_init(dmx_port_t dmx_num);
+
+/**
+ * @brief De-initializes the UART DMA, if it is being used by the DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_uart_dma_deinit(dmx_port_t dmx_num);
+
+/**
+ * @brief Sends a buffer on the UART using DMA. The buffer must be placed in
+ * DMA-capable memory and must remain valid until the UART raises the TX done
+ * interrupt. dmx_uart_dma_stop() should be called once the TX done interrupt
+ * has been raised.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] buf The source buffer from which to send.
+ * @param size The number of bytes to send.
+ */
+void dmx_uart_dma_write(dmx_port_t dmx_num, const void *buf, int size);
+
+/**
+ * @brief Starts receiving data on the UART using DMA. Each DMX frame is
+ * written into the buffer beginning at slot 0. The UHCI ends a frame when a
+ * DMX break is received or when the bus has been idle for a few slot times,
+ * after which the received size is published to the DMX driver.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[inout] isr_context Context to be used in the DMA ISR.
+ * @param[out] buf The DMA-capable buffer into which to receive data.
+ * @param size The size of the buffer.
+ * @return true on success.
+ * @return false if DMA is not supported on this target or DMA is already in
+ * use by another DMX port.
+ */
+bool dmx_uart_dma_rx_init(dmx_port_t dmx_num, void *isr_context, void *buf,
+                          int size);
+
+/**
+ * @brief Stops sending data using the UART DMA and detaches the UHCI from
+ * the UART if it is not being used to receive data.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_uart_dma_stop(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,8 @@
 #include "include/nvs.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "dmx/include/service.h"
 #include "esp_dmx.h"
 #include "nvs_flash.h"
@@ -12,8 +15,25 @@
 
 #define DMX_NVS_KEY_SIZE_MAX (16)
 
+// Parameters larger than this are not kept in RAM after they are loaded.
+#define DMX_NVS_CACHE_SIZE_MAX (36)
+
 static const char *dmx_nvs_namespace = "esp_dmx";
 
+// A parameter which was loaded from NVS when the DMX driver was installed.
+typedef struct dmx_nvs_entry_t {
+  char key[DMX_NVS_KEY_SIZE_MAX];  // The NVS key of the parameter.
+  nvs_type_t type;  // The NVS type of the parameter.
+  uint8_t size;  // The size of the parameter, or 0 if it is too large to keep.
+  uint8_t data[DMX_NVS_CACHE_SIZE_MAX];  // The parameter data.
+} dmx_nvs_entry_t;
+
+static struct dmx_nvs_cache_t {
+  dmx_nvs_entry_t *entries;  // The parameters of the DMX port, or NULL if they were not loaded.
+  size_t count;  // The number of parameters of the DMX port.
+} dmx_nvs_cache[DMX_NUM_MAX];
+static dmx_spinlock_t dmx_nvs_spinlock = DMX_SPINLOCK_INIT;
+
 static void dmx_nvs_get_key(char *key, dmx_port_t dmx_num,
                             rdm_sub_device_t sub_device, rdm_pid_t pid) {
   const int w =
@@ -22,15 +42,222 @@ static void dmx_nvs_get_key(char *key, dmx_port_t dmx_num,
   assert(w < DMX_NVS_KEY_SIZE_MAX);
 }
 
+// Finds the entries in the namespace with keys which begin with a prefix.
+// Returns the number of matching entries, which may be more than are copied.
+static size_t dmx_nvs_find(const char *prefix, nvs_entry_info_t *infos,
+                           size_t infos_max) {
+  const size_t prefix_len = strlen(prefix);
+  size_t count = 0;
+  nvs_entry_info_t info;
+  // nvs_open() uses the default partition so it is iterated here as well
+#if ESP_IDF_VERSION_MAJOR >= 5
+  nvs_iterator_t it = NULL;
+  esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, dmx_nvs_namespace,
+                                 NVS_TYPE_ANY, &it);
+  for (; err == ESP_OK; err = nvs_entry_next(&it)) {
+    nvs_entry_info(it, &info);
+#else
+  nvs_iterator_t it =
+      nvs_entry_find(NVS_DEFAULT_PART_NAME, dmx_nvs_namespace, NVS_TYPE_ANY);
+  for (; it != NULL; it = nvs_entry_next(it)) {
+    nvs_entry_info(it, &info);
+#endif
+    if (strncmp(info.key, prefix, prefix_len) != 0) {
+      continue;  // Key belongs to another DMX port or library version
+    }
+    if (count < infos_max) {
+      infos[count] = info;
+    }
+    ++count;
+  }
+  nvs_release_iterator(it);
+
+  return count;
+}
+
+// Loads every parameter of a DMX port from NVS in a single pass so that
+// parameters do not each need to open NVS when they are registered.
+static void dmx_nvs_load(dmx_port_t dmx_num) {
+  // Every key of the DMX port begins with the same prefix
+  char prefix[DMX_NVS_KEY_SIZE_MAX];
+  snprintf(prefix, DMX_NVS_KEY_SIZE_MAX, "%x%x%x", ESP_DMX_VERSION_MAJOR,
+           ESP_DMX_VERSION_MINOR, dmx_num);
+
+  const size_t count = dmx_nvs_find(prefix, NULL, 0);
+  dmx_nvs_entry_t *entries = malloc(sizeof(*entries) * (count > 0 ? count : 1));
+  nvs_entry_info_t *infos = malloc(sizeof(*infos) * (count > 0 ? count : 1));
+  if (entries == NULL || infos == NULL) {
+    free(entries);
+    free(infos);
+    return;  // Parameters are read from NVS when they are requested instead
+  }
+  const size_t found = dmx_nvs_find(prefix, infos, count);
+
+  nvs_handle_t nvs;
+  size_t loaded = 0;
+  if (found == 0) {
+    // There are no parameters to load
+  } else if (!nvs_open(dmx_nvs_namespace, NVS_READONLY, &nvs)) {
+#ifndef DMX_ISR_IN_IRAM
+    // Track which drivers are currently enabled and disable those which are
+    bool driver_is_enabled[DMX_NUM_MAX];
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      driver_is_enabled[i] = dmx_driver_is_enabled(i);
+      if (dmx_driver_is_installed(i)) {
+        dmx_driver_disable(i);
+      }
+    }
+#endif
+
+    // Read the parameters depending on their type
+    for (size_t i = 0; i < found && i < count; ++i) {
+      dmx_nvs_entry_t *const entry = &entries[loaded];
+      strncpy(entry->key, infos[i].key, DMX_NVS_KEY_SIZE_MAX);
+      entry->type = infos[i].type;
+      size_t size;
+      esp_err_t err;
+      switch (entry->type) {
+        case NVS_TYPE_U8:
+          err = nvs_get_u8(nvs, entry->key, entry->data);
+          size = sizeof(uint8_t);
+          break;
+        case NVS_TYPE_U16:
+          err = nvs_get_u16(nvs, entry->key, (uint16_t *)entry->data);
+          size = sizeof(uint16_t);
+          break;
+        case NVS_TYPE_U32:
+          err = nvs_get_u32(nvs, entry->key, (uint32_t *)entry->data);
+          size = sizeof(uint32_t);
+          break;
+        case NVS_TYPE_BLOB:
+          size = DMX_NVS_CACHE_SIZE_MAX;
+          err = nvs_get_blob(nvs, entry->key, entry->data, &size);
+          if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+            size = 0;  // Large parameters are read when they are requested
+            err = ESP_OK;
+          }
+          break;
+        default:
+          err = ESP_FAIL;  // This type is never written by the DMX driver
+      }
+      if (!err) {
+        entry->size = size;
+        ++loaded;
+      }
+    }
+
+#ifndef DMX_ISR_IN_IRAM
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      if (driver_is_enabled[i]) {
+        dmx_driver_enable(i);
+      }
+    }
+#endif
+
+    nvs_close(nvs);
+  } else {
+    free(entries);
+    entries = NULL;  // NVS could not be opened so nothing is known to exist
+  }
+  free(infos);
+
+  taskENTER_CRITICAL(&dmx_nvs_spinlock);
+  dmx_nvs_entry_t *stale = dmx_nvs_cache[dmx_num].entries;
+  dmx_nvs_cache[dmx_num].entries = entries;
+  dmx_nvs_cache[dmx_num].count = loaded;
+  taskEXIT_CRITICAL(&dmx_nvs_spinlock);
+  free(stale);
+}
+
+// Copies a parameter from the parameters which were loaded when the DMX driver
+// was installed. Returns false if the parameter must be read from NVS instead.
+static bool dmx_nvs_cache_get(dmx_port_t dmx_num, const char *key,
+                              void *param, size_t *size) {
+  bool is_cached = false;
+  taskENTER_CRITICAL(&dmx_nvs_spinlock);
+  const struct dmx_nvs_cache_t *cache = &dmx_nvs_cache[dmx_num];
+  if (cache->entries != NULL) {
+    is_cached = true;
+    size_t found_size = 0;  // Parameters which were not loaded do not exist
+    for (size_t i = 0; i < cache->count; ++i) {
+      const dmx_nvs_entry_t *entry = &cache->entries[i];
+      if (strncmp(entry->key, key, DMX_NVS_KEY_SIZE_MAX) != 0) {
+        continue;
+      }
+      if (entry->size == 0) {
+        is_cached = false;  // The parameter was too large to keep
+        break;
+      }
+
+      // Match the behavior of the typed NVS getters
+      const nvs_type_t type = *size == sizeof(uint8_t)    ? NVS_TYPE_U8
+                              : *size == sizeof(uint16_t) ? NVS_TYPE_U16
+                              : *size == sizeof(uint32_t) ? NVS_TYPE_U32
+                                                          : NVS_TYPE_BLOB;
+      if (entry->type == type && entry->size <= *size &&
+          (type == NVS_TYPE_BLOB || entry->size == *size)) {
+        memcpy(param, entry->data, entry->size);
+        found_size = entry->size;
+      }
+      break;
+    }
+    *size = found_size;
+  }
+  taskEXIT_CRITICAL(&dmx_nvs_spinlock);
+
+  return is_cached;
+}
+
+// Updates a parameter which was loaded when the DMX driver was installed after
+// it is written to NVS.
+static void dmx_nvs_cache_set(dmx_port_t dmx_num, const char *key,
+                              nvs_type_t type, const void *param,
+                              size_t size) {
+  dmx_nvs_entry_t *stale = NULL;
+  taskENTER_CRITICAL(&dmx_nvs_spinlock);
+  struct dmx_nvs_cache_t *cache = &dmx_nvs_cache[dmx_num];
+  if (cache->entries != NULL) {
+    size_t i = 0;
+    while (i < cache->count &&
+           strncmp(cache->entries[i].key, key, DMX_NVS_KEY_SIZE_MAX) != 0) {
+      ++i;
+    }
+    if (i < cache->count && size <= DMX_NVS_CACHE_SIZE_MAX) {
+      cache->entries[i].type = type;
+      cache->entries[i].size = size;
+      memcpy(cache->entries[i].data, param, size);
+    } else if (i < cache->count) {
+      cache->entries[i].size = 0;  // Too large to keep
+    } else {
+      // New parameters are not kept so parameters are read from NVS instead
+      stale = cache->entries;
+      cache->entries = NULL;
+      cache->count = 0;
+    }
+  }
+  taskEXIT_CRITICAL(&dmx_nvs_spinlock);
+  free(stale);
+}
+
 void dmx_nvs_init(dmx_port_t dmx_num) {
   nvs_flash_init_partition(DMX_NVS_PARTITION_NAME);
+  dmx_nvs_load(dmx_num);
+}
+
+void dmx_nvs_deinit(dmx_port_t dmx_num) {
+  taskENTER_CRITICAL(&dmx_nvs_spinlock);
+  dmx_nvs_entry_t *entries = dmx_nvs_cache[dmx_num].entries;
+  dmx_nvs_cache[dmx_num].entries = NULL;
+  dmx_nvs_cache[dmx_num].count = 0;
+  taskEXIT_CRITICAL(&dmx_nvs_spinlock);
+  free(entries);
 }
 
 size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                    rdm_pid_t pid, void *param, size_t size) {
   assert(dmx_num < DMX_NUM_MAX);
   assert(pid > 0);
-  assert(sub_device < RDM_SUB_DEVICE_MAX);
+  assert(sub_device < RDM_SUB_DEVICE_MAX + RDM_VIRTUAL_RESPONDER_MAX);
   assert(param != NULL);
 
   if (size == 0) {
@@ -41,6 +268,11 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
   char key[DMX_NVS_KEY_SIZE_MAX];
   dmx_nvs_get_key(key, dmx_num, sub_device, pid);
 
+  // Use the parameters which were loaded when the DMX driver was installed
+  if (dmx_nvs_cache_get(dmx_num, key, param, &size)) {
+    return size;
+  }
+
   nvs_handle_t nvs;
   esp_err_t err = nvs_open(dmx_nvs_namespace, NVS_READONLY, &nvs);
   if (!err) {
@@ -93,19 +325,29 @@ size_t dmx_nvs_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 
 bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid,
                  const void *param, size_t size) {
+  const dmx_nvs_item_t item = {
+      .sub_device = sub_device, .pid = pid, .param = param, .size = size};
+  return dmx_nvs_set_batch(dmx_num, &item, 1);
+}
+
+bool dmx_nvs_set_batch(dmx_port_t dmx_num, const dmx_nvs_item_t *items,
+                       size_t count) {
   assert(dmx_num < DMX_NUM_MAX);
-  assert(pid > 0);
-  assert(sub_device < 513);
-  assert(param != NULL);
+  assert(items != NULL || count == 0);
 
-  if (size == 0) {
+  // Skip opening NVS if there is nothing to write
+  size_t size_total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    assert(items[i].pid > 0);
+    assert(items[i].sub_device <
+           RDM_SUB_DEVICE_MAX + RDM_VIRTUAL_RESPONDER_MAX);
+    assert(items[i].param != NULL);
+    size_total += items[i].size;
+  }
+  if (size_total == 0) {
     return true;
   }
 
-  // Get the NVS key
-  char key[DMX_NVS_KEY_SIZE_MAX];
-  dmx_nvs_get_key(key, dmx_num, sub_device, pid);
-
   nvs_handle_t nvs;
   esp_err_t err = nvs_open(dmx_nvs_namespace, NVS_READWRITE, &nvs);
   if (!err) {
@@ -120,19 +362,38 @@ bool dmx_nvs_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid,
     }
 #endif
 
-    // Write the parameter to NVS depending on its type
-    switch (size) {
-      case sizeof(uint8_t):
-        err = nvs_set_u8(nvs, key, *(uint8_t *)param);
-        break;
-      case sizeof(uint16_t):
-        err = nvs_set_u16(nvs, key, *(uint16_t *)param);
-        break;
-      case sizeof(uint32_t):
-        err = nvs_set_u32(nvs, key, *(uint32_t *)param);
-        break;
-      default:
-        err = nvs_set_blob(nvs, key, param, size);
+    for (size_t i = 0; i < count && !err; ++i) {
+      const void *param = items[i].param;
+      if (items[i].size == 0) {
+        continue;
+      }
+
+      // Get the NVS key
+      char key[DMX_NVS_KEY_SIZE_MAX];
+      dmx_nvs_get_key(key, dmx_num, items[i].sub_device, items[i].pid);
+
+      // Write the parameter to NVS depending on its type
+      nvs_type_t type;
+      switch (items[i].size) {
+        case sizeof(uint8_t):
+          err = nvs_set_u8(nvs, key, *(uint8_t *)param);
+          type = NVS_TYPE_U8;
+          break;
+        case sizeof(uint16_t):
+          err = nvs_set_u16(nvs, key, *(uint16_t *)param);
+          type = NVS_TYPE_U16;
+          break;
+        case sizeof(uint32_t):
+          err = nvs_set_u32(nvs, key, *(uint32_t *)param);
+          type = NVS_TYPE_U32;
+          break;
+        default:
+          err = nvs_set_blob(nvs, key, param, items[i].size);
+          type = NVS_TYPE_BLOB;
+      }
+      if (!err) {
+        dmx_nvs_cache_set(dmx_num, key, type, param, items[i].size);
+      }
     }
     if (!err) {
       err = nvs_commit(nvs);
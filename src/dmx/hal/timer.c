@@ -1,62 +1,285 @@
 #include "include/timer.h"
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "dmx/hal/include/uart.h"
+#include "dmx/include/isr.h"
 #include "dmx/include/service.h"
 #include "driver/gpio.h"
 
+#ifdef CONFIG_DMX_SHARED_TIMER
+/* Every DMX port uses the same hardware timer. Each DMX port has a software
+  timer which keeps the timer counter and alarm that the DMX port would have
+  set on its own hardware timer. The hardware timer is armed for the earliest
+  alarm of all DMX ports. Timestamps are in microseconds since boot.*/
 static struct dmx_timer_t {
+  void *isr_context;  // The context of the DMX timer ISR, or NULL if unused.
+  bool is_running;
+  bool alarm_is_enabled;  // False once a one-shot alarm has fired.
+  bool auto_reload;
+  int64_t base;  // The timestamp at which the running counter was 0.
+  uint64_t counter;  // The counter of the stopped timer.
+  uint64_t alarm;
+} dmx_timer_context[DMX_NUM_MAX] = {};
+
+static struct dmx_timer_shared_t {
 #if ESP_IDF_VERSION_MAJOR >= 5
   gptimer_handle_t gptimer_handle;
-#else
-  timer_group_t group;  // The timer group to use for DMX functions.
-  timer_idx_t idx;      // The timer index to use for DMX functions.
 #endif
-  bool is_running;
-} dmx_timer_context[DMX_NUM_MAX] = {};
+  bool is_running;  // True if the hardware timer is counting.
+  int port_count;  // The number of DMX ports which use the hardware timer.
+} dmx_timer_shared = {};
+
+static portMUX_TYPE dmx_timer_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+#if ESP_IDF_VERSION_MAJOR < 5
+// The hardware timer which is shared by the DMX ports
+#define DMX_TIMER_SHARED_GROUP (0)
+#define DMX_TIMER_SHARED_IDX (0)
+#endif
+
+// Arms the hardware timer for the earliest alarm of the DMX ports, or stops
+// the hardware timer if no alarm is enabled. Must be called within the timer
+// spinlock.
+static void DMX_ISR_ATTR dmx_timer_shared_arm(int64_t now) {
+  int64_t deadline = INT64_MAX;
+  for (int i = 0; i < DMX_NUM_MAX; ++i) {
+    const struct dmx_timer_t *timer = &dmx_timer_context[i];
+    if (timer->isr_context != NULL && timer->is_running &&
+        timer->alarm_is_enabled && timer->base + timer->alarm < deadline) {
+      deadline = timer->base + timer->alarm;
+    }
+  }
 
-static bool DMX_ISR_ATTR dmx_timer_isr(
+  if (deadline == INT64_MAX) {
+    if (dmx_timer_shared.is_running) {
 #if ESP_IDF_VERSION_MAJOR >= 5
-    gptimer_handle_t gptimer_handle,
-    const gptimer_alarm_event_data_t *event_data,
+      gptimer_stop(dmx_timer_shared.gptimer_handle);
+#else
+      timer_group_set_counter_enable_in_isr(DMX_TIMER_SHARED_GROUP,
+                                            DMX_TIMER_SHARED_IDX, 0);
 #endif
-    void *arg) {
-  dmx_driver_t *const driver = (dmx_driver_t *)arg;
-  const dmx_port_t dmx_num = driver->dmx_num;
-  int task_awoken = false;
+      dmx_timer_shared.is_running = false;
+    }
+    return;
+  }
 
-  if (driver->dmx.status == DMX_STATUS_SENDING) {
-    if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK) {
-      dmx_uart_invert_tx(dmx_num, 0);
-      driver->dmx.progress = DMX_PROGRESS_IN_MAB;
+  // Alarms which are already due are handled as soon as possible
+  const uint64_t wait = deadline > now ? deadline - now : 1;
+#if ESP_IDF_VERSION_MAJOR >= 5
+  const gptimer_alarm_config_t alarm_config = {
+      .alarm_count = wait, .reload_count = 0, .flags.auto_reload_on_alarm = 0};
+  gptimer_set_raw_count(dmx_timer_shared.gptimer_handle, 0);
+  gptimer_set_alarm_action(dmx_timer_shared.gptimer_handle, &alarm_config);
+  if (!dmx_timer_shared.is_running) {
+    gptimer_start(dmx_timer_shared.gptimer_handle);
+  }
+#else
+  timer_set_counter_value(DMX_TIMER_SHARED_GROUP, DMX_TIMER_SHARED_IDX, 0);
+  timer_group_set_alarm_value_in_isr(DMX_TIMER_SHARED_GROUP,
+                                     DMX_TIMER_SHARED_IDX, wait);
+  if (!dmx_timer_shared.is_running) {
+    timer_group_set_counter_enable_in_isr(DMX_TIMER_SHARED_GROUP,
+                                          DMX_TIMER_SHARED_IDX, 1);
+  }
+#endif
+  dmx_timer_shared.is_running = true;
+}
 
-      // Reset the alarm for the end of the DMX mark-after-break
-      dmx_timer_set_alarm(dmx_num, driver->mab_len, false);
+// Calls the DMX timer ISR of each DMX port whose alarm is due, earliest alarm
+// first, and then arms the hardware timer for the next alarm. Alarms are never
+// handled early. Alarms which are due together are handled one after another,
+// so an alarm may be late by the duration of the timer ISRs of the other DMX
+// ports.
+static bool DMX_ISR_ATTR dmx_timer_shared_isr(void *arg) {
+  bool task_awoken = false;
+  while (true) {
+    void *isr_context = NULL;
+    portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+    const int64_t now = esp_timer_get_time();
+    struct dmx_timer_t *due = NULL;
+    for (int i = 0; i < DMX_NUM_MAX; ++i) {
+      struct dmx_timer_t *timer = &dmx_timer_context[i];
+      if (timer->isr_context != NULL && timer->is_running &&
+          timer->alarm_is_enabled && timer->base + timer->alarm <= now &&
+          (due == NULL ||
+           timer->base + timer->alarm < due->base + due->alarm)) {
+        due = timer;
+      }
+    }
+    if (due != NULL) {
+      if (due->auto_reload && due->alarm > 0) {
+        due->base += due->alarm;  // The counter is reloaded at the alarm
+      } else {
+        due->alarm_is_enabled = false;
+      }
+      isr_context = due->isr_context;
     } else {
-      // Write data to the UART
-      int write_len = driver->dmx.size;
-      dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
-      driver->dmx.head = write_len;
+      dmx_timer_shared_arm(now);
+    }
+    portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+
+    if (isr_context == NULL) {
+      break;
+    } else if (dmx_timer_isr(isr_context)) {
+      task_awoken = true;
+    }
+  }
+
+  return task_awoken;
+}
 
-      // Pause MAB timer alarm
-      dmx_timer_stop(dmx_num);  // TODO: is this needed?
+#if ESP_IDF_VERSION_MAJOR >= 5
+static bool DMX_ISR_ATTR dmx_timer_gptimer_isr(
+    gptimer_handle_t gptimer_handle,
+    const gptimer_alarm_event_data_t *event_data, void *arg) {
+  return dmx_timer_shared_isr(arg);
+}
+#endif
+
+bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
 
-      // Enable DMX write interrupts
-      dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+  // Initialize the hardware timer when the first DMX port is installed
+  if (dmx_timer_shared.port_count == 0) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    const gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,  // 1MHz resolution timer
+    };
+    esp_err_t err =
+        gptimer_new_timer(&timer_config, &dmx_timer_shared.gptimer_handle);
+    if (err) {
+      return false;
     }
-  } else {
-    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-    if (driver->task_waiting) {
-      xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eSetValueWithOverwrite,
-                         &task_awoken);
+    const gptimer_event_callbacks_t gptimer_cb = {
+        .on_alarm = dmx_timer_gptimer_isr};
+    gptimer_register_event_callbacks(dmx_timer_shared.gptimer_handle,
+                                     &gptimer_cb, NULL);
+    gptimer_enable(dmx_timer_shared.gptimer_handle);
+#else
+    const timer_config_t timer_config = {
+        .divider = 80,  // (80MHz / 80) == 1MHz resolution timer
+        .counter_dir = TIMER_COUNT_UP,
+        .counter_en = false,
+        .alarm_en = true,
+        .auto_reload = true,  // Keeps the alarm enabled after it triggers
+    };
+    esp_err_t err = timer_init(DMX_TIMER_SHARED_GROUP, DMX_TIMER_SHARED_IDX,
+                               &timer_config);
+    if (err) {
+      return false;
     }
-    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-    dmx_timer_stop(dmx_num);  // TODO: is this needed?
+    timer_isr_callback_add(DMX_TIMER_SHARED_GROUP, DMX_TIMER_SHARED_IDX,
+                           dmx_timer_shared_isr, NULL, isr_flags);
+#endif
+    dmx_timer_shared.is_running = false;
   }
+  ++dmx_timer_shared.port_count;
 
-  return task_awoken;
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  timer->is_running = false;
+  timer->alarm_is_enabled = false;
+  timer->auto_reload = false;
+  timer->base = 0;
+  timer->counter = 0;
+  timer->alarm = 0;
+  timer->isr_context = isr_context;
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+
+  return true;
+}
+
+void dmx_timer_deinit(dmx_port_t dmx_num) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  timer->isr_context = NULL;
+  timer->is_running = false;
+  dmx_timer_shared_arm(esp_timer_get_time());
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+
+  // De-initialize the hardware timer when the last DMX port is deleted
+  if (--dmx_timer_shared.port_count == 0) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    gptimer_disable(dmx_timer_shared.gptimer_handle);
+    gptimer_del_timer(dmx_timer_shared.gptimer_handle);
+#else
+    timer_isr_callback_remove(DMX_TIMER_SHARED_GROUP, DMX_TIMER_SHARED_IDX);
+    timer_deinit(DMX_TIMER_SHARED_GROUP, DMX_TIMER_SHARED_IDX);
+#endif
+  }
+}
+
+void DMX_ISR_ATTR dmx_timer_stop(dmx_port_t dmx_num) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  if (timer->is_running) {
+    timer->counter = 0;
+    timer->is_running = false;
+    dmx_timer_shared_arm(esp_timer_get_time());
+  }
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_set_counter(dmx_port_t dmx_num, uint64_t counter) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  if (timer->is_running) {
+    const int64_t now = esp_timer_get_time();
+    timer->base = now - counter;
+    dmx_timer_shared_arm(now);
+  } else {
+    timer->counter = counter;
+  }
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_set_alarm(dmx_port_t dmx_num, uint64_t alarm,
+                                      bool auto_reload) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  timer->alarm = alarm;
+  timer->auto_reload = auto_reload;
+  timer->alarm_is_enabled = true;
+  if (timer->is_running) {
+    dmx_timer_shared_arm(esp_timer_get_time());
+  }
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+
+void DMX_ISR_ATTR dmx_timer_start(dmx_port_t dmx_num) {
+  struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
+  portENTER_CRITICAL_SAFE(&dmx_timer_spinlock);
+  if (!timer->is_running) {
+    const int64_t now = esp_timer_get_time();
+    timer->base = now - timer->counter;
+    timer->is_running = true;
+    dmx_timer_shared_arm(now);
+  }
+  portEXIT_CRITICAL_SAFE(&dmx_timer_spinlock);
+}
+#else
+static struct dmx_timer_t {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  gptimer_handle_t gptimer_handle;
+#else
+  timer_group_t group;  // The timer group to use for DMX functions.
+  timer_idx_t idx;      // The timer index to use for DMX functions.
+#endif
+  bool is_running;
+} dmx_timer_context[DMX_NUM_MAX] = {};
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+static bool DMX_ISR_ATTR dmx_timer_gptimer_isr(
+    gptimer_handle_t gptimer_handle,
+    const gptimer_alarm_event_data_t *event_data, void *arg) {
+  return dmx_timer_isr(arg);
 }
+#endif
 
 bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
   struct dmx_timer_t *timer = &dmx_timer_context[dmx_num];
@@ -72,7 +295,7 @@ bool dmx_timer_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
   if (err) {
     return NULL;
   }
-  const gptimer_event_callbacks_t gptimer_cb = {.on_alarm = dmx_timer_isr};
+  const gptimer_event_callbacks_t gptimer_cb = {.on_alarm = dmx_timer_gptimer_isr};
   gptimer_register_event_callbacks(timer->gptimer_handle, &gptimer_cb,
                                    isr_context);
   gptimer_enable(timer->gptimer_handle);
@@ -162,6 +385,8 @@ void DMX_ISR_ATTR dmx_timer_start(dmx_port_t dmx_num) {
   }
 }
 
+#endif
+
 int64_t DMX_ISR_ATTR dmx_timer_get_micros_since_boot() {
   return esp_timer_get_time();
 }
\ No newline at end of file
@@ -1,11 +1,9 @@
 #include "include/uart.h"
 
 #include "dmx/hal/include/timer.h"
+#include "dmx/include/isr.h"
 #include "dmx/include/service.h"
 #include "driver/uart.h"
-#include "endian.h"
-#include "rdm/include/driver.h"
-#include "rdm/include/uid.h"
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
 #include "esp_private/esp_clk.h"
@@ -19,8 +17,21 @@
 #include "driver/timer.h"
 #endif
 
+#if ESP_IDF_VERSION_MAJOR >= 5 && SOC_GDMA_SUPPORTED && SOC_UHCI_NUM > 0
+#include "esp_private/gdma.h"
+#include "hal/dma_types.h"
+#include "hal/uhci_ll.h"
+/** @brief This macro is defined when the target is able to send DMX slot data
+ * using the UHCI peripheral and GDMA.*/
+#define DMX_UART_DMA_SUPPORTED
+#endif
+
 #define DMX_UART_FULL_DEFAULT 1
 #define DMX_UART_EMPTY_DEFAULT 8
+#define DMX_UART_RX_TOUT_DEFAULT 2  // Idle slot times which flush the RX FIFO
+#define DMX_UART_TX_BREAK_BITS_MAX 255  // The width of the UART break length
+#define DMX_UART_TX_IDLE_BITS_MAX 1023  // The width of the UART idle length
+#define DMX_UART_DMA_RX_IDLE_NUM 32  // Idle bit times which end a DMA frame
 
 static struct dmx_uart_t {
   const int num;
@@ -34,295 +45,53 @@ static struct dmx_uart_t {
 #endif
 };
 
-enum {
-  RDM_TYPE_IS_NOT_RDM = 0,  // The packet is not RDM.
-  RDM_TYPE_IS_DISCOVERY,    // The packet is an RDM discovery request.
-  RDM_TYPE_IS_RESPONSE,     // The packet is an RDM response.
-  RDM_TYPE_IS_BROADCAST,    // The packet is a non-discovery RDM broadcast.
-  RDM_TYPE_IS_REQUEST,      // The packet is a standard RDM request.
-  RDM_TYPE_IS_UNKNOWN,  // The packet is RDM, but it is unclear what type it is.
-};
+#ifdef DMX_UART_DMA_SUPPORTED
+static struct dmx_uart_dma_t {
+  int owner;  // The DMX port which is using the UHCI, or -1 if it is unused.
+  uhci_dev_t *const dev;
+  gdma_channel_handle_t tx_channel;
+  dma_descriptor_t *tx_desc;  // The DMA descriptor which points at the packet.
+  gdma_channel_handle_t rx_channel;
+  dma_descriptor_t *rx_desc;  // The circular DMA descriptor for received data.
+} dmx_uart_dma_context = {.owner = -1, .dev = UHCI_LL_GET_HW(0)};
+#endif
 
-static void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
+#ifdef DMX_UART_DMA_SUPPORTED
+static bool DMX_ISR_ATTR dmx_uart_dma_rx_isr(gdma_channel_handle_t channel,
+                                             gdma_event_data_t *event_data,
+                                             void *arg) {
   const int64_t now = dmx_timer_get_micros_since_boot();
   dmx_driver_t *const driver = arg;
-  const dmx_port_t dmx_num = driver->dmx_num;
-  int task_awoken = false;
-
-  while (true) {
-    const uint32_t intr_flags = dmx_uart_get_interrupt_status(dmx_num);
-    if (intr_flags == 0) break;
-
-    // DMX Receive ####################################################
-    if (intr_flags & DMX_INTR_RX_ALL) {
-      // Read data into the DMX buffer if there is enough space
-      int dmx_head;
-      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      dmx_head = driver->dmx.head;
-      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      if (dmx_head >= 0 && dmx_head < DMX_PACKET_SIZE_MAX) {
-        int read_len = DMX_PACKET_SIZE_MAX - dmx_head;
-        dmx_uart_read_rxfifo(dmx_num, &driver->dmx.data[dmx_head], &read_len);
-        dmx_head += read_len;
-        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        driver->dmx.head = dmx_head;
-        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      } else {
-        if (dmx_head > 0) {
-          // Record the number of slots received for error reporting
-          dmx_head += dmx_uart_get_rxfifo_len(dmx_num);
-          taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-          driver->dmx.head = dmx_head;
-          taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        }
-        dmx_uart_rxfifo_reset(dmx_num);
-      }
-      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
-
-      // Handle DMX break condition
-      if (intr_flags & DMX_INTR_RX_BREAK) {
-        // Handle possible condition where expected packet size is too large
-        if (driver->dmx.progress == DMX_PROGRESS_IN_DATA && dmx_head > 0) {
-          taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-          driver->dmx.size = dmx_head - 1;  // Attempt to fix packet size
-          if (driver->task_waiting) {
-            xTaskNotifyFromISR(driver->task_waiting, DMX_ERR_NOT_ENOUGH_SLOTS,
-                               eSetValueWithOverwrite, &task_awoken);
-          }
-          taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        }
-
-        // Reset the DMX buffer for the next packet
-        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        driver->dmx.status = DMX_STATUS_RECEIVING;
-        driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
-        driver->dmx.head = 0;
-        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        continue;  // Nothing else to do on DMX break
-      } else if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK ||
-                 driver->dmx.progress == DMX_PROGRESS_IN_MAB) {
-        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        // UART ISR cannot detect MAB so we go straight to DMX_PROGRESS_IN_DATA
-        driver->dmx.progress = DMX_PROGRESS_IN_DATA;
-        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      }
-
-      // Guard against notifying multiple times for the same packet
-      if (driver->dmx.progress != DMX_PROGRESS_IN_DATA) {
-        continue;
-      }
-
-      // Process the data depending on the type of packet that was received
-      dmx_err_t err;
-      int rdm_type;
-      bool packet_is_complete;
-      if (intr_flags & DMX_INTR_RX_ERR) {
-        rdm_type = RDM_TYPE_IS_NOT_RDM;
-        packet_is_complete = true;
-        err = intr_flags & DMX_INTR_RX_FIFO_OVERFLOW
-                  ? DMX_ERR_UART_OVERFLOW   // UART overflow
-                  : DMX_ERR_IMPROPER_SLOT;  // Missing stop bits
-      } else {
-        // Determine the type of the packet that was received
-        const uint8_t sc = driver->dmx.data[0];  // DMX start-code.
-        if (sc == RDM_SC) {
-          rdm_type = RDM_TYPE_IS_UNKNOWN;  // Determine actual type later
-        } else if (sc == RDM_PREAMBLE || sc == RDM_DELIMITER) {
-          rdm_type = RDM_TYPE_IS_DISCOVERY;
-        } else {
-          rdm_type = RDM_TYPE_IS_NOT_RDM;
-          taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-          // Get the best resolution on the controller EOP timestamp
-          driver->dmx.controller_eop_timestamp = now;
-          taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        }
-
-        // Set inter-slot timer for RDM response packets
-        if (driver->is_controller && rdm_type != RDM_TYPE_IS_NOT_RDM) {
-          dmx_timer_set_counter(dmx_num, 0);
-          dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_INTER_SLOT_MAX,
-                              false);
-        }
-
-        err = DMX_OK;
-      }
-      while (err == DMX_OK) {
-        if (rdm_type == RDM_TYPE_IS_DISCOVERY) {
-          // Parse an RDM discovery response packet
-          if (dmx_head < 17) {
-            packet_is_complete = false;
-            break;  // Haven't received the minimum packet size
-          }
-
-          // Get the delimiter index
-          int delimiter_idx = 0;
-          for (; delimiter_idx <= 7; ++delimiter_idx) {
-            const uint8_t slot_value = driver->dmx.data[delimiter_idx];
-            if (slot_value != RDM_PREAMBLE) {
-              if (slot_value != RDM_DELIMITER) {
-                delimiter_idx = 9;  // Force invalid packet type
-              }
-              break;
-            }
-          }
-          if (delimiter_idx > 8) {
-            rdm_type = RDM_TYPE_IS_NOT_RDM;
-            continue;  // Packet is malformed - treat it as DMX
-          }
-
-          // Process RDM discovery response packet
-          if (dmx_head < delimiter_idx + 17) {
-            packet_is_complete = false;
-            break;  // Haven't received full RDM_PID_DISC_UNIQUE_BRANCH response
-          } else if (!rdm_read_header(dmx_num, NULL)) {
-            rdm_type = RDM_TYPE_IS_NOT_RDM;
-            continue;  // Packet is malformed - treat it as DMX
-          } else {
-            driver->dmx.last_responder_pid = RDM_PID_DISC_UNIQUE_BRANCH;
-            driver->dmx.responder_sent_last = true;
-            packet_is_complete = true;
-            break;
-          }
-        } else if (rdm_type != RDM_TYPE_IS_NOT_RDM) {
-          // Parse a standard RDM packet
-          uint8_t msg_len;
-          if (dmx_head < sizeof(rdm_header_t) + 2) {
-            packet_is_complete = false;
-            break;  // Haven't received full RDM header and checksum yet
-          } else if (driver->dmx.data[1] != RDM_SUB_SC ||
-                     !rdm_cc_is_valid(driver->dmx.data[20]) ||
-                     (msg_len = driver->dmx.data[2]) < sizeof(rdm_header_t)) {
-            rdm_type = RDM_TYPE_IS_NOT_RDM;
-            continue;  // Packet is malformed - treat it as DMX
-          } else if (dmx_head < msg_len + 2) {
-            packet_is_complete = false;
-            break;  // Haven't received full RDM packet and checksum yet
-          } else if (!rdm_read_header(dmx_num, NULL)) {
-            rdm_type = RDM_TYPE_IS_NOT_RDM;
-            continue;  // Packet is malformed - treat it as DMX
-          } else {
-            bool responder_sent_last;
-            const rdm_cc_t cc = driver->dmx.data[20];
-            const rdm_pid_t *pid = (rdm_pid_t *)&driver->dmx.data[21];
-            const rdm_uid_t *uid_ptr = (rdm_uid_t *)&driver->dmx.data[3];
-            const rdm_uid_t dest_uid = {.man_id = bswap16(uid_ptr->man_id),
-                                        .dev_id = bswap32(uid_ptr->dev_id)};
-            if (!rdm_cc_is_request(cc)) {
-              rdm_type = RDM_TYPE_IS_RESPONSE;
-              responder_sent_last = true;
-            } else if (rdm_uid_is_broadcast(&dest_uid)) {
-              rdm_type = RDM_TYPE_IS_BROADCAST;
-              responder_sent_last = false;
-            } else {
-              rdm_type = RDM_TYPE_IS_REQUEST;
-              responder_sent_last = false;
-            }
-            if (!responder_sent_last) {
-              taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-              driver->dmx.controller_eop_timestamp = now;
-              driver->dmx.last_controller_pid = bswap16(*pid);
-              taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-            } else {
-              taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-              driver->dmx.last_responder_pid = bswap16(*pid);
-              taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-            }
-            taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-            driver->dmx.responder_sent_last = responder_sent_last;
-            taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-            packet_is_complete = true;
-            break;
-          }
-        } else {
-          // Parse a standard DMX packet
-          // TODO: verify that a data collision hasn't happened
-          taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-          driver->dmx.last_controller_pid = 0;
-          driver->dmx.responder_sent_last = false;
-          taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-          packet_is_complete = (dmx_head >= driver->dmx.size);
-          break;
-        }
-      }
-      if (!packet_is_complete) {
-        continue;
-      }
-      dmx_timer_stop(dmx_num);
-
-      // Set driver flags and notify task
-      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      driver->dmx.progress = DMX_PROGRESS_COMPLETE;
-      driver->dmx.status = DMX_STATUS_IDLE;  // Could still be receiving data
-      if (driver->task_waiting) {
-        xTaskNotifyFromISR(driver->task_waiting, err, eSetValueWithOverwrite,
-                           &task_awoken);
-      }
-      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-    }
-
-    // DMX Transmit #####################################################
-    else if (intr_flags & DMX_INTR_TX_DATA) {
-      // Write data to the UART and clear the interrupt
-      int write_len = driver->dmx.size - driver->dmx.head;
-      dmx_uart_write_txfifo(dmx_num, &driver->dmx.data[driver->dmx.head],
-                            &write_len);
-      driver->dmx.head += write_len;
-      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DATA);
-
-      // Allow FIFO to empty when done writing data
-      if (driver->dmx.head == driver->dmx.size) {
-        dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_DATA);
-      }
-    } else if (intr_flags & DMX_INTR_TX_DONE) {
-      // Disable write interrupts and clear the interrupt
-      dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_ALL);
-      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
-
-      // Record the EOP timestamp if this device is the DMX controller
-      if (driver->is_controller) {
-        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-        driver->dmx.controller_eop_timestamp = now;
-        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      }
-
-      // Update the DMX status and notify task
-      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      driver->dmx.progress = DMX_PROGRESS_COMPLETE;
-      driver->dmx.status = DMX_STATUS_IDLE;
-      if (driver->task_waiting) {
-        xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction,
-                           &task_awoken);
-      }
-      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-
-      // Skip the rest of the ISR loop if an RDM response is not expected
-      if (!driver->is_controller || driver->dmx.last_controller_pid == 0 ||
-          (driver->dmx.last_request_was_broadcast &&
-           driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH)) {
-        continue;
-      }
-
-      // Determine if a DMX break is expected in the response packet
-      int progress;
-      if (driver->dmx.last_controller_pid == RDM_PID_DISC_UNIQUE_BRANCH) {
-        progress = DMX_PROGRESS_IN_DATA;
-        driver->dmx.head = 0;  // Not expecting a DMX break
-      } else {
-        progress = DMX_PROGRESS_STALE;
-        driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
-      }
-
-      // Flip the DMX bus so the response may be read
-      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-      dmx_uart_rxfifo_reset(dmx_num);
-      dmx_uart_set_rts(dmx_num, 1);
-      driver->dmx.progress = progress;
-      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
-    }
+  if (!driver->is_enabled) {
+    return false;  // Received data is ignored while the driver is disabled
+  }
+
+  // The UHCI ends a frame on a DMX break or when the bus goes idle
+  dma_descriptor_t *const desc = (void *)event_data->rx_eof_desc_addr;
+  int dmx_head = desc->dw0.length;
+  desc->dw0.length = 0;
+  if (dmx_head == 0) {
+    return false;  // The bus went idle immediately before a DMX break
+  } else if (dmx_head > driver->packet_size_max) {
+    dmx_head = driver->packet_size_max;
+  }
+
+  const bool task_awoken = dmx_uart_dma_rx_frame(driver, dmx_head, now);
+
+#if DMX_RX_BUFFER_COUNT > 1
+  // Point the DMA at the new ISR buffer before the next frame's slots arrive
+  dma_descriptor_t *const rx_desc = dmx_uart_dma_context.rx_desc;
+  if (rx_desc->buffer != driver->dmx.data) {
+    gdma_stop(channel);
+    gdma_reset(channel);
+    rx_desc->buffer = driver->dmx.data;
+    gdma_start(channel, (intptr_t)rx_desc);
   }
+#endif
 
-  if (task_awoken) portYIELD_FROM_ISR();
+  return task_awoken;
 }
+#endif
 
 bool dmx_uart_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
   struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
@@ -380,6 +149,7 @@ bool dmx_uart_init(dmx_port_t dmx_num, void *isr_context, int isr_flags) {
 
 void dmx_uart_deinit(dmx_port_t dmx_num) {
   struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
+  dmx_uart_dma_deinit(dmx_num);
   if (uart->num != 0) {  // Default UART port for console
     esp_intr_free(uart->isr_handle);
     periph_module_disable(uart_periph_signal[uart->num].module);
@@ -433,6 +203,19 @@ int dmx_uart_get_rts(dmx_port_t dmx_num) {
 #endif
 }
 
+void DMX_ISR_ATTR dmx_uart_set_tx_break(dmx_port_t dmx_num, int break_bits,
+                                        int mab_bits) {
+  struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
+  if (break_bits > DMX_UART_TX_BREAK_BITS_MAX) {
+    break_bits = DMX_UART_TX_BREAK_BITS_MAX;
+  }
+  if (mab_bits > DMX_UART_TX_IDLE_BITS_MAX) {
+    mab_bits = DMX_UART_TX_IDLE_BITS_MAX;
+  }
+  uart_ll_set_tx_idle_num(uart->dev, break_bits > 0 ? mab_bits : 0);
+  uart_ll_tx_break(uart->dev, break_bits);
+}
+
 int DMX_ISR_ATTR dmx_uart_get_interrupt_status(dmx_port_t dmx_num) {
   struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
   return uart_ll_get_intsts_mask(uart->dev);
@@ -473,6 +256,13 @@ void DMX_ISR_ATTR dmx_uart_set_rts(dmx_port_t dmx_num, int set) {
   uart_ll_set_rts_active_level(uart->dev, set);
 }
 
+void DMX_ISR_ATTR dmx_uart_set_rx_threshold(dmx_port_t dmx_num,
+                                             int threshold) {
+  struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
+  uart_ll_set_rxfifo_full_thr(uart->dev, threshold);
+  uart_ll_set_rx_tout(uart->dev, threshold > 1 ? DMX_UART_RX_TOUT_DEFAULT : 0);
+}
+
 void DMX_ISR_ATTR dmx_uart_rxfifo_reset(dmx_port_t dmx_num) {
   struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
   uart_ll_rxfifo_rst(uart->dev);
@@ -495,3 +285,164 @@ void DMX_ISR_ATTR dmx_uart_txfifo_reset(dmx_port_t dmx_num) {
   struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
   uart_ll_txfifo_rst(uart->dev);
 }
+
+#ifdef DMX_UART_DMA_SUPPORTED
+static void dmx_uart_dma_claim(dmx_port_t dmx_num) {
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  if (dma->owner == dmx_num) {
+    return;  // The UHCI has already been initialized for this DMX port
+  }
+
+  // Initialize the UHCI without any SLIP framing so data is sent verbatim
+  periph_module_enable(PERIPH_UHCI0_MODULE);
+  periph_module_reset(PERIPH_UHCI0_MODULE);
+  uhci_ll_init(dma->dev);
+  uhci_seper_chr_t seper_chr = {.sub_chr_en = 0};
+  uhci_ll_set_seper_chr(dma->dev, &seper_chr);
+
+  dma->owner = dmx_num;
+}
+#endif
+
+bool dmx_uart_dma_init(dmx_port_t dmx_num) {
+#ifdef DMX_UART_DMA_SUPPORTED
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  if (dma->owner != -1 && dma->owner != dmx_num) {
+    return false;  // The UHCI is already in use by another DMX port
+  }
+
+  // The DMA descriptor must be placed in DMA-capable memory
+  dma->tx_desc = heap_caps_calloc(1, sizeof(dma_descriptor_t), MALLOC_CAP_DMA);
+  if (dma->tx_desc == NULL) {
+    return false;
+  }
+
+  // Allocate a GDMA channel and connect it to the UHCI
+  const gdma_channel_alloc_config_t channel_config = {
+      .direction = GDMA_CHANNEL_DIRECTION_TX,
+  };
+  if (gdma_new_channel(&channel_config, &dma->tx_channel) != ESP_OK) {
+    heap_caps_free(dma->tx_desc);
+    dma->tx_channel = NULL;
+    return false;
+  }
+  gdma_connect(dma->tx_channel, GDMA_MAKE_TRIGGER(GDMA_TRIG_PERIPH_UHCI, 0));
+  dmx_uart_dma_claim(dmx_num);
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+void dmx_uart_dma_deinit(dmx_port_t dmx_num) {
+#ifdef DMX_UART_DMA_SUPPORTED
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  if (dma->owner != dmx_num) {
+    return;  // This DMX port is not using the UHCI
+  }
+  if (dma->tx_channel != NULL) {
+    gdma_stop(dma->tx_channel);
+    gdma_disconnect(dma->tx_channel);
+    gdma_del_channel(dma->tx_channel);
+    heap_caps_free(dma->tx_desc);
+    dma->tx_channel = NULL;
+  }
+  if (dma->rx_channel != NULL) {
+    gdma_stop(dma->rx_channel);
+    gdma_disconnect(dma->rx_channel);
+    gdma_del_channel(dma->rx_channel);
+    heap_caps_free(dma->rx_desc);
+    dma->rx_channel = NULL;
+  }
+  periph_module_disable(PERIPH_UHCI0_MODULE);
+  dma->owner = -1;
+#endif
+}
+
+void DMX_ISR_ATTR dmx_uart_dma_write(dmx_port_t dmx_num, const void *buf,
+                                     int size) {
+#ifdef DMX_UART_DMA_SUPPORTED
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  dma->tx_desc->dw0.size = size;
+  dma->tx_desc->dw0.length = size;
+  dma->tx_desc->dw0.suc_eof = 1;
+  dma->tx_desc->dw0.owner = DMA_DESCRIPTOR_BUFFER_OWNER_DMA;
+  dma->tx_desc->buffer = (void *)buf;
+  dma->tx_desc->next = NULL;
+
+  // Attach the UHCI to the UART only for the duration of the packet
+  uhci_ll_attach_uart_port(dma->dev, dmx_num);
+  gdma_start(dma->tx_channel, (intptr_t)dma->tx_desc);
+#endif
+}
+
+void DMX_ISR_ATTR dmx_uart_dma_stop(dmx_port_t dmx_num) {
+#ifdef DMX_UART_DMA_SUPPORTED
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  gdma_stop(dma->tx_channel);
+  if (dma->rx_channel != NULL) {
+    return;  // The UHCI must remain attached to receive data
+  }
+
+  // Detach the UHCI so that it does not consume bytes from the UART RX FIFO
+  dma->dev->conf0.val &= ~(UHCI_UART0_CE | UHCI_UART1_CE);
+#ifdef UHCI_UART2_CE
+  dma->dev->conf0.val &= ~UHCI_UART2_CE;
+#endif
+#endif
+}
+
+bool dmx_uart_dma_rx_init(dmx_port_t dmx_num, void *isr_context, void *buf,
+                          int size) {
+#ifdef DMX_UART_DMA_SUPPORTED
+  struct dmx_uart_dma_t *dma = &dmx_uart_dma_context;
+  if (dma->owner != -1 && dma->owner != dmx_num) {
+    return false;  // The UHCI is already in use by another DMX port
+  }
+
+  // Use a single circular descriptor so each frame is written from slot 0
+  dma->rx_desc = heap_caps_calloc(1, sizeof(dma_descriptor_t), MALLOC_CAP_DMA);
+  if (dma->rx_desc == NULL) {
+    return false;
+  }
+  dma->rx_desc->dw0.size = size;
+  dma->rx_desc->dw0.length = 0;
+  dma->rx_desc->dw0.owner = DMA_DESCRIPTOR_BUFFER_OWNER_DMA;
+  dma->rx_desc->buffer = buf;
+  dma->rx_desc->next = dma->rx_desc;
+
+  // Allocate a GDMA channel and connect it to the UHCI
+  const gdma_channel_alloc_config_t channel_config = {
+      .direction = GDMA_CHANNEL_DIRECTION_RX,
+  };
+  if (gdma_new_channel(&channel_config, &dma->rx_channel) != ESP_OK) {
+    heap_caps_free(dma->rx_desc);
+    dma->rx_channel = NULL;
+    return false;
+  }
+  gdma_connect(dma->rx_channel, GDMA_MAKE_TRIGGER(GDMA_TRIG_PERIPH_UHCI, 0));
+  const gdma_strategy_config_t strategy_config = {
+      .owner_check = false,  // The descriptor is reused for every frame
+      .auto_update_desc = false,
+  };
+  gdma_apply_strategy(dma->rx_channel, &strategy_config);
+  gdma_rx_event_callbacks_t rx_cb = {.on_recv_eof = dmx_uart_dma_rx_isr};
+  gdma_register_rx_event_callbacks(dma->rx_channel, &rx_cb, isr_context);
+  dmx_uart_dma_claim(dmx_num);
+
+  // End each frame on a DMX break or when the bus goes idle
+  struct dmx_uart_t *uart = &dmx_uart_context[dmx_num];
+  uart_ll_set_rx_idle_thr(uart->dev, DMX_UART_DMA_RX_IDLE_NUM);
+  uhci_ll_rx_set_eof_mode(dma->dev, UHCI_RX_BREAK_CHR_EOF | UHCI_RX_IDLE_EOF);
+
+  // The UHCI remains attached to the UART while DMA is receiving
+  ((dmx_driver_t *)isr_context)->dmx.rx_err_flags = 0;
+  uhci_ll_attach_uart_port(dma->dev, dmx_num);
+  gdma_start(dma->rx_channel, (intptr_t)dma->rx_desc);
+
+  return true;
+#else
+  return false;
+#endif
+}
@@ -194,6 +194,245 @@ uint32_t dmx_get_mab_len(dmx_port_t dmx_num);
  */
 uint32_t dmx_set_mab_len(dmx_port_t dmx_num, uint32_t mab_len);
 
+/**
+ * @brief Gets the number of DMX slots the UART receives per interrupt.
+ *
+ * @param dmx_num The DMX port number.
+ * @return the current receive interrupt threshold or 0 on error.
+ */
+uint32_t dmx_get_rx_intr_threshold(dmx_port_t dmx_num);
+
+/**
+ * @brief Sets the number of DMX slots the UART receives per interrupt. Values
+ * greater than 1 coalesce DMX slots into fewer interrupts, and the UART receive
+ * timeout is used to read the end of each packet. The threshold is clamped to
+ * between 1 and DMX_RX_INTR_THRESHOLD_MAX. The new value takes effect on the
+ * next DMX break.
+ *
+ * @note RDM packets are always received one slot per interrupt so that RDM
+ * response timing is not affected.
+ *
+ * @param dmx_num The DMX port number.
+ * @param rx_intr_threshold The number of slots to receive per interrupt.
+ * @return the value that the receive interrupt threshold was set to or 0 on
+ * error.
+ */
+uint32_t dmx_set_rx_intr_threshold(dmx_port_t dmx_num,
+                                   uint32_t rx_intr_threshold);
+
+/**
+ * @brief Gets the number of DMX interrupts that were needed to receive the last
+ * complete packet. This can be used to measure the effect of interrupt
+ * coalescing.
+ *
+ * @param dmx_num The DMX port number.
+ * @return the number of receive interrupts for the last packet or 0 on error.
+ */
+uint32_t dmx_get_rx_intr_count(dmx_port_t dmx_num);
+
+/**
+ * @brief Enables or disables change detection on received DMX packets. When
+ * enabled, each received DMX packet is compared to the previous one and
+ * dmx_packet_t reports which blocks of DMX_CHANGED_BLOCK_SIZE slots changed.
+ * When disabled, every slot in each packet is reported as changed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param enable True to enable change detection, false to disable it.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_rx_change_detection(dmx_port_t dmx_num, bool enable);
+
+/**
+ * @brief Enables or disables automatic sizing of transmitted DMX packets. When
+ * enabled, DMX packets which are sent with a size of 0, such as with
+ * dmx_send(), are shortened to the last non-zero slot so that they may be sent
+ * at a higher refresh rate. Packets are never shorter than the minimum size
+ * and a full-sized packet is sent once per refresh period so that receivers
+ * which hold their last values see every slot.
+ *
+ * @note Some DMX receivers do not accept packets which are shorter than 25
+ * slots including the start code.
+ *
+ * @param dmx_num The DMX port number.
+ * @param min_size The minimum size of a DMX packet including the start code,
+ * or 0 to disable automatic sizing.
+ * @param full_period_us The duration in microseconds between full-sized DMX
+ * packets, or 0 to never force a full-sized packet.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_tx_auto_size(dmx_port_t dmx_num, size_t min_size,
+                          uint32_t full_period_us);
+
+/**
+ * @brief Reads the rolling timing statistics of the DMX packets received on a
+ * DMX port. The statistics include the period, jitter, and size of received DMX
+ * packets as well as a histogram of DMX packet periods.
+ *
+ * @note The DMX_RX_TIMING_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] timing A pointer to a dmx_rx_timing_t into which the statistics
+ * are copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_get_rx_timing(dmx_port_t dmx_num, dmx_rx_timing_t *timing);
+
+/**
+ * @brief Resets the rolling timing statistics of the DMX packets received on a
+ * DMX port.
+ *
+ * @note The DMX_RX_TIMING_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_reset_rx_timing(dmx_port_t dmx_num);
+
+/**
+ * @brief Reads the counters of the packets and errors seen by the DMX driver on
+ * a DMX port. The counters include the number of packets sent and received,
+ * the number of each receive error, the number of RDM packets received by
+ * type, and the number of RDM responses which missed their deadline.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer to a dmx_stats_t into which the counters are
+ * copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_get_stats(dmx_port_t dmx_num, dmx_stats_t *stats);
+
+/**
+ * @brief Resets the counters of the packets and errors seen by the DMX driver
+ * on a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_reset_stats(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the interrupt events which were traced on a DMX port since the
+ * last call to this function, oldest first. Each event is a dmx_trace_event_t
+ * of 8 bytes, so the copied events may be exported as-is in a compact binary
+ * form. Events which were overwritten before they could be copied are counted
+ * in dropped. Only one task should drain a DMX port at a time.
+ *
+ * @note The DMX_TRACE option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] events An array into which the events are copied.
+ * @param count The maximum number of events to copy.
+ * @param[out] dropped A pointer to a value which is set to the number of events
+ * which were lost. May be NULL.
+ * @return The number of events which were copied.
+ */
+size_t dmx_trace_drain(dmx_port_t dmx_num, dmx_trace_event_t *events,
+                       size_t count, uint32_t *dropped);
+
+/**
+ * @brief Subscribes a FreeRTOS queue to the packets received on a DMX port.
+ * Each time a packet is received, the DMX interrupt handler sends a dmx_packet_t
+ * to every subscribed queue. This allows several tasks to wait for packets on
+ * the same DMX port without blocking each other in dmx_receive(). If a queue is
+ * full, the packet is not sent to that queue.
+ *
+ * @note The queue must be created with an item size of sizeof(dmx_packet_t).
+ * The change detection fields of the dmx_packet_t report that every slot has
+ * changed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param queue The queue which receives the packets.
+ * @return true on success.
+ * @return false if the maximum number of subscribers has been reached.
+ */
+bool dmx_subscribe(dmx_port_t dmx_num, QueueHandle_t queue);
+
+/**
+ * @brief Unsubscribes a FreeRTOS queue which was subscribed with
+ * dmx_subscribe(). After this function returns, the DMX driver does not send
+ * any more packets to the queue.
+ *
+ * @param dmx_num The DMX port number.
+ * @param queue The queue to unsubscribe.
+ * @return true on success.
+ * @return false if the queue was not subscribed.
+ */
+bool dmx_unsubscribe(dmx_port_t dmx_num, QueueHandle_t queue);
+
+/**
+ * @brief Sets a callback which is invoked from the DMX interrupt handler each
+ * time a packet is done being received. The callback receives the size, start
+ * code, and error code of the packet so that latency-critical code may act on
+ * the packet without waiting for a task to wake. The callback is invoked in
+ * addition to notifying any task which is blocked in dmx_receive().
+ *
+ * @note The callback runs in an interrupt context. It must be short, must not
+ * block, and must be placed in IRAM if the DMX driver is placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param callback The callback to invoke, or NULL to remove the callback.
+ * @param context A pointer which is passed to the callback.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_rx_callback(dmx_port_t dmx_num, dmx_rx_callback_t callback,
+                         void *context);
+
+/**
+ * @brief Sets the action which the DMX ISR takes for packets with a start
+ * code. By default, packets of every start code are delivered to the DMX
+ * buffer and wake the task which is waiting in dmx_receive(). Dropped packets
+ * are discarded without waking any task, and when the DMX port receives
+ * without DMA, the slots after their start code are not copied. Routed packets
+ * are passed to the handler which is set with dmx_set_sc_handler() instead of
+ * being delivered. Packets which are dropped or routed are not passed to the
+ * receive callback, the subscribers, or the receive queue. RDM start codes are
+ * always delivered.
+ *
+ * @note The start code filter is bypassed while the DMX port is repeating its
+ * packets to other DMX ports.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sc The start code.
+ * @param action The action to take for packets with the start code.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_sc_action(dmx_port_t dmx_num, int sc, dmx_sc_action_t action);
+
+/**
+ * @brief Gets the action which the DMX ISR takes for packets with a start
+ * code.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sc The start code.
+ * @return The action which is taken for packets with the start code.
+ */
+dmx_sc_action_t dmx_get_sc_action(dmx_port_t dmx_num, int sc);
+
+/**
+ * @brief Sets a handler which is invoked from the DMX ISR each time a packet
+ * with a start code which is routed with dmx_set_sc_action() is done being
+ * received. Routed packets are dropped while no handler is set.
+ *
+ * @note The handler runs in an interrupt context. It must be short, must not
+ * block, and must be placed in IRAM if the DMX driver is placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param handler The handler to invoke, or NULL to remove the handler.
+ * @param context A pointer which is passed to the handler.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_set_sc_handler(dmx_port_t dmx_num, dmx_sc_handler_t handler,
+                        void *context);
+
 /**
  * @brief Reads DMX data from the driver into a destination buffer with an
  * offset. This can be useful when a receiving DMX device only needs to process
@@ -230,6 +469,57 @@ size_t dmx_read(dmx_port_t dmx_num, void *destination, size_t size);
  */
 int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num);
 
+/**
+ * @brief Lends a pointer to the last complete DMX frame so that it may be read
+ * without copying it. While the frame is acquired, the DMX driver will not
+ * overwrite it. The frame must be released with dmx_read_release() before it
+ * can be acquired again.
+ *
+ * @note The frame is only stable if the DMX_RX_TRIPLE_BUFFER option is enabled
+ * in the Kconfig. Otherwise, the frame may be overwritten when a new packet is
+ * received, as with dmx_read().
+ *
+ * @param dmx_num The DMX port number.
+ * @return A pointer to the DMX frame, which is dmx_config_t.packet_size_max
+ * bytes long, or NULL on failure.
+ */
+const uint8_t *dmx_read_acquire(dmx_port_t dmx_num);
+
+/**
+ * @brief Returns a DMX frame which was lent by dmx_read_acquire().
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false if the frame was not acquired.
+ */
+bool dmx_read_release(dmx_port_t dmx_num);
+
+/**
+ * @brief Lends a pointer to a DMX buffer so that the next DMX packet may be
+ * filled without copying it into the DMX driver. The buffer initially contains
+ * the current DMX packet. After it is filled, the buffer must be released with
+ * dmx_write_release(). It is sent by swapping it with the DMX driver buffer at
+ * the start of the next DMX packet.
+ *
+ * @note Write buffers cannot be acquired when the DMX driver receives with
+ * DMX_RX_MODE_DMA.
+ *
+ * @param dmx_num The DMX port number.
+ * @return A pointer to the DMX buffer, which is dmx_config_t.packet_size_max
+ * bytes long, or NULL on failure.
+ */
+uint8_t *dmx_write_acquire(dmx_port_t dmx_num);
+
+/**
+ * @brief Releases a DMX buffer which was lent by dmx_write_acquire() so that it
+ * is sent in the next DMX packet.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false if the buffer was not acquired.
+ */
+bool dmx_write_release(dmx_port_t dmx_num);
+
 /**
  * @brief Writes DMX data from a source buffer into the DMX driver buffer with
  * an offset. Allows a source buffer to be written to a specific slot number in
@@ -308,6 +598,143 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
 size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
                    TickType_t wait_ticks);
 
+/**
+ * @brief Receives a DMX packet, but only unblocks when the packet differs from
+ * the previous DMX packet. Packets with a non-zero start code, such as RDM
+ * packets, and packets with errors always unblock.
+ * Change detection must be enabled with dmx_set_rx_change_detection() or else
+ * this function is equivalent to dmx_receive().
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The size of the received DMX packet or 0 if no changed packet was
+ * received.
+ */
+size_t dmx_receive_changed(dmx_port_t dmx_num, dmx_packet_t *packet,
+                           TickType_t wait_ticks);
+
+/**
+ * @brief Receives the DMX footprint of this device and copies it into a
+ * destination buffer. The footprint window begins at the DMX start address and
+ * its size is the footprint of the current DMX personality. This function
+ * unblocks as soon as the last slot in the footprint window is received
+ * instead of waiting for the full DMX packet. Changes to the DMX start address
+ * or DMX personality take effect on the next call.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] destination The destination buffer into which to read the DMX
+ * footprint.
+ * @param size The size of the destination buffer.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The number of slots copied into the destination buffer or 0 if the
+ * footprint was not received.
+ */
+size_t dmx_receive_footprint(dmx_port_t dmx_num, void *destination,
+                             size_t size, dmx_packet_t *packet,
+                             TickType_t wait_ticks);
+
+/**
+ * @brief Receives a DMX packet from whichever of several DMX ports completes a
+ * packet first. This allows a single task to receive every universe instead of
+ * blocking one task per DMX port in dmx_receive(). Each DMX driver notifies
+ * the waiting task from its interrupts when a packet is complete. If several
+ * DMX ports already have a complete packet, the first one in the array is
+ * returned.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability. Only one task may
+ * wait on a DMX port at a time, and the DMX ports should not be received by
+ * other tasks at the same time. RDM responses are not awaited, so RDM
+ * controllers should use dmx_receive() instead.
+ *
+ * @param[in] ports An array of the DMX port numbers to wait on.
+ * @param count The number of DMX ports in the array.
+ * @param[out] packet An optional pointer to a dmx_packet_t which contains
+ * information about the received DMX packet.
+ * @param wait_ticks The number of ticks to wait before this function times out.
+ * @return The DMX port number which received a packet or DMX_NUM_MAX if no
+ * packet was received.
+ */
+dmx_port_t dmx_receive_any(const dmx_port_t *ports, size_t count,
+                           dmx_packet_t *packet, TickType_t wait_ticks);
+
+/**
+ * @brief Enables the receive queue of a DMX port. The DMX driver copies each
+ * packet it receives into the next free frame of the queue as soon as the
+ * packet is complete, so that a consumer which falls behind does not lose
+ * packets which are overwritten in the DMX driver buffer. Packets which are
+ * received while the queue is full are dropped and counted. The frames of the
+ * queue are preallocated with the memory capabilities of the DMX port and are
+ * each as large as the packet_size_max of the DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The number of frames in the queue. Must be a power of two and
+ * greater than 1.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_rx_queue_enable(dmx_port_t dmx_num, size_t size);
+
+/**
+ * @brief Disables the receive queue of a DMX port and frees its frames. Frames
+ * which were acquired with dmx_rx_queue_acquire() become invalid.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_rx_queue_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Acquires a batch of the oldest frames in the receive queue of a DMX
+ * port without copying their slots. The slot pointers of the frames remain
+ * valid until the frames are released with dmx_rx_queue_release(). Calling
+ * this function again before releasing the frames returns the same frames
+ * again, followed by any frames which were queued since.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability. Only one task may
+ * consume the receive queue of a DMX port at a time.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] frames An array of dmx_frame_t into which the frames are copied.
+ * @param count The number of frames in the array.
+ * @param[out] dropped An optional pointer into which the number of frames
+ * which were dropped since the last call to this function is written.
+ * @param wait_ticks The number of ticks to wait for a frame to be queued if
+ * the queue is empty.
+ * @return The number of frames which were acquired.
+ */
+size_t dmx_rx_queue_acquire(dmx_port_t dmx_num, dmx_frame_t *frames,
+                            size_t count, uint32_t *dropped,
+                            TickType_t wait_ticks);
+
+/**
+ * @brief Releases the oldest frames in the receive queue of a DMX port so that
+ * the DMX driver may reuse them for new packets. Frames must be released in
+ * the order in which they were acquired.
+ *
+ * @param dmx_num The DMX port number.
+ * @param count The number of frames to release. It is clamped to the number of
+ * frames in the queue.
+ * @return The number of frames which were released.
+ */
+size_t dmx_rx_queue_release(dmx_port_t dmx_num, size_t count);
+
 /**
  * @brief Sends a DMX packet on the DMX bus. This function blocks until the DMX
  * driver is idle and then sends a packet.
@@ -317,8 +744,9 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
  * can lead to undesired behavior and program instability.
  *
  * @param dmx_num The DMX port number.
- * @param size The size of the packet to send. If 0, sends a full DMX packet. If
- * an RDM packet was written, this value is ignored.
+ * @param size The size of the packet to send. If 0, sends a full DMX packet, or
+ * an automatically sized packet if enabled with dmx_set_tx_auto_size(). If an
+ * RDM packet was written, this value is ignored.
  * @return The number of bytes sent on the DMX bus.
  */
 size_t dmx_send_num(dmx_port_t dmx_num, size_t size);
@@ -337,6 +765,93 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size);
  */
 size_t dmx_send(dmx_port_t dmx_num);
 
+/**
+ * @brief Queues a DMX packet to be sent on the DMX bus and returns without
+ * blocking. The DMX driver starts the packet from its interrupts as soon as
+ * the packet which is being sent is done and the RDM controller timing allows.
+ * Data written with dmx_write() before this function is called is sent in the
+ * queued packet. A write buffer which was released with dmx_write_release() is
+ * swapped into the DMX driver when the queued packet starts, so it can be
+ * filled while the previous packet is still being sent. It should not be
+ * acquired again until the queued packet has started. Only one packet may be
+ * queued at a time.
+ *
+ * @note RDM packets cannot be sent asynchronously; they must be sent with
+ * dmx_send_num() or the rdm_send_ functions. This function may not be used
+ * while continuous sending is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the packet to send. If 0, sends a full DMX packet, or
+ * an automatically sized packet if enabled with dmx_set_tx_auto_size().
+ * @param callback An optional callback which is invoked from the DMX interrupt
+ * handler when the queued packet is done being sent, or NULL.
+ * @param context A pointer which is passed to the callback.
+ * @return true if the packet was queued.
+ * @return false if a packet is already queued, if the driver is being used by
+ * another task, or on failure.
+ */
+bool dmx_send_async(dmx_port_t dmx_num, size_t size,
+                    dmx_tx_callback_t callback, void *context);
+
+/**
+ * @brief Sends a DMX packet on each DMX port in a group so that the DMX
+ * packets are phase-aligned. This function blocks until each DMX driver is
+ * idle and then starts the DMX break on every port in the group from a single
+ * hardware timer event.
+ *
+ * @note This function uses FreeRTOS direct-to-task notifications to block and
+ * unblock. Using task notifications on the same task that calls this function
+ * can lead to undesired behavior and program instability.
+ *
+ * @param group An array of the DMX port numbers in the group.
+ * @param group_size The number of DMX ports in the group.
+ * @param size The size of the packet to send on each port. If 0, sends a full
+ * DMX packet.
+ * @param[out] skew An optional pointer which receives the measured skew in
+ * microseconds between the first and the last DMX break in the group.
+ * @return The number of bytes sent on each DMX port, or 0 on failure.
+ */
+size_t dmx_sync_send_num(const dmx_port_t *group, size_t group_size,
+                         size_t size, uint32_t *skew);
+
+/**
+ * @brief Starts repeating the packets received on a DMX port on one or more
+ * other DMX ports, as an opto-splitter would. The DMX break is started on the
+ * outputs as soon as it is received on the source, and each slot is written to
+ * the UART of the outputs from the source's interrupts as soon as it arrives,
+ * so the outputs lag the source by much less than a DMX packet. RDM packets are
+ * repeated only if they are forwarded. A dropped RDM packet is sent as a DMX
+ * break without slots because its start code arrives after the DMX break has
+ * started.
+ *
+ * @note The source must use DMX_RX_MODE_FIFO and the outputs must use
+ * DMX_TX_MODE_FIFO. The latency is shortest with a low rx_intr_threshold on the
+ * source. If an output uses a DMX break and mark-after-break which are longer
+ * than those of the source, its latency grows until it stays behind the source
+ * by its remaining inter-packet time. Packets should not be sent on the outputs
+ * while repeating.
+ *
+ * @param dmx_num The DMX port number of the source.
+ * @param[in] outputs An array of the DMX port numbers of the outputs.
+ * @param output_count The number of outputs.
+ * @param forward_rdm True to repeat RDM packets as well as DMX packets.
+ * Responses from devices on the outputs are not repeated back to the source.
+ * @return true if repeating was started.
+ * @return false on failure.
+ */
+bool dmx_repeater_start(dmx_port_t dmx_num, const dmx_port_t *outputs,
+                        size_t output_count, bool forward_rdm);
+
+/**
+ * @brief Stops repeating the packets received on a DMX port. Each output
+ * finishes sending the slots it has already received before it is released.
+ *
+ * @param dmx_num The DMX port number of the source.
+ * @return true if repeating was stopped.
+ * @return false on failure.
+ */
+bool dmx_repeater_stop(dmx_port_t dmx_num);
+
 /**
  * @brief Waits until the DMX packet is done being sent. This function can be
  * used to ensure that calls to dmx_write() happen synchronously with the
@@ -353,6 +868,141 @@ size_t dmx_send(dmx_port_t dmx_num);
  */
 bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks);
 
+/**
+ * @brief Starts sending DMX packets continuously. After it is started, the DMX
+ * driver re-sends the DMX packet from its interrupts every refresh period
+ * without the need for a task to call dmx_send(). Data written with
+ * dmx_write() is sent at the start of the next DMX packet. RDM requests may
+ * still be sent while sending continuously; they are sent between DMX packets.
+ *
+ * @note While continuous sending is running, dmx_send() and dmx_wait_sent()
+ * should not be called. Continuous sending must be stopped before the DMX
+ * driver can be disabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the DMX packets to send. If 0, sends full DMX
+ * packets, or automatically sized packets if enabled with
+ * dmx_set_tx_auto_size().
+ * @param period_us The duration in microseconds from the start of one DMX
+ * packet to the start of the next. If the period is shorter than the duration
+ * of a DMX packet, packets are sent back-to-back.
+ * @return true if continuous sending was started.
+ * @return false on failure.
+ */
+bool dmx_continuous_start(dmx_port_t dmx_num, size_t size,
+                          uint32_t period_us);
+
+/**
+ * @brief Stops sending DMX packets continuously. This function blocks until
+ * the DMX packet which is currently being sent is done.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if continuous sending was stopped.
+ * @return false on failure.
+ */
+bool dmx_continuous_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Checks if the DMX driver is sending DMX packets continuously.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if continuous sending is running.
+ * @return false if continuous sending is not running.
+ */
+bool dmx_continuous_is_running(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts merging the DMX frames received on two DMX ports into the DMX
+ * packets which are sent continuously on this DMX port. At the start of each
+ * DMX packet, the last complete DMX frames of both inputs are merged into the
+ * DMX buffer four slots at a time. Slots whose bit is set in the priority mask
+ * are merged latest-takes-precedence (LTP): the value from the input which
+ * changed the slot most recently is sent. All other slots are merged
+ * highest-takes-precedence (HTP). Only DMX frames with a NULL start code are
+ * merged.
+ *
+ * An input which does not receive a DMX frame within the timeout is lost and
+ * is not merged until it receives another DMX frame. While both inputs are
+ * lost, the last merged DMX packet is held, though data written with
+ * dmx_write() is still sent.
+ *
+ * @note The DMX_RX_TRIPLE_BUFFER option must be enabled in the Kconfig.
+ * Continuous sending must be started on this DMX port with
+ * dmx_continuous_start() before the merge is started. Stopping continuous
+ * sending also stops the merge.
+ *
+ * @param dmx_num The DMX port number of the output.
+ * @param input_a The DMX port number of the first input.
+ * @param input_b The DMX port number of the second input.
+ * @param[in] config A pointer to the merge configuration, or NULL to merge all
+ * slots HTP with the default timeout.
+ * @return true if the merge was started.
+ * @return false on failure.
+ */
+bool dmx_merge_start(dmx_port_t dmx_num, dmx_port_t input_a,
+                     dmx_port_t input_b, const dmx_merge_config_t *config);
+
+/**
+ * @brief Stops merging into the DMX packets which are sent continuously. The
+ * last merged DMX packet continues to be sent until it is written with
+ * dmx_write().
+ *
+ * @param dmx_num The DMX port number of the output.
+ * @return true if the merge was stopped.
+ * @return false on failure.
+ */
+bool dmx_merge_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the statistics of the last merge which was started on a DMX
+ * port, including the latency of each input and how often it was lost.
+ *
+ * @note The DMX_RX_TRIPLE_BUFFER option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number of the output.
+ * @param[out] stats A pointer to a dmx_merge_stats_t into which the statistics
+ * are copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_merge_get_stats(dmx_port_t dmx_num, dmx_merge_stats_t *stats);
+
+/**
+ * @brief Fades a range of slots to target values in the DMX packets which are
+ * sent continuously. At the start of each DMX packet, the DMX driver's
+ * interrupts step every fading slot towards its target using fixed-point
+ * interpolation, so slots change smoothly even when they are written much less
+ * often than the DMX refresh rate. Only the slots which are fading are stepped.
+ * Fades start from the values which are currently being sent. Slots which are
+ * already fading are taken over by the new fade. Data written with dmx_write()
+ * to a fading slot is overwritten until the fade is done.
+ *
+ * @note Continuous sending must be started on this DMX port with
+ * dmx_continuous_start() before a fade is started. Stopping continuous sending
+ * sets all fading slots to their targets.
+ *
+ * @param dmx_num The DMX port number.
+ * @param offset The first slot to fade. The DMX start code may not be faded.
+ * @param[in] targets A pointer to the target value of each slot.
+ * @param size The number of slots to fade.
+ * @param fade_us The duration of the fade in microseconds. If 0, the slots are
+ * set to their targets at the start of the next DMX packet.
+ * @return true if the fade was started.
+ * @return false on failure, or if DMX_FADES_MAX fades are already running.
+ */
+bool dmx_fade_start(dmx_port_t dmx_num, size_t offset, const void *targets,
+                    size_t size, uint32_t fade_us);
+
+/**
+ * @brief Stops every fade on a DMX port. Fading slots are set to their targets
+ * at the start of the next DMX packet.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_fade_stop(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,91 @@
+/**
+ * @file dmx/include/isr.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the interrupt handlers of the DMX driver. The
+ * handlers implement the DMX and RDM state machines using only the functions
+ * declared in the Hardware Abstraction Layer (HAL) headers, so that they can be
+ * shared by each HAL backend. This file is not considered part of the API and
+ * should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dmx/include/service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The DMX UART interrupt handler. It should be called by the UART HAL
+ * whenever a DMX UART interrupt is raised.
+ *
+ * @param[in] arg A pointer to the DMX driver.
+ */
+void dmx_uart_isr(void *arg);
+
+/**
+ * @brief Processes a frame of slot data which was received by DMA. It should be
+ * called by the UART HAL when the DMA ends a received frame.
+ *
+ * @param[in] driver A pointer to the DMX driver.
+ * @param dmx_head The number of slots received in the frame.
+ * @param now The current timestamp in microseconds since boot.
+ * @return true if a higher priority task was woken.
+ */
+bool dmx_uart_dma_rx_frame(dmx_driver_t *driver, int dmx_head, int64_t now);
+
+/**
+ * @brief Records that a DMX packet has started to be sent for the RDM
+ * transaction scheduler. Must be called from within a critical section.
+ *
+ * @param[in] driver A pointer to the DMX driver.
+ * @param now The current timestamp in microseconds since boot.
+ * @param[out] task_awoken Set to true if a higher priority task was woken.
+ */
+void dmx_schedule_count_frame(dmx_driver_t *driver, int64_t now,
+                              int *task_awoken);
+
+/**
+ * @brief Gets the size of the next automatically sized DMX packet. Trailing
+ * null slots are trimmed from the DMX buffer, but not below the minimum size,
+ * and a full-sized packet is returned once per refresh period. Must be called
+ * from within a critical section.
+ *
+ * @param[in] driver A pointer to the DMX driver.
+ * @param now The current timestamp in microseconds since boot.
+ * @return The size of the DMX packet to send including the start code.
+ */
+int dmx_auto_size_get(dmx_driver_t *driver, int64_t now);
+
+/**
+ * @brief Writes the slots of a repeated DMX packet which have been received to
+ * the UART of a repeater output. Must be called from within a critical section
+ * of the output port.
+ *
+ * @param[in] output A pointer to the DMX driver of the repeater output.
+ */
+void dmx_repeater_write(dmx_driver_t *output);
+
+/**
+ * @brief The DMX timer interrupt handler. It should be called by the timer HAL
+ * each time the timer alarm fires.
+ *
+ * @param[in] arg A pointer to the DMX driver.
+ * @return true if a higher priority task was woken.
+ */
+bool dmx_timer_isr(void *arg);
+
+/**
+ * @brief The DMX sniffer interrupt handler. It should be called by the GPIO HAL
+ * on each edge of the sniffer pin.
+ *
+ * @param[in] arg A pointer to the DMX driver.
+ */
+void dmx_gpio_isr(void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file dmx/include/parallel.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains the functions which are used by the DMX driver to
+ * write and send packets on the parallel DMX output ports. This file is not
+ * considered part of the API and should not be included by the user.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Evaluates to true if the DMX port is a parallel DMX output port.
+ *
+ * @param dmx_num The DMX port number.
+ */
+#define dmx_num_is_parallel(dmx_num) ((dmx_num) >= DMX_NUM_UART_MAX)
+
+/**
+ * @brief Writes to the packet buffer of a parallel DMX port. The data is sent
+ * in the next call to dmx_parallel_send_num() on any parallel DMX port.
+ *
+ * @param dmx_num The parallel DMX port number.
+ * @param offset The number of slots with which to offset the write.
+ * @param[in] source A pointer to the data to write.
+ * @param size The number of slots to write.
+ * @return The number of slots which were written.
+ */
+size_t dmx_parallel_write_offset(dmx_port_t dmx_num, size_t offset,
+                                 const void *source, size_t size);
+
+/**
+ * @brief Sends the packets of every parallel DMX port. The size of the packet
+ * of the specified DMX port is updated before the packets are sent. The
+ * packets of the other parallel DMX ports are sent with their previous size.
+ * This function blocks until the previous parallel DMX packets are done being
+ * sent, and then returns as soon as the new packets are handed to DMA. Every
+ * call sends the packets of every parallel DMX port.
+ *
+ * @param dmx_num The parallel DMX port number.
+ * @param size The size of the packet of the DMX port, or 0 to send the
+ * previous size.
+ * @return The size of the packet of the DMX port, or 0 on failure.
+ */
+size_t dmx_parallel_send_num(dmx_port_t dmx_num, size_t size);
+
+/**
+ * @brief Waits until the parallel DMX packets are done being sent.
+ *
+ * @param dmx_num The parallel DMX port number.
+ * @param wait_ticks The number of FreeRTOS ticks to wait.
+ * @return true if the parallel DMX packets are done being sent.
+ * @return false if the timeout elapsed.
+ */
+bool dmx_parallel_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks);
+
+#ifdef __cplusplus
+}
+#endif
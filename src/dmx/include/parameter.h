@@ -25,6 +25,20 @@ extern "C" {
  */
 int dmx_sub_device_get_count(dmx_port_t dmx_num);
 
+/**
+ * @brief Adds a sub-device to the DMX driver. Sub-devices are stored in a table
+ * which is allocated by dmx_driver_install(), so the sub-device number must be
+ * no greater than the sub_device_count field of the DMX configuration. Each
+ * sub-device may support as many parameters as the sub_device_parameter_count
+ * field of the DMX configuration.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number.
+ * @return true on success or if the sub-device already exists.
+ * @return false on failure.
+ */
+bool dmx_sub_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num);
+
 /**
  * @brief Returns true if the sub-device exists.
  *
@@ -87,7 +101,8 @@ void *dmx_parameter_get_data(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
  * @brief Copies the desired parameter to a destination buffer. Unlike
  * dmx_parameter_get(), this function is thread-safe. Because the parameter is
  * copied to a buffer, updates to the parameter will not affect the copied
- * parameter.
+ * parameter. The parameter is copied without entering a critical section, and
+ * the copy is retried if the parameter was updated while it was being copied.
  *
  * @param dmx_num The DMX port number.
  * @param sub_device The sub-device number.
@@ -114,16 +129,49 @@ size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                          rdm_pid_t pid, const void *source, size_t size);
 
 /**
- * @brief Commits any updated non-volatile parameters to non-volatile storage.
- * Because committing non-volatile parameters can take some time, this function
- * commits only one parameter per function call. This function is not
- * thread-safe.
+ * @brief Sets the value of a desired parameter on the root device and on every
+ * sub-device which supports the parameter. Because sub-devices support the
+ * same parameters as each other, the parameter is usually found at the same
+ * index of each sub-device, so each sub-device is updated without searching
+ * its parameters.
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The parameter ID of the desired parameter.
+ * @param[in] source The value to which to set the parameter.
+ * @param size The size of the source buffer.
+ * @return The number of devices on which the parameter was set.
+ */
+size_t dmx_parameter_set_all(dmx_port_t dmx_num, rdm_pid_t pid,
+                             const void *source, size_t size);
+
+/**
+ * @brief Commits every updated non-volatile parameter to non-volatile storage
+ * in a single NVS transaction. The parameters are copied before they are
+ * written so they may be set again while the commit is in progress. Parameters
+ * are normally committed by a background task, so this function only needs to
+ * be called when CONFIG_DMX_NVS_COMMIT_TASK is disabled or to commit
+ * parameters at a time of the caller's choosing, such as while the DMX bus is
+ * idle.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of parameters that were committed or 0 if there are no
+ * parameters waiting to be committed.
+ */
+size_t dmx_parameter_commit(dmx_port_t dmx_num);
+
+/**
+ * @brief Reads the memory used by parameters on a DMX port. This may be used to
+ * tune dmx_config_t.parameter_memory_size so that no parameter data needs to be
+ * allocated on the heap and no reserved memory is wasted.
  *
  * @param dmx_num The DMX port number.
- * @return The parameter ID of the parameter that was committed or 0 if there
- * are no parameters waiting to be committed.
+ * @param[out] memory A pointer to a dmx_parameter_memory_t into which the
+ * memory usage is copied.
+ * @return true on success.
+ * @return false on failure.
  */
-rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num);
+bool dmx_parameter_get_memory(dmx_port_t dmx_num,
+                              dmx_parameter_memory_t *memory);
 
 #ifdef __cplusplus
 }
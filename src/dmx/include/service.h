@@ -57,8 +57,167 @@ extern "C" {
 typedef spinlock_t dmx_spinlock_t;
 #define DMX_SPINLOCK_INIT portMUX_INITIALIZER_UNLOCKED
 
+/** @brief Begins an update of the DMX packet state. The DMX packet state is
+ * protected by a sequence counter so that tasks may read it using
+ * dmx_driver_get_state() without entering a critical section. Writers must
+ * still be serialized using the DMX spinlock or by running in the DMX ISR.*/
+#define DMX_STATE_WRITE_BEGIN(driver)                               \
+  do {                                                              \
+    __atomic_store_n(&(driver)->dmx.seq, (driver)->dmx.seq + 1,     \
+                     __ATOMIC_RELAXED);                             \
+    __atomic_thread_fence(__ATOMIC_RELEASE);                        \
+  } while (0)
+
+/** @brief Ends an update of the DMX packet state which was started with
+ * DMX_STATE_WRITE_BEGIN().*/
+#define DMX_STATE_WRITE_END(driver)                             \
+  __atomic_store_n(&(driver)->dmx.seq, (driver)->dmx.seq + 1, \
+                   __ATOMIC_RELEASE)
+
+/** @brief Begins an update of the data of a dmx_parameter_t. The parameter data
+ * is protected by a sequence counter so that tasks may copy it using
+ * dmx_parameter_copy() without entering a critical section. Writers must still
+ * be serialized using the DMX spinlock.*/
+#define DMX_PARAMETER_WRITE_BEGIN(entry)                    \
+  do {                                                      \
+    __atomic_store_n(&(entry)->seq, (entry)->seq + 1,       \
+                     __ATOMIC_RELAXED);                     \
+    __atomic_thread_fence(__ATOMIC_RELEASE);                \
+  } while (0)
+
+/** @brief Ends an update of the data of a dmx_parameter_t which was started
+ * with DMX_PARAMETER_WRITE_BEGIN().*/
+#define DMX_PARAMETER_WRITE_END(entry)                \
+  __atomic_store_n(&(entry)->seq, (entry)->seq + 1, __ATOMIC_RELEASE)
+
+/** @brief Gets the dmx_sc_action_t of the start code filter of a DMX driver
+ * for a start code.*/
+#define DMX_SC_FILTER_GET(driver, sc) \
+  (((driver)->sc_filter.actions[(sc) >> 4] >> (((sc) & 15) * 2)) & 3)
+
+/** @brief Discards the cached RDM header of the packet in the DMX buffer. Must
+ * be used whenever the contents of the DMX buffer are changed.*/
+#define DMX_RDM_HEADER_INVALIDATE(driver)       \
+  do {                                          \
+    (driver)->dmx.rdm_header_is_cached = false; \
+    (driver)->dmx.rx_checksum_len = 0;          \
+  } while (0)
+
 extern const char *TAG;  // The log tagline for the library.
 
+#ifdef CONFIG_DMX_RX_TRIPLE_BUFFER
+#define DMX_RX_BUFFER_COUNT (3)
+#else
+#define DMX_RX_BUFFER_COUNT (1)
+#endif
+
+#ifndef CONFIG_DMX_SUBSCRIBERS_MAX
+/** @brief The maximum number of packet subscribers per DMX port.*/
+#define DMX_SUBSCRIBERS_MAX (4)
+#else
+#define DMX_SUBSCRIBERS_MAX CONFIG_DMX_SUBSCRIBERS_MAX
+#endif
+
+#ifndef CONFIG_DMX_FADES_MAX
+/** @brief The maximum number of slot ranges which may fade at once per DMX
+ * port.*/
+#define DMX_FADES_MAX (8)
+#else
+#define DMX_FADES_MAX CONFIG_DMX_FADES_MAX
+#endif
+
+#ifndef CONFIG_RDM_ACK_TIMER_MAX_DELAY
+/** @brief The longest RDM_RESPONSE_TYPE_ACK_TIMER delay, in milliseconds, that
+ * an RDM controller request waits for before giving up on a deferred
+ * response.*/
+#define RDM_ACK_TIMER_MAX_DELAY (2000)
+#else
+#define RDM_ACK_TIMER_MAX_DELAY CONFIG_RDM_ACK_TIMER_MAX_DELAY
+#endif
+
+#ifndef CONFIG_RDM_ASYNC_QUEUE_SIZE
+/** @brief The maximum number of asynchronous RDM requests which may be queued
+ * per DMX port.*/
+#define RDM_ASYNC_QUEUE_SIZE (8)
+#else
+#define RDM_ASYNC_QUEUE_SIZE CONFIG_RDM_ASYNC_QUEUE_SIZE
+#endif
+
+#ifndef CONFIG_RDM_RESPONDER_SELECT_MAX
+/** @brief The maximum number of tasks which may select a virtual responder at
+ * once per DMX port.*/
+#define RDM_RESPONDER_SELECT_MAX (4)
+#else
+#define RDM_RESPONDER_SELECT_MAX CONFIG_RDM_RESPONDER_SELECT_MAX
+#endif
+
+#ifndef CONFIG_RDM_LATENCY_UIDS
+/** @brief The number of responder UIDs whose RDM round-trip statistics are
+ * kept per DMX port.*/
+#define RDM_LATENCY_UIDS (16)
+#else
+#define RDM_LATENCY_UIDS CONFIG_RDM_LATENCY_UIDS
+#endif
+
+#ifndef CONFIG_RDM_LATENCY_PIDS
+/** @brief The number of PIDs whose RDM round-trip statistics are kept per DMX
+ * port.*/
+#define RDM_LATENCY_PIDS (16)
+#else
+#define RDM_LATENCY_PIDS CONFIG_RDM_LATENCY_PIDS
+#endif
+
+#ifndef CONFIG_DMX_NVS_COMMIT_DELAY
+/** @brief The time in milliseconds that non-volatile parameters must stay
+ * unchanged before they are committed to NVS by the commit task.*/
+#define DMX_NVS_COMMIT_DELAY (500)
+#else
+#define DMX_NVS_COMMIT_DELAY CONFIG_DMX_NVS_COMMIT_DELAY
+#endif
+
+#ifdef CONFIG_DMX_TRACE
+#ifndef CONFIG_DMX_TRACE_EVENTS
+/** @brief The number of interrupt events kept in each trace ring buffer.*/
+#define DMX_TRACE_EVENTS (128)
+#else
+#define DMX_TRACE_EVENTS CONFIG_DMX_TRACE_EVENTS
+#endif
+_Static_assert((DMX_TRACE_EVENTS & (DMX_TRACE_EVENTS - 1)) == 0,
+               "DMX_TRACE_EVENTS must be a power of two");
+#endif
+
+/** @brief The size of each DMX packet buffer of a DMX port whose packets are
+ * at most packet_size_max slots long. It is rounded up to a multiple of 4 bytes
+ * so that every buffer may be compared one word at a time.*/
+#define DMX_BUFFER_SIZE(packet_size_max) (((packet_size_max) + 3) & ~3)
+
+/** @brief The smallest packet_size_max of a DMX port. It fits an RDM header
+ * and an RDM_PID_DISC_UNIQUE_BRANCH response so that received RDM packets may
+ * always be parsed.*/
+#define DMX_PACKET_SIZE_MIN (32)
+
+/** @brief The number of bytes of parameter memory which are reserved for each
+ * root device parameter when dmx_config_t.parameter_memory_size is 0.*/
+#define DMX_PARAMETER_SIZE_AVERAGE (16)
+
+/** @brief The alignment of parameter data allocated from the parameter
+ * arena.*/
+#define DMX_PARAMETER_ALIGN (sizeof(void *))
+
+/** @brief The size of the parameter storage of a device with room for the
+ * desired number of parameters. Each parameter is stored with an entry in the
+ * index which sorts the parameters by PID.*/
+#define DMX_DEVICE_PARAMETERS_SIZE(parameter_count) \
+  ((sizeof(dmx_parameter_t) + sizeof(uint16_t)) * (parameter_count))
+
+/** @brief The size of a table entry of the desired type which ends with a
+ * dmx_device_t, such as a sub-device or a virtual responder. The size is
+ * aligned so that the entries of the table may be stored contiguously.*/
+#define DMX_DEVICE_STRIDE(type, parameter_count)                        \
+  ((sizeof(type) + DMX_DEVICE_PARAMETERS_SIZE(parameter_count) +        \
+    DMX_PARAMETER_ALIGN - 1) &                                          \
+   ~(DMX_PARAMETER_ALIGN - 1))
+
 enum dmx_parameter_type_t {
   DMX_PARAMETER_TYPE_NULL,
   DMX_PARAMETER_TYPE_DYNAMIC,
@@ -89,22 +248,82 @@ typedef struct dmx_parameter_t {
   rdm_pid_t pid;  // The parameter ID of the parameter.
   size_t size;    // The size of the parameter in bytes.
   void *data;     // A pointer to the data pertaining to the parameter.
+  uint32_t seq;   // The sequence counter of the parameter data. It is odd while the data is being updated.
   uint8_t type;  // The storage type of the parameter data. Determines if the parameter is non-volatile or not.
   const rdm_parameter_definition_t *definition;  // The RDM definition of the parameter. Is only needed for RDM responders.
   rdm_callback_t callback;  // A user callback for the parameter. Is only needed for RDM responders.
   void *context;            // Context for the user callback.
+  bool cache_response;  // True if encoded GET responses for the parameter may be cached. Is only needed for RDM responders.
+  uint32_t cache_generation;  // The parameter generation of the driver when the response was cached.
+  uint8_t *cache;  // The cached GET response packet, prefixed by its size, or NULL if no response is cached.
 } dmx_parameter_t;
 
 /**
  * @brief The DMX device type. Holds an array of parameters associated with the
- * device as well as a linked-list style pointer to the next DMX device.
+ * device. Sub-devices are stored in a contiguous table which is indexed by
+ * sub-device number.
  */
 typedef struct dmx_device_t {
-  dmx_device_num_t num;  // The device number.
-  struct dmx_device_t *next;  // A pointer to the next device.
-  dmx_parameter_t parameters[];  // An array of parameters associated with this device.
+  dmx_device_num_t num;  // The device number. Is 0 in unused sub-device table entries.
+  uint32_t parameter_count;  // The number of parameters in use. Parameters are never moved once they are added, so pointers to them remain valid.
+  uint16_t *index;  // The indices of the parameters sorted by PID so that they can be found with a binary search. It is stored after the parameters.
+  dmx_parameter_t parameters[];  // An array of parameters associated with this device, in the order in which they were added.
 } dmx_device_t;
 
+/**
+ * @brief A virtual RDM responder. Virtual responders are stored in a
+ * contiguous table which is indexed by responder number minus one.
+ */
+typedef struct dmx_responder_t {
+  rdm_uid_t uid;  // The UID of the virtual responder.
+  dmx_device_t root;  // The root device of the virtual responder. Its num is RDM_SUB_DEVICE_MAX plus the responder number minus one so that its non-volatile parameters have their own keys.
+} dmx_responder_t;
+
+/** @brief An entry in the table of virtual RDM responders sorted by UID.*/
+typedef struct dmx_responder_index_t {
+  rdm_uid_t uid;  // The UID of the virtual responder.
+  uint16_t num;  // The responder number of the virtual responder.
+} dmx_responder_index_t;
+
+/** @brief The virtual responder which is selected by a task.*/
+typedef struct dmx_responder_selection_t {
+  TaskHandle_t task;  // The task which selected the responder, or NULL if the entry is unused.
+  uint16_t num;  // The number of the selected responder.
+} dmx_responder_selection_t;
+
+#if DMX_RX_BUFFER_COUNT > 1
+/** @brief The number of 32-bit words which hold a DMX packet while merging.*/
+#define DMX_MERGE_WORDS ((DMX_PACKET_SIZE_MAX + 3) / 4)
+
+/**
+ * @brief The working memory of a DMX merge. Each word holds four DMX slots so
+ * that the inputs may be merged four slots at a time.
+ */
+typedef struct dmx_merge_buffer_t {
+  uint32_t frames[2][DMX_MERGE_WORDS];  // The last DMX frame merged from each input. Slots beyond the size of the frame are 0.
+  uint32_t incoming[DMX_MERGE_WORDS];  // The DMX frame which is being taken from an input.
+  uint32_t owners[DMX_MERGE_WORDS];  // 0xff in each byte whose LTP slot was last changed by the second input.
+  uint32_t ltp[DMX_MERGE_WORDS];  // 0xff in each byte whose slot is merged LTP.
+} dmx_merge_buffer_t;
+#endif
+
+/**
+ * @brief The working memory of the fade engine. Each fading slot is owned by
+ * the last fade which was started on it.
+ */
+typedef struct dmx_fade_buffer_t {
+  uint8_t starts[DMX_PACKET_SIZE_MAX];  // The value of each fading slot when its fade was started.
+  uint8_t targets[DMX_PACKET_SIZE_MAX];  // The value of each fading slot when its fade is done.
+  uint8_t owners[DMX_PACKET_SIZE_MAX];  // The number of the fade which owns each slot plus one, or 0 if the slot is not fading.
+  struct dmx_fade_t {
+    int64_t timestamp;  // The timestamp (in microseconds since boot) at which the fade was started.
+    uint32_t duration;  // The duration of the fade in microseconds.
+    uint16_t first;  // The first slot of the fade.
+    uint16_t end;  // The slot after the last slot of the fade.
+    uint16_t count;  // The number of slots which are owned by the fade, or 0 if the fade is free.
+  } fades[DMX_FADES_MAX];
+} dmx_fade_buffer_t;
+
 /** @brief The DMX driver object used to handle reading and writing DMX data on
  * the UART port. It stores all the information needed to run and analyze DMX
  * and RDM.*/
@@ -114,6 +333,13 @@ typedef struct dmx_driver_t {
   rdm_uid_t uid;       // The driver's UID.
   uint32_t break_len;  // Length in microseconds of the transmitted break.
   uint32_t mab_len;  // Length in microseconds of the transmitted mark-after-break.
+  int tx_mode;  // The method used to write slot data to the UART, one of dmx_tx_mode_t.
+  int rx_mode;  // The method used to read slot data from the UART, one of dmx_rx_mode_t.
+  uint32_t rx_intr_threshold;  // The number of DMX slots to receive per UART interrupt.
+  int break_mode;  // The method used to generate the DMX break, one of dmx_break_mode_t.
+  int isr_core;  // The CPU core on which the DMX driver interrupts are allocated.
+  int packet_size_max;  // The maximum size of a DMX packet which may be sent or received. Each packet buffer is DMX_BUFFER_SIZE(packet_size_max) bytes.
+  uint32_t memory_caps;  // The heap_caps_malloc() capabilities of the memory in which the DMX driver and its buffers are allocated.
 
   bool is_enabled;  // True if the DMX driver is enabled.
   bool is_controller;  // True if the DMX driver is the controller on the DMX bus.
@@ -121,25 +347,60 @@ typedef struct dmx_driver_t {
   // Synchronization state
   SemaphoreHandle_t mux;      // The handle to the driver mutex which allows multi-threaded driver function calls.
   TaskHandle_t task_waiting;  // The handle to a task that is waiting for data to be sent or received.
+  TaskHandle_t any_waiting;  // The handle to a task that is waiting in dmx_receive_any() for a packet on this DMX port.
+  dmx_rx_callback_t rx_callback;  // A user callback which is invoked from the DMX ISR when a packet is received.
+  void *rx_callback_context;  // Context for the user receive callback.
+  struct dmx_driver_sc_filter_t {
+    uint32_t actions[16];  // The dmx_sc_action_t of each start code, packed two bits per start code.
+    dmx_sc_handler_t handler;  // A user handler which is invoked from the DMX ISR when a packet with a routed start code is received.
+    void *context;  // Context for the start code handler.
+  } sc_filter;
+  QueueHandle_t subscribers[DMX_SUBSCRIBERS_MAX];  // The queues which receive a dmx_packet_t each time a packet is received.
 #ifdef DMX_USE_SPINLOCK
   dmx_spinlock_t spinlock;  // The spinlock used for critical sections.
 #endif
 
   // Data buffer
   struct dmx_driver_dmx_t {
+    uint32_t seq;  // The sequence counter of the packet state. It is odd while the packet state is being updated.
     int head;  // The index of the slot being transmitted or received.
-    uint8_t data[DMX_PACKET_SIZE_MAX];  // The buffer that stores the DMX packet.
+    uint8_t *data;  // The buffer that stores the DMX packet which is being sent or received.
+#if DMX_RX_BUFFER_COUNT > 1
+    uint8_t *ready;  // The buffer that stores the last complete DMX frame.
+    uint8_t *front;  // The buffer that is read by dmx_read().
+    bool ready_is_fresh;  // True if the ready buffer is newer than the front buffer.
+    int latest_size;  // The size of the last complete DMX frame. It is in the ready buffer if ready_is_fresh is true or in the front buffer otherwise.
+    int64_t latest_timestamp;  // The timestamp (in microseconds since boot) of the end-of-packet of the last complete DMX frame.
+    int sc;  // The start code of the last complete packet.
+#endif
     int size;  // The expected size of the incoming/outgoing packet.
     int status;  // The status of the DMX port.
     int progress;  // The progress of the current packet.
+    int rx_threshold;  // The UART RX FIFO threshold currently in use.
+    int tx_break_bits;  // The length in bits of the UART break to send after the current packet, or 0 to not send one.
+    int tx_mab_bits;  // The length in bits of the UART mark-after-break to send after the UART break.
+    bool tx_break_was_sent;  // True if the last packet sent was followed by a UART break.
+    uint32_t rx_intr_count;  // The number of receive interrupts for the current packet.
+    uint32_t last_rx_intr_count;  // The number of receive interrupts for the last complete packet.
+    uint32_t rx_err_flags;  // The UART errors latched for the frame being received by DMA.
     rdm_pid_t last_controller_pid;  // The PID of the last controller-generated packet.
     int64_t controller_eop_timestamp;  // The timestamp (in microseconds since boot) of the end-of-packet of the last controller-generated packet.
+    int64_t rx_break_timestamp;  // The timestamp (in microseconds since boot) of the DMX break of the packet being received.
+    int64_t last_break_timestamp;  // The timestamp (in microseconds since boot) of the DMX break of the last complete received packet.
+    int64_t last_eop_timestamp;  // The timestamp (in microseconds since boot) of the end-of-packet of the last complete received packet.
+    dmx_err_t last_err;  // The error of the last complete received packet.
     rdm_pid_t last_responder_pid;  // The PID of the last responder-generated packet.
     bool responder_sent_last;  // True if the last packet was a responder-generated packet.
+    bool rdm_header_is_cached;  // True if the RDM header of the packet in the DMX buffer has been decoded into rdm_header.
+    bool rdm_header_is_valid;  // True if the cached packet is an RDM packet with a valid checksum. Is only used when rdm_header_is_cached is true.
+    rdm_header_t rdm_header;  // The decoded RDM header of the packet in the DMX buffer. Is only used when rdm_header_is_cached and rdm_header_is_valid are true.
+    uint16_t rx_checksum;  // The running RDM checksum of the packet being received.
+    int rx_checksum_len;  // The number of slots which have been summed into rx_checksum.
     union {
       struct {
         rdm_pid_t last_request_pid;  // The PID of the last packet which targeted this device. Is only used when this device is a DMX responder.
         uint8_t last_request_pid_repeats;  // The number of times the last request targeting this device repeated its PID. Used for PIDs which can generate ACK overflow responses. Is only used when this device is a DMX responder.
+        bool last_response_was_overflow;  // True if the last response of this device was an RDM_RESPONSE_TYPE_ACK_OVERFLOW page. Is only used when this device is a DMX responder.
       }; 
       bool last_request_was_broadcast;  // True if the last request was a broadcast. Is only used when this device is a DMX controller.
     };
@@ -151,17 +412,208 @@ typedef struct dmx_driver_t {
       uint8_t tn;  // The current RDM transaction number. Is incremented with every RDM request sent.
       bool boot_loader;  // The RDM responder boot-loader flag. True when when the device is incapable of normal operation until receiving a firmware upload.
     };
+    uint8_t *data;  // The buffer which is swapped with the DMX buffer while an RDM request is in progress. Holds the DMX packet of the application during the request.
+    bool request_is_active;  // True while an RDM request has swapped its buffer into the DMX driver.
+    rdm_pid_t deferred_pid;  // The PID of the response which was deferred with an RDM_RESPONSE_TYPE_ACK_TIMER response, or 0 if no response is deferred. Is only used when this device is an RDM responder.
+    int64_t deferred_timestamp;  // The time (in microseconds since boot) at which the deferred response is estimated to be ready. Is only used when this device is an RDM responder.
+    struct rdm_ring_t *queue;  // The lock-free ring of queued message PIDs, or NULL if RDM_PID_QUEUED_MESSAGE is not registered. Is only used when this device is an RDM responder.
+    struct rdm_ring_t *status;  // The lock-free ring of status messages, or NULL if RDM_PID_STATUS_MESSAGE is not registered. Is only used when this device is an RDM responder.
+    bool disc_is_active;  // True while the RDM discovery algorithm is running on this port. Is only used when this device is an RDM controller.
+    rdm_disc_unique_branch_t disc_stack[49];  // The instruction stack of the RDM discovery algorithm. The max binary tree depth is 49. Is only used when this device is an RDM controller.
   } rdm;
   
+  dmx_stats_t stats;  // The counters of the packets and errors seen by the DMX driver.
+
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+  // Receive timing statistics
+  struct dmx_driver_timing_t {
+    dmx_rx_timing_t stats;  // The rolling timing statistics of received DMX packets.
+    int64_t last_break_timestamp;  // The timestamp (in microseconds since boot) of the DMX break of the last measured DMX packet, or 0 if none.
+  } timing;
+#endif
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  // RDM latency statistics
+  struct dmx_driver_latency_t {
+    rdm_responder_latency_t responder;  // The latency statistics of the responses sent by this device. Is only used when this device is an RDM responder.
+    uint16_t uid_count;  // The number of entries of uids which are in use.
+    uint16_t pid_count;  // The number of entries of pids which are in use.
+    rdm_uid_latency_t uids[RDM_LATENCY_UIDS];  // The round-trip statistics of each responder UID. Is only used when this device is an RDM controller.
+    rdm_pid_latency_t pids[RDM_LATENCY_PIDS];  // The round-trip statistics of each PID. Is only used when this device is an RDM controller.
+  } latency;
+#endif
+
+#ifdef CONFIG_DMX_TRACE
+  // Interrupt event trace
+  struct dmx_driver_trace_t {
+    uint32_t head;  // The number of events which have been recorded. Is only written by the DMX interrupt handlers.
+    uint32_t tail;  // The number of events which have been drained. Is only written by dmx_trace_drain().
+    dmx_trace_event_t events[DMX_TRACE_EVENTS];  // The ring buffer of recorded events.
+  } trace;
+#endif
+
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+  // RDM discovery responses which are sent by the DMX interrupt
+  struct dmx_driver_disc_isr_t {
+    uint8_t *is_muted;  // The value of the RDM_PID_DISC_MUTE parameter, or NULL if no discovery request has been handled by the task.
+    uint32_t generation;  // The parameter generation of the driver when a discovery request was last handled by the task.
+    bool is_sending;  // True while the DMX interrupt is sending a discovery response.
+    bool task_was_waiting;  // True if a task was waiting for a packet when the DMX interrupt started sending a discovery response.
+    int rx_size;  // The expected size of incoming packets, which is restored after a discovery response is sent.
+    uint8_t unique_branch[24];  // The encoded RDM_PID_DISC_UNIQUE_BRANCH response. Its first byte is 0 if it has not been encoded.
+    uint8_t mute[sizeof(rdm_header_t) + sizeof(rdm_disc_mute_t) + 2];  // The encoded RDM_PID_DISC_MUTE or RDM_PID_DISC_UN_MUTE response. Its first byte is 0 if it has not been encoded or is stale.
+  } disc_isr;
+#endif
+
+  // Zero-copy buffer leases
+  struct dmx_driver_lease_t {
+    bool read_is_leased;  // True if the last complete DMX frame is lent to a task by dmx_read_acquire().
+    bool write_is_leased;  // True if a buffer is lent to a task by dmx_write_acquire().
+    bool write_is_pending;  // True if the write buffer has been released and is sent in the next DMX packet.
+    uint8_t *back;  // The buffer which is lent by dmx_write_acquire() and swapped with the DMX buffer when sent.
+    void *memory;  // The memory which was allocated for the write buffer.
+  } lease;
+
+  // Receive change detection
+  struct dmx_driver_change_t {
+    uint32_t *last;  // A copy of the last DMX packet which was received, or NULL if change detection is disabled.
+    size_t last_size;  // The size of the last DMX packet which was received, or 0 if none.
+  } change;
+
+  // Continuous transmit configuration
+  struct dmx_driver_continuous_t {
+    bool is_running;  // True if the DMX driver is sending DMX packets continuously.
+    bool is_paused;  // True if continuous sending is paused so that a task may send another packet.
+    bool is_dirty;  // True if the staging buffer contains data which has not yet been sent.
+    int size;  // The size of the DMX packets which are sent continuously.
+    bool is_auto_sized;  // True if the size of each continuous DMX packet is determined by automatic sizing.
+    uint32_t period;  // The duration in microseconds from the start of one continuous DMX packet to the start of the next.
+    int64_t frame_timestamp;  // The timestamp (in microseconds since boot) of the start of the last DMX packet that was sent.
+    uint8_t *staging;  // The buffer which is written by dmx_write() while sending continuously.
+  } continuous;
+
+  // Asynchronous transmit queue
+  struct dmx_driver_tx_async_t {
+    bool is_queued;  // True if a DMX packet is queued to be sent from the DMX ISR by dmx_send_async().
+    size_t size;  // The size of the queued DMX packet, or 0 to send a full-sized or automatically sized DMX packet.
+    int tx_break_bits;  // The number of bits of the DMX break which the UART sends after the queued DMX packet.
+    int tx_mab_bits;  // The number of bits of the DMX mark-after-break which the UART sends after the queued DMX packet.
+    dmx_tx_callback_t queued_callback;  // The completion callback of the queued DMX packet, or NULL.
+    void *queued_context;  // Context for the completion callback of the queued DMX packet.
+    dmx_tx_callback_t callback;  // The completion callback of the DMX packet which is being sent, or NULL.
+    void *context;  // Context for the completion callback of the DMX packet which is being sent.
+  } tx_async;
+
+  // Automatic transmit size configuration
+  struct dmx_driver_auto_size_t {
+    int min_size;  // The minimum size of an automatically sized DMX packet, or 0 if automatic sizing is disabled.
+    uint32_t full_period;  // The duration in microseconds between full-sized DMX packets, or 0 to never force a full-sized packet.
+    int64_t full_timestamp;  // The timestamp (in microseconds since boot) of the last forced full-sized DMX packet.
+  } auto_size;
+
+  // Fade configuration
+  struct dmx_driver_fade_t {
+    int active;  // The number of fades which own at least one slot.
+    dmx_fade_buffer_t *buffer;  // The working memory of the fade engine, or NULL if no fade was started.
+  } fade;
+
+#if DMX_RX_BUFFER_COUNT > 1
+  // Merge configuration
+  struct dmx_driver_merge_t {
+    bool is_running;  // True if the DMX packets which are sent continuously are merged from two DMX inputs.
+    dmx_port_t inputs[2];  // The DMX ports whose received DMX frames are merged.
+    uint32_t timeout;  // The duration in microseconds after which an input without DMX frames is lost.
+    int64_t seen_timestamps[2];  // The timestamp of the last complete DMX frame which was inspected on each input.
+    int64_t frame_timestamps[2];  // The timestamp (in microseconds since boot) of the end-of-packet of the last DMX frame merged from each input.
+    dmx_merge_buffer_t *buffer;  // The working memory of the merge.
+    dmx_merge_stats_t stats;  // The merge statistics.
+  } merge;
+#endif
+
+  // Repeater configuration
+  struct dmx_driver_repeater_t {
+    uint32_t outputs;  // A bit mask of the DMX ports which repeat the packets received on this DMX port, or 0 if none.
+    uint32_t active;  // A bit mask of the outputs which are repeating the packet being received on this DMX port.
+    bool forwards_rdm;  // True if RDM packets received on this DMX port are repeated on its outputs.
+    dmx_port_t source;  // The DMX port whose packets are repeated on this DMX port, or DMX_NUM_MAX if none.
+    int available;  // The number of slots of the repeated packet which have been received from the source.
+    bool is_pending;  // True if the next repeated packet is waiting for the current packet to be sent.
+    uint8_t *next;  // The buffer which receives the next repeated packet while it is pending.
+  } repeater;
+
+  // Synchronized send configuration
+  struct dmx_driver_sync_t {
+    uint32_t group;  // A bit mask of the DMX ports whose DMX break is started by this driver's next timer alarm, or 0 if none.
+    uint32_t skew;  // The measured skew in microseconds between the DMX breaks of the last synchronized send.
+  } sync;
+
+  // RDM transaction scheduler
+  struct dmx_driver_schedule_t {
+    uint32_t dmx_frames_per_rdm;  // The number of DMX packets which must be sent between RDM transactions.
+    uint32_t min_refresh_rate;  // The minimum DMX refresh rate in hertz which is preserved while sending RDM requests, or 0 if unused.
+    uint32_t dmx_frames;  // The number of DMX packets which have been sent since the last RDM transaction.
+    uint32_t dmx_period;  // The duration in microseconds between the starts of the last two DMX packets which were sent, or 0 if unknown.
+    int64_t dmx_timestamp;  // The timestamp (in microseconds since boot) of the start of the last DMX packet which was sent.
+    bool rdm_is_waiting;  // True if an RDM request is waiting for DMX packets to be sent.
+    SemaphoreHandle_t grant;  // The semaphore which is given when a DMX packet is sent while an RDM request is waiting.
+  } schedule;
+
+  // Asynchronous RDM controller requests
+  struct dmx_driver_async_t {
+    QueueHandle_t requests;  // The queue of asynchronous RDM requests waiting to be sent, or NULL if it has not been allocated.
+    TaskHandle_t task;  // The task which sends asynchronous RDM requests, or NULL if it has not been started.
+    uint32_t next_handle;  // The handle of the next asynchronous RDM request which is queued.
+    uint32_t pending;  // The number of asynchronous RDM requests which have been queued but have not completed.
+  } async;
+
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+  struct dmx_driver_commit_t {
+    TaskHandle_t task;  // The task which commits staged non-volatile parameters to NVS, or NULL if it is not running.
+  } commit;
+#endif
+
+  struct rdm_tod_t *tod;  // The Table of Devices which is maintained by background discovery, or NULL if background discovery is stopped.
+  struct rdm_cache_t *cache;  // The cache of GET responses received by the RDM controller, or NULL if the cache is disabled.
+
   // DMX sniffer configuration
   struct dmx_driver_sniffer_t {
     bool is_enabled;
+    bool uses_capture;  // True if the sniffer is using the MCPWM capture hardware instead of the GPIO ISR.
     int buffer_index;
     dmx_metadata_t metadata[2];  // The metadata received by the DMX sniffer.
     int64_t last_pos_edge_ts;  // Timestamp of the last positive edge on the sniffer pin.
     int64_t last_neg_edge_ts;  // Timestamp of the last negative edge on the sniffer pin.
+    struct dmx_driver_sniffer_stream_t {
+      dmx_metadata_t *ring;  // The ring buffer of streamed metadata, or NULL if streaming is disabled.
+      uint32_t size;  // The number of records in the ring buffer. Is a power of two.
+      uint32_t head;  // The number of records which have been pushed. Is only written by the sniffer ISR.
+      uint32_t tail;  // The number of records which have been read. Is only written by dmx_sniffer_stream_read().
+      uint32_t dropped;  // The number of records which were dropped because the ring buffer was full. Is only written by the sniffer ISR.
+      uint32_t reported;  // The number of dropped records which have been reported. Is only written by dmx_sniffer_stream_read().
+    } stream;
   } sniffer;
 
+  // Receive frame queue
+  struct dmx_driver_rx_queue_t {
+    dmx_frame_t *frames;  // The ring of queued frames followed by the slot buffer of each frame, or NULL if the queue is disabled.
+    uint32_t size;  // The number of frames in the ring. Is a power of two.
+    uint32_t head;  // The number of frames which have been pushed. Is only written by the DMX ISR.
+    uint32_t tail;  // The number of frames which have been released. Is only written by dmx_rx_queue_release().
+    uint32_t dropped;  // The number of frames which were dropped because the ring was full. Is only written by the DMX ISR.
+    uint32_t reported;  // The number of dropped frames which have been reported. Is only written by dmx_rx_queue_acquire().
+    TaskHandle_t task_waiting;  // The handle to a task which is waiting for a frame to be queued.
+  } rx_queue;
+
+  // Virtual RDM responders
+  struct dmx_driver_responders_t {
+    uint8_t *table;  // The virtual responders, indexed by responder number minus one. Is NULL if virtual responders are not supported.
+    size_t stride;  // The size in bytes of each virtual responder in the table.
+    dmx_responder_index_t *index;  // The virtual responders sorted by UID so that they can be found with a binary search. Is read by the DMX ISR.
+    uint16_t max;  // The number of virtual responders in the table.
+    uint16_t count;  // The number of virtual responders which have been added.
+    dmx_responder_selection_t selected[RDM_RESPONDER_SELECT_MAX + 1];  // The responder whose root device is used by parameter functions on each task which has not selected the responder of the DMX port. One entry is kept free for the DMX driver, which selects responders while it holds the driver mutex.
+  } responders;
+
   // DMX device information
   struct dmx_driver_device_t {
     struct dmx_driver_parameter_count_t {
@@ -169,17 +621,179 @@ typedef struct dmx_driver_t {
       unsigned int sub_devices;  // The number of parameters supported by sub-devices.
       unsigned int staged;  // The number of non-volatile parameters waiting to be committed to non-volatile storage.
     } parameter_count;  // Parameter counts for various purposes.
+    uint32_t generation;  // Incremented whenever a parameter or sub-device is added or a parameter is set. Invalidates cached RDM responses.
+    struct dmx_driver_sub_device_table_t {
+      uint8_t *table;  // The sub-devices, indexed by sub-device number minus one. Is NULL if sub-devices are not supported.
+      size_t stride;  // The size in bytes of each sub-device in the table.
+      uint16_t max;  // The number of sub-devices in the table.
+      uint16_t count;  // The number of sub-devices which have been added.
+    } sub_devices;  // The table of sub-devices.
+    struct dmx_driver_parameter_memory_t {
+      uint8_t *arena;  // The memory from which parameter data is allocated, or NULL if there is none.
+      size_t size;  // The size of the parameter arena in bytes.
+      size_t used;  // The number of bytes which have been allocated from the parameter arena.
+      size_t heap;  // The number of bytes of parameter data which were allocated from the heap because the arena was full.
+      size_t cache;  // The number of bytes which were allocated from the heap for cached RDM responses.
+    } memory;  // The memory used by parameter data.
     dmx_device_t root;  // The root device of the RDM driver.
   } device;
 } dmx_driver_t;
 
 extern dmx_driver_t *dmx_driver[DMX_NUM_MAX];
 
-// TODO: implement dmx_device_add()
-// dmx_device_add(dmx_num, device_num);
+#ifdef CONFIG_DMX_TRACE
+/** @brief Records an event in the trace ring buffer of a DMX driver. The DMX
+ * interrupt handlers of a DMX port run on the same core and do not preempt each
+ * other, so no lock is needed. The oldest event is overwritten when the ring
+ * buffer is full.*/
+#define DMX_TRACE(driver, event, argument, now)                              \
+  do {                                                                       \
+    const uint32_t _head = (driver)->trace.head;                             \
+    dmx_trace_event_t *const _event =                                        \
+        &(driver)->trace.events[_head & (DMX_TRACE_EVENTS - 1)];             \
+    _event->timestamp = (uint32_t)(now);                                     \
+    _event->code = (event);                                                  \
+    _event->arg = (argument);                                                \
+    __atomic_store_n(&(driver)->trace.head, _head + 1, __ATOMIC_RELEASE);    \
+  } while (0)
+#else
+/** @brief Records an event in the trace ring buffer of a DMX driver. Tracing
+ * is disabled in the Kconfig so the arguments are not evaluated.*/
+#define DMX_TRACE(driver, event, argument, now) \
+  do {                                          \
+  } while (0)
+#endif
+
+/** @brief A consistent snapshot of the DMX packet state of a DMX driver.*/
+typedef struct dmx_driver_state_t {
+  int head;      // The index of the slot being transmitted or received.
+  int size;      // The expected size of the incoming/outgoing packet.
+  int status;    // The status of the DMX port.
+  int progress;  // The progress of the current packet.
+  int64_t controller_eop_timestamp;  // The timestamp (in microseconds since boot) of the end-of-packet of the last controller-generated packet.
+} dmx_driver_state_t;
+
+/**
+ * @brief Reads a consistent snapshot of the DMX packet state without entering
+ * a critical section. The read is retried if the DMX ISR or another task
+ * updates the packet state while it is being read.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param[out] state The snapshot of the DMX packet state.
+ */
+void dmx_driver_get_state(const dmx_driver_t *driver,
+                          dmx_driver_state_t *state);
+
+/**
+ * @brief Pushes the most recent DMX sniffer metadata into the sniffer stream if
+ * streaming is enabled. Must be called from within a critical section.
+ *
+ * @param driver A pointer to the DMX driver.
+ */
+void dmx_sniffer_push(dmx_driver_t *driver);
+
+/**
+ * @brief Publishes a buffer which was released by dmx_write_release() by
+ * swapping it with the DMX buffer. This must be called before a new packet is
+ * written or sent on the DMX bus and should only be called while the DMX driver
+ * is not sending.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_lease_publish(dmx_port_t dmx_num);
+
+/**
+ * @brief Blocks until the RDM transaction scheduler allows an RDM transaction
+ * to be sent. RDM transactions are spaced so that the configured number of DMX
+ * packets are sent between them and so that the minimum DMX refresh rate is
+ * preserved. This function returns immediately if the scheduler is disabled,
+ * if the calling task holds the driver mutex, or if DMX packets are not being
+ * sent.
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The PID of the RDM request.
+ * @param request_size The size of the RDM request packet.
+ * @param response_size The maximum size of the RDM response packet, or 0 if no
+ * response is expected.
+ */
+void rdm_schedule_wait(dmx_port_t dmx_num, rdm_pid_t pid, size_t request_size,
+                       size_t response_size);
+
+/**
+ * @brief Pauses continuous sending at the next DMX packet boundary so that the
+ * calling task may send a different packet, such as an RDM request. The packet
+ * which is currently being sent is allowed to finish. This function should be
+ * called while holding the driver mutex.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if continuous sending was paused.
+ * @return false if continuous sending was not running.
+ */
+bool dmx_continuous_pause(dmx_port_t dmx_num);
+
+/**
+ * @brief Resumes continuous sending after it was paused with
+ * dmx_continuous_pause(). Any data written with dmx_write() while continuous
+ * sending was paused is sent in the next DMX packet.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_continuous_resume(dmx_port_t dmx_num);
+
+/**
+ * @brief Starts the task which commits staged non-volatile parameters to NVS.
+ * Does nothing if CONFIG_DMX_NVS_COMMIT_TASK is disabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false if the task could not be created.
+ */
+bool dmx_parameter_commit_start(dmx_port_t dmx_num);
+
+/**
+ * @brief Stops the task which commits staged non-volatile parameters to NVS.
+ * Blocks until the task has committed any parameters which are still staged.
+ *
+ * @param dmx_num The DMX port number.
+ */
+void dmx_parameter_commit_stop(dmx_port_t dmx_num);
 
 /**
- * @brief Gets a pointer to the desired device, if it exists.
+ * @brief Schedules staged non-volatile parameters to be committed to NVS. The
+ * commit task is woken if it is running. Otherwise parameters are committed
+ * immediately, but only if the DMX bus is idle.
+ *
+ * @param dmx_num The DMX port number.
+ * @param bus_is_idle True if the DMX bus is idle, such as when dmx_receive()
+ * times out.
+ */
+void dmx_parameter_commit_schedule(dmx_port_t dmx_num, bool bus_is_idle);
+
+/**
+ * @brief Adds a sub-device to the DMX driver, if there is space available in
+ * the sub-device table.
+ *
+ * @param dmx_num The DMX port number.
+ * @param device_num The sub-device number.
+ * @return true on success or if the sub-device already exists.
+ * @return false on failure.
+ */
+bool dmx_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num);
+
+/**
+ * @brief Removes all parameters from a device and places its parameter index
+ * after its parameters. Must be called before a device is used.
+ *
+ * @param[in] device A pointer to the device.
+ * @param parameter_count The number of parameters which the device has room
+ * for.
+ */
+void dmx_device_reset(dmx_device_t *device, uint32_t parameter_count);
+
+/**
+ * @brief Gets a pointer to the desired device, if it exists. Devices are
+ * located by their index in the sub-device table. If the calling task has
+ * selected a virtual responder, only its root device exists.
  * 
  * @param dmx_num The DMX port number.
  * @param device_num The sub-device number.
@@ -187,8 +801,74 @@ extern dmx_driver_t *dmx_driver[DMX_NUM_MAX];
  */
 dmx_device_t *dmx_device_get(dmx_port_t dmx_num, dmx_device_num_t device_num);
 
+/**
+ * @brief Gets a pointer to a device regardless of which responder is selected.
+ * The root device and sub-devices of the DMX port are at indices 0 through the
+ * size of the sub-device table, followed by the root device of each virtual
+ * responder which has been added.
+ *
+ * @param dmx_num The DMX port number.
+ * @param index The index of the device.
+ * @return A pointer to the device, or NULL if no device is at the index.
+ */
+dmx_device_t *dmx_device_at(dmx_port_t dmx_num, int index);
+
+/**
+ * @brief Gets the number of device indices which may be passed to
+ * dmx_device_at().
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of device indices.
+ */
+int dmx_device_count(dmx_port_t dmx_num);
+
+/**
+ * @brief Finds the number of the responder of a DMX port which has a UID.
+ * Virtual responders are found with a binary search. May be called from the
+ * DMX ISR.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param uid A pointer to the UID to find.
+ * @return The responder number, 0 for the responder of the DMX port, or -1 if
+ * no responder has the UID.
+ */
+int dmx_responder_find(const dmx_driver_t *driver, const rdm_uid_t *uid);
+
+/**
+ * @brief Gets the number of the responder whose root device is used by the
+ * parameter functions on the calling task. Tasks which have not selected a
+ * virtual responder use the responder of the DMX port. Must not be called from
+ * the DMX ISR.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @return The selected responder number, or 0 for the responder of the DMX
+ * port.
+ */
+uint16_t dmx_responder_get_selected(const dmx_driver_t *driver);
+
+/**
+ * @brief Sets the number of the responder whose root device is used by the
+ * parameter functions on the calling task. Selecting responder 0 frees the
+ * selection entry of the task. Must not be called from the DMX ISR.
+ *
+ * @param driver A pointer to the DMX driver.
+ * @param responder_num The responder number, or 0 for the responder of the DMX
+ * port.
+ * @param is_driver True if the DMX driver selects the responder while it holds
+ * the driver mutex, which allows the last free selection entry to be used.
+ * @return true on success.
+ * @return false if there is no free selection entry.
+ */
+bool dmx_responder_set_selected(dmx_driver_t *driver, uint16_t responder_num,
+                                bool is_driver);
+
 /**
  * @brief Adds a parameter to the DMX driver, if there is space available.
+ * Parameters are appended to the device and are not moved afterwards, so they
+ * may be added after the RDM responder has started. This function takes the
+ * DMX driver mutex so that parameters are added one at a time, so it waits
+ * while rdm_send_response() or any other function which holds the mutex is
+ * running.
  *
  * @param dmx_num The DMX port number.
  * @param device_num The sub-device number.
@@ -204,8 +884,13 @@ bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num,
                        rdm_pid_t pid, int type, void *data, size_t size);
 
 /**
- * @brief Gets a pointer to the desired parameter, if it exists.
- * 
+ * @brief Gets a pointer to the desired parameter, if it exists. The parameter
+ * entry includes the RDM definition and callback of the parameter, so only one
+ * lookup is needed to respond to an RDM request. The lookup is a binary search
+ * of the index which sorts the parameters by PID. Entries are not moved when
+ * parameters are added, so the returned pointer remains valid until the DMX
+ * driver is deleted.
+ *
  * @param dmx_num The DMX port number.
  * @param device_num The sub-device number.
  * @param pid The parameter ID.
@@ -66,14 +66,27 @@ extern "C" {
 #define rdm_mab_len_is_valid(mab) \
   (mab >= RDM_MAB_LEN_MIN_US && mab <= RDM_MAB_LEN_MAX_US)
 
+#ifndef CONFIG_DMX_PARALLEL_PORTS
+/** @brief The number of parallel DMX output ports.*/
+#define DMX_PARALLEL_NUM_MAX (0)
+#else
+#define DMX_PARALLEL_NUM_MAX CONFIG_DMX_PARALLEL_PORTS
+#endif
+
 /** @brief DMX port constants.*/
 enum {
   DMX_NUM_0, /** @brief DMX port 0.*/
   DMX_NUM_1, /** @brief DMX port 1.*/
-#if SOC_UART_NUM > 2
+#if SOC_UART_NUM > 2 || defined(CONFIG_IDF_TARGET_LINUX)
   DMX_NUM_2, /** @brief DMX port 2.*/
 #endif
-  DMX_NUM_MAX /** @brief DMX port max. Used for error checking.*/
+  /** @brief The number of DMX ports which use a UART.*/
+  DMX_NUM_UART_MAX,
+  /** @brief The first parallel DMX output port. The parallel DMX ports are
+     numbered after the DMX ports which use a UART.*/
+  DMX_NUM_PARALLEL_0 = DMX_NUM_UART_MAX,
+  /** @brief DMX port max. Used for error checking.*/
+  DMX_NUM_MAX = DMX_NUM_UART_MAX + DMX_PARALLEL_NUM_MAX
 };
 
 /** @brief DMX pin constants.*/
@@ -120,6 +133,35 @@ enum {
      is considered lost.*/
   DMX_TIMEOUT_TICK = dmx_ms_to_ticks(1250),
 
+  /** @brief The maximum number of slots which may be coalesced into a single
+     DMX receive interrupt.*/
+  DMX_RX_INTR_THRESHOLD_MAX = 100,
+
+  /** @brief The number of DMX slots which are represented by each bit of
+     dmx_packet_t.changed_blocks.*/
+  DMX_CHANGED_BLOCK_SIZE = 32,
+
+  /** @brief The number of buckets in the histogram of received DMX packet
+     periods.*/
+  DMX_RX_TIMING_HISTOGRAM_SIZE = 8,
+  /** @brief The upper bound in microseconds of the first bucket of the
+     histogram of received DMX packet periods. The upper bound of each following
+     bucket is double that of the previous.*/
+  DMX_RX_TIMING_HISTOGRAM_BASE_US = 2048,
+
+  /** @brief The size in bytes of a per-slot DMX merge mask. Bit n % 8 of byte
+     n / 8 represents slot n.*/
+  DMX_MERGE_MASK_SIZE = (DMX_PACKET_SIZE_MAX + 7) / 8,
+  /** @brief The default duration in microseconds after which a DMX merge
+     input which has not received a DMX frame is considered lost.*/
+  DMX_MERGE_TIMEOUT_US = 1250000,
+
+  /** @brief The maximum packet size of RDM, including the checksum.*/
+  RDM_PACKET_SIZE_MAX = 257,
+
+  /** @brief The maximum number of virtual RDM responders on a DMX port.*/
+  RDM_VIRTUAL_RESPONDER_MAX = 255,
+
   /** @brief The typical RDM break length in microseconds.*/
   RDM_BREAK_LEN_US = 176,
   /** @brief The minimum RDM break length in microseconds.*/
@@ -263,6 +305,110 @@ typedef enum dmx_err_t {
   DMX_FAIL = -1
 } dmx_err_t;
 
+/** @brief DMX transmit modes. The transmit mode determines how DMX slot data
+ * is written to the UART once the DMX break and mark-after-break have been
+ * sent.*/
+typedef enum dmx_tx_mode_t {
+  /** @brief Slot data is written to the UART TX FIFO from the DMX interrupt
+     service routine each time the TX FIFO runs low. This is the default
+     transmit mode and is supported on all targets.*/
+  DMX_TX_MODE_FIFO = 0,
+  /** @brief The entire packet is handed to the UHCI peripheral using GDMA
+     after the mark-after-break so that only a single interrupt is raised when
+     the packet is done sending. This mode is only available on targets which
+     support UHCI and GDMA, and only one DMX port may use it at a time. Ports
+     which cannot use DMA fall back to DMX_TX_MODE_FIFO.*/
+  DMX_TX_MODE_DMA,
+} dmx_tx_mode_t;
+
+/** @brief DMX receive modes. The receive mode determines how DMX slot data is
+ * read from the UART.*/
+typedef enum dmx_rx_mode_t {
+  /** @brief Slot data is read from the UART RX FIFO by the DMX interrupt
+     service routine each time the RX FIFO fills. This is the default receive
+     mode and is supported on all targets.*/
+  DMX_RX_MODE_FIFO = 0,
+  /** @brief Slot data is written directly into the DMX buffer by the UHCI
+     peripheral using GDMA. A single interrupt is raised when a DMX break
+     arrives or the bus goes idle, at which point the whole frame is
+     processed. This mode is intended for receive-only devices and is only
+     available on targets which support UHCI and GDMA. Only one DMX port may
+     use DMA at a time. Ports which cannot use DMA fall back to
+     DMX_RX_MODE_FIFO.*/
+  DMX_RX_MODE_DMA,
+} dmx_rx_mode_t;
+
+/** @brief DMX break modes. The break mode determines how the DMX break and
+ * mark-after-break are generated when sending DMX packets.*/
+typedef enum dmx_break_mode_t {
+  /** @brief The DMX break and mark-after-break are timed by the hardware timer
+     before each packet is sent. This is the default break mode.*/
+  DMX_BREAK_MODE_TIMER = 0,
+  /** @brief The UART hardware sends the DMX break and mark-after-break
+     immediately after each DMX packet so that the next DMX packet can be sent
+     without involving the hardware timer. The hardware timer is still used for
+     the first packet, for RDM packets, and when the bus has been idle for
+     longer than the maximum DMX mark-after-break.*/
+  DMX_BREAK_MODE_UART,
+} dmx_break_mode_t;
+
+/** @brief The CPU core on which the DMX driver interrupts are allocated.*/
+typedef enum dmx_isr_core_t {
+  /** @brief Interrupts are allocated on the core which calls
+     dmx_driver_install(). This is the default.*/
+  DMX_ISR_CORE_CALLER = 0,
+  /** @brief Interrupts are allocated on core 0.*/
+  DMX_ISR_CORE_0,
+  /** @brief Interrupts are allocated on core 1. Single-core targets fall back
+     to core 0.*/
+  DMX_ISR_CORE_1,
+  /** @brief Interrupts are allocated on the core which is servicing the
+     fewest DMX ports, preferring core 1 so that DMX is kept away from Wi-Fi on
+     core 0.*/
+  DMX_ISR_CORE_AUTO,
+} dmx_isr_core_t;
+
+/** @brief The types of DMX interrupt events which may be traced when the
+   DMX_TRACE option is enabled in the Kconfig.*/
+typedef enum dmx_trace_code_t {
+  /** @brief A DMX break was received. The argument is the number of slots
+     received before the DMX break.*/
+  DMX_TRACE_RX_BREAK = 1,
+  /** @brief Slots were received. The argument is the new head index.*/
+  DMX_TRACE_RX_DATA,
+  /** @brief A UART receive error occurred. The argument is the error code.*/
+  DMX_TRACE_RX_ERROR,
+  /** @brief A packet was done being received. The argument is the packet
+     size.*/
+  DMX_TRACE_RX_DONE,
+  /** @brief The transmit FIFO was refilled. The argument is the new head
+     index.*/
+  DMX_TRACE_TX_DATA,
+  /** @brief A packet was done being sent. The argument is the packet size.*/
+  DMX_TRACE_TX_DONE,
+  /** @brief The hardware timer alarm fired. The argument is the packet
+     progress.*/
+  DMX_TRACE_TIMER_ALARM,
+  /** @brief The DMX bus was turned around. The argument is the new RTS
+     level.*/
+  DMX_TRACE_RTS,
+  /** @brief An edge was detected on the sniffer pin. The argument is the new
+     pin level.*/
+  DMX_TRACE_GPIO_EDGE,
+} dmx_trace_code_t;
+
+/** @brief A DMX interrupt event which was recorded in the trace ring buffer.
+   Events are 8 bytes each so that they may be exported in their binary form.*/
+typedef struct dmx_trace_event_t {
+  /** @brief The low 32 bits of the timestamp in microseconds since boot at
+     which the event occurred.*/
+  uint32_t timestamp;
+  /** @brief The type of event. See dmx_trace_code_t.*/
+  uint16_t code;
+  /** @brief An argument which depends on the type of event.*/
+  uint16_t arg;
+} dmx_trace_event_t;
+
 /** @brief Configuration settings for the DMX driver.*/
 typedef struct dmx_config_t {
   /** @brief The interrupt allocation flags to use.*/
@@ -288,6 +434,49 @@ typedef struct dmx_config_t {
   /** @brief The maximum size of the RDM queue. Setting this value to 0 disables
    * the RDM queue.*/
   uint32_t queue_size_max;
+  /** @brief The transmit mode of the DMX driver. One of dmx_tx_mode_t.*/
+  dmx_tx_mode_t tx_mode;
+  /** @brief The receive mode of the DMX driver. One of dmx_rx_mode_t.*/
+  dmx_rx_mode_t rx_mode;
+  /** @brief The number of slots the UART must receive before the DMX driver is
+     interrupted. Values greater than 1 coalesce DMX slots into fewer
+     interrupts and the UART receive timeout is used to read the end of each
+     packet. RDM packets are always received one slot per interrupt. Setting
+     this value to 0 uses the default value of 1.*/
+  uint32_t rx_intr_threshold;
+  /** @brief The break mode of the DMX driver. One of dmx_break_mode_t.*/
+  dmx_break_mode_t break_mode;
+  /** @brief The CPU core on which to allocate the DMX interrupts. One of
+     dmx_isr_core_t.*/
+  dmx_isr_core_t isr_core;
+  /** @brief The number of sub-devices that may be added with
+     dmx_sub_device_add(). Sub-devices are numbered from 1 through this
+     count.*/
+  uint16_t sub_device_count;
+  /** @brief The number of bytes to reserve for the data of dynamic and
+     non-volatile parameters. Parameter data is allocated from this memory
+     instead of allocating each parameter separately on the heap. Parameters
+     which do not fit are allocated on the heap. Setting this value to 0
+     reserves memory based on root_device_parameter_count. The memory used by
+     parameters can be read with dmx_parameter_get_memory().*/
+  size_t parameter_memory_size;
+  /** @brief The maximum size in slots, including the start code, of the
+     packets which may be sent or received on the DMX port. Each packet buffer
+     of the DMX driver is allocated with this size. Received packets which are
+     larger are truncated. RDM requests may only be sent when this value is at
+     least RDM_PACKET_SIZE_MAX and RDM responses which are larger than this
+     value are not sent. Setting this value to 0 uses DMX_PACKET_SIZE_MAX.*/
+  size_t packet_size_max;
+  /** @brief The heap_caps_malloc() capabilities of the memory in which the DMX
+     driver and its packet buffers are allocated, such as MALLOC_CAP_INTERNAL
+     or MALLOC_CAP_SPIRAM. MALLOC_CAP_DMA is added when tx_mode or rx_mode is a
+     DMA mode. Setting this value to 0 uses MALLOC_CAP_8BIT.*/
+  uint32_t memory_caps;
+  /** @brief The number of virtual RDM responders that may be added with
+     rdm_responder_add(). Each virtual responder has its own UID and supports
+     root_device_parameter_count parameters. Virtual responders are numbered
+     from 1 through this count.*/
+  uint16_t virtual_responder_count;
 } dmx_config_t;
 
 /** @brief A struct which defines DMX personalities. Used to declare the
@@ -311,16 +500,234 @@ typedef struct dmx_packet_t {
   size_t size;
   /** @brief True if the received packet is RDM.*/
   bool is_rdm;
+  /** @brief True if the received packet differs from the previous DMX packet.
+     Is always true when change detection is disabled and for packets which
+     are not checked for changes, such as packets with a non-zero start code
+     or packets with an error.*/
+  bool is_changed;
+  /** @brief A bit mask of the blocks of DMX_CHANGED_BLOCK_SIZE slots which
+     differ from the previous DMX packet. Bit n is set if any slot from
+     n * DMX_CHANGED_BLOCK_SIZE to (n + 1) * DMX_CHANGED_BLOCK_SIZE - 1
+     changed.*/
+  uint32_t changed_blocks;
+  /** @brief The timestamp in microseconds since boot of the DMX break of the
+     received packet, or 0 if unknown.*/
+  int64_t break_timestamp;
+  /** @brief The timestamp in microseconds since boot at which the packet was
+     done being received, or 0 if unknown.*/
+  int64_t eop_timestamp;
 } dmx_packet_t;
 
+/** @brief A DMX packet which was stored in the receive queue of a DMX port.
+ * The slots of the packet are owned by the receive queue and remain valid
+ * until the frame is released with dmx_rx_queue_release().*/
+typedef struct dmx_frame_t {
+  /** @brief Evaluates to true if an error occurred reading DMX data.*/
+  dmx_err_t err;
+  /** @brief Start code of the DMX packet.*/
+  int sc;
+  /** @brief The size of the received DMX packet in bytes.*/
+  size_t size;
+  /** @brief The timestamp in microseconds since boot of the DMX break of the
+     received packet, or 0 if unknown.*/
+  int64_t break_timestamp;
+  /** @brief The timestamp in microseconds since boot at which the packet was
+     done being received.*/
+  int64_t eop_timestamp;
+  /** @brief A pointer to the slots of the received DMX packet, starting with
+     the start code.*/
+  const uint8_t *data;
+} dmx_frame_t;
+
+/** @brief Rolling timing statistics of the DMX packets received on a DMX port.
+ * Only DMX packets with a NULL start code are measured.*/
+typedef struct dmx_rx_timing_t {
+  /** @brief The number of DMX packets that have been measured.*/
+  uint32_t packet_count;
+  /** @brief The shortest period in microseconds from one DMX break to the
+     next.*/
+  uint32_t period_min;
+  /** @brief The moving average period in microseconds from one DMX break to
+     the next.*/
+  uint32_t period_avg;
+  /** @brief The longest period in microseconds from one DMX break to the
+     next.*/
+  uint32_t period_max;
+  /** @brief The moving average difference in microseconds between each DMX
+     packet period and the average period.*/
+  uint32_t jitter;
+  /** @brief The size of the smallest DMX packet in bytes.*/
+  uint16_t size_min;
+  /** @brief The size of the largest DMX packet in bytes.*/
+  uint16_t size_max;
+  /** @brief A histogram of DMX packet periods. Bucket n counts the periods
+     shorter than DMX_RX_TIMING_HISTOGRAM_BASE_US << n microseconds which did
+     not fit in a previous bucket. The last bucket counts all longer periods.*/
+  uint32_t histogram[DMX_RX_TIMING_HISTOGRAM_SIZE];
+} dmx_rx_timing_t;
+
+/** @brief The configuration of a DMX merge. See dmx_merge_start().*/
+typedef struct dmx_merge_config_t {
+  /** @brief A per-slot priority mask of DMX_MERGE_MASK_SIZE bytes. Slots whose
+     bit is set are merged latest-takes-precedence (LTP). All other slots are
+     merged highest-takes-precedence (HTP). If NULL, all slots are merged
+     HTP.*/
+  const uint8_t *ltp_mask;
+  /** @brief The duration in microseconds after which an input which has not
+     received a DMX frame is considered lost. If 0, DMX_MERGE_TIMEOUT_US is
+     used.*/
+  uint32_t timeout_us;
+} dmx_merge_config_t;
+
+/** @brief Statistics of one input of a DMX merge.*/
+typedef struct dmx_merge_source_stats_t {
+  /** @brief The number of DMX frames from this input which were merged.*/
+  uint32_t frame_count;
+  /** @brief The duration in microseconds from the end of the last merged DMX
+     frame from this input to the start of the DMX packet it was sent in.*/
+  uint32_t latency;
+  /** @brief The longest latency in microseconds which was measured.*/
+  uint32_t latency_max;
+  /** @brief The number of times this input was lost.*/
+  uint32_t loss_count;
+  /** @brief True if this input is currently lost. Lost inputs are not merged.
+     An input is lost until its first DMX frame is received.*/
+  bool is_lost;
+} dmx_merge_source_stats_t;
+
+/** @brief Statistics of a DMX merge.*/
+typedef struct dmx_merge_stats_t {
+  /** @brief The number of merged DMX packets which were sent.*/
+  uint32_t frame_count;
+  /** @brief The statistics of each of the two inputs.*/
+  dmx_merge_source_stats_t sources[2];
+} dmx_merge_stats_t;
+
+/** @brief The memory used by the parameters of a DMX driver.*/
+typedef struct dmx_parameter_memory_t {
+  /** @brief The number of bytes which were reserved for parameter data.*/
+  size_t arena_size;
+  /** @brief The number of reserved bytes which are in use by parameters.*/
+  size_t arena_used;
+  /** @brief The number of bytes of parameter data which were allocated on the
+     heap because the reserved memory was full.*/
+  size_t heap_used;
+  /** @brief The number of bytes which were allocated on the heap for cached
+     RDM responses.*/
+  size_t cache_used;
+} dmx_parameter_memory_t;
+
+/** @brief Counters of the packets and errors seen by the DMX driver on a DMX
+ * port. Each counter wraps around on overflow.*/
+typedef struct dmx_stats_t {
+  /** @brief The number of packets which were received, including packets
+     which were received with an error.*/
+  uint32_t rx_packets;
+  /** @brief The number of packets which were sent.*/
+  uint32_t tx_packets;
+  /** @brief The number of packets which were received with a
+     DMX_ERR_UART_OVERFLOW error.*/
+  uint32_t rx_uart_overflows;
+  /** @brief The number of packets which were received with a
+     DMX_ERR_IMPROPER_SLOT error.*/
+  uint32_t rx_improper_slots;
+  /** @brief The number of packets which were received with a
+     DMX_ERR_NOT_ENOUGH_SLOTS error.*/
+  uint32_t rx_not_enough_slots;
+  /** @brief The number of RDM packets which were received with an invalid
+     checksum.*/
+  uint32_t rdm_checksum_errors;
+  /** @brief The number of non-broadcast RDM requests which were received.*/
+  uint32_t rdm_requests;
+  /** @brief The number of broadcast RDM requests which were received.*/
+  uint32_t rdm_broadcasts;
+  /** @brief The number of RDM responses which were received, excluding RDM
+     discovery responses.*/
+  uint32_t rdm_responses;
+  /** @brief The number of RDM discovery responses which were received.*/
+  uint32_t rdm_discovery_responses;
+  /** @brief The number of RDM responses which were not sent because the
+     response deadline had already passed.*/
+  uint32_t rdm_late_responses;
+  /** @brief The number of packets which were dropped or routed by the start
+     code filter instead of being delivered to the DMX buffer.*/
+  uint32_t rx_filtered;
+  /** @brief The number of RDM packets which were dropped because they were not
+     addressed to this device.*/
+  uint32_t rdm_filtered;
+} dmx_stats_t;
+
 /** @brief Metadata for received DMX packets. For use in the DMX sniffer.*/
 typedef struct dmx_metadata_t {
   /** @brief Length in microseconds of the last received DMX break.*/
   uint32_t break_len;
   /** @brief Length in microseconds of the last received DMX mark-after-break.*/
   uint32_t mab_len;
+  /** @brief The timestamp in microseconds since boot at which the last
+     received DMX break started.*/
+  int64_t break_timestamp;
 } dmx_metadata_t;
 
+/**
+ * @brief A callback which is invoked from the DMX interrupt handler when a
+ * packet is done being received. It may be used by latency-critical code to act
+ * on a packet without waiting for a task to wake. The callback must be short
+ * and must not block. If the DMX driver is placed in IRAM, the callback and any
+ * data it accesses must also be placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the received packet in bytes.
+ * @param sc The start code of the received packet.
+ * @param err The error code of the received packet.
+ * @param context The context which was provided when setting the callback.
+ * @return true if a higher priority task was woken by the callback.
+ */
+typedef bool (*dmx_rx_callback_t)(dmx_port_t dmx_num, size_t size, int sc,
+                                  dmx_err_t err, void *context);
+
+/**
+ * @brief A callback which is invoked from the DMX interrupt handler when a
+ * packet which was queued with dmx_send_async() is done being sent. The
+ * callback must be short and must not block. If the DMX driver is placed in
+ * IRAM, the callback and any data it accesses must also be placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The size of the sent packet in bytes.
+ * @param context The context which was provided when queuing the packet.
+ * @return true if a higher priority task was woken by the callback.
+ */
+typedef bool (*dmx_tx_callback_t)(dmx_port_t dmx_num, size_t size,
+                                  void *context);
+
+/** @brief The actions which the start code filter of a DMX port may take for
+ * packets with a given start code.*/
+typedef enum dmx_sc_action_t {
+  /** @brief The packet is delivered to the DMX buffer and wakes any task which
+     is waiting to receive it.*/
+  DMX_SC_ACTION_DELIVER = 0,
+  /** @brief The packet is dropped in the DMX ISR. Slots after the start code
+     are not copied when the DMX port receives without DMA.*/
+  DMX_SC_ACTION_DROP,
+  /** @brief The packet is passed to the start code handler of the DMX port
+     instead of being delivered to the DMX buffer.*/
+  DMX_SC_ACTION_ROUTE,
+} dmx_sc_action_t;
+
+/**
+ * @brief A function which is invoked from the DMX ISR when a packet with a
+ * routed start code is done being received.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] data A pointer to the slots of the packet, starting with the start
+ * code. It is only valid until the handler returns.
+ * @param size The size of the received packet in bytes.
+ * @param err The error code of the received packet.
+ * @param context The context which was provided when setting the handler.
+ * @return true if a higher priority task was woken by the handler.
+ */
+typedef bool (*dmx_sc_handler_t)(dmx_port_t dmx_num, const uint8_t *data,
+                                 size_t size, dmx_err_t err, void *context);
+
 /** @brief DMX start address which indicates the device does not have a DMX
  * start address.*/
 static const uint16_t DMX_START_ADDRESS_NONE = 0xffff;
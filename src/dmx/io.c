@@ -4,7 +4,10 @@
 #include "dmx/hal/include/nvs.h"
 #include "dmx/hal/include/timer.h"
 #include "dmx/hal/include/uart.h"
+#include "dmx/include/device.h"
 #include "dmx/include/driver.h"
+#include "dmx/include/isr.h"
+#include "dmx/include/parallel.h"
 #include "dmx/include/parameter.h"
 #include "dmx/include/service.h"
 #include "rdm/include/driver.h"
@@ -14,21 +17,38 @@
 size_t dmx_read_offset(dmx_port_t dmx_num, size_t offset, void *destination,
                        size_t size) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
   DMX_CHECK(destination, 0, "destination is null");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(offset < dmx_driver[dmx_num]->packet_size_max, 0, "offset error");
 
-  // Clamp size to the maximum DMX packet size
-  if (size + offset > DMX_PACKET_SIZE_MAX) {
-    size = DMX_PACKET_SIZE_MAX - offset;
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Clamp size to the maximum packet size of the DMX driver
+  if (size + offset > driver->packet_size_max) {
+    size = driver->packet_size_max - offset;
   } else if (size == 0) {
     return 0;
   }
 
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
+#if DMX_RX_BUFFER_COUNT > 1
+  // Take the last complete frame so that the ISR cannot write to it
+  const uint8_t *frame;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->dmx.ready_is_fresh && !driver->lease.read_is_leased) {
+    uint8_t *const front = driver->dmx.front;
+    driver->dmx.front = driver->dmx.ready;
+    driver->dmx.ready = front;
+    driver->dmx.ready_is_fresh = false;
+  }
+  frame = driver->dmx.front;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
+  // Copy data from the frame buffer to the destination asynchronously
+  memcpy(destination, frame + offset, size);
+#else
   // Copy data from the driver buffer to the destination asynchronously
   memcpy(destination, driver->dmx.data + offset, size);
+#endif
 
   return size;
 }
@@ -43,8 +63,9 @@ size_t dmx_read(dmx_port_t dmx_num, void *destination, size_t size) {
 
 int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
-  DMX_CHECK(slot_num < DMX_PACKET_SIZE_MAX, -1, "slot_num error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
+  DMX_CHECK(slot_num < dmx_driver[dmx_num]->packet_size_max, -1,
+            "slot_num error");
 
   uint8_t slot;
   dmx_read_offset(dmx_num, slot_num, &slot, 1);
@@ -55,42 +76,61 @@ int dmx_read_slot(dmx_port_t dmx_num, size_t slot_num) {
 size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source,
                         size_t size) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
   DMX_CHECK(source, 0, "source is null");
+  if (dmx_num_is_parallel(dmx_num)) {
+    DMX_CHECK(offset < DMX_PACKET_SIZE_MAX, 0, "offset error");
+    return dmx_parallel_write_offset(dmx_num, offset, source, size);
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(offset < dmx_driver[dmx_num]->packet_size_max, 0, "offset error");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
 
-  // Clamp size to the maximum DMX packet size
-  if (size + offset > DMX_PACKET_SIZE_MAX) {
-    size = DMX_PACKET_SIZE_MAX - offset;
+  // Clamp size to the maximum packet size of the DMX driver
+  if (size + offset > driver->packet_size_max) {
+    size = driver->packet_size_max - offset;
   } else if (size == 0) {
     return 0;
   }
 
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
-
-  // Check if the driver is currently sending an RDM packet
-  int dmx_status;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  dmx_status = driver->dmx.status;
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  if (dmx_status == DMX_STATUS_SENDING) {
+  // Check if the driver is currently sending an RDM response
+  dmx_driver_state_t state;
+  dmx_driver_get_state(driver, &state);
+  bool request_is_active;
+  if (state.status == DMX_STATUS_SENDING) {
     rdm_header_t header;
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    const bool is_rdm = rdm_read_header(dmx_num, &header);
+    request_is_active = driver->rdm.request_is_active;
+    const bool is_rdm = !request_is_active && rdm_read_header(dmx_num, &header);
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     if (is_rdm) {
       return 0;  // Do not allow asynchronous writes while sending RDM
     }
+  } else {
+    request_is_active = driver->rdm.request_is_active;
   }
 
-  // Flip the DMX bus to write mode
-  if (dmx_uart_get_rts(dmx_num) == 1) {
+  // Flip the DMX bus to write mode unless an RDM request is using the bus
+  if (!request_is_active && dmx_uart_get_rts(dmx_num) == 1) {
     dmx_uart_set_rts(dmx_num, 0);
   }
 
   // Copy data from the source to the driver buffer asynchronously
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  memcpy(driver->dmx.data + offset, source, size);
+  if (driver->continuous.staging != NULL) {
+    // The data is sent at the start of the next continuous DMX packet
+    memcpy(driver->continuous.staging + offset, source, size);
+    driver->continuous.is_dirty = true;
+  } else if (driver->lease.write_is_pending) {
+    // The released write buffer is sent in the next DMX packet
+    memcpy(driver->lease.back + offset, source, size);
+  } else if (driver->rdm.request_is_active) {
+    // The DMX packet is swapped out of the driver while RDM is in progress
+    memcpy(driver->rdm.data + offset, source, size);
+  } else {
+    memcpy(driver->dmx.data + offset, source, size);
+    DMX_RDM_HEADER_INVALIDATE(driver);
+  }
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return size;
@@ -99,6 +139,9 @@ size_t dmx_write_offset(dmx_port_t dmx_num, size_t offset, const void *source,
 size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
   DMX_CHECK(source, 0, "source is null");
+  if (dmx_num_is_parallel(dmx_num)) {
+    return dmx_parallel_write_offset(dmx_num, 0, source, size);
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
   return dmx_write_offset(dmx_num, 0, source, size);
@@ -106,14 +149,131 @@ size_t dmx_write(dmx_port_t dmx_num, const void *source, size_t size) {
 
 int dmx_write_slot(dmx_port_t dmx_num, size_t slot_num, uint8_t value) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
-  DMX_CHECK(slot_num < DMX_PACKET_SIZE_MAX, -1, "slot_num error");
+  if (dmx_num_is_parallel(dmx_num)) {
+    DMX_CHECK(slot_num < DMX_PACKET_SIZE_MAX, -1, "slot_num error");
+    return dmx_parallel_write_offset(dmx_num, slot_num, &value, 1) ? value
+                                                                   : -1;
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
+  DMX_CHECK(slot_num < dmx_driver[dmx_num]->packet_size_max, -1,
+            "slot_num error");
 
   dmx_write_offset(dmx_num, slot_num, &value, 1);
 
   return value;
 }
 
+// Compares the last received DMX packet to the one before it and returns a
+// bit mask of the blocks of DMX_CHANGED_BLOCK_SIZE slots which have changed.
+// All blocks in the packet are reported as changed if change detection is
+// disabled.
+static uint32_t dmx_detect_changes(dmx_driver_t *driver, size_t size) {
+  const size_t block_count =
+      (size + DMX_CHANGED_BLOCK_SIZE - 1) / DMX_CHANGED_BLOCK_SIZE;
+  const uint32_t all_blocks = (1 << block_count) - 1;
+  uint32_t *const last = driver->change.last;
+  if (last == NULL) {
+    return all_blocks;
+  }
+
+  // Get the last complete packet so that the ISR cannot write to it
+  const uint32_t *frame;
+#if DMX_RX_BUFFER_COUNT > 1
+  taskENTER_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+  if (driver->dmx.ready_is_fresh && !driver->lease.read_is_leased) {
+    uint8_t *const front = driver->dmx.front;
+    driver->dmx.front = driver->dmx.ready;
+    driver->dmx.ready = front;
+    driver->dmx.ready_is_fresh = false;
+  }
+  frame = (const uint32_t *)driver->dmx.front;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+#else
+  frame = (const uint32_t *)driver->dmx.data;
+#endif
+
+  // Slots beyond the size of the last packet have always changed
+  uint32_t changed_blocks = 0;
+  if (size != driver->change.last_size) {
+    const size_t common_size =
+        size < driver->change.last_size ? size : driver->change.last_size;
+    const uint32_t common_blocks =
+        (1 << (common_size / DMX_CHANGED_BLOCK_SIZE)) - 1;
+    changed_blocks = all_blocks & ~common_blocks;
+  }
+
+  // Compare each block one word at a time and copy any changes
+  const size_t word_count = size / 4;
+  const size_t words_per_block = DMX_CHANGED_BLOCK_SIZE / 4;
+  for (size_t i = 0; i < word_count; ++i) {
+    if (frame[i] != last[i]) {
+      changed_blocks |= 1 << (i / words_per_block);
+      last[i] = frame[i];
+    }
+  }
+
+  // Compare the remaining slots which do not fill a word
+  const uint8_t *const frame_tail = (const uint8_t *)&frame[word_count];
+  uint8_t *const last_tail = (uint8_t *)&last[word_count];
+  for (size_t i = 0; i < size % 4; ++i) {
+    if (frame_tail[i] != last_tail[i]) {
+      changed_blocks |= 1 << (word_count / words_per_block);
+      last_tail[i] = frame_tail[i];
+    }
+  }
+  driver->change.last_size = size;
+
+  return changed_blocks;
+}
+
+// Fills a dmx_packet_t to report that no packet was received. The packet may
+// be NULL.
+static void dmx_packet_reset(dmx_packet_t *packet) {
+  if (packet == NULL) {
+    return;
+  }
+  packet->err = DMX_ERR_TIMEOUT;
+  packet->sc = -1;
+  packet->size = 0;
+  packet->is_rdm = false;
+  packet->is_changed = false;
+  packet->changed_blocks = 0;
+  packet->break_timestamp = 0;
+  packet->eop_timestamp = 0;
+}
+
+// Fills a dmx_packet_t with information about the last received packet.
+static void dmx_parse_packet(dmx_driver_t *driver, dmx_packet_t *packet,
+                             int packet_size, dmx_err_t err) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  if (packet_size > 0) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+#if DMX_RX_BUFFER_COUNT > 1
+    packet->sc = driver->dmx.sc;
+#else
+    packet->sc = driver->dmx.data[0];
+#endif
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  } else {
+    packet->sc = -1;
+  }
+  packet->err = err;
+  packet->size = packet_size;
+  packet->is_rdm = dmx_start_code_is_rdm(packet->sc);
+  if (packet->sc == DMX_SC && err == DMX_OK) {
+    packet->changed_blocks = dmx_detect_changes(driver, packet_size);
+    packet->is_changed = (packet->changed_blocks != 0);
+  } else {
+    // Packets which are not checked for changes are always reported changed
+    packet->changed_blocks = 0;
+    packet->is_changed = true;
+  }
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  packet->break_timestamp = driver->dmx.last_break_timestamp;
+  packet->eop_timestamp = driver->dmx.last_eop_timestamp;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+
 size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
                        TickType_t wait_ticks) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
@@ -127,22 +287,12 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
   vTaskSetTimeOutState(&timeout);
   if (!xSemaphoreTakeRecursive(driver->mux, wait_ticks) ||
       (wait_ticks && xTaskCheckForTimeOut(&timeout, &wait_ticks))) {
-    if (packet != NULL) {
-      packet->err = DMX_ERR_TIMEOUT;
-      packet->sc = -1;
-      packet->size = 0;
-      packet->is_rdm = 0;
-    }
+    dmx_packet_reset(packet);
     return 0;
   } else if (!dmx_wait_sent(dmx_num, wait_ticks) ||
              (wait_ticks && xTaskCheckForTimeOut(&timeout, &wait_ticks))) {
     xSemaphoreGiveRecursive(driver->mux);
-    if (packet != NULL) {
-      packet->err = DMX_ERR_TIMEOUT;
-      packet->sc = -1;
-      packet->size = 0;
-      packet->is_rdm = 0;
-    }
+    dmx_packet_reset(packet);
     return 0;
   }
 
@@ -150,42 +300,37 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
   if (dmx_uart_get_rts(dmx_num) == 0) {
     xTaskNotifyStateClear(xTaskGetCurrentTaskHandle());
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_STATE_WRITE_BEGIN(driver);
     driver->dmx.progress = DMX_PROGRESS_STALE;
     driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+    DMX_STATE_WRITE_END(driver);
     dmx_uart_set_rts(dmx_num, 1);
+    driver->dmx.tx_break_was_sent = false;
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
 
   // Update the receive size only if it has changed
-  int old_size;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  old_size = driver->dmx.size;
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  if (size != old_size) {
+  dmx_driver_state_t state;
+  dmx_driver_get_state(driver, &state);
+  if (size != state.size) {
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_STATE_WRITE_BEGIN(driver);
     driver->dmx.size = size;
     if (driver->dmx.progress != DMX_PROGRESS_STALE &&
         driver->dmx.head >= size) {
       driver->dmx.progress = DMX_PROGRESS_COMPLETE;
     }
+    DMX_STATE_WRITE_END(driver);
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
 
   // Guard against condition where this task cannot block and data isn't ready
-  int packet_status;
-  int packet_size;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  packet_status = driver->dmx.progress;
-  packet_size = driver->dmx.head;
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  dmx_driver_get_state(driver, &state);
+  const int packet_status = state.progress;
+  int packet_size = state.head;
   if (packet_status != DMX_PROGRESS_COMPLETE && wait_ticks == 0) {
     // Not enough DMX data has been received yet - return early
-    if (packet != NULL) {
-      packet->err = DMX_ERR_TIMEOUT;
-      packet->sc = -1;
-      packet->size = 0;
-      packet->is_rdm = 0;
-    }
+    dmx_packet_reset(packet);
     xSemaphoreGiveRecursive(driver->mux);
     return 0;
   }
@@ -209,20 +354,12 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
 
     // Set an alarm to timeout early if an RDM response is expected
     if (timer_alarm > 0) {
-      int64_t last_timestamp;
-      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-      last_timestamp = driver->dmx.controller_eop_timestamp;
-      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      dmx_driver_get_state(driver, &state);
       const int64_t timer_elapsed =
-          dmx_timer_get_micros_since_boot() - last_timestamp;
+          dmx_timer_get_micros_since_boot() - state.controller_eop_timestamp;
       if (timer_elapsed > timer_alarm) {
         // Return early if the time elapsed is greater than the timer alarm
-        if (packet != NULL) {
-          packet->err = DMX_ERR_TIMEOUT;
-          packet->sc = -1;
-          packet->size = 0;
-          packet->is_rdm = 0;
-        }
+        dmx_packet_reset(packet);
         xSemaphoreGiveRecursive(driver->mux);
         return 0;
       }
@@ -243,14 +380,9 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     if (!notified) {
       xTaskNotifyStateClear(current_task_handle);  // Avoid race condition
-      if (packet != NULL) {
-        packet->err = DMX_ERR_TIMEOUT;
-        packet->sc = -1;
-        packet->size = 0;
-        packet->is_rdm = 0;
-      }
+      dmx_packet_reset(packet);
       xSemaphoreGiveRecursive(driver->mux);
-      dmx_parameter_commit(dmx_num);
+      dmx_parameter_commit_schedule(dmx_num, true);
       return 0;
     }
   } else {
@@ -263,19 +395,17 @@ size_t dmx_receive_num(dmx_port_t dmx_num, dmx_packet_t *packet, size_t size,
 
   // Parse DMX packet data
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  driver->dmx.progress = DMX_PROGRESS_STALE;  // Prevent parsing old data
+  // A packet which was ended by a DMX break is notified after the DMX driver
+  // has started receiving the next packet, which must not be made stale
+  if (err != DMX_ERR_NOT_ENOUGH_SLOTS ||
+      driver->dmx.progress == DMX_PROGRESS_COMPLETE) {
+    DMX_STATE_WRITE_BEGIN(driver);
+    driver->dmx.progress = DMX_PROGRESS_STALE;  // Prevent parsing old data
+    DMX_STATE_WRITE_END(driver);
+  }
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   if (packet != NULL) {
-    if (packet_size > 0) {
-      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-      packet->sc = driver->dmx.data[0];
-      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    } else {
-      packet->sc = -1;
-    }
-    packet->err = err;
-    packet->size = packet_size;
-    packet->is_rdm = dmx_start_code_is_rdm(packet->sc);
+    dmx_parse_packet(driver, packet, packet_size, err);
   }
 
   xSemaphoreGiveRecursive(driver->mux);
@@ -288,16 +418,338 @@ size_t dmx_receive(dmx_port_t dmx_num, dmx_packet_t *packet,
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
   DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
 
-  size_t size;
+  dmx_driver_state_t state;
+  dmx_driver_get_state(dmx_driver[dmx_num], &state);
+
+  return dmx_receive_num(dmx_num, packet, state.size, wait_ticks);
+}
+
+size_t dmx_receive_changed(dmx_port_t dmx_num, dmx_packet_t *packet,
+                           TickType_t wait_ticks) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+
+  dmx_packet_t changed_packet;
+  if (packet == NULL) {
+    packet = &changed_packet;
+  }
+
+  // Receive packets until one has changed, has a non-zero start code, or has
+  // an error
+  TimeOut_t timeout;
+  vTaskSetTimeOutState(&timeout);
+  do {
+    const size_t packet_size = dmx_receive(dmx_num, packet, wait_ticks);
+    if (packet_size == 0 || packet->is_changed || packet->err != DMX_OK) {
+      return packet_size;
+    }
+  } while (!xTaskCheckForTimeOut(&timeout, &wait_ticks));
+
+  dmx_packet_reset(packet);
+  return 0;
+}
+
+dmx_port_t dmx_receive_any(const dmx_port_t *ports, size_t count,
+                           dmx_packet_t *packet, TickType_t wait_ticks) {
+  DMX_CHECK(ports != NULL, DMX_NUM_MAX, "ports is null");
+  DMX_CHECK(count > 0 && count <= DMX_NUM_MAX, DMX_NUM_MAX, "count error");
+  for (size_t i = 0; i < count; ++i) {
+    DMX_CHECK(ports[i] < DMX_NUM_MAX, DMX_NUM_MAX, "ports[%i] error", (int)i);
+    DMX_CHECK(dmx_driver_is_installed(ports[i]), DMX_NUM_MAX,
+              "ports[%i] driver is not installed", (int)i);
+    DMX_CHECK(dmx_driver_is_enabled(ports[i]), DMX_NUM_MAX,
+              "ports[%i] driver is not enabled", (int)i);
+  }
+
+  // Tell each DMX driver that this task is awaiting a DMX packet
+  const TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
+  xTaskNotifyStateClear(current_task_handle);
+  uint32_t port_mask = 0;
+  bool is_registered = true;
+  for (size_t i = 0; i < count; ++i) {
+    const dmx_port_t dmx_num = ports[i];
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->any_waiting == NULL) {
+      driver->any_waiting = current_task_handle;
+      port_mask |= 1 << dmx_num;
+    } else if (driver->any_waiting != current_task_handle) {
+      is_registered = false;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (!is_registered) {
+      DMX_ERR("ports[%i] is already awaited by another task", (int)i);
+      break;
+    }
+
+    // Set the RTS pin to enable reading from the DMX bus if it is not in use
+    if (dmx_uart_get_rts(dmx_num) == 0 &&
+        xSemaphoreTakeRecursive(driver->mux, 0)) {
+      if (dmx_wait_sent(dmx_num, 0)) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.progress = DMX_PROGRESS_STALE;
+        driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+        DMX_STATE_WRITE_END(driver);
+        dmx_uart_set_rts(dmx_num, 1);
+        driver->dmx.tx_break_was_sent = false;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      }
+      xSemaphoreGiveRecursive(driver->mux);
+    }
+  }
+
+  // Wait until any of the DMX ports has a complete packet
+  dmx_port_t ret = DMX_NUM_MAX;
+  int packet_size = 0;
+  dmx_err_t err = DMX_OK;
+  TimeOut_t timeout;
+  vTaskSetTimeOutState(&timeout);
+  bool is_waiting = is_registered;
+  while (is_waiting) {
+    for (size_t i = 0; i < count && ret == DMX_NUM_MAX; ++i) {
+      const dmx_port_t dmx_num = ports[i];
+      dmx_driver_t *const driver = dmx_driver[dmx_num];
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      if (driver->dmx.progress == DMX_PROGRESS_COMPLETE) {
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.progress = DMX_PROGRESS_STALE;  // Prevent parsing old data
+        DMX_STATE_WRITE_END(driver);
+        packet_size = driver->dmx.head > 0 ? driver->dmx.head : 0;
+        err = driver->dmx.last_err;
+        ret = dmx_num;
+      }
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+    is_waiting = ret == DMX_NUM_MAX && wait_ticks > 0 &&
+                 !xTaskCheckForTimeOut(&timeout, &wait_ticks) &&
+                 xTaskNotifyWait(0, port_mask, NULL, wait_ticks);
+  }
+
+  // Stop awaiting packets on the DMX ports
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    if (port_mask & (1 << dmx_num)) {
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      dmx_driver[dmx_num]->any_waiting = NULL;
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+  }
+  xTaskNotifyStateClear(current_task_handle);  // Avoid race condition
+
+  if (packet != NULL) {
+    if (ret != DMX_NUM_MAX) {
+      dmx_parse_packet(dmx_driver[ret], packet, packet_size, err);
+    } else {
+      dmx_packet_reset(packet);
+    }
+  }
+
+  return ret;
+}
+
+bool dmx_rx_queue_enable(dmx_port_t dmx_num, size_t size) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(size > 1 && (size & (size - 1)) == 0, false, "size error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->rx_queue.frames == NULL, false,
+            "receive queue is already enabled");
+
+  // Allocate the ring of frames followed by the slot buffer of each frame
+  const size_t buffer_size = DMX_BUFFER_SIZE(driver->packet_size_max);
+  const size_t frames_size = (sizeof(dmx_frame_t) * size + 3) & ~3;
+  dmx_frame_t *frames = heap_caps_malloc(frames_size + buffer_size * size,
+                                         driver->memory_caps);
+  if (frames == NULL) {
+    DMX_ERR("receive queue malloc error");
+    return false;
+  }
+  uint8_t *const buffers = (uint8_t *)frames + frames_size;
+  for (size_t i = 0; i < size; ++i) {
+    frames[i].data = buffers + buffer_size * i;
+  }
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->rx_queue.size = size;
+  driver->rx_queue.head = 0;
+  driver->rx_queue.tail = 0;
+  driver->rx_queue.dropped = 0;
+  driver->rx_queue.reported = 0;
+  driver->rx_queue.frames = frames;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_rx_queue_disable(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->rx_queue.frames != NULL, false,
+            "receive queue is not enabled");
+
+  // Detach the frames from the DMX ISR before freeing them
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  size = dmx_driver[dmx_num]->dmx.size;
+  dmx_frame_t *const frames = driver->rx_queue.frames;
+  driver->rx_queue.frames = NULL;
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  heap_caps_free(frames);
+
+  return true;
+}
+
+size_t dmx_rx_queue_acquire(dmx_port_t dmx_num, dmx_frame_t *frames,
+                            size_t count, uint32_t *dropped,
+                            TickType_t wait_ticks) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(frames != NULL || count == 0, 0, "frames is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  struct dmx_driver_rx_queue_t *const queue = &driver->rx_queue;
+  DMX_CHECK(queue->frames != NULL, 0, "receive queue is not enabled");
+
+  // Tell the DMX driver that this task is awaiting a frame
+  const TaskHandle_t current_task_handle = xTaskGetCurrentTaskHandle();
+  const uint32_t tail = queue->tail;
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  if (head == tail && wait_ticks > 0) {
+    xTaskNotifyStateClear(current_task_handle);
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    queue->task_waiting = current_task_handle;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+    // Wait until a frame is queued
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (;;) {
+      head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+      if (head != tail || xTaskCheckForTimeOut(&timeout, &wait_ticks) ||
+          !xTaskNotifyWait(0, 0, NULL, wait_ticks)) {
+        break;
+      }
+    }
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    queue->task_waiting = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    xTaskNotifyStateClear(current_task_handle);  // Avoid race condition
+    head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  }
+
+  // Copy the descriptors of the frames which have not been released
+  size_t acquired = head - tail;
+  if (acquired > count) {
+    acquired = count;
+  }
+  for (size_t i = 0; i < acquired; ++i) {
+    frames[i] = queue->frames[(tail + i) & (queue->size - 1)];
+  }
+
+  // Report the frames which were dropped since the last call
+  const uint32_t total_dropped =
+      __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+  if (dropped != NULL) {
+    *dropped = total_dropped - queue->reported;
+  }
+  queue->reported = total_dropped;
+
+  return acquired;
+}
+
+size_t dmx_rx_queue_release(dmx_port_t dmx_num, size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  struct dmx_driver_rx_queue_t *const queue = &driver->rx_queue;
+  DMX_CHECK(queue->frames != NULL, 0, "receive queue is not enabled");
+
+  // Hand the released frames back to the DMX ISR
+  const uint32_t tail = queue->tail;
+  size_t released = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - tail;
+  if (released > count) {
+    released = count;
+  }
+  __atomic_store_n(&queue->tail, tail + released, __ATOMIC_RELEASE);
+
+  return released;
+}
+
+size_t dmx_receive_footprint(dmx_port_t dmx_num, void *destination,
+                             size_t size, dmx_packet_t *packet,
+                             TickType_t wait_ticks) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(destination, 0, "destination is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+
+  // Get the current footprint window of this device
+  const uint16_t start_address = dmx_get_start_address(dmx_num);
+  DMX_CHECK(start_address != DMX_START_ADDRESS_NONE, 0,
+            "device does not have a DMX start address");
+  const uint8_t personality_num = dmx_get_current_personality(dmx_num);
+  size_t footprint =
+      personality_num > 0 ? dmx_get_footprint(dmx_num, personality_num) : 0;
+  const size_t packet_size_max = dmx_driver[dmx_num]->packet_size_max;
+  if (start_address >= packet_size_max) {
+    footprint = 0;  // The footprint window is beyond the maximum packet size
+  } else if (start_address + footprint > packet_size_max) {
+    footprint = packet_size_max - start_address;
+  }
+  if (footprint > size) {
+    footprint = size;
+  }
+
+  // Wake as soon as the last slot in the footprint window has been received
+  dmx_packet_t footprint_packet;
+  if (packet == NULL) {
+    packet = &footprint_packet;
+  }
+  const size_t packet_size =
+      dmx_receive_num(dmx_num, packet, start_address + footprint, wait_ticks);
+  if (packet_size <= start_address || packet->sc != DMX_SC) {
+    return 0;  // The packet does not contain any of the footprint window
+  }
+
+  // Copy only the footprint window into the destination buffer
+  if (packet_size < start_address + footprint) {
+    footprint = packet_size - start_address;
+  }
+  return dmx_read_offset(dmx_num, start_address, destination, footprint);
+}
 
-  return dmx_receive_num(dmx_num, packet, size, wait_ticks);
+// Gets the minimum duration in microseconds from the end of the last packet
+// to the start of the next packet which is sent by the RDM controller.
+static int64_t dmx_controller_get_spacing(const dmx_driver_t *driver) {
+  if (driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+    if (driver->dmx.responder_sent_last ||
+        driver->dmx.last_controller_pid == 0 ||
+        driver->dmx.last_request_was_broadcast) {
+      return RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
+    } else {
+      return RDM_TIMING_CONTROLLER_RESPONSE_LOST_MIN;
+    }
+  } else if (driver->dmx.responder_sent_last) {
+    /* This is a condition in which the RDM controller sends an
+      RDM_PID_DISC_UNIQUE_BRANCH message and a valid response has already been
+      received. The RDM standard doesn't specify how long the RDM controller
+      should wait before sending the next RDM request. Therefore this value is
+      customizable by the user in the Kconfig.*/
+    return RDM_TIMING_CONTROLLER_DISCOVERY_TRANSACTION_MIN;
+  } else {
+    return RDM_TIMING_CONTROLLER_DISCOVERY_TO_REQUEST_MIN;
+  }
 }
 
 size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  if (dmx_num_is_parallel(dmx_num)) {
+    return dmx_parallel_send_num(dmx_num, size);
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
   DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
 
@@ -313,6 +765,7 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
     xSemaphoreGiveRecursive(driver->mux);
     return 0;
   }
+  dmx_lease_publish(dmx_num);
 
   // Determine if the packet was an RDM packet
   bool is_rdm;
@@ -328,31 +781,9 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
   driver->is_controller = !is_rdm || rdm_cc_is_request(header.cc);
 
   // Determine if it is necessary to set a hardware timeout alarm
-  int64_t timer_alarm;
-  if (driver->is_controller) {
-    if (driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-      if (driver->dmx.responder_sent_last ||
-          driver->dmx.last_controller_pid == 0 ||
-          driver->dmx.last_request_was_broadcast) {
-        timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
-      } else {
-        timer_alarm = RDM_TIMING_CONTROLLER_RESPONSE_LOST_MIN;
-      }
-    } else {
-      if (driver->dmx.responder_sent_last) {
-        /* This is a condition in which the RDM controller sends an
-          RDM_PID_DISC_UNIQUE_BRANCH message and a valid response has already
-          been received. The RDM standard doesn't specify how long the RDM
-          controller should wait before sending the next RDM request. Therefore
-          this value is customizable by the user in the Kconfig.*/
-        timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TRANSACTION_MIN;
-      } else {
-        timer_alarm = RDM_TIMING_CONTROLLER_DISCOVERY_TO_REQUEST_MIN;
-      }
-    }
-  } else {
-    timer_alarm = RDM_TIMING_RESPONDER_MIN;
-  }
+  const int64_t timer_alarm = driver->is_controller
+                                  ? dmx_controller_get_spacing(driver)
+                                  : RDM_TIMING_RESPONDER_MIN;
 
   // If necessary, set an alarm to wait the minimum duration before sending
   int64_t timer_elapsed;
@@ -379,6 +810,9 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
   // Return early if it is too late to send a response packet
   if (!driver->is_controller) {
     if (timer_elapsed > RDM_TIMING_RESPONDER_MAX) {
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      ++driver->stats.rdm_late_responses;
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
       xSemaphoreGiveRecursive(driver->mux);
       return 0;
     }
@@ -399,11 +833,38 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
     } else {
       size = header.message_len + 2;  // Send a standard RDM packet
     }
-  } else if (size == 0 || size > DMX_PACKET_SIZE_MAX) {
-    size = DMX_PACKET_SIZE_MAX;  // Send a standard DMX packet
+  } else if (size > driver->packet_size_max) {
+    size = driver->packet_size_max;  // Send a standard DMX packet
   }
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (size == 0) {
+    // Send an automatically sized or a standard DMX packet
+    size = driver->auto_size.min_size > 0
+               ? dmx_auto_size_get(driver, dmx_timer_get_micros_since_boot())
+               : driver->packet_size_max;
+  }
+  DMX_STATE_WRITE_BEGIN(driver);
   driver->dmx.size = size;
+  DMX_STATE_WRITE_END(driver);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  // Determine if the UART should send the DMX break after this packet
+  bool break_is_needed = true;
+  int tx_break_bits = 0;
+  int tx_mab_bits = 0;
+  if (driver->break_mode == DMX_BREAK_MODE_UART && !is_rdm) {
+    const uint64_t baud_rate = dmx_uart_get_baud_rate(dmx_num);
+    tx_break_bits = (driver->break_len * baud_rate + 999999) / 1000000;
+    tx_mab_bits = (driver->mab_len * baud_rate + 999999) / 1000000;
+
+    // The previous packet's DMX break may be used if the bus has stayed idle
+    break_is_needed = !driver->dmx.tx_break_was_sent ||
+                      timer_elapsed >= DMX_MAB_LEN_MAX_US;
+  }
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->dmx.tx_break_bits = tx_break_bits;
+  driver->dmx.tx_mab_bits = tx_mab_bits;
+  driver->dmx.tx_break_was_sent = false;
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   // Record information about the packet that is being sent
@@ -414,6 +875,11 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
     driver->dmx.last_controller_pid = pid;
     driver->dmx.last_request_was_broadcast = was_broadcast;
     driver->dmx.responder_sent_last = false;
+    if (!is_rdm) {
+      int task_awoken = false;  // Tasks are not yielded to from a task
+      dmx_schedule_count_frame(driver, dmx_timer_get_micros_since_boot(),
+                               &task_awoken);
+    }
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     if (pid != 0) {
       ++driver->rdm.tn;
@@ -427,25 +893,45 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
   }
 
   // Determine if a DMX break is required and send the packet
-  if (is_rdm && header.cc == RDM_CC_DISC_COMMAND_RESPONSE &&
-      header.pid == RDM_PID_DISC_UNIQUE_BRANCH) {
-    // RDM discovery responses do not send a DMX break - write immediately
+  if (!break_is_needed ||
+      (is_rdm && header.cc == RDM_CC_DISC_COMMAND_RESPONSE &&
+       header.pid == RDM_PID_DISC_UNIQUE_BRANCH)) {
+    /* RDM discovery responses do not send a DMX break and the UART may have
+      already sent the DMX break after the last packet - write immediately.*/
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    driver->dmx.status = DMX_STATUS_SENDING;
-
+    int tx_intr_mask;
     int write_len = driver->dmx.size;
-    dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
+    const int tx_done_intr = driver->dmx.tx_break_bits > 0
+                                 ? DMX_INTR_TX_BREAK_DONE
+                                 : DMX_INTR_TX_DONE;
+    dmx_uart_set_tx_break(dmx_num, driver->dmx.tx_break_bits,
+                          driver->dmx.tx_mab_bits);
+    if (driver->tx_mode == DMX_TX_MODE_DMA) {
+      dmx_uart_clear_interrupt(dmx_num, tx_done_intr);
+      dmx_uart_dma_write(dmx_num, driver->dmx.data, write_len);
+      tx_intr_mask = tx_done_intr;  // DMA refills the TX FIFO
+    } else {
+      dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
+      tx_intr_mask = DMX_INTR_TX_DATA | tx_done_intr;
+    }
+    DMX_STATE_WRITE_BEGIN(driver);
+    driver->dmx.status = DMX_STATUS_SENDING;
     driver->dmx.head = write_len;
+    DMX_STATE_WRITE_END(driver);
+    driver->continuous.frame_timestamp = dmx_timer_get_micros_since_boot();
 
     // Enable DMX write interrupts
-    dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_ALL);
+    dmx_uart_enable_interrupt(dmx_num, tx_intr_mask);
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   } else {
     // Send the packet by starting the DMX break
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_STATE_WRITE_BEGIN(driver);
     driver->dmx.head = 0;
     driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
     driver->dmx.status = DMX_STATUS_SENDING;
+    DMX_STATE_WRITE_END(driver);
+    driver->continuous.frame_timestamp = dmx_timer_get_micros_since_boot();
     dmx_timer_set_counter(dmx_num, 0);
     dmx_timer_set_alarm(dmx_num, driver->break_len, true);
     dmx_timer_start(dmx_num);
@@ -461,14 +947,93 @@ size_t dmx_send_num(dmx_port_t dmx_num, size_t size) {
 
 size_t dmx_send(dmx_port_t dmx_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  if (dmx_num_is_parallel(dmx_num)) {
+    return dmx_parallel_send_num(dmx_num, 0);
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
   DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
 
-  return dmx_send_num(dmx_num, DMX_PACKET_SIZE);
+  return dmx_send_num(dmx_num, 0);
+}
+
+bool dmx_send_async(dmx_port_t dmx_num, size_t size,
+                    dmx_tx_callback_t callback, void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+  DMX_CHECK(!dmx_continuous_is_running(dmx_num), false,
+            "continuous sending is running");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Return early if another task is using the driver
+  if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+    return false;
+  }
+
+  // Clamp size to the maximum packet size of the DMX driver
+  if (size > driver->packet_size_max) {
+    size = driver->packet_size_max;
+  }
+
+  // Get the UART DMX break which is sent after the packet
+  int tx_break_bits = 0;
+  int tx_mab_bits = 0;
+  if (driver->break_mode == DMX_BREAK_MODE_UART) {
+    const uint64_t baud_rate = dmx_uart_get_baud_rate(dmx_num);
+    tx_break_bits = (driver->break_len * baud_rate + 999999) / 1000000;
+    tx_mab_bits = (driver->mab_len * baud_rate + 999999) / 1000000;
+  }
+
+  // Queue the packet. If the driver is idle, the timer is started so that the
+  // packet is sent as soon as the RDM controller spacing allows.
+  bool is_rdm, is_queued;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  const uint8_t *frame =
+      driver->lease.write_is_pending ? driver->lease.back : driver->dmx.data;
+  is_rdm = driver->rdm.request_is_active || frame[0] == RDM_SC;
+  is_queued = driver->tx_async.is_queued;
+  if (!is_rdm && !is_queued) {
+    driver->tx_async.size = size;
+    driver->tx_async.tx_break_bits = tx_break_bits;
+    driver->tx_async.tx_mab_bits = tx_mab_bits;
+    driver->tx_async.queued_callback = callback;
+    driver->tx_async.queued_context = context;
+    driver->tx_async.is_queued = true;
+    if (driver->dmx.status != DMX_STATUS_SENDING) {
+      const int64_t elapsed = dmx_timer_get_micros_since_boot() -
+                              driver->dmx.controller_eop_timestamp;
+      int64_t wait = (driver->is_controller
+                          ? dmx_controller_get_spacing(driver)
+                          : RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN) -
+                     elapsed;
+      if (wait < 1) {
+        wait = 1;
+      }
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.progress = DMX_PROGRESS_STALE;
+      driver->dmx.status = DMX_STATUS_SENDING;
+      DMX_STATE_WRITE_END(driver);
+      dmx_timer_set_counter(dmx_num, 0);
+      dmx_timer_set_alarm(dmx_num, wait, false);
+      dmx_timer_start(dmx_num);
+    }
+    driver->is_controller = true;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  // Give the mutex back
+  xSemaphoreGiveRecursive(driver->mux);
+  DMX_CHECK(!is_rdm, false, "RDM packets cannot be sent asynchronously");
+
+  return !is_queued;  // The queue only holds the next DMX packet
 }
 
 bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  if (dmx_num_is_parallel(dmx_num)) {
+    return dmx_parallel_wait_sent(dmx_num, wait_ticks);
+  }
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
@@ -498,14 +1063,818 @@ bool dmx_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
       driver->task_waiting = NULL;
     }
   } else {
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    if (driver->dmx.status == DMX_STATUS_SENDING) {
+    dmx_driver_state_t state;
+    dmx_driver_get_state(driver, &state);
+    if (state.status == DMX_STATUS_SENDING) {
       result = false;
     }
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
 
   // Give the mutex back and return
   xSemaphoreGiveRecursive(driver->mux);
   return result;
 }
+
+bool dmx_continuous_start(dmx_port_t dmx_num, size_t size,
+                          uint32_t period_us) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+  DMX_CHECK(!dmx_continuous_is_running(dmx_num), false,
+            "continuous sending is already running");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Clamp size to the maximum packet size of the DMX driver
+  const bool is_auto_sized = (size == 0);
+  if (size == 0 || size > driver->packet_size_max) {
+    size = driver->packet_size_max;
+  }
+
+  // Allocate the staging buffer
+  uint8_t *staging =
+      heap_caps_malloc(driver->packet_size_max, driver->memory_caps);
+  if (staging == NULL) {
+    DMX_ERR("continuous staging buffer malloc error");
+    return false;
+  }
+
+  // Take the mutex and wait until the driver is done sending
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    heap_caps_free(staging);
+    return false;
+  }
+  if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+    xSemaphoreGiveRecursive(driver->mux);
+    heap_caps_free(staging);
+    return false;
+  }
+  dmx_lease_publish(dmx_num);
+
+  // Start sending continuously with the data currently in the DMX buffer
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(staging, driver->dmx.data, driver->packet_size_max);
+  driver->continuous.staging = staging;
+  driver->continuous.is_dirty = false;
+  driver->continuous.size = size;
+  driver->continuous.is_auto_sized = is_auto_sized;
+  driver->continuous.period = period_us;
+  driver->continuous.is_paused = false;
+  driver->continuous.is_running = true;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  const bool ret = dmx_send_num(dmx_num, is_auto_sized ? 0 : size) > 0;
+  if (!ret) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->continuous.is_running = false;
+    driver->continuous.staging = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    heap_caps_free(staging);
+  }
+
+  // Give the mutex back
+  xSemaphoreGiveRecursive(driver->mux);
+  return ret;
+}
+
+bool dmx_continuous_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_continuous_is_running(dmx_num), false,
+            "continuous sending is not running");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Take the mutex and stop at the end of the current packet
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    return false;
+  }
+#if DMX_RX_BUFFER_COUNT > 1
+  if (driver->merge.is_running) {
+    dmx_merge_stop(dmx_num);  // Merged frames are sent by continuous sending
+  }
+#endif
+  dmx_continuous_pause(dmx_num);
+  if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+    dmx_continuous_resume(dmx_num);
+    xSemaphoreGiveRecursive(driver->mux);
+    return false;
+  }
+  dmx_fade_stop(dmx_num);  // Fades are stepped by continuous sending
+
+  // Copy the staged data into the DMX buffer and free the staging buffer
+  uint8_t *staging;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  staging = driver->continuous.staging;
+  memcpy(driver->dmx.data, staging, driver->packet_size_max);
+  DMX_RDM_HEADER_INVALIDATE(driver);
+  driver->continuous.is_dirty = false;
+  driver->continuous.staging = NULL;
+  driver->continuous.is_running = false;
+  driver->continuous.is_paused = false;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  heap_caps_free(staging);
+
+  // Give the mutex back
+  xSemaphoreGiveRecursive(driver->mux);
+  return true;
+}
+
+bool dmx_continuous_is_running(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  return dmx_driver[dmx_num]->continuous.is_running;
+}
+
+bool dmx_merge_start(dmx_port_t dmx_num, dmx_port_t input_a,
+                     dmx_port_t input_b, const dmx_merge_config_t *config) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(input_a < DMX_NUM_MAX, false, "input_a error");
+  DMX_CHECK(input_b < DMX_NUM_MAX, false, "input_b error");
+  DMX_CHECK(input_a != input_b && input_a != dmx_num && input_b != dmx_num,
+            false, "merge ports must be different");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_installed(input_a), false,
+            "input_a driver is not installed");
+  DMX_CHECK(dmx_driver_is_installed(input_b), false,
+            "input_b driver is not installed");
+  DMX_CHECK(dmx_continuous_is_running(dmx_num), false,
+            "continuous sending is not running");
+
+#if DMX_RX_BUFFER_COUNT > 1
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(!driver->merge.is_running, false, "merge is already running");
+
+  // Allocate the merge buffer and expand the priority mask to one byte per slot
+  dmx_merge_buffer_t *buffer =
+      heap_caps_malloc(sizeof(dmx_merge_buffer_t), MALLOC_CAP_8BIT);
+  if (buffer == NULL) {
+    DMX_ERR("merge buffer malloc error");
+    return false;
+  }
+  memset(buffer, 0, sizeof(*buffer));
+  if (config != NULL && config->ltp_mask != NULL) {
+    uint8_t *const ltp = (uint8_t *)buffer->ltp;
+    for (int slot = 1; slot < DMX_PACKET_SIZE_MAX; ++slot) {
+      if (config->ltp_mask[slot / 8] & (1 << (slot % 8))) {
+        ltp[slot] = 0xff;
+      }
+    }
+  }
+  uint32_t timeout = DMX_MERGE_TIMEOUT_US;
+  if (config != NULL && config->timeout_us > 0) {
+    timeout = config->timeout_us;
+  }
+
+  // Start merging at the start of the next DMX packet
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->merge.inputs[0] = input_a;
+  driver->merge.inputs[1] = input_b;
+  driver->merge.timeout = timeout;
+  for (int i = 0; i < 2; ++i) {
+    driver->merge.seen_timestamps[i] = 0;
+    driver->merge.frame_timestamps[i] = 0;
+  }
+  memset(&driver->merge.stats, 0, sizeof(driver->merge.stats));
+  driver->merge.stats.sources[0].is_lost = true;
+  driver->merge.stats.sources[1].is_lost = true;
+  driver->merge.buffer = buffer;
+  driver->merge.is_running = true;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("merging requires triple-buffering to be enabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool dmx_merge_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#if DMX_RX_BUFFER_COUNT > 1
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->merge.is_running, false, "merge is not running");
+
+  // The DMX ISR only uses the merge buffer from within a critical section
+  dmx_merge_buffer_t *buffer;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  buffer = driver->merge.buffer;
+  driver->merge.buffer = NULL;
+  driver->merge.is_running = false;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  heap_caps_free(buffer);
+
+  return true;
+#else
+  DMX_WARN("merging requires triple-buffering to be enabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool dmx_merge_get_stats(dmx_port_t dmx_num, dmx_merge_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#if DMX_RX_BUFFER_COUNT > 1
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(stats, &driver->merge.stats, sizeof(*stats));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("merging requires triple-buffering to be enabled in the Kconfig");
+  return false;
+#endif
+}
+
+// Takes a slot away from the fade which owns it. The fade is freed once it owns
+// no slots. Must be called from within a critical section.
+static void dmx_fade_release_slot(dmx_driver_t *const driver, int slot) {
+  dmx_fade_buffer_t *const buffer = driver->fade.buffer;
+  const uint8_t owner = buffer->owners[slot];
+  if (owner > 0) {
+    buffer->owners[slot] = 0;
+    if (--buffer->fades[owner - 1].count == 0) {
+      --driver->fade.active;
+    }
+  }
+}
+
+bool dmx_fade_start(dmx_port_t dmx_num, size_t offset, const void *targets,
+                    size_t size, uint32_t fade_us) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(offset > 0, false, "offset error");
+  DMX_CHECK(targets != NULL, false, "targets is null");
+  DMX_CHECK(size > 0, false, "size error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_continuous_is_running(dmx_num), false,
+            "continuous sending is not running");
+  DMX_CHECK(offset + size <= dmx_driver[dmx_num]->packet_size_max, false,
+            "size error");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Allocate the fade buffer the first time a fade is started
+  if (driver->fade.buffer == NULL) {
+    dmx_fade_buffer_t *buffer =
+        heap_caps_malloc(sizeof(dmx_fade_buffer_t), MALLOC_CAP_8BIT);
+    if (buffer == NULL) {
+      DMX_ERR("fade buffer malloc error");
+      return false;
+    }
+    memset(buffer, 0, sizeof(*buffer));
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->fade.buffer == NULL) {
+      driver->fade.buffer = buffer;
+      buffer = NULL;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    heap_caps_free(buffer);  // Another task allocated the fade buffer first
+  }
+
+  const uint8_t *const values = targets;
+  dmx_fade_buffer_t *const buffer = driver->fade.buffer;
+  const int64_t now = dmx_timer_get_micros_since_boot();
+  bool ret = true;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  uint8_t *const staging = driver->continuous.staging;
+  if (fade_us == 0) {
+    // Set the slots to their targets at the start of the next DMX packet
+    for (int slot = offset; slot < offset + size; ++slot) {
+      dmx_fade_release_slot(driver, slot);
+      staging[slot] = values[slot - offset];
+    }
+    driver->continuous.is_dirty = true;
+  } else {
+    // Take the slots from the fades which own them before finding a free fade
+    for (int slot = offset; slot < offset + size; ++slot) {
+      dmx_fade_release_slot(driver, slot);
+    }
+    int i = 0;
+    while (i < DMX_FADES_MAX && buffer->fades[i].count > 0) {
+      ++i;
+    }
+    if (i < DMX_FADES_MAX) {
+      // Fade from the values which are currently being sent
+      for (int slot = offset; slot < offset + size; ++slot) {
+        buffer->starts[slot] = staging[slot];
+        buffer->targets[slot] = values[slot - offset];
+        buffer->owners[slot] = i + 1;
+      }
+      struct dmx_fade_t *const fade = &buffer->fades[i];
+      fade->timestamp = now;
+      fade->duration = fade_us;
+      fade->first = offset;
+      fade->end = offset + size;
+      fade->count = size;
+      ++driver->fade.active;
+    } else {
+      ret = false;
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  if (!ret) {
+    DMX_ERR("no fade is available");
+  }
+  return ret;
+}
+
+bool dmx_fade_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Finish each fade by setting its slots to their targets
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  dmx_fade_buffer_t *const buffer = driver->fade.buffer;
+  uint8_t *const staging = driver->continuous.staging;
+  if (driver->fade.active > 0 && staging != NULL) {
+    for (int slot = 1; slot < driver->packet_size_max; ++slot) {
+      if (buffer->owners[slot] > 0) {
+        staging[slot] = buffer->targets[slot];
+        buffer->owners[slot] = 0;
+      }
+    }
+    for (int i = 0; i < DMX_FADES_MAX; ++i) {
+      buffer->fades[i].count = 0;
+    }
+    driver->fade.active = 0;
+    driver->continuous.is_dirty = true;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_continuous_pause(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  bool was_running;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  was_running = driver->continuous.is_running && !driver->continuous.is_paused;
+  if (was_running) {
+    driver->continuous.is_paused = true;
+    if (driver->dmx.status == DMX_STATUS_SENDING &&
+        driver->dmx.progress == DMX_PROGRESS_STALE) {
+      // Cancel the DMX packet which is waiting to be sent
+      dmx_timer_stop(dmx_num);
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.status = DMX_STATUS_IDLE;
+      DMX_STATE_WRITE_END(driver);
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return was_running;
+}
+
+void dmx_continuous_resume(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Copy data written while paused into the DMX buffer
+  int size;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->continuous.is_dirty) {
+    memcpy(driver->dmx.data, driver->continuous.staging,
+           driver->continuous.size);
+    driver->continuous.is_dirty = false;
+    DMX_RDM_HEADER_INVALIDATE(driver);
+  }
+  driver->continuous.is_paused = false;
+  size = driver->continuous.is_auto_sized ? 0 : driver->continuous.size;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  // Send the next DMX packet to restart the continuous sending
+  dmx_send_num(dmx_num, size);
+}
+
+size_t dmx_sync_send_num(const dmx_port_t *group, size_t group_size,
+                         size_t size, uint32_t *skew) {
+  DMX_CHECK(group != NULL, 0, "group is null");
+  DMX_CHECK(group_size > 0 && group_size <= DMX_NUM_MAX, 0,
+            "group_size error");
+
+  // Build the group bit mask and verify each DMX port
+  uint32_t group_mask = 0;
+  size_t size_max = DMX_PACKET_SIZE_MAX;
+  for (size_t i = 0; i < group_size; ++i) {
+    const dmx_port_t dmx_num = group[i];
+    DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+    DMX_CHECK(!(group_mask & (1 << dmx_num)), 0, "dmx_num is duplicated");
+    DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(dmx_num), 0, "driver is not enabled");
+    DMX_CHECK(!dmx_driver[dmx_num]->continuous.is_running, 0,
+              "continuous sending is running");
+    if (size_max > dmx_driver[dmx_num]->packet_size_max) {
+      size_max = dmx_driver[dmx_num]->packet_size_max;
+    }
+    group_mask |= (1 << dmx_num);
+  }
+
+  // Clamp size to the smallest maximum packet size of the DMX ports
+  if (size == 0 || size > size_max) {
+    size = size_max;
+  }
+
+  // Take the mutexes in port order and wait until each driver is done sending
+  uint32_t taken_mask = 0;
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(group_mask & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const driver = dmx_driver[i];
+    if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+      break;
+    } else if (!dmx_wait_sent(i, dmx_ms_to_ticks(23))) {
+      xSemaphoreGiveRecursive(driver->mux);
+      break;
+    }
+    taken_mask |= (1 << i);
+  }
+  if (taken_mask != group_mask) {
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      if (taken_mask & (1 << i)) {
+        xSemaphoreGiveRecursive(dmx_driver[i]->mux);
+      }
+    }
+    return 0;
+  }
+
+  // Prepare a DMX packet on each port and find the time to send the packets
+  dmx_port_t master_num = DMX_NUM_MAX;
+  int64_t timer_alarm = 1;
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(group_mask & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const driver = dmx_driver[i];
+    if (master_num == DMX_NUM_MAX) {
+      master_num = i;  // The first DMX port's timer starts every DMX break
+    }
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(i));
+    const int64_t timer_elapsed =
+        dmx_timer_get_micros_since_boot() - driver->dmx.controller_eop_timestamp;
+    if (RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN - timer_elapsed >
+        timer_alarm) {
+      timer_alarm = RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN - timer_elapsed;
+    }
+    if (dmx_uart_get_rts(i) == 1) {
+      dmx_uart_set_rts(i, 0);
+    }
+    DMX_STATE_WRITE_BEGIN(driver);
+    driver->dmx.size = size;
+    DMX_STATE_WRITE_END(driver);
+    driver->dmx.tx_break_bits = 0;  // Every DMX break is sent by the timer
+    driver->dmx.tx_mab_bits = 0;
+    driver->dmx.tx_break_was_sent = false;
+    driver->is_controller = true;
+    driver->dmx.last_controller_pid = 0;
+    driver->dmx.last_request_was_broadcast = false;
+    driver->dmx.responder_sent_last = false;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(i));
+  }
+
+  // Set an alarm on the master DMX port to start every DMX break
+  dmx_driver_t *const master = dmx_driver[master_num];
+  taskENTER_CRITICAL(DMX_SPINLOCK(master_num));
+  master->sync.group = group_mask;
+  master->task_waiting = xTaskGetCurrentTaskHandle();
+  dmx_timer_set_counter(master_num, 0);
+  dmx_timer_set_alarm(master_num, timer_alarm, false);
+  dmx_timer_start(master_num);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(master_num));
+
+  // Block until the DMX breaks have started
+  if (!xTaskNotifyWait(0, ULONG_MAX, NULL, dmx_ms_to_ticks(20))) {
+    __unreachable();  // The hardware timer should always notify the task
+  }
+  master->task_waiting = NULL;
+  if (skew != NULL) {
+    *skew = master->sync.skew;
+  }
+
+  // Give the mutexes back
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (group_mask & (1 << i)) {
+      xSemaphoreGiveRecursive(dmx_driver[i]->mux);
+    }
+  }
+
+  return size;
+}
+
+bool dmx_repeater_start(dmx_port_t dmx_num, const dmx_port_t *outputs,
+                        size_t output_count, bool forward_rdm) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(outputs != NULL, false, "outputs is null");
+  DMX_CHECK(output_count > 0 && output_count < DMX_NUM_MAX, false,
+            "output_count error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+  DMX_CHECK(dmx_driver_is_enabled(dmx_num), false, "driver is not enabled");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->rx_mode != DMX_RX_MODE_DMA, false,
+            "repeating requires DMX_RX_MODE_FIFO");
+  DMX_CHECK(driver->repeater.outputs == 0, false,
+            "repeater is already running");
+  DMX_CHECK(driver->repeater.source == DMX_NUM_MAX, false,
+            "driver is a repeater output");
+
+  // Build the output bit mask and verify each DMX port
+  uint32_t output_mask = 0;
+  for (size_t i = 0; i < output_count; ++i) {
+    const dmx_port_t output_num = outputs[i];
+    DMX_CHECK(output_num < DMX_NUM_MAX && output_num != dmx_num, false,
+              "output error");
+    DMX_CHECK(!(output_mask & (1 << output_num)), false,
+              "output is duplicated");
+    DMX_CHECK(dmx_driver_is_installed(output_num), false,
+              "output driver is not installed");
+    DMX_CHECK(dmx_driver_is_enabled(output_num), false,
+              "output driver is not enabled");
+    const dmx_driver_t *const output = dmx_driver[output_num];
+    DMX_CHECK(output->tx_mode != DMX_TX_MODE_DMA, false,
+              "repeating requires DMX_TX_MODE_FIFO");
+    DMX_CHECK(output->packet_size_max >= driver->packet_size_max, false,
+              "output packet_size_max is less than the input");
+    DMX_CHECK(!output->continuous.is_running, false,
+              "continuous sending is running");
+    DMX_CHECK(output->repeater.outputs == 0 &&
+                  output->repeater.source == DMX_NUM_MAX,
+              false, "output is already repeating");
+    output_mask |= (1 << output_num);
+  }
+
+  // Allocate the buffers for pending packets
+  uint8_t *next[DMX_NUM_MAX] = {0};
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(output_mask & (1 << i))) {
+      continue;
+    }
+    next[i] = heap_caps_malloc(dmx_driver[i]->packet_size_max,
+                               dmx_driver[i]->memory_caps);
+    if (next[i] == NULL) {
+      DMX_ERR("repeater buffer malloc error");
+      for (dmx_port_t j = 0; j < i; ++j) {
+        heap_caps_free(next[j]);
+      }
+      return false;
+    }
+  }
+
+  // Prepare each output to send the packets of the source
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(output_mask & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const output = dmx_driver[i];
+    bool is_ready = xSemaphoreTakeRecursive(output->mux, 0);
+    if (is_ready && !dmx_wait_sent(i, dmx_ms_to_ticks(23))) {
+      xSemaphoreGiveRecursive(output->mux);
+      is_ready = false;
+    }
+    if (!is_ready) {
+      if (driver->repeater.outputs != 0) {
+        dmx_repeater_stop(dmx_num);  // Release the outputs which were prepared
+      }
+      for (dmx_port_t j = i; j < DMX_NUM_MAX; ++j) {
+        heap_caps_free(next[j]);
+      }
+      return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(i));
+    if (dmx_uart_get_rts(i) == 1) {
+      dmx_uart_set_rts(i, 0);
+    }
+    output->dmx.tx_break_bits = 0;  // Every DMX break is sent by the timer
+    output->dmx.tx_mab_bits = 0;
+    output->dmx.tx_break_was_sent = false;
+    output->is_controller = true;
+    output->dmx.last_controller_pid = 0;
+    output->dmx.last_request_was_broadcast = false;
+    output->dmx.responder_sent_last = false;
+    output->repeater.available = 0;
+    output->repeater.is_pending = false;
+    output->repeater.next = next[i];
+    output->repeater.source = dmx_num;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(i));
+    xSemaphoreGiveRecursive(output->mux);
+
+    // Let a failed start release this output
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->repeater.outputs |= (1 << i);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+
+  // Start repeating at the next DMX break
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->repeater.forwards_rdm = forward_rdm;
+  driver->repeater.active = 0;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_repeater_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  uint32_t outputs;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  outputs = driver->repeater.outputs;
+  driver->repeater.outputs = 0;
+  driver->repeater.active = 0;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(outputs != 0, false, "repeater is not running");
+
+  // Release each output once it has sent the slots it already received
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(outputs & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const output = dmx_driver[i];
+    uint8_t *next;
+    taskENTER_CRITICAL(DMX_SPINLOCK(i));
+    if (output->dmx.status == DMX_STATUS_SENDING &&
+        !output->repeater.is_pending) {
+      DMX_STATE_WRITE_BEGIN(output);
+      output->dmx.size = output->repeater.available;
+      DMX_STATE_WRITE_END(output);
+    }
+    output->repeater.is_pending = false;
+    dmx_repeater_write(output);
+    next = output->repeater.next;
+    output->repeater.next = NULL;
+    output->repeater.source = DMX_NUM_MAX;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(i));
+    heap_caps_free(next);
+    dmx_wait_sent(i, dmx_ms_to_ticks(23));
+  }
+
+  return true;
+}
+
+const uint8_t *dmx_read_acquire(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, NULL, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), NULL, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  const uint8_t *frame;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->lease.read_is_leased) {
+    frame = NULL;
+  } else {
+#if DMX_RX_BUFFER_COUNT > 1
+    // Take the last complete frame so that the ISR cannot write to it
+    if (driver->dmx.ready_is_fresh) {
+      uint8_t *const front = driver->dmx.front;
+      driver->dmx.front = driver->dmx.ready;
+      driver->dmx.ready = front;
+      driver->dmx.ready_is_fresh = false;
+    }
+    frame = driver->dmx.front;
+#else
+    frame = driver->dmx.data;
+#endif
+    driver->lease.read_is_leased = true;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(frame != NULL, NULL, "read buffer is already acquired");
+
+  return frame;
+}
+
+bool dmx_read_release(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  bool was_leased;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  was_leased = driver->lease.read_is_leased;
+  driver->lease.read_is_leased = false;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(was_leased, false, "read buffer is not acquired");
+
+  return true;
+}
+
+uint8_t *dmx_write_acquire(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, NULL, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), NULL, "driver is not installed");
+  DMX_CHECK(dmx_driver[dmx_num]->rx_mode != DMX_RX_MODE_DMA, NULL,
+            "write buffers cannot be acquired in DMA receive mode");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Allocate the write buffer the first time it is needed
+  if (driver->lease.memory == NULL) {
+    // The write buffer is swapped with the DMX buffer so it must be the same
+    void *memory = heap_caps_malloc(DMX_BUFFER_SIZE(driver->packet_size_max),
+                                    driver->memory_caps);
+    if (memory == NULL) {
+      DMX_ERR("write buffer malloc error");
+      return NULL;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->lease.memory == NULL) {
+      driver->lease.memory = memory;
+      driver->lease.back = memory;
+      memory = NULL;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (memory != NULL) {
+      heap_caps_free(memory);  // Another task allocated the buffer first
+    }
+  }
+
+  // Lend the buffer which will be sent in the next DMX packet
+  uint8_t *buffer;
+  const uint8_t *frame;
+  bool needs_copy = false;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  frame = driver->rdm.request_is_active ? driver->rdm.data : driver->dmx.data;
+  if (driver->lease.write_is_leased) {
+    buffer = NULL;
+  } else if (driver->continuous.staging != NULL) {
+    buffer = driver->continuous.staging;
+  } else {
+    buffer = driver->lease.back;
+    needs_copy = !driver->lease.write_is_pending;
+  }
+  driver->lease.write_is_leased = (buffer != NULL);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(buffer != NULL, NULL, "write buffer is already acquired");
+
+  // Start from the current DMX packet without holding a critical section
+  if (needs_copy) {
+    memcpy(buffer, frame, driver->packet_size_max);
+  }
+
+  return buffer;
+}
+
+bool dmx_write_release(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  bool was_leased;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  was_leased = driver->lease.write_is_leased;
+  if (was_leased) {
+    if (driver->continuous.staging != NULL) {
+      driver->continuous.is_dirty = true;
+    } else {
+      driver->lease.write_is_pending = true;
+    }
+    driver->lease.write_is_leased = false;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_CHECK(was_leased, false, "write buffer is not acquired");
+
+  // Flip the DMX bus to write mode unless an RDM request is using the bus
+  if (!driver->rdm.request_is_active && dmx_uart_get_rts(dmx_num) == 1) {
+    dmx_uart_set_rts(dmx_num, 0);
+  }
+
+  return true;
+}
+
+void dmx_lease_publish(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Swap the released write buffer with the DMX buffer. The swap is deferred
+  // while an RDM request is in progress so that the request is not replaced.
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->lease.write_is_pending && !driver->rdm.request_is_active) {
+    uint8_t *const data = driver->dmx.data;
+    driver->dmx.data = driver->lease.back;
+    driver->lease.back = data;
+    DMX_RDM_HEADER_INVALIDATE(driver);
+    driver->lease.write_is_pending = false;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
@@ -0,0 +1,1614 @@
+#include "include/isr.h"
+
+#include <string.h>
+
+#include "dmx/hal/include/capture.h"
+#include "dmx/hal/include/gpio.h"
+#include "dmx/hal/include/timer.h"
+#include "dmx/hal/include/uart.h"
+#include "endian.h"
+#include "rdm/include/driver.h"
+#include "rdm/include/uid.h"
+
+enum {
+  RDM_TYPE_IS_NOT_RDM = 0,  // The packet is not RDM.
+  RDM_TYPE_IS_DISCOVERY,    // The packet is an RDM discovery request.
+  RDM_TYPE_IS_RESPONSE,     // The packet is an RDM response.
+  RDM_TYPE_IS_BROADCAST,    // The packet is a non-discovery RDM broadcast.
+  RDM_TYPE_IS_REQUEST,      // The packet is a standard RDM request.
+  RDM_TYPE_IS_UNKNOWN,  // The packet is RDM, but it is unclear what type it is.
+};
+
+// Gets the action which the start code filter takes for a packet which was
+// just completed and counts the packet if it is not delivered. Must be called
+// from within a critical section.
+static int DMX_ISR_ATTR dmx_uart_rx_filter(dmx_driver_t *const driver,
+                                           int sc) {
+  if (sc < 0 || driver->repeater.outputs != 0) {
+    return DMX_SC_ACTION_DELIVER;  // No packet or the filter is bypassed
+  }
+  int action = DMX_SC_FILTER_GET(driver, sc);
+  if (action == DMX_SC_ACTION_ROUTE && driver->sc_filter.handler == NULL) {
+    action = DMX_SC_ACTION_DROP;
+  }
+  if (action != DMX_SC_ACTION_DELIVER) {
+    ++driver->stats.rx_filtered;
+  }
+  return action;
+}
+
+// Copies a received packet into the next free frame of the receive queue,
+// dropping it if the queue is full. Must be called from within a critical
+// section.
+static void DMX_ISR_ATTR dmx_uart_rx_enqueue(dmx_driver_t *const driver,
+                                             dmx_err_t err) {
+  struct dmx_driver_rx_queue_t *const queue = &driver->rx_queue;
+  if (queue->frames == NULL) {
+    return;
+  }
+  const uint32_t head = queue->head;
+  if (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) >= queue->size) {
+    ++queue->dropped;
+    return;
+  }
+  dmx_frame_t *const frame = &queue->frames[head & (queue->size - 1)];
+  size_t size = driver->dmx.size;
+  if (size > driver->packet_size_max) {
+    size = driver->packet_size_max;
+  }
+  memcpy((uint8_t *)frame->data, driver->dmx.data, size);
+  frame->err = err;
+  frame->sc = driver->dmx.data[0];
+  frame->size = size;
+  frame->break_timestamp = driver->dmx.last_break_timestamp;
+  frame->eop_timestamp = driver->dmx.last_eop_timestamp;
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Records a received packet as complete and, if it is a DMX frame, swaps it
+// out of the ISR buffer so that it may be read without being overwritten. Must
+// be called from within a critical section.
+static void DMX_ISR_ATTR dmx_uart_rx_publish(dmx_driver_t *const driver,
+                                             bool is_dmx, dmx_err_t err) {
+  dmx_uart_rx_enqueue(driver, err);
+#if DMX_RX_BUFFER_COUNT > 1
+  driver->dmx.sc = driver->dmx.data[0];
+  if (is_dmx) {
+    uint8_t *const frame = driver->dmx.data;
+    driver->dmx.data = driver->dmx.ready;
+    DMX_RDM_HEADER_INVALIDATE(driver);
+    driver->dmx.ready = frame;
+    driver->dmx.ready_is_fresh = true;
+    driver->dmx.latest_size = driver->dmx.size;
+    driver->dmx.latest_timestamp = driver->dmx.last_eop_timestamp;
+  }
+#endif
+}
+
+// Adds newly received slots to the running RDM checksum so that the checksum
+// of a standard RDM packet is ready as soon as its last slot arrives. Slots are
+// only summed when they continue the packet and are within its message length.
+static void DMX_ISR_ATTR dmx_uart_rx_checksum(dmx_driver_t *const driver,
+                                              int dmx_head, int read_len) {
+  const uint8_t *data = driver->dmx.data;
+  driver->dmx.rdm_header_is_cached = false;
+  if (dmx_head == 0) {
+    driver->dmx.rx_checksum = 0;
+    driver->dmx.rx_checksum_len = 0;
+  } else if (driver->dmx.rx_checksum_len != dmx_head) {
+    return;  // The checksum is complete or the slots are not contiguous
+  }
+  if (data[0] != RDM_SC) {
+    return;  // Only standard RDM packets have a running checksum
+  }
+
+  // Sum the slots up to the end of the message
+  int end = dmx_head + read_len;
+  if (end > 2 && end > data[2]) {
+    end = data[2];
+  }
+  uint16_t checksum = driver->dmx.rx_checksum;
+  for (int i = dmx_head; i < end; ++i) {
+    checksum += data[i];
+  }
+  if (end > dmx_head) {
+    driver->dmx.rx_checksum = checksum;
+    driver->dmx.rx_checksum_len = end;
+  }
+}
+
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+// Updates the rolling timing statistics with a received DMX packet. Must be
+// called from within a critical section.
+static void DMX_ISR_ATTR dmx_uart_rx_measure(dmx_driver_t *const driver,
+                                             int64_t break_timestamp,
+                                             size_t size) {
+  dmx_rx_timing_t *const stats = &driver->timing.stats;
+  if (stats->packet_count == 0 || size < stats->size_min) {
+    stats->size_min = size;
+  }
+  if (size > stats->size_max) {
+    stats->size_max = size;
+  }
+  ++stats->packet_count;
+
+  // The period is measured from the DMX break of the previous DMX packet
+  const int64_t last_break_timestamp = driver->timing.last_break_timestamp;
+  driver->timing.last_break_timestamp = break_timestamp;
+  if (last_break_timestamp == 0 || break_timestamp <= last_break_timestamp) {
+    return;
+  }
+  const int64_t elapsed = break_timestamp - last_break_timestamp;
+  const uint32_t period = elapsed > UINT32_MAX ? UINT32_MAX : elapsed;
+  if (stats->period_avg == 0) {
+    stats->period_min = period;
+    stats->period_avg = period;
+    stats->period_max = period;
+  } else {
+    if (period < stats->period_min) {
+      stats->period_min = period;
+    }
+    if (period > stats->period_max) {
+      stats->period_max = period;
+    }
+
+    // Exponential moving averages with a weight of 1/16 per packet
+    const uint32_t deviation = period > stats->period_avg
+                                   ? period - stats->period_avg
+                                   : stats->period_avg - period;
+    stats->jitter = stats->jitter - (stats->jitter >> 4) + (deviation >> 4);
+    stats->period_avg =
+        stats->period_avg - (stats->period_avg >> 4) + (period >> 4);
+  }
+
+  int bucket = 0;
+  for (uint32_t p = period / DMX_RX_TIMING_HISTOGRAM_BASE_US;
+       p > 0 && bucket < DMX_RX_TIMING_HISTOGRAM_SIZE - 1; p >>= 1) {
+    ++bucket;
+  }
+  ++stats->histogram[bucket];
+}
+#endif
+
+// Updates the driver statistics with a packet which was just completed. Must be
+// called from within a critical section.
+static void DMX_ISR_ATTR dmx_uart_rx_count(dmx_driver_t *const driver,
+                                           int rdm_type, dmx_err_t err) {
+  dmx_stats_t *const stats = &driver->stats;
+  ++stats->rx_packets;
+  if (err == DMX_ERR_UART_OVERFLOW) {
+    ++stats->rx_uart_overflows;
+  } else if (err == DMX_ERR_IMPROPER_SLOT) {
+    ++stats->rx_improper_slots;
+  } else if (err == DMX_ERR_NOT_ENOUGH_SLOTS) {
+    ++stats->rx_not_enough_slots;
+  }
+  if (rdm_type == RDM_TYPE_IS_REQUEST) {
+    ++stats->rdm_requests;
+  } else if (rdm_type == RDM_TYPE_IS_BROADCAST) {
+    ++stats->rdm_broadcasts;
+  } else if (rdm_type == RDM_TYPE_IS_RESPONSE) {
+    ++stats->rdm_responses;
+  } else if (rdm_type == RDM_TYPE_IS_DISCOVERY) {
+    ++stats->rdm_discovery_responses;
+  }
+}
+
+// Invokes the user's receive callback and notifies each subscriber and any task
+// waiting in dmx_receive_any() of a packet which was just completed, or passes
+// the packet to the start code handler if its start code is routed. Must be
+// called outside of a critical section.
+static void DMX_ISR_ATTR dmx_uart_rx_callback(dmx_driver_t *const driver,
+                                              dmx_rx_callback_t callback,
+                                              size_t size, int sc,
+                                              dmx_err_t err, int action,
+                                              int *task_awoken) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  if (action == DMX_SC_ACTION_ROUTE) {
+    const dmx_sc_handler_t handler = driver->sc_filter.handler;
+    if (handler != NULL && handler(dmx_num, driver->dmx.data, size, err,
+                                   driver->sc_filter.context)) {
+      *task_awoken = true;
+    }
+    return;
+  } else if (action == DMX_SC_ACTION_DROP) {
+    return;
+  }
+  if (callback != NULL &&
+      callback(dmx_num, size, sc, err, driver->rx_callback_context)) {
+    *task_awoken = true;
+  }
+
+  // Send the packet summary to each subscriber, dropping it if a queue is full
+  const size_t block_count =
+      (size + DMX_CHANGED_BLOCK_SIZE - 1) / DMX_CHANGED_BLOCK_SIZE;
+  taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  const dmx_packet_t packet = {
+      .err = err,
+      .sc = sc,
+      .size = size,
+      .is_rdm = dmx_start_code_is_rdm(sc),
+      .is_changed = true,
+      .changed_blocks = (1 << block_count) - 1,
+      .break_timestamp = driver->dmx.last_break_timestamp,
+      .eop_timestamp = driver->dmx.last_eop_timestamp};
+#ifdef CONFIG_DMX_RX_TIMING_STATS
+  if (sc == DMX_SC) {
+    dmx_uart_rx_measure(driver, packet.break_timestamp, size);
+  }
+#endif
+  for (int i = 0; i < DMX_SUBSCRIBERS_MAX; ++i) {
+    if (driver->subscribers[i] != NULL) {
+      BaseType_t woken = pdFALSE;
+      xQueueSendFromISR(driver->subscribers[i], &packet, &woken);
+      if (woken) {
+        *task_awoken = true;
+      }
+    }
+  }
+  driver->dmx.last_err = err;
+  if (driver->any_waiting != NULL) {
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(driver->any_waiting, 1 << dmx_num, eSetBits, &woken);
+    if (woken) {
+      *task_awoken = true;
+    }
+  }
+  if (driver->rx_queue.task_waiting != NULL) {
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(driver->rx_queue.task_waiting, 0, eNoAction, &woken);
+    if (woken) {
+      *task_awoken = true;
+    }
+  }
+  taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+}
+
+// Sets the RX FIFO threshold for the packet being received. RDM needs tighter
+// response latency than DMX so interrupts are only coalesced for DMX packets.
+static void DMX_ISR_ATTR dmx_uart_rx_adapt(dmx_driver_t *const driver,
+                                           bool is_rdm) {
+  const int threshold = is_rdm ? 1 : driver->rx_intr_threshold;
+  if (driver->dmx.rx_threshold != threshold) {
+    dmx_uart_set_rx_threshold(driver->dmx_num, threshold);
+    driver->dmx.rx_threshold = threshold;
+  }
+}
+
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+// Answers an RDM discovery request with a response which was encoded by the
+// RDM responder task. Returns true if the request was handled and should not
+// be passed to the task. Returns false if the task must handle the request
+// because the encoded responses are missing or stale. Must be called from
+// within a critical section.
+static bool DMX_ISR_ATTR dmx_uart_rx_answer(dmx_driver_t *const driver,
+                                            int rdm_type, int64_t now) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  struct dmx_driver_disc_isr_t *const disc = &driver->disc_isr;
+  uint8_t *const data = driver->dmx.data;
+  if ((rdm_type != RDM_TYPE_IS_REQUEST && rdm_type != RDM_TYPE_IS_BROADCAST) ||
+      data[20] != RDM_CC_DISC_COMMAND || disc->is_muted == NULL ||
+      disc->generation != driver->device.generation ||
+      driver->continuous.is_running || driver->tx_async.is_queued ||
+      driver->lease.write_is_pending ||
+      driver->rdm.request_is_active || driver->responders.count > 0) {
+    return false;  // Virtual responders are discovered by the task
+  }
+
+  // Discovery requests which are not for the root device are ignored
+  const rdm_uid_t *uid_ptr = (rdm_uid_t *)&data[3];
+  const rdm_uid_t dest_uid = {.man_id = bswap16(uid_ptr->man_id),
+                              .dev_id = bswap32(uid_ptr->dev_id)};
+  const rdm_sub_device_t sub_device = (data[18] << 8) | data[19];
+  const rdm_pid_t pid = (data[21] << 8) | data[22];
+  if (!rdm_uid_is_target(&driver->uid, &dest_uid) ||
+      sub_device != RDM_SUB_DEVICE_ROOT) {
+    return true;
+  }
+
+  // Copy the encoded response into the DMX buffer
+  int size;
+  if (pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    if (data[23] != sizeof(rdm_disc_unique_branch_t)) {
+      return true;  // Don't respond to malformed requests
+    }
+    const rdm_uid_t *bounds = (rdm_uid_t *)&data[24];
+    const rdm_uid_t lower_bound = {.man_id = bswap16(bounds[0].man_id),
+                                   .dev_id = bswap32(bounds[0].dev_id)};
+    const rdm_uid_t upper_bound = {.man_id = bswap16(bounds[1].man_id),
+                                   .dev_id = bswap32(bounds[1].dev_id)};
+    if (*disc->is_muted || rdm_uid_is_lt(&driver->uid, &lower_bound) ||
+        rdm_uid_is_gt(&driver->uid, &upper_bound)) {
+      return true;  // Request not for this device
+    } else if (disc->unique_branch[0] != RDM_PREAMBLE) {
+      return false;
+    }
+    size = sizeof(disc->unique_branch);
+    memcpy(data, disc->unique_branch, size);
+  } else if (pid == RDM_PID_DISC_MUTE || pid == RDM_PID_DISC_UN_MUTE) {
+    if (disc->mute[0] != RDM_SC) {
+      return false;
+    }
+    *disc->is_muted = (pid == RDM_PID_DISC_MUTE);
+    if (rdm_type == RDM_TYPE_IS_BROADCAST) {
+      return true;  // Do not send a response to broadcast packets
+    }
+
+    // Patch the destination UID, transaction number, and PID of the response
+    uint8_t src_uid[6];
+    memcpy(src_uid, &data[9], sizeof(src_uid));
+    const uint8_t tn = data[15];
+    size = disc->mute[2] + 2;
+    memcpy(data, disc->mute, size);
+    memcpy(&data[3], src_uid, sizeof(src_uid));
+    data[15] = tn;
+    data[21] = pid >> 8;
+    data[22] = pid;
+    uint16_t checksum = 0;
+    for (int i = 0; i < size - 2; ++i) {
+      checksum += data[i];
+    }
+    data[size - 2] = checksum >> 8;
+    data[size - 1] = checksum;
+  } else {
+    return false;
+  }
+  DMX_RDM_HEADER_INVALIDATE(driver);  // The packet in the buffer is replaced
+
+  // Wait the minimum RDM responder turnaround time before sending
+  driver->is_controller = false;
+  driver->dmx.last_responder_pid = pid;
+  driver->dmx.responder_sent_last = true;
+  driver->dmx.tx_break_bits = 0;
+  driver->dmx.tx_mab_bits = 0;
+  driver->dmx.tx_break_was_sent = false;
+  disc->is_sending = true;
+  disc->task_was_waiting = (driver->task_waiting != NULL);
+  disc->rx_size = driver->dmx.size;
+  DMX_STATE_WRITE_BEGIN(driver);
+  driver->dmx.size = size;
+  driver->dmx.head = 0;
+  driver->dmx.progress = DMX_PROGRESS_STALE;
+  driver->dmx.status = DMX_STATUS_SENDING;
+  DMX_STATE_WRITE_END(driver);
+  dmx_timer_set_counter(dmx_num, dmx_timer_get_micros_since_boot() - now);
+  dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_MIN, false);
+  dmx_timer_start(dmx_num);
+
+  return true;
+}
+#endif
+
+#ifdef CONFIG_RDM_RESPONDER_UID_FILTER
+// Returns true if the destination UID of the RDM packet which is being
+// received is the UID of the DMX port, the UID of one of its virtual
+// responders, or a broadcast UID which may include them.
+static bool DMX_ISR_ATTR dmx_uart_rx_is_target(const dmx_driver_t *driver) {
+  const rdm_uid_t *uid_ptr = (rdm_uid_t *)&driver->dmx.data[3];
+  const rdm_uid_t dest_uid = {.man_id = bswap16(uid_ptr->man_id),
+                              .dev_id = bswap32(uid_ptr->dev_id)};
+  if (rdm_uid_is_target(&driver->uid, &dest_uid)) {
+    return true;
+  } else if (rdm_uid_is_broadcast(&dest_uid)) {
+    return driver->responders.count > 0;  // Checked by the task
+  }
+  return dmx_responder_find(driver, &dest_uid) > 0;
+}
+#endif
+
+// Processes the slots received so far and notifies the waiting task when the
+// packet is complete.
+static void DMX_ISR_ATTR dmx_uart_rx_process(dmx_driver_t *const driver,
+                                             uint32_t intr_flags, int dmx_head,
+                                             int64_t now, int *task_awoken) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+
+  // Guard against notifying multiple times for the same packet
+  if (driver->dmx.progress != DMX_PROGRESS_IN_DATA) {
+    return;
+  }
+
+  // Process the data depending on the type of packet that was received
+  dmx_err_t err;
+  int rdm_type;
+  bool packet_is_complete;
+  if (intr_flags & DMX_INTR_RX_ERR) {
+    rdm_type = RDM_TYPE_IS_NOT_RDM;
+    packet_is_complete = true;
+    err = intr_flags & DMX_INTR_RX_FIFO_OVERFLOW
+              ? DMX_ERR_UART_OVERFLOW   // UART overflow
+              : DMX_ERR_IMPROPER_SLOT;  // Missing stop bits
+    DMX_TRACE(driver, DMX_TRACE_RX_ERROR, err, now);
+  } else {
+    // Determine the type of the packet that was received
+    const uint8_t sc = driver->dmx.data[0];  // DMX start-code.
+    if (sc == RDM_SC) {
+      rdm_type = RDM_TYPE_IS_UNKNOWN;  // Determine actual type later
+    } else if (sc == RDM_PREAMBLE || sc == RDM_DELIMITER) {
+      rdm_type = RDM_TYPE_IS_DISCOVERY;
+    } else {
+      rdm_type = RDM_TYPE_IS_NOT_RDM;
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      // Get the best resolution on the controller EOP timestamp
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.controller_eop_timestamp = now;
+      DMX_STATE_WRITE_END(driver);
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    }
+
+    // Set inter-slot timer for RDM response packets
+    if (driver->is_controller && rdm_type != RDM_TYPE_IS_NOT_RDM) {
+      dmx_timer_set_counter(dmx_num, 0);
+      dmx_timer_set_alarm(dmx_num, RDM_TIMING_RESPONDER_INTER_SLOT_MAX, false);
+    }
+
+    err = DMX_OK;
+  }
+  while (err == DMX_OK) {
+    if (rdm_type == RDM_TYPE_IS_DISCOVERY) {
+      // Parse an RDM discovery response packet
+      if (dmx_head < 17) {
+        packet_is_complete = false;
+        break;  // Haven't received the minimum packet size
+      }
+
+      // Get the delimiter index
+      int delimiter_idx = 0;
+      for (; delimiter_idx <= 7; ++delimiter_idx) {
+        const uint8_t slot_value = driver->dmx.data[delimiter_idx];
+        if (slot_value != RDM_PREAMBLE) {
+          if (slot_value != RDM_DELIMITER) {
+            delimiter_idx = 9;  // Force invalid packet type
+          }
+          break;
+        }
+      }
+      if (delimiter_idx > 8) {
+        rdm_type = RDM_TYPE_IS_NOT_RDM;
+        continue;  // Packet is malformed - treat it as DMX
+      }
+
+      // Process RDM discovery response packet
+      if (dmx_head < delimiter_idx + 17) {
+        packet_is_complete = false;
+        break;  // Haven't received full RDM_PID_DISC_UNIQUE_BRANCH response
+      } else if (!rdm_read_header(dmx_num, NULL)) {
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        ++driver->stats.rdm_checksum_errors;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        rdm_type = RDM_TYPE_IS_NOT_RDM;
+        continue;  // Packet is malformed - treat it as DMX
+      } else {
+        driver->dmx.last_responder_pid = RDM_PID_DISC_UNIQUE_BRANCH;
+        driver->dmx.responder_sent_last = true;
+        packet_is_complete = true;
+        break;
+      }
+    } else if (rdm_type != RDM_TYPE_IS_NOT_RDM) {
+      // Parse a standard RDM packet
+      uint8_t msg_len;
+#ifdef CONFIG_RDM_RESPONDER_UID_FILTER
+      if (dmx_head >= 9 && !driver->is_controller &&
+          driver->repeater.outputs == 0 && !dmx_uart_rx_is_target(driver)) {
+        // Drop packets which are addressed to other devices
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+        driver->dmx.progress = DMX_PROGRESS_STALE;
+        DMX_STATE_WRITE_END(driver);
+        ++driver->stats.rdm_filtered;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        return;
+      }
+#endif
+      if (dmx_head < sizeof(rdm_header_t) + 2) {
+        packet_is_complete = false;
+        break;  // Haven't received full RDM header and checksum yet
+      } else if (driver->dmx.data[1] != RDM_SUB_SC ||
+                 !rdm_cc_is_valid(driver->dmx.data[20]) ||
+                 (msg_len = driver->dmx.data[2]) < sizeof(rdm_header_t)) {
+        rdm_type = RDM_TYPE_IS_NOT_RDM;
+        continue;  // Packet is malformed - treat it as DMX
+      } else if (dmx_head < msg_len + 2) {
+        packet_is_complete = false;
+        break;  // Haven't received full RDM packet and checksum yet
+      } else if (!rdm_read_header(dmx_num, NULL)) {
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        ++driver->stats.rdm_checksum_errors;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        rdm_type = RDM_TYPE_IS_NOT_RDM;
+        continue;  // Packet is malformed - treat it as DMX
+      } else {
+        bool responder_sent_last;
+        const rdm_cc_t cc = driver->dmx.data[20];
+        const rdm_pid_t *pid = (rdm_pid_t *)&driver->dmx.data[21];
+        const rdm_uid_t *uid_ptr = (rdm_uid_t *)&driver->dmx.data[3];
+        const rdm_uid_t dest_uid = {.man_id = bswap16(uid_ptr->man_id),
+                                    .dev_id = bswap32(uid_ptr->dev_id)};
+        if (!rdm_cc_is_request(cc)) {
+          rdm_type = RDM_TYPE_IS_RESPONSE;
+          responder_sent_last = true;
+        } else if (rdm_uid_is_broadcast(&dest_uid)) {
+          rdm_type = RDM_TYPE_IS_BROADCAST;
+          responder_sent_last = false;
+        } else {
+          rdm_type = RDM_TYPE_IS_REQUEST;
+          responder_sent_last = false;
+        }
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        if (!responder_sent_last) {
+          DMX_STATE_WRITE_BEGIN(driver);
+          driver->dmx.controller_eop_timestamp = now;
+          DMX_STATE_WRITE_END(driver);
+          driver->dmx.last_controller_pid = bswap16(*pid);
+        } else {
+          driver->dmx.last_responder_pid = bswap16(*pid);
+        }
+        driver->dmx.responder_sent_last = responder_sent_last;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        packet_is_complete = true;
+        break;
+      }
+    } else {
+      // Parse a standard DMX packet
+      // TODO: verify that a data collision hasn't happened
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      driver->dmx.last_controller_pid = 0;
+      driver->dmx.responder_sent_last = false;
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      packet_is_complete = (dmx_head >= driver->dmx.size);
+      break;
+    }
+  }
+  if (!packet_is_complete) {
+    return;
+  }
+  dmx_timer_stop(dmx_num);
+  DMX_TRACE(driver, DMX_TRACE_RX_DONE, driver->dmx.size, now);
+
+  // Set driver flags and notify task
+  taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  const size_t size = driver->dmx.size;
+  const int sc = driver->dmx.data[0];
+  const int action = dmx_uart_rx_filter(driver, sc);
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+  if (dmx_uart_rx_answer(driver, rdm_type, now)) {
+    // Discovery requests which are answered here are not passed to the task
+    if (driver->dmx.status != DMX_STATUS_SENDING) {
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+      driver->dmx.progress = DMX_PROGRESS_STALE;
+      driver->dmx.status = DMX_STATUS_IDLE;
+      DMX_STATE_WRITE_END(driver);
+    }
+    dmx_uart_rx_count(driver, rdm_type, err);
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    return;
+  }
+#endif
+  DMX_STATE_WRITE_BEGIN(driver);
+  driver->dmx.progress = action == DMX_SC_ACTION_DELIVER
+                             ? DMX_PROGRESS_COMPLETE
+                             : DMX_PROGRESS_STALE;
+  driver->dmx.status = DMX_STATUS_IDLE;  // Could still be receiving data
+  DMX_STATE_WRITE_END(driver);
+  driver->dmx.last_rx_intr_count = driver->dmx.rx_intr_count;
+  driver->dmx.last_break_timestamp = driver->dmx.rx_break_timestamp;
+  driver->dmx.last_eop_timestamp = now;
+  const dmx_rx_callback_t callback = driver->rx_callback;
+  dmx_uart_rx_count(driver, rdm_type, err);
+  if (action == DMX_SC_ACTION_DELIVER) {
+    dmx_uart_rx_publish(driver,
+                        rdm_type == RDM_TYPE_IS_NOT_RDM && err == DMX_OK, err);
+    if (driver->task_waiting) {
+      xTaskNotifyFromISR(driver->task_waiting, err, eSetValueWithOverwrite,
+                         task_awoken);
+    }
+  }
+  taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  dmx_uart_rx_callback(driver, callback, size, sc, err, action, task_awoken);
+}
+
+bool DMX_ISR_ATTR dmx_uart_dma_rx_frame(dmx_driver_t *const driver,
+                                        int dmx_head, int64_t now) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  int task_awoken = false;
+
+  // Publish the head index of the received frame
+  uint32_t intr_flags;
+  taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  intr_flags = driver->dmx.rx_err_flags;
+  driver->dmx.rx_err_flags = 0;
+  DMX_RDM_HEADER_INVALIDATE(driver);
+  ++driver->dmx.rx_intr_count;
+  DMX_STATE_WRITE_BEGIN(driver);
+  driver->dmx.head = dmx_head;
+  driver->dmx.progress = DMX_PROGRESS_IN_DATA;
+  DMX_STATE_WRITE_END(driver);
+  taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  DMX_TRACE(driver, DMX_TRACE_RX_DATA, dmx_head, now);
+  dmx_uart_rx_process(driver, intr_flags, dmx_head, now, &task_awoken);
+
+  // No more slots will arrive for this frame so report if it was too short
+  if (driver->dmx.progress == DMX_PROGRESS_IN_DATA) {
+    DMX_TRACE(driver, DMX_TRACE_RX_DONE, dmx_head, now);
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    const int sc = driver->dmx.data[0];
+    const int action = dmx_uart_rx_filter(driver, sc);
+    DMX_STATE_WRITE_BEGIN(driver);
+    driver->dmx.size = dmx_head;
+    driver->dmx.progress = action == DMX_SC_ACTION_DELIVER
+                               ? DMX_PROGRESS_COMPLETE
+                               : DMX_PROGRESS_STALE;
+    driver->dmx.status = DMX_STATUS_IDLE;
+    DMX_STATE_WRITE_END(driver);
+    driver->dmx.last_rx_intr_count = driver->dmx.rx_intr_count;
+    driver->dmx.last_break_timestamp = driver->dmx.rx_break_timestamp;
+    driver->dmx.last_eop_timestamp = now;
+    const dmx_rx_callback_t callback = driver->rx_callback;
+    dmx_uart_rx_count(driver, RDM_TYPE_IS_NOT_RDM, DMX_ERR_NOT_ENOUGH_SLOTS);
+    if (action == DMX_SC_ACTION_DELIVER) {
+      dmx_uart_rx_publish(driver, !dmx_start_code_is_rdm(sc),
+                          DMX_ERR_NOT_ENOUGH_SLOTS);
+      if (driver->task_waiting) {
+        xTaskNotifyFromISR(driver->task_waiting, DMX_ERR_NOT_ENOUGH_SLOTS,
+                           eSetValueWithOverwrite, &task_awoken);
+      }
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    dmx_uart_rx_callback(driver, callback, dmx_head, sc,
+                         DMX_ERR_NOT_ENOUGH_SLOTS, action, &task_awoken);
+  }
+
+  return task_awoken;
+}
+
+void DMX_ISR_ATTR dmx_schedule_count_frame(dmx_driver_t *const driver,
+                                           int64_t now, int *task_awoken) {
+  struct dmx_driver_schedule_t *const schedule = &driver->schedule;
+  const int64_t elapsed = now - schedule->dmx_timestamp;
+  schedule->dmx_period = elapsed < DMX_MAB_LEN_MAX_US ? elapsed : 0;
+  schedule->dmx_timestamp = now;
+  ++schedule->dmx_frames;
+  if (schedule->rdm_is_waiting) {
+    xSemaphoreGiveFromISR(schedule->grant, task_awoken);
+  }
+}
+
+int DMX_ISR_ATTR dmx_auto_size_get(dmx_driver_t *const driver, int64_t now) {
+  struct dmx_driver_auto_size_t *const auto_size = &driver->auto_size;
+  if (auto_size->full_period > 0 &&
+      now - auto_size->full_timestamp >= auto_size->full_period) {
+    auto_size->full_timestamp = now;
+    return driver->packet_size_max;  // Periodically refresh every slot
+  }
+
+  // Trim the trailing null slots, but not below the minimum size
+  const uint8_t *const data = driver->dmx.data;
+  int size = driver->packet_size_max;
+  while (size > auto_size->min_size && data[size - 1] == 0) {
+    --size;
+  }
+  return size;
+}
+
+// Starts the DMX break of a repeated packet on a repeater output. If the packet
+// was pending, its slots are moved into the DMX buffer. Must be called from
+// within a critical section of the output port.
+static void DMX_ISR_ATTR dmx_repeater_break(dmx_driver_t *const output) {
+  const dmx_port_t dmx_num = output->dmx_num;
+  if (output->repeater.is_pending) {
+    memcpy(output->dmx.data, output->repeater.next,
+           output->repeater.available);
+    output->repeater.is_pending = false;
+  }
+  DMX_STATE_WRITE_BEGIN(output);
+  output->dmx.head = 0;
+  output->dmx.size = output->packet_size_max;  // Set when the packet starts
+  output->dmx.progress = DMX_PROGRESS_IN_BREAK;
+  output->dmx.status = DMX_STATUS_SENDING;
+  DMX_STATE_WRITE_END(output);
+  DMX_RDM_HEADER_INVALIDATE(output);
+  dmx_uart_invert_tx(dmx_num, 1);
+  dmx_timer_set_counter(dmx_num, 0);
+  dmx_timer_set_alarm(dmx_num, output->break_len, true);
+  dmx_timer_start(dmx_num);
+}
+
+// Writes the slots of the repeated packet which have been received to the UART
+// of a repeater output. While it waits for more slots the UART idles in a
+// mark-between-slots, so the TX done interrupt is only enabled once the size of
+// the packet is known and all of it was written. Must be called from within a
+// critical section of the output port.
+void DMX_ISR_ATTR dmx_repeater_write(dmx_driver_t *const output) {
+  const dmx_port_t dmx_num = output->dmx_num;
+  if (output->dmx.progress != DMX_PROGRESS_IN_DATA) {
+    return;  // The DMX break or mark-after-break is still being sent
+  }
+
+  // Pending slots belong to the next packet
+  const int end = output->repeater.is_pending ? output->dmx.size
+                                              : output->repeater.available;
+  int write_len = end - output->dmx.head;
+  if (write_len > 0) {
+    dmx_uart_write_txfifo(dmx_num, &output->dmx.data[output->dmx.head],
+                          &write_len);
+    DMX_STATE_WRITE_BEGIN(output);
+    output->dmx.head += write_len;
+    DMX_STATE_WRITE_END(output);
+    dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DONE);
+  }
+
+  if (output->dmx.head < end) {
+    dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_DATA);
+  } else {
+    dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_DATA);
+  }
+  if (output->dmx.head < output->dmx.size) {
+    return;  // Wait for more slots from the source
+  } else if (output->dmx.head > 0) {
+    dmx_uart_enable_interrupt(dmx_num, DMX_INTR_TX_DONE);
+    return;
+  }
+
+  // No slots were sent so there will not be a TX done interrupt
+  DMX_STATE_WRITE_BEGIN(output);
+  output->dmx.progress = DMX_PROGRESS_COMPLETE;
+  output->dmx.status = DMX_STATUS_IDLE;
+  DMX_STATE_WRITE_END(output);
+  if (output->repeater.is_pending) {
+    dmx_repeater_break(output);
+  }
+}
+
+// Starts repeating a new packet on the outputs of a repeater source. Outputs
+// which are still sending the previous packet are told its size and start the
+// DMX break of the new packet once they are done.
+static void DMX_ISR_ATTR dmx_repeater_rx_break(dmx_driver_t *const driver) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  const uint32_t outputs = driver->repeater.outputs;
+  uint32_t active = 0;
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(outputs & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const output = dmx_driver[i];
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+    if (output->repeater.source == dmx_num) {
+      if (output->dmx.status == DMX_STATUS_SENDING) {
+        if (!output->repeater.is_pending) {
+          DMX_STATE_WRITE_BEGIN(output);
+          output->dmx.size = output->repeater.available;
+          DMX_STATE_WRITE_END(output);
+        }
+        output->repeater.available = 0;
+        output->repeater.is_pending = true;
+        dmx_repeater_write(output);
+      } else {
+        output->repeater.available = 0;
+        dmx_repeater_break(output);
+      }
+      active |= (1 << i);
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+  }
+  driver->repeater.active = active;
+}
+
+// Copies newly received slots of a repeater source to its outputs. RDM packets
+// are dropped when the start code arrives unless RDM is forwarded, which leaves
+// a DMX break without slots on the outputs.
+static void DMX_ISR_ATTR dmx_repeater_rx_data(dmx_driver_t *const driver,
+                                              int dmx_head, int read_len) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+  const uint32_t active = driver->repeater.active;
+  if (active == 0 || read_len <= 0) {
+    return;
+  }
+  const bool is_dropped = dmx_head == 0 && !driver->repeater.forwards_rdm &&
+                          dmx_start_code_is_rdm(driver->dmx.data[0]);
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    if (!(active & (1 << i))) {
+      continue;
+    }
+    dmx_driver_t *const output = dmx_driver[i];
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+    if (output->repeater.source != dmx_num ||
+        output->repeater.available != dmx_head) {
+      // The output stopped repeating or missed part of the packet
+    } else if (is_dropped) {
+      if (output->repeater.is_pending) {
+        output->repeater.is_pending = false;
+      } else {
+        DMX_STATE_WRITE_BEGIN(output);
+        output->dmx.size = 0;
+        DMX_STATE_WRITE_END(output);
+        dmx_repeater_write(output);
+      }
+    } else {
+      uint8_t *const data = output->repeater.is_pending ? output->repeater.next
+                                                        : output->dmx.data;
+      memcpy(&data[dmx_head], &driver->dmx.data[dmx_head], read_len);
+      output->repeater.available = dmx_head + read_len;
+      dmx_repeater_write(output);
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+  }
+  if (is_dropped) {
+    driver->repeater.active = 0;
+  }
+}
+
+void DMX_ISR_ATTR dmx_uart_isr(void *arg) {
+  const int64_t now = dmx_timer_get_micros_since_boot();
+  dmx_driver_t *const driver = arg;
+  const dmx_port_t dmx_num = driver->dmx_num;
+  int task_awoken = false;
+
+  while (true) {
+    const uint32_t intr_flags = dmx_uart_get_interrupt_status(dmx_num);
+    if (intr_flags == 0) break;
+
+    // DMX Receive ####################################################
+    if (driver->rx_mode == DMX_RX_MODE_DMA && (intr_flags & DMX_INTR_RX_ALL)) {
+      // Slot data is moved by the UHCI - only latch errors for the DMA ISR
+      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      if (intr_flags & DMX_INTR_RX_BREAK) {
+        DMX_TRACE(driver, DMX_TRACE_RX_BREAK, driver->dmx.head, now);
+        driver->dmx.rx_err_flags = 0;
+        DMX_RDM_HEADER_INVALIDATE(driver);
+        if (driver->sniffer.uses_capture) {
+          dmx_capture_arm(dmx_num, now);
+        }
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.status = DMX_STATUS_RECEIVING;
+        DMX_STATE_WRITE_END(driver);
+        driver->dmx.rx_intr_count = 1;
+        driver->dmx.rx_break_timestamp = now;
+      } else {
+        ++driver->dmx.rx_intr_count;
+        driver->dmx.rx_err_flags |= (intr_flags & DMX_INTR_RX_ERR);
+      }
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    } else if (intr_flags & DMX_INTR_RX_ALL) {
+      // Read data into the DMX buffer if there is enough space
+      int dmx_head = driver->dmx.head;  // Only the DMX ISR advances the head
+      bool is_filtered = false;
+      if (dmx_head >= 0 && dmx_head < driver->packet_size_max) {
+        int read_len = driver->packet_size_max - dmx_head;
+        dmx_uart_read_rxfifo(dmx_num, &driver->dmx.data[dmx_head], &read_len);
+        if (read_len > 0) {
+          dmx_uart_rx_checksum(driver, dmx_head, read_len);
+        }
+        if (dmx_head == 0 && read_len > 0 &&
+            !(intr_flags & DMX_INTR_RX_BREAK) &&
+            driver->repeater.outputs == 0 &&
+            DMX_SC_FILTER_GET(driver, driver->dmx.data[0]) ==
+                DMX_SC_ACTION_DROP) {
+          is_filtered = true;  // Skip the remaining slots of this packet
+        }
+        if (driver->repeater.outputs != 0) {
+          // The last slot which is read with a DMX break is the break itself
+          const bool is_break = (intr_flags & DMX_INTR_RX_BREAK);
+          dmx_repeater_rx_data(driver, dmx_head, read_len - is_break);
+        }
+        dmx_head += read_len;
+      } else {
+        if (dmx_head > 0) {
+          // Record the number of slots received for error reporting
+          dmx_head += dmx_uart_get_rxfifo_len(dmx_num);
+        }
+        dmx_uart_rxfifo_reset(dmx_num);
+      }
+      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_RX_ALL);
+
+      // Handle DMX break condition
+      if (intr_flags & DMX_INTR_RX_BREAK) {
+        DMX_TRACE(driver, DMX_TRACE_RX_BREAK, dmx_head, now);
+        if (driver->sniffer.uses_capture) {
+          dmx_capture_arm(dmx_num, now);
+        }
+        dmx_rx_callback_t callback = NULL;
+        int sc = -1;
+        int action = DMX_SC_ACTION_DELIVER;
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        DMX_STATE_WRITE_BEGIN(driver);
+        // Handle possible condition where expected packet size is too large
+        if (driver->dmx.progress == DMX_PROGRESS_IN_DATA && dmx_head > 0) {
+          DMX_TRACE(driver, DMX_TRACE_RX_DONE, dmx_head - 1, now);
+          driver->dmx.size = dmx_head - 1;  // Attempt to fix packet size
+          driver->dmx.last_rx_intr_count = driver->dmx.rx_intr_count;
+          driver->dmx.last_break_timestamp = driver->dmx.rx_break_timestamp;
+          driver->dmx.last_eop_timestamp = now;
+          callback = driver->rx_callback;
+          sc = driver->dmx.data[0];
+          action = dmx_uart_rx_filter(driver, sc);
+          dmx_uart_rx_count(driver, RDM_TYPE_IS_NOT_RDM,
+                            DMX_ERR_NOT_ENOUGH_SLOTS);
+          if (action == DMX_SC_ACTION_DELIVER) {
+            dmx_uart_rx_publish(driver, !dmx_start_code_is_rdm(sc),
+                                DMX_ERR_NOT_ENOUGH_SLOTS);
+            if (driver->task_waiting) {
+              xTaskNotifyFromISR(driver->task_waiting,
+                                 DMX_ERR_NOT_ENOUGH_SLOTS,
+                                 eSetValueWithOverwrite, &task_awoken);
+            }
+          }
+        }
+
+        // Reset the DMX buffer for the next packet
+        driver->dmx.status = DMX_STATUS_RECEIVING;
+        driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
+        driver->dmx.head = 0;
+        driver->dmx.rx_intr_count = 1;
+        driver->dmx.rx_break_timestamp = now;
+        DMX_STATE_WRITE_END(driver);
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        if (driver->repeater.outputs != 0) {
+          dmx_repeater_rx_break(driver);
+        }
+        dmx_uart_rx_callback(driver, callback, dmx_head - 1, sc,
+                             DMX_ERR_NOT_ENOUGH_SLOTS, action, &task_awoken);
+        dmx_uart_rx_adapt(driver, driver->is_controller &&
+                                      driver->dmx.last_controller_pid != 0);
+        continue;  // Nothing else to do on DMX break
+      }
+
+      // Stop reading packets which are dropped by the start code filter
+      if (is_filtered) {
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+        driver->dmx.progress = DMX_PROGRESS_STALE;
+        DMX_STATE_WRITE_END(driver);
+        ++driver->stats.rx_filtered;
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        continue;
+      }
+
+      // Publish the new head index in a single critical section
+      DMX_TRACE(driver, DMX_TRACE_RX_DATA, dmx_head, now);
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      DMX_STATE_WRITE_BEGIN(driver);
+      if (driver->dmx.head >= 0) {
+        driver->dmx.head = dmx_head;
+      }
+      ++driver->dmx.rx_intr_count;
+      if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK ||
+          driver->dmx.progress == DMX_PROGRESS_IN_MAB) {
+        // UART ISR cannot detect MAB so we go straight to DMX_PROGRESS_IN_DATA
+        driver->dmx.progress = DMX_PROGRESS_IN_DATA;
+      }
+      DMX_STATE_WRITE_END(driver);
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+      // Stop coalescing interrupts as soon as an RDM packet is detected
+      if (dmx_head > 0 && driver->dmx.progress == DMX_PROGRESS_IN_DATA) {
+        dmx_uart_rx_adapt(driver, dmx_start_code_is_rdm(driver->dmx.data[0]));
+      }
+
+      dmx_uart_rx_process(driver, intr_flags, dmx_head, now, &task_awoken);
+    }
+
+    // DMX Transmit #####################################################
+    else if (intr_flags & DMX_INTR_TX_DATA) {
+      if (driver->repeater.source < DMX_NUM_MAX) {
+        // Repeated packets are written as their slots are received
+        taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DATA);
+        dmx_repeater_write(driver);
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        continue;
+      }
+
+      // Write data to the UART and clear the interrupt
+      int write_len = driver->dmx.size - driver->dmx.head;
+      dmx_uart_write_txfifo(dmx_num, &driver->dmx.data[driver->dmx.head],
+                            &write_len);
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.head += write_len;
+      DMX_STATE_WRITE_END(driver);
+      dmx_uart_clear_interrupt(dmx_num, DMX_INTR_TX_DATA);
+      DMX_TRACE(driver, DMX_TRACE_TX_DATA, driver->dmx.head, now);
+
+      // Allow FIFO to empty when done writing data
+      if (driver->dmx.head == driver->dmx.size) {
+        dmx_uart_disable_interrupt(dmx_num, DMX_INTR_TX_DATA);
+      }
+    } else if (intr_flags & (DMX_INTR_TX_DONE | DMX_INTR_TX_BREAK_DONE)) {
+      // Disable write interrupts and clear the interrupt
+      dmx_uart_disable_interrupt(dmx_num,
+                                 DMX_INTR_TX_ALL | DMX_INTR_TX_BREAK_DONE);
+      dmx_uart_clear_interrupt(dmx_num,
+                               DMX_INTR_TX_DONE | DMX_INTR_TX_BREAK_DONE);
+      driver->dmx.tx_break_was_sent = (intr_flags & DMX_INTR_TX_BREAK_DONE);
+      DMX_TRACE(driver, DMX_TRACE_TX_DONE, driver->dmx.size, now);
+      if (driver->tx_mode == DMX_TX_MODE_DMA) {
+        dmx_uart_dma_stop(dmx_num);
+      }
+
+      // Call the completion callback of a packet sent by dmx_send_async()
+      const dmx_tx_callback_t tx_callback = driver->tx_async.callback;
+      if (tx_callback != NULL) {
+        driver->tx_async.callback = NULL;
+        if (tx_callback(dmx_num, driver->dmx.size, driver->tx_async.context)) {
+          task_awoken = true;
+        }
+      }
+
+      // Schedule the next DMX packet if sending continuously or if a packet
+      // was queued by dmx_send_async()
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      ++driver->stats.tx_packets;
+      if (driver->repeater.is_pending) {
+        // The next repeated packet has been waiting for this one to be sent
+        dmx_repeater_break(driver);
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        continue;
+      }
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+      if (driver->disc_isr.is_sending) {
+        // Flip the DMX bus so the next request may be read
+        driver->disc_isr.is_sending = false;
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.size = driver->disc_isr.rx_size;
+        driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+        driver->dmx.progress = DMX_PROGRESS_STALE;
+        driver->dmx.status = DMX_STATUS_IDLE;
+        DMX_STATE_WRITE_END(driver);
+        dmx_uart_rxfifo_reset(dmx_num);
+        dmx_uart_set_rts(dmx_num, 1);
+        DMX_TRACE(driver, DMX_TRACE_RTS, 1, now);
+        driver->dmx.tx_break_was_sent = false;
+
+        // A task which was waiting for a packet is still waiting for one
+        if (driver->task_waiting && !driver->disc_isr.task_was_waiting) {
+          xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction,
+                             &task_awoken);
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        continue;
+      }
+#endif
+      const bool is_continuous =
+          driver->continuous.is_running && !driver->continuous.is_paused;
+      if (is_continuous || driver->tx_async.is_queued) {
+        int64_t wait = is_continuous
+                           ? driver->continuous.period -
+                                 (now - driver->continuous.frame_timestamp)
+                           : 0;
+        const int64_t wait_min =
+            driver->dmx.tx_break_was_sent
+                ? 1
+                : RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
+        if (wait < wait_min) {
+          wait = wait_min;
+        }
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.controller_eop_timestamp = now;
+        driver->dmx.progress = DMX_PROGRESS_STALE;
+        DMX_STATE_WRITE_END(driver);
+        dmx_timer_set_counter(dmx_num, 0);
+        dmx_timer_set_alarm(dmx_num, wait, false);
+        dmx_timer_start(dmx_num);
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        continue;
+      }
+
+      // Update the DMX status and notify task
+      DMX_STATE_WRITE_BEGIN(driver);
+      if (driver->is_controller) {
+        // Record the EOP timestamp if this device is the DMX controller
+        driver->dmx.controller_eop_timestamp = now;
+      }
+      driver->dmx.progress = DMX_PROGRESS_COMPLETE;
+      driver->dmx.status = DMX_STATUS_IDLE;
+      DMX_STATE_WRITE_END(driver);
+      if (driver->task_waiting) {
+        xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction,
+                           &task_awoken);
+      }
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+
+      // Skip the rest of the ISR loop if an RDM response is not expected
+      if (!driver->is_controller || driver->dmx.last_controller_pid == 0 ||
+          (driver->dmx.last_request_was_broadcast &&
+           driver->dmx.last_controller_pid != RDM_PID_DISC_UNIQUE_BRANCH)) {
+        continue;
+      }
+
+      // Determine if a DMX break is expected in the response packet
+      int head, progress;
+      if (driver->dmx.last_controller_pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+        head = 0;  // Not expecting a DMX break
+        progress = DMX_PROGRESS_IN_DATA;
+      } else {
+        head = DMX_HEAD_WAITING_FOR_BREAK;
+        progress = DMX_PROGRESS_STALE;
+      }
+
+      // Flip the DMX bus so the response may be read
+      dmx_uart_rx_adapt(driver, true);
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      dmx_uart_rxfifo_reset(dmx_num);
+      dmx_uart_set_rts(dmx_num, 1);
+      DMX_TRACE(driver, DMX_TRACE_RTS, 1, now);
+      driver->dmx.tx_break_was_sent = false;  // Another device may send
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.head = head;
+      driver->dmx.progress = progress;
+      DMX_STATE_WRITE_END(driver);
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    }
+  }
+
+  if (task_awoken) portYIELD_FROM_ISR();
+}
+
+#if DMX_RX_BUFFER_COUNT > 1
+// Returns the per-byte maximum of two words. The even and odd bytes are
+// compared in separate 16-bit lanes so that each subtraction has room for its
+// borrow bit.
+static uint32_t DMX_ISR_ATTR dmx_merge_max(uint32_t a, uint32_t b) {
+  const uint32_t lanes = 0x00ff00ff;
+  const uint32_t borrows = 0x01000100;
+  uint32_t max = 0;
+  for (int shift = 0; shift <= 8; shift += 8) {
+    const uint32_t x = (a >> shift) & lanes;
+    const uint32_t y = (b >> shift) & lanes;
+    const uint32_t ge = ((x | borrows) - y) & borrows;  // Set where x >= y
+    const uint32_t mask = ge - (ge >> 8);  // 0xff in each lane where x >= y
+    max |= ((x & mask) | (y & ~mask)) << shift;
+  }
+  return max;
+}
+
+// Returns a word with 0xff in each byte which is non-zero in the given word.
+static uint32_t DMX_ISR_ATTR dmx_merge_nonzero(uint32_t x) {
+  const uint32_t high = (((x & 0x7f7f7f7f) + 0x7f7f7f7f) | x) & 0x80808080;
+  return (high >> 7) * 0xff;
+}
+
+// Takes the last complete DMX frame of a merge input if it has a NULL start
+// code. The LTP slots which the frame changed become owned by the input. Must
+// be called from within a critical section of the output port.
+static void DMX_ISR_ATTR dmx_merge_take(dmx_driver_t *const driver, int i,
+                                        int64_t now) {
+  struct dmx_driver_merge_t *const merge = &driver->merge;
+  dmx_merge_buffer_t *const buffer = merge->buffer;
+  const dmx_port_t input_num = merge->inputs[i];
+  dmx_driver_t *const input = dmx_driver[input_num];
+
+  // Copy the frame so that the input is not blocked while it is merged
+  taskENTER_CRITICAL_ISR(DMX_SPINLOCK(input_num));
+  const uint8_t *frame =
+      input->dmx.ready_is_fresh ? input->dmx.ready : input->dmx.front;
+  const int64_t timestamp = input->dmx.latest_timestamp;
+  int size = input->dmx.latest_size;
+  if (size > input->packet_size_max) {
+    size = input->packet_size_max;
+  }
+  const bool is_dmx = size > 0 && frame[0] == DMX_SC &&
+                      now - timestamp < merge->timeout;
+  if (is_dmx) {
+    memcpy(buffer->incoming, frame, size);
+  }
+  taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(input_num));
+  merge->seen_timestamps[i] = timestamp;
+  if (!is_dmx) {
+    return;  // Only recent DMX frames with a NULL start code are merged
+  }
+  memset((uint8_t *)buffer->incoming + size, 0,
+         sizeof(buffer->incoming) - size);
+
+  // Give the input ownership of the slots it changed
+  uint32_t *const frame_words = buffer->frames[i];
+  for (int w = 0; w < DMX_MERGE_WORDS; ++w) {
+    const uint32_t changed =
+        dmx_merge_nonzero(frame_words[w] ^ buffer->incoming[w]);
+    if (i == 0) {
+      buffer->owners[w] &= ~changed;
+    } else {
+      buffer->owners[w] |= changed;
+    }
+    frame_words[w] = buffer->incoming[w];
+  }
+
+  // Record the merge statistics of the input
+  dmx_merge_source_stats_t *const stats = &merge->stats.sources[i];
+  const uint32_t latency = now - timestamp;
+  ++stats->frame_count;
+  stats->latency = latency;
+  if (latency > stats->latency_max) {
+    stats->latency_max = latency;
+  }
+  stats->is_lost = false;
+  merge->frame_timestamps[i] = timestamp;
+}
+
+// Merges the last complete DMX frames of the merge inputs into the DMX buffer.
+// If both inputs are lost, the DMX buffer is not modified. Must be called from
+// within a critical section of the output port.
+static void DMX_ISR_ATTR dmx_merge_frame(dmx_driver_t *const driver,
+                                         int64_t now) {
+  struct dmx_driver_merge_t *const merge = &driver->merge;
+  dmx_merge_buffer_t *const buffer = merge->buffer;
+
+  // Take new DMX frames from the inputs in the order in which they arrived
+  int64_t timestamps[2];
+  for (int i = 0; i < 2; ++i) {
+    const dmx_port_t input_num = merge->inputs[i];
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(input_num));
+    timestamps[i] = dmx_driver[input_num]->dmx.latest_timestamp;
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(input_num));
+  }
+  const int first = timestamps[1] < timestamps[0];
+  for (int n = 0; n < 2; ++n) {
+    const int i = n ^ first;
+    if (timestamps[i] != merge->seen_timestamps[i]) {
+      dmx_merge_take(driver, i, now);
+    }
+  }
+
+  // Inputs which have not received a DMX frame within the timeout are lost
+  for (int i = 0; i < 2; ++i) {
+    dmx_merge_source_stats_t *const stats = &merge->stats.sources[i];
+    if (!stats->is_lost && now - merge->frame_timestamps[i] >= merge->timeout) {
+      stats->is_lost = true;
+      ++stats->loss_count;
+      memset(buffer->frames[i], 0, sizeof(buffer->frames[i]));
+      memset(buffer->owners, i == 0 ? 0xff : 0, sizeof(buffer->owners));
+    }
+  }
+  if (merge->stats.sources[0].is_lost && merge->stats.sources[1].is_lost) {
+    return;  // Hold the last merged DMX frame
+  }
+
+  // Merge the inputs four slots at a time
+  uint8_t *const data = driver->dmx.data;
+  const int size = driver->continuous.size;
+  for (int w = 0, offset = 0; offset < size; ++w, offset += 4) {
+    const uint32_t a = buffer->frames[0][w];
+    const uint32_t b = buffer->frames[1][w];
+    const uint32_t owners = buffer->owners[w];
+    const uint32_t ltp = buffer->ltp[w];
+    const uint32_t htp_value = dmx_merge_max(a, b);
+    const uint32_t ltp_value = (a & ~owners) | (b & owners);
+    const uint32_t merged = (htp_value & ~ltp) | (ltp_value & ltp);
+    memcpy(&data[offset], &merged, size - offset < 4 ? size - offset : 4);
+  }
+  DMX_RDM_HEADER_INVALIDATE(driver);
+  ++merge->stats.frame_count;
+}
+#endif
+
+// Steps each active fade to the value of its slots at the start of the next
+// continuous DMX packet. Slots are interpolated with a 16-bit fixed-point
+// fraction of the fade duration. The staging buffer follows the fading slots so
+// that they are not reverted when written data is copied into the DMX buffer.
+static void DMX_ISR_ATTR dmx_fade_frame(dmx_driver_t *const driver,
+                                        int64_t now) {
+  dmx_fade_buffer_t *const buffer = driver->fade.buffer;
+  uint8_t *const data = driver->dmx.data;
+  uint8_t *const staging = driver->continuous.staging;
+
+  for (int i = 0; i < DMX_FADES_MAX; ++i) {
+    struct dmx_fade_t *const fade = &buffer->fades[i];
+    if (fade->count == 0) {
+      continue;
+    }
+    const uint8_t owner = i + 1;
+    const int64_t elapsed = now > fade->timestamp ? now - fade->timestamp : 0;
+    if (elapsed >= fade->duration) {
+      // The fade is done - leave its slots at their targets
+      for (int slot = fade->first; slot < fade->end; ++slot) {
+        if (buffer->owners[slot] == owner) {
+          data[slot] = buffer->targets[slot];
+          staging[slot] = buffer->targets[slot];
+          buffer->owners[slot] = 0;
+        }
+      }
+      fade->count = 0;
+      --driver->fade.active;
+      continue;
+    }
+
+    // Only the slots which are owned by this fade are stepped
+    const int32_t fraction = (elapsed << 16) / fade->duration;
+    for (int slot = fade->first; slot < fade->end; ++slot) {
+      if (buffer->owners[slot] == owner) {
+        const int32_t delta = buffer->targets[slot] - buffer->starts[slot];
+        const uint8_t value =
+            buffer->starts[slot] + ((delta * fraction + 0x8000) >> 16);
+        data[slot] = value;
+        staging[slot] = value;
+      }
+    }
+  }
+  DMX_RDM_HEADER_INVALIDATE(driver);
+}
+
+static void DMX_ISR_ATTR dmx_timer_write_data(dmx_driver_t *driver) {
+  const dmx_port_t dmx_num = driver->dmx_num;
+
+  if (driver->repeater.source < DMX_NUM_MAX) {
+    // Write the slots of the repeated packet which have been received
+    dmx_timer_stop(dmx_num);
+    dmx_uart_set_tx_break(dmx_num, 0, 0);
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    DMX_STATE_WRITE_BEGIN(driver);
+    driver->dmx.progress = DMX_PROGRESS_IN_DATA;
+    DMX_STATE_WRITE_END(driver);
+    dmx_repeater_write(driver);
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    return;
+  }
+
+  // Write data to the UART
+  int tx_intr_mask;
+  int write_len = driver->dmx.size;
+  const int tx_done_intr = driver->dmx.tx_break_bits > 0
+                               ? DMX_INTR_TX_BREAK_DONE
+                               : DMX_INTR_TX_DONE;
+  dmx_uart_set_tx_break(dmx_num, driver->dmx.tx_break_bits,
+                        driver->dmx.tx_mab_bits);
+  if (driver->tx_mode == DMX_TX_MODE_DMA) {
+    dmx_uart_clear_interrupt(dmx_num, tx_done_intr);
+    dmx_uart_dma_write(dmx_num, driver->dmx.data, write_len);
+    tx_intr_mask = tx_done_intr;  // DMA refills the TX FIFO
+  } else {
+    dmx_uart_write_txfifo(dmx_num, driver->dmx.data, &write_len);
+    tx_intr_mask = DMX_INTR_TX_DATA | tx_done_intr;
+  }
+  DMX_STATE_WRITE_BEGIN(driver);
+  driver->dmx.head = write_len;
+  DMX_STATE_WRITE_END(driver);
+
+  // Pause MAB timer alarm
+  dmx_timer_stop(dmx_num);  // TODO: is this needed?
+
+  // Enable DMX write interrupts
+  dmx_uart_enable_interrupt(dmx_num, tx_intr_mask);
+}
+
+bool DMX_ISR_ATTR dmx_timer_isr(void *arg) {
+  dmx_driver_t *const driver = (dmx_driver_t *)arg;
+  const dmx_port_t dmx_num = driver->dmx_num;
+  int task_awoken = false;
+  DMX_TRACE(driver, DMX_TRACE_TIMER_ALARM, driver->dmx.progress,
+            dmx_timer_get_micros_since_boot());
+
+  if (driver->sync.group != 0) {
+    const uint32_t group = driver->sync.group;
+    driver->sync.group = 0;
+
+    // Start the DMX break on every port in the group as close together as
+    // possible and measure when each one started
+    int64_t break_timestamps[DMX_NUM_MAX];
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      if (group & (1 << i)) {
+        dmx_uart_invert_tx(i, 1);
+        break_timestamps[i] = dmx_timer_get_micros_since_boot();
+      }
+    }
+
+    // Set the timer alarm for the end of the DMX break on each port
+    int64_t first_break = INT64_MAX;
+    int64_t last_break = INT64_MIN;
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      if (!(group & (1 << i))) {
+        continue;
+      }
+      dmx_driver_t *const port = dmx_driver[i];
+      const int64_t now = dmx_timer_get_micros_since_boot();
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(i));
+      DMX_STATE_WRITE_BEGIN(port);
+      port->dmx.head = 0;
+      port->dmx.progress = DMX_PROGRESS_IN_BREAK;
+      port->dmx.status = DMX_STATUS_SENDING;
+      DMX_STATE_WRITE_END(port);
+      port->continuous.frame_timestamp = break_timestamps[i];
+      dmx_timer_set_counter(i, now - break_timestamps[i]);
+      dmx_timer_set_alarm(i, port->break_len, true);
+      dmx_timer_start(i);
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(i));
+
+      if (break_timestamps[i] < first_break) {
+        first_break = break_timestamps[i];
+      }
+      if (break_timestamps[i] > last_break) {
+        last_break = break_timestamps[i];
+      }
+    }
+
+    // Record the skew and notify the task which started the send
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    driver->sync.skew = last_break - first_break;
+    if (driver->task_waiting) {
+      xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eSetValueWithOverwrite,
+                         &task_awoken);
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+  } else if (driver->dmx.status == DMX_STATUS_SENDING) {
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+    if (driver->dmx.progress == DMX_PROGRESS_STALE &&
+        driver->disc_isr.is_sending) {
+      // The RDM responder turnaround time before a discovery response elapsed
+      const int64_t now = dmx_timer_get_micros_since_boot();
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      dmx_uart_set_rts(dmx_num, 0);
+      DMX_TRACE(driver, DMX_TRACE_RTS, 0, now);
+      driver->continuous.frame_timestamp = now;
+      if (driver->dmx.data[0] != RDM_SC) {
+        // RDM_PID_DISC_UNIQUE_BRANCH responses do not send a DMX break
+        dmx_timer_write_data(driver);
+      } else {
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
+        DMX_STATE_WRITE_END(driver);
+        dmx_timer_set_counter(dmx_num, 0);
+        dmx_timer_set_alarm(dmx_num, driver->break_len, true);
+        dmx_uart_invert_tx(dmx_num, 1);
+      }
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      return task_awoken;
+    }
+#endif
+    if (driver->dmx.progress == DMX_PROGRESS_STALE) {
+      // The wait before the next continuous DMX packet has elapsed
+      const int64_t now = dmx_timer_get_micros_since_boot();
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      const bool is_async = driver->tx_async.is_queued;
+      if (!is_async &&
+          (!driver->continuous.is_running || driver->continuous.is_paused)) {
+        // A task has requested the DMX bus - do not send the packet
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.status = DMX_STATUS_IDLE;
+        DMX_STATE_WRITE_END(driver);
+        dmx_timer_stop(dmx_num);
+        if (driver->task_waiting) {
+          xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eNoAction,
+                             &task_awoken);
+        }
+        taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+        return task_awoken;
+      }
+
+      if (is_async) {
+        // Start the packet which was queued by dmx_send_async()
+        driver->tx_async.is_queued = false;
+        driver->tx_async.callback = driver->tx_async.queued_callback;
+        driver->tx_async.context = driver->tx_async.queued_context;
+        if (driver->lease.write_is_pending && !driver->rdm.request_is_active) {
+          // Swap in the write buffer which was released by the task
+          uint8_t *const data = driver->dmx.data;
+          driver->dmx.data = driver->lease.back;
+          driver->lease.back = data;
+          DMX_RDM_HEADER_INVALIDATE(driver);
+          driver->lease.write_is_pending = false;
+        }
+        const int size = driver->tx_async.size > 0
+                             ? driver->tx_async.size
+                         : driver->auto_size.min_size > 0
+                             ? dmx_auto_size_get(driver, now)
+                             : driver->packet_size_max;
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.size = size;
+        DMX_STATE_WRITE_END(driver);
+        driver->dmx.tx_break_bits = driver->tx_async.tx_break_bits;
+        driver->dmx.tx_mab_bits = driver->tx_async.tx_mab_bits;
+        driver->dmx.last_controller_pid = 0;
+        driver->dmx.last_request_was_broadcast = false;
+        driver->dmx.responder_sent_last = false;
+        dmx_uart_set_rts(dmx_num, 0);  // Turn the DMX bus around
+        DMX_TRACE(driver, DMX_TRACE_RTS, 0, now);
+      }
+
+      // Copy data written since the last packet into the DMX buffer
+      if (driver->continuous.is_dirty) {
+        memcpy(driver->dmx.data, driver->continuous.staging,
+               driver->continuous.size);
+        driver->continuous.is_dirty = false;
+        DMX_RDM_HEADER_INVALIDATE(driver);
+      }
+#if DMX_RX_BUFFER_COUNT > 1
+      if (driver->merge.is_running) {
+        dmx_merge_frame(driver, now);
+      }
+#endif
+      if (driver->fade.active > 0) {
+        dmx_fade_frame(driver, now);
+      }
+      if (!is_async && driver->continuous.is_auto_sized &&
+          driver->auto_size.min_size > 0) {
+        const int size = dmx_auto_size_get(driver, now);
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.size = size;
+        DMX_STATE_WRITE_END(driver);
+      }
+      driver->continuous.frame_timestamp = now;
+      dmx_schedule_count_frame(driver, now, &task_awoken);
+
+      if (driver->dmx.tx_break_was_sent &&
+          now - driver->dmx.controller_eop_timestamp < DMX_MAB_LEN_MAX_US) {
+        // The UART already sent the DMX break after the last packet
+        driver->dmx.tx_break_was_sent = false;
+        dmx_timer_write_data(driver);
+      } else {
+        // Start the DMX break
+        driver->dmx.tx_break_was_sent = false;
+        DMX_STATE_WRITE_BEGIN(driver);
+        driver->dmx.head = 0;
+        driver->dmx.progress = DMX_PROGRESS_IN_BREAK;
+        DMX_STATE_WRITE_END(driver);
+        dmx_timer_set_counter(dmx_num, 0);
+        dmx_timer_set_alarm(dmx_num, driver->break_len, true);
+        dmx_uart_invert_tx(dmx_num, 1);
+      }
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    } else if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK) {
+      dmx_uart_invert_tx(dmx_num, 0);
+      DMX_STATE_WRITE_BEGIN(driver);
+      driver->dmx.progress = DMX_PROGRESS_IN_MAB;
+      DMX_STATE_WRITE_END(driver);
+
+      // Reset the alarm for the end of the DMX mark-after-break
+      dmx_timer_set_alarm(dmx_num, driver->mab_len, false);
+    } else {
+      dmx_timer_write_data(driver);
+    }
+  } else {
+    taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    if (driver->task_waiting) {
+      xTaskNotifyFromISR(driver->task_waiting, DMX_OK, eSetValueWithOverwrite,
+                         &task_awoken);
+    }
+    taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+    dmx_timer_stop(dmx_num);  // TODO: is this needed?
+  }
+
+  return task_awoken;
+}
+
+void DMX_ISR_ATTR dmx_gpio_isr(void *arg) {
+  const int64_t now = dmx_timer_get_micros_since_boot();
+  dmx_driver_t *const driver = (dmx_driver_t *)arg;
+  const dmx_port_t dmx_num = driver->dmx_num;
+  const int level = dmx_gpio_read(dmx_num);
+  DMX_TRACE(driver, DMX_TRACE_GPIO_EDGE, level, now);
+
+  if (level) {
+    /* If this ISR is called on a positive edge and the current DMX frame is in
+    a break and a negative edge timestamp has been recorded then a break has
+    just finished. Therefore the DMX break length is able to be recorded. It can
+    also be deduced that the driver is now in a DMX mark-after-break. */
+
+    if (driver->dmx.progress == DMX_PROGRESS_IN_BREAK &&
+        driver->sniffer.last_neg_edge_ts > -1) {
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      driver->sniffer.buffer_index = !driver->sniffer.buffer_index;
+      driver->sniffer.metadata[driver->sniffer.buffer_index].break_len =
+          now - driver->sniffer.last_neg_edge_ts;
+      driver->sniffer.metadata[driver->sniffer.buffer_index].break_timestamp =
+          driver->sniffer.last_neg_edge_ts;
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      driver->dmx.progress = DMX_PROGRESS_IN_MAB;
+    }
+    driver->sniffer.last_pos_edge_ts = now;
+  } else {
+    /* If this ISR is called on a negative edge in a DMX mark-after-break then
+    the DMX mark-after-break has just finished. It can be recorded. Sniffer data
+    is now available to be read by the user. */
+
+    if (driver->dmx.progress == DMX_PROGRESS_IN_MAB) {
+      taskENTER_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      driver->sniffer.metadata[driver->sniffer.buffer_index].mab_len =
+          now - driver->sniffer.last_pos_edge_ts;
+      dmx_sniffer_push(driver);
+      taskEXIT_CRITICAL_ISR(DMX_SPINLOCK(dmx_num));
+      driver->dmx.progress = DMX_PROGRESS_IN_DATA;
+    }
+    driver->sniffer.last_neg_edge_ts = now;
+  }
+}
@@ -0,0 +1,368 @@
+#include "dmx/net.h"
+
+#include <string.h>
+
+#include "dmx/hal/include/timer.h"
+#include "dmx/include/driver.h"
+#include "dmx/include/service.h"
+
+enum {
+  DMX_NET_ARTNET_OP_DMX = 0x5000,   // The Art-Net OpCode of an ArtDmx packet.
+  DMX_NET_ARTNET_OP_SYNC = 0x5200,  // The Art-Net OpCode of an ArtSync packet.
+  DMX_NET_ARTNET_VERSION = 14,      // The lowest supported Art-Net version.
+  DMX_NET_ARTNET_DMX_HEADER = 18,   // The size of an ArtDmx header.
+  DMX_NET_ARTNET_SYNC_SIZE = 14,    // The size of an ArtSync packet.
+
+  DMX_NET_SACN_ROOT_DATA = 0x00000004,  // VECTOR_ROOT_E131_DATA
+  DMX_NET_SACN_ROOT_EXTENDED = 0x00000008,  // VECTOR_ROOT_E131_EXTENDED
+  DMX_NET_SACN_FRAME_DATA = 0x00000002,  // VECTOR_E131_DATA_PACKET
+  DMX_NET_SACN_FRAME_SYNC = 0x00000001,  // VECTOR_E131_EXTENDED_SYNCHRONIZATION
+  DMX_NET_SACN_DMP_SET_PROPERTY = 0x02,  // VECTOR_DMP_SET_PROPERTY
+  DMX_NET_SACN_DATA_HEADER = 125,  // The size of an sACN data packet header.
+  DMX_NET_SACN_SYNC_SIZE = 49,     // The size of an sACN sync packet.
+  DMX_NET_SACN_OPTION_PREVIEW = 0x80,  // The sACN preview data option bit.
+  DMX_NET_SACN_OPTION_TERMINATED = 0x40,  // The sACN stream terminated bit.
+
+  DMX_NET_SEQUENCE_WINDOW = 20,  // Sequence numbers this far behind are late.
+};
+
+// The network ingest state of a DMX port.
+typedef struct dmx_net_port_t {
+  dmx_net_protocol_t protocol;  // The protocol of the mapped universe.
+  uint16_t universe;  // The Art-Net port-address or sACN universe.
+  bool has_sequence;  // True if a sequence number has been received.
+  uint8_t sequence;  // The sequence number of the last data packet.
+  uint16_t sync_address;  // The sACN sync address of the held DMX packet.
+  int64_t sync_timestamp;  // The time of the last sync for the sync address.
+  uint8_t *frame;  // The write buffer of the held DMX packet, or NULL.
+  dmx_net_stats_t stats;  // The network ingest statistics of the DMX port.
+} dmx_net_port_t;
+
+static dmx_net_port_t dmx_net_ports[DMX_NUM_MAX];
+static dmx_spinlock_t dmx_net_spinlock = DMX_SPINLOCK_INIT;
+static int64_t dmx_net_artsync_timestamp;  // The time of the last ArtSync.
+
+static uint16_t dmx_net_get_u16(const uint8_t *data) {
+  return (data[0] << 8) | data[1];
+}
+
+static uint32_t dmx_net_get_u32(const uint8_t *data) {
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+         ((uint32_t)data[2] << 8) | data[3];
+}
+
+// Checks if a DMX port is mapped to a universe. The mapping is read under the
+// lock because it may be changed by dmx_net_map() from another task.
+static bool dmx_net_is_mapped(const dmx_net_port_t *port,
+                              dmx_net_protocol_t protocol, uint16_t universe) {
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  const bool is_mapped =
+      port->protocol == protocol && port->universe == universe;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  return is_mapped;
+}
+
+// Checks the sequence number of a data packet using the method of ANSI E1.31
+// section 6.7.2. Art-Net packets with a sequence number of 0 are not checked.
+// Packets which arrive out of sequence are counted.
+static bool dmx_net_sequence_is_valid(dmx_net_port_t *port, uint8_t sequence) {
+  bool is_valid = true;
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  if (port->protocol != DMX_NET_PROTOCOL_ARTNET || sequence != 0) {
+    const int8_t diff = (int8_t)(sequence - port->sequence);
+    if (port->has_sequence && diff <= 0 && diff > -DMX_NET_SEQUENCE_WINDOW) {
+      ++port->stats.sequence_errors;
+      is_valid = false;
+    } else {
+      port->has_sequence = true;
+      port->sequence = sequence;
+    }
+  }
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  return is_valid;
+}
+
+// Releases the held DMX packet of a DMX port so that it is sent. Returns true
+// if a DMX packet was held.
+static bool dmx_net_release(dmx_port_t dmx_num, dmx_net_port_t *port) {
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  const bool is_held = port->frame != NULL;
+  port->frame = NULL;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  if (is_held) {
+    dmx_write_release(dmx_num);
+  }
+  return is_held;
+}
+
+// Releases the held DMX packets whose sync packets have timed out. This keeps
+// the last DMX packet of a universe from being held forever once its sync
+// packets stop.
+static uint32_t dmx_net_release_expired(int64_t now) {
+  const bool is_artsync_expired =
+      now - dmx_net_artsync_timestamp >= DMX_NET_ARTSYNC_TIMEOUT_US;
+
+  uint32_t written = 0;
+  for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+    dmx_net_port_t *const port = &dmx_net_ports[i];
+    taskENTER_CRITICAL(&dmx_net_spinlock);
+    bool is_expired = false;
+    if (port->frame != NULL) {
+      if (port->protocol == DMX_NET_PROTOCOL_ARTNET) {
+        is_expired = is_artsync_expired;
+      } else if (port->protocol == DMX_NET_PROTOCOL_SACN) {
+        is_expired =
+            now - port->sync_timestamp >= DMX_NET_SACN_SYNC_TIMEOUT_US;
+      }
+    }
+    taskEXIT_CRITICAL(&dmx_net_spinlock);
+    if (is_expired && dmx_net_release(i, port)) {
+      written |= (1 << i);
+    }
+  }
+
+  return written;
+}
+
+// Copies slot data into the write buffer of a DMX port and releases it unless
+// it is held for a sync packet. Slots after the end of the data are cleared.
+static bool dmx_net_write(dmx_port_t dmx_num, dmx_net_port_t *port,
+                          const uint8_t *slots, size_t size, bool has_sc,
+                          bool is_held) {
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  uint8_t *frame = port->frame;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  if (frame == NULL) {
+    frame = dmx_write_acquire(dmx_num);
+    if (frame == NULL) {
+      return false;
+    }
+  }
+  size_t offset = 0;
+  if (!has_sc) {
+    frame[0] = DMX_SC;
+    offset = 1;
+  }
+  const size_t packet_size_max = dmx_driver[dmx_num]->packet_size_max;
+  if (offset + size > packet_size_max) {
+    size = packet_size_max - offset;  // Drop slots which do not fit the port
+  }
+  memcpy(frame + offset, slots, size);
+  memset(frame + offset + size, 0, packet_size_max - offset - size);
+
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  port->frame = frame;
+  ++port->stats.packet_count;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  if (!is_held) {
+    dmx_net_release(dmx_num, port);
+  }
+  return true;
+}
+
+// Ingests an Art-Net packet.
+static uint32_t dmx_net_ingest_artnet(const uint8_t *data, size_t size,
+                                      int64_t now) {
+  const uint16_t op = data[8] | (data[9] << 8);
+  if (size < DMX_NET_ARTNET_SYNC_SIZE ||
+      dmx_net_get_u16(&data[10]) < DMX_NET_ARTNET_VERSION) {
+    return 0;
+  }
+
+  uint32_t written = 0;
+  if (op == DMX_NET_ARTNET_OP_SYNC) {
+    // Release every Art-Net DMX packet which is held
+    dmx_net_artsync_timestamp = now;
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      dmx_net_port_t *const port = &dmx_net_ports[i];
+      taskENTER_CRITICAL(&dmx_net_spinlock);
+      const bool is_mapped = port->protocol == DMX_NET_PROTOCOL_ARTNET;
+      taskEXIT_CRITICAL(&dmx_net_spinlock);
+      if (is_mapped && dmx_net_release(i, port)) {
+        taskENTER_CRITICAL(&dmx_net_spinlock);
+        ++port->stats.sync_count;
+        taskEXIT_CRITICAL(&dmx_net_spinlock);
+        written |= (1 << i);
+      }
+    }
+  } else if (op == DMX_NET_ARTNET_OP_DMX && size >= DMX_NET_ARTNET_DMX_HEADER) {
+    const uint16_t universe = data[14] | ((data[15] & 0x7f) << 8);
+    size_t length = dmx_net_get_u16(&data[16]);
+    if (length > DMX_PACKET_SIZE_MAX - 1 ||
+        length > size - DMX_NET_ARTNET_DMX_HEADER) {
+      return 0;
+    }
+    const bool is_held = dmx_net_artsync_timestamp != 0 &&
+                         now - dmx_net_artsync_timestamp <
+                             DMX_NET_ARTSYNC_TIMEOUT_US;
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      dmx_net_port_t *const port = &dmx_net_ports[i];
+      if (dmx_net_is_mapped(port, DMX_NET_PROTOCOL_ARTNET, universe) &&
+          dmx_net_sequence_is_valid(port, data[12]) &&
+          dmx_net_write(i, port, &data[DMX_NET_ARTNET_DMX_HEADER], length,
+                        false, is_held)) {
+        written |= (1 << i);
+      }
+    }
+  }
+
+  return written;
+}
+
+// Ingests an sACN packet.
+static uint32_t dmx_net_ingest_sacn(const uint8_t *data, size_t size,
+                                    int64_t now) {
+  const uint32_t root_vector = dmx_net_get_u32(&data[18]);
+  const uint32_t frame_vector = dmx_net_get_u32(&data[40]);
+
+  uint32_t written = 0;
+  if (root_vector == DMX_NET_SACN_ROOT_EXTENDED &&
+      frame_vector == DMX_NET_SACN_FRAME_SYNC &&
+      size >= DMX_NET_SACN_SYNC_SIZE) {
+    // Release every sACN DMX packet which is held for this sync address
+    const uint16_t sync_address = dmx_net_get_u16(&data[45]);
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      dmx_net_port_t *const port = &dmx_net_ports[i];
+      taskENTER_CRITICAL(&dmx_net_spinlock);
+      const bool is_synced = port->protocol == DMX_NET_PROTOCOL_SACN &&
+                             port->sync_address == sync_address &&
+                             sync_address != 0;
+      if (is_synced) {
+        port->sync_timestamp = now;
+      }
+      taskEXIT_CRITICAL(&dmx_net_spinlock);
+      if (is_synced && dmx_net_release(i, port)) {
+        taskENTER_CRITICAL(&dmx_net_spinlock);
+        ++port->stats.sync_count;
+        taskEXIT_CRITICAL(&dmx_net_spinlock);
+        written |= (1 << i);
+      }
+    }
+  } else if (root_vector == DMX_NET_SACN_ROOT_DATA &&
+             frame_vector == DMX_NET_SACN_FRAME_DATA &&
+             size > DMX_NET_SACN_DATA_HEADER) {
+    // Verify the DMP layer and find the property values
+    const size_t count = dmx_net_get_u16(&data[123]);
+    if (data[117] != DMX_NET_SACN_DMP_SET_PROPERTY || data[118] != 0xa1 ||
+        dmx_net_get_u16(&data[119]) != 0 || dmx_net_get_u16(&data[121]) != 1 ||
+        count == 0 || count > DMX_PACKET_SIZE_MAX ||
+        count > size - DMX_NET_SACN_DATA_HEADER) {
+      return 0;
+    }
+    const uint8_t options = data[112];
+    if ((options & DMX_NET_SACN_OPTION_PREVIEW) ||
+        data[DMX_NET_SACN_DATA_HEADER] != DMX_SC) {
+      return 0;  // Preview data and alternate start codes are not output
+    }
+    const bool is_terminated = (options & DMX_NET_SACN_OPTION_TERMINATED);
+    const uint16_t sync_address = dmx_net_get_u16(&data[109]);
+    const uint16_t universe = dmx_net_get_u16(&data[113]);
+    for (dmx_port_t i = 0; i < DMX_NUM_MAX; ++i) {
+      dmx_net_port_t *const port = &dmx_net_ports[i];
+      if (!dmx_net_is_mapped(port, DMX_NET_PROTOCOL_SACN, universe)) {
+        continue;
+      } else if (is_terminated) {
+        taskENTER_CRITICAL(&dmx_net_spinlock);
+        port->has_sequence = false;  // The next stream starts a new sequence
+        taskEXIT_CRITICAL(&dmx_net_spinlock);
+        continue;
+      } else if (!dmx_net_sequence_is_valid(port, data[111])) {
+        continue;
+      }
+
+      // Data is only held while sync packets arrive for its sync address
+      taskENTER_CRITICAL(&dmx_net_spinlock);
+      if (port->sync_address != sync_address) {
+        port->sync_address = sync_address;
+        port->sync_timestamp = 0;  // No sync was received for this address
+      }
+      const bool is_held =
+          sync_address != 0 && port->sync_timestamp != 0 &&
+          now - port->sync_timestamp < DMX_NET_SACN_SYNC_TIMEOUT_US;
+      taskEXIT_CRITICAL(&dmx_net_spinlock);
+      if (dmx_net_write(i, port, &data[DMX_NET_SACN_DATA_HEADER], count, true,
+                        is_held)) {
+        written |= (1 << i);
+      }
+    }
+  }
+
+  return written;
+}
+
+bool dmx_net_map(dmx_port_t dmx_num, dmx_net_protocol_t protocol,
+                 uint16_t universe) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(protocol == DMX_NET_PROTOCOL_ARTNET ||
+                protocol == DMX_NET_PROTOCOL_SACN,
+            false, "protocol error");
+  DMX_CHECK(protocol != DMX_NET_PROTOCOL_ARTNET ||
+                universe <= DMX_NET_ARTNET_UNIVERSE_MAX,
+            false, "universe error");
+  DMX_CHECK(protocol != DMX_NET_PROTOCOL_SACN ||
+                (universe >= DMX_NET_SACN_UNIVERSE_MIN &&
+                 universe <= DMX_NET_SACN_UNIVERSE_MAX),
+            false, "universe error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_net_unmap(dmx_num);  // Release any held DMX packet
+
+  dmx_net_port_t *const port = &dmx_net_ports[dmx_num];
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  port->universe = universe;
+  port->has_sequence = false;
+  port->sync_address = 0;
+  port->sync_timestamp = 0;
+  memset(&port->stats, 0, sizeof(port->stats));
+  port->protocol = protocol;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+
+  return true;
+}
+
+bool dmx_net_unmap(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+
+  dmx_net_port_t *const port = &dmx_net_ports[dmx_num];
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  port->protocol = DMX_NET_PROTOCOL_NONE;
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+  if (dmx_driver_is_installed(dmx_num)) {
+    dmx_net_release(dmx_num, port);
+  }
+
+  return true;
+}
+
+uint32_t dmx_net_ingest(const void *packet, size_t size) {
+  DMX_CHECK(packet != NULL, 0, "packet is null");
+
+  static const uint8_t artnet_id[8] = "Art-Net";
+  static const uint8_t sacn_id[12] = "ASC-E1.17";
+  const uint8_t *const data = packet;
+
+  const int64_t now = dmx_timer_get_micros_since_boot();
+  uint32_t written = dmx_net_release_expired(now);
+  if (size >= DMX_NET_ARTNET_SYNC_SIZE &&
+      memcmp(data, artnet_id, sizeof(artnet_id)) == 0) {
+    written |= dmx_net_ingest_artnet(data, size, now);
+  } else if (size >= DMX_NET_SACN_SYNC_SIZE &&
+             dmx_net_get_u16(&data[0]) == 0x0010 &&
+             dmx_net_get_u16(&data[2]) == 0x0000 &&
+             memcmp(&data[4], sacn_id, sizeof(sacn_id)) == 0) {
+    written |= dmx_net_ingest_sacn(data, size, now);
+  }
+
+  return written;
+}
+
+bool dmx_net_get_stats(dmx_port_t dmx_num, dmx_net_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+
+  taskENTER_CRITICAL(&dmx_net_spinlock);
+  memcpy(stats, &dmx_net_ports[dmx_num].stats, sizeof(*stats));
+  taskEXIT_CRITICAL(&dmx_net_spinlock);
+
+  return true;
+}
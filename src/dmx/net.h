@@ -0,0 +1,130 @@
+/**
+ * @file dmx/net.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow DMX received over a network
+ * with Art-Net or ANSI E1.31 (sACN) to be output on the DMX ports. Network
+ * packets are parsed in place and their slot data is copied directly into the
+ * DMX packet which is sent next on the mapped DMX port.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The network protocols which may be mapped to a DMX port.*/
+typedef enum dmx_net_protocol_t {
+  /** @brief The DMX port is not mapped to a network universe.*/
+  DMX_NET_PROTOCOL_NONE = 0,
+  /** @brief The DMX port outputs an Art-Net port-address.*/
+  DMX_NET_PROTOCOL_ARTNET,
+  /** @brief The DMX port outputs an ANSI E1.31 (sACN) universe.*/
+  DMX_NET_PROTOCOL_SACN,
+} dmx_net_protocol_t;
+
+/** @brief Network ingest constants.*/
+enum {
+  /** @brief The UDP port on which Art-Net packets are received.*/
+  DMX_NET_ARTNET_PORT = 6454,
+  /** @brief The largest Art-Net port-address.*/
+  DMX_NET_ARTNET_UNIVERSE_MAX = 32767,
+  /** @brief The UDP port on which sACN packets are received.*/
+  DMX_NET_SACN_PORT = 5568,
+  /** @brief The smallest sACN universe.*/
+  DMX_NET_SACN_UNIVERSE_MIN = 1,
+  /** @brief The largest sACN universe.*/
+  DMX_NET_SACN_UNIVERSE_MAX = 63999,
+  /** @brief The duration in microseconds for which Art-Net data is held for
+     an ArtSync packet after the last ArtSync packet was received.*/
+  DMX_NET_ARTSYNC_TIMEOUT_US = 4000000,
+  /** @brief The duration in microseconds for which sACN data is held for a
+     sync packet after the last sync packet for its synchronization address was
+     received. This is E131_NETWORK_DATA_LOSS_TIMEOUT of ANSI E1.31.*/
+  DMX_NET_SACN_SYNC_TIMEOUT_US = 2500000,
+};
+
+/** @brief Counters of the network packets ingested for a DMX port. Each
+ * counter wraps around on overflow.*/
+typedef struct dmx_net_stats_t {
+  /** @brief The number of data packets which were written to the DMX port.*/
+  uint32_t packet_count;
+  /** @brief The number of data packets which were dropped because they
+     arrived out of sequence.*/
+  uint32_t sequence_errors;
+  /** @brief The number of held DMX packets which were released by a sync
+     packet.*/
+  uint32_t sync_count;
+} dmx_net_stats_t;
+
+/**
+ * @brief Maps a DMX port to a network universe. Data packets for the universe
+ * which are passed to dmx_net_ingest() are written to the DMX port. Continuous
+ * sending should be started on the DMX port with dmx_continuous_start() so
+ * that the data is sent from the DMX driver's interrupts. Otherwise the data
+ * is sent in the next call to dmx_send().
+ *
+ * @note The DMX port's write buffer is acquired with dmx_write_acquire() while
+ * a packet is ingested or held for a sync packet, so it should not be acquired
+ * by the user while the DMX port is mapped.
+ *
+ * @param dmx_num The DMX port number.
+ * @param protocol The network protocol of the universe.
+ * @param universe The Art-Net port-address or the sACN universe number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_net_map(dmx_port_t dmx_num, dmx_net_protocol_t protocol,
+                 uint16_t universe);
+
+/**
+ * @brief Removes the network universe mapping of a DMX port. A DMX packet
+ * which is held for a sync packet is released.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_net_unmap(dmx_port_t dmx_num);
+
+/**
+ * @brief Parses an Art-Net or sACN packet and writes its slot data to each DMX
+ * port which is mapped to its universe. The packet may be the payload of an
+ * lwIP pbuf; it is only read and the slot data is copied once.
+ *
+ * ArtDmx and sACN data packets are dropped if they arrive out of sequence.
+ * sACN preview data and terminated streams are ignored. DMX packets are held
+ * until a sync packet is received when a sync packet for the synchronization
+ * address of the sACN data packet was received within the last
+ * DMX_NET_SACN_SYNC_TIMEOUT_US microseconds, or when an ArtSync packet was
+ * received within the last DMX_NET_ARTSYNC_TIMEOUT_US microseconds. Once sync
+ * packets stop, DMX packets which are held are released by the next network
+ * packet which is ingested and data is no longer held.
+ *
+ * @note This function should only be called by one task at a time.
+ *
+ * @param[in] packet A pointer to the UDP payload of the network packet.
+ * @param size The size of the UDP payload in bytes.
+ * @return A bit mask of the DMX ports whose DMX packets were written or
+ * released by the network packet.
+ */
+uint32_t dmx_net_ingest(const void *packet, size_t size);
+
+/**
+ * @brief Gets the network ingest statistics of a DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer to a dmx_net_stats_t into which the statistics
+ * are copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_net_get_stats(dmx_port_t dmx_num, dmx_net_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,388 @@
+#include "dmx/parallel.h"
+
+#include <string.h>
+
+#include "dmx/hal/include/gpio.h"
+#include "dmx/include/parallel.h"
+#include "dmx/include/service.h"
+#include "soc/soc_caps.h"
+
+#if ESP_IDF_VERSION_MAJOR >= 5 && SOC_LCD_I80_SUPPORTED && \
+    DMX_PARALLEL_NUM_MAX > 0
+#include "esp_lcd_panel_io.h"
+/** @brief This macro is defined when the parallel DMX ports are enabled and
+ * the target is able to send them with the I80 LCD bus.*/
+#define DMX_PARALLEL_SUPPORTED
+#endif
+
+#ifdef DMX_PARALLEL_SUPPORTED
+#if DMX_PARALLEL_NUM_MAX > 8
+typedef uint16_t dmx_parallel_sample_t;  // One bit-time of every DMX port.
+#else
+typedef uint8_t dmx_parallel_sample_t;  // One bit-time of every DMX port.
+#endif
+
+/* The I80 bus cannot clock slower than about 1.25MHz, so each DMX bit is sent
+  as several identical samples.*/
+enum {
+  DMX_PARALLEL_BIT_SAMPLES = 8,  // The number of samples in one DMX bit.
+  DMX_PARALLEL_PCLK_HZ = DMX_BAUD_RATE * DMX_PARALLEL_BIT_SAMPLES,
+  DMX_PARALLEL_BREAK_SAMPLES =
+      (DMX_BREAK_LEN_US * (DMX_PARALLEL_PCLK_HZ / 1000) + 999) / 1000,
+  DMX_PARALLEL_MAB_SAMPLES =
+      (DMX_MAB_LEN_US * (DMX_PARALLEL_PCLK_HZ / 1000) + 999) / 1000,
+  DMX_PARALLEL_SLOT_BITS = 11,  // A start bit, 8 data bits, 2 stop bits.
+  DMX_PARALLEL_SAMPLES_MAX =
+      DMX_PARALLEL_BREAK_SAMPLES + DMX_PARALLEL_MAB_SAMPLES +
+      (DMX_PACKET_SIZE_MAX * DMX_PARALLEL_SLOT_BITS *
+       DMX_PARALLEL_BIT_SAMPLES),
+  DMX_PARALLEL_IDLE_SAMPLES = 8,  // The mark which is sent at installation.
+};
+
+// A sample in which every DMX port is at the mark level
+#define DMX_PARALLEL_MARK \
+  ((dmx_parallel_sample_t)((1 << DMX_PARALLEL_NUM_MAX) - 1))
+
+static struct dmx_parallel_t {
+  bool is_installed;
+  SemaphoreHandle_t mux;  // Guards the packet buffers of the DMX ports.
+  SemaphoreHandle_t idle;  // Given when the DMA transfer is done.
+  esp_lcd_i80_bus_handle_t bus;
+  esp_lcd_panel_io_handle_t io;
+  uint8_t *data;  // The packet buffers of the DMX ports, one after another.
+  size_t sizes[DMX_PARALLEL_NUM_MAX];  // The packet size of each DMX port.
+  dmx_parallel_sample_t *samples;  // The encoded packets which are sent by DMA.
+  size_t sample_count;  // The number of samples of the DMA transfer in flight.
+} dmx_parallel = {};
+
+static bool DMX_ISR_ATTR dmx_parallel_isr(
+    esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *event_data,
+    void *arg) {
+  struct dmx_parallel_t *const parallel = arg;
+  BaseType_t task_awoken = false;
+  xSemaphoreGiveFromISR(parallel->idle, &task_awoken);
+  return task_awoken;
+}
+
+// Transposes a matrix of 8x8 bits so that bit b of byte i becomes bit i of
+// byte b. Byte i holds a slot of DMX port i, so byte b of the result holds data
+// bit b of each DMX port.
+static inline uint64_t dmx_parallel_transpose(uint64_t x) {
+  uint64_t t;
+  t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+  x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+  x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+  x ^= t ^ (t << 28);
+  return x;
+}
+
+// Writes one DMX bit of every DMX port as DMX_PARALLEL_BIT_SAMPLES samples.
+static inline dmx_parallel_sample_t *dmx_parallel_put_bit(
+    dmx_parallel_sample_t *sample, dmx_parallel_sample_t value) {
+  for (int i = 0; i < DMX_PARALLEL_BIT_SAMPLES; ++i) {
+    *sample++ = value;
+  }
+  return sample;
+}
+
+// Returns the number of FreeRTOS ticks which a DMA transfer of the samples
+// lasts, rounded up and with a margin of one tick.
+static TickType_t dmx_parallel_get_ticks(size_t sample_count) {
+  const uint32_t us =
+      ((uint64_t)sample_count * 1000000 + DMX_PARALLEL_PCLK_HZ - 1) /
+      DMX_PARALLEL_PCLK_HZ;
+  return dmx_ms_to_ticks((us + 999) / 1000) + 1;
+}
+
+// Encodes the packets of every DMX port into the DMA buffer and returns the
+// number of samples which were encoded. Each DMX bit is several samples long
+// and each bit of a sample is one DMX port. DMX ports with a shorter packet are
+// held at the mark level once their packet is done.
+static size_t dmx_parallel_encode(struct dmx_parallel_t *parallel) {
+  dmx_parallel_sample_t *sample = parallel->samples;
+
+  size_t size_max = 0;
+  for (int i = 0; i < DMX_PARALLEL_NUM_MAX; ++i) {
+    if (parallel->sizes[i] > size_max) {
+      size_max = parallel->sizes[i];
+    }
+  }
+
+  // Encode the DMX break and mark-after-break
+  for (int i = 0; i < DMX_PARALLEL_BREAK_SAMPLES; ++i) {
+    *sample++ = 0;
+  }
+  for (int i = 0; i < DMX_PARALLEL_MAB_SAMPLES; ++i) {
+    *sample++ = DMX_PARALLEL_MARK;
+  }
+
+  // Encode the slots eight DMX ports at a time
+  for (size_t slot = 0; slot < size_max; ++slot) {
+    dmx_parallel_sample_t idle = 0;
+    uint64_t lanes[(DMX_PARALLEL_NUM_MAX + 7) / 8] = {0};
+    for (int i = 0; i < DMX_PARALLEL_NUM_MAX; ++i) {
+      if (slot >= parallel->sizes[i]) {
+        idle |= 1 << i;
+      }
+      lanes[i / 8] |= (uint64_t)parallel->data[i * DMX_PACKET_SIZE_MAX + slot]
+                      << ((i % 8) * 8);
+    }
+    for (int i = 0; i < (DMX_PARALLEL_NUM_MAX + 7) / 8; ++i) {
+      lanes[i] = dmx_parallel_transpose(lanes[i]);
+    }
+
+    sample = dmx_parallel_put_bit(sample, idle);  // Start bit
+    for (int bit = 0; bit < 8; ++bit) {
+      dmx_parallel_sample_t value = idle;
+      for (int i = 0; i < (DMX_PARALLEL_NUM_MAX + 7) / 8; ++i) {
+        value |= ((lanes[i] >> (bit * 8)) & 0xff) << (i * 8);
+      }
+      sample = dmx_parallel_put_bit(sample, value);
+    }
+    sample = dmx_parallel_put_bit(sample, DMX_PARALLEL_MARK);  // Stop bits
+    sample = dmx_parallel_put_bit(sample, DMX_PARALLEL_MARK);
+  }
+
+  return sample - parallel->samples;
+}
+#endif
+
+bool dmx_parallel_install(const dmx_parallel_config_t *config) {
+  DMX_CHECK(config != NULL, false, "config is null");
+  DMX_CHECK(!dmx_parallel_is_installed(), false,
+            "parallel ports are already installed");
+
+#ifdef DMX_PARALLEL_SUPPORTED
+  DMX_CHECK(config->data_pins != NULL, false, "data_pins is null");
+  for (int i = 0; i < DMX_PARALLEL_NUM_MAX; ++i) {
+    DMX_CHECK(config->data_pins[i] >= 0 &&
+                  dmx_tx_pin_is_valid(config->data_pins[i]),
+              false, "data_pins error");
+  }
+  DMX_CHECK(config->clk_pin >= 0 && dmx_tx_pin_is_valid(config->clk_pin),
+            false, "clk_pin error");
+  DMX_CHECK(config->dc_pin >= 0 && dmx_tx_pin_is_valid(config->dc_pin), false,
+            "dc_pin error");
+
+  struct dmx_parallel_t *const parallel = &dmx_parallel;
+  parallel->is_installed = true;
+
+  // Allocate the packet buffers and the DMA buffer
+  parallel->data =
+      heap_caps_calloc(DMX_PARALLEL_NUM_MAX, DMX_PACKET_SIZE_MAX,
+                       MALLOC_CAP_8BIT);
+  parallel->samples =
+      heap_caps_malloc(sizeof(dmx_parallel_sample_t) * DMX_PARALLEL_SAMPLES_MAX,
+                       MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  parallel->mux = xSemaphoreCreateMutex();
+  parallel->idle = xSemaphoreCreateBinary();
+  if (parallel->data == NULL || parallel->samples == NULL ||
+      parallel->mux == NULL || parallel->idle == NULL) {
+    dmx_parallel_delete();
+    DMX_ERR("parallel DMX malloc error");
+    return false;
+  }
+  for (int i = 0; i < DMX_PARALLEL_NUM_MAX; ++i) {
+    parallel->sizes[i] = DMX_PACKET_SIZE_MAX;
+  }
+
+  // Initialize the I80 bus with one data line per DMX port
+  esp_lcd_i80_bus_config_t bus_config = {
+      .dc_gpio_num = config->dc_pin,
+      .wr_gpio_num = config->clk_pin,
+      .clk_src = LCD_CLK_SRC_DEFAULT,
+      .bus_width = DMX_PARALLEL_NUM_MAX,
+      .max_transfer_bytes =
+          sizeof(dmx_parallel_sample_t) * DMX_PARALLEL_SAMPLES_MAX,
+  };
+  for (int i = 0; i < DMX_PARALLEL_NUM_MAX; ++i) {
+    bus_config.data_gpio_nums[i] = config->data_pins[i];
+  }
+  esp_err_t err = esp_lcd_new_i80_bus(&bus_config, &parallel->bus);
+  if (err) {
+    parallel->bus = NULL;
+    dmx_parallel_delete();
+    DMX_ERR("parallel DMX bus error");
+    return false;
+  }
+
+  // Clock DMX_PARALLEL_BIT_SAMPLES samples per DMX bit without a command
+  const esp_lcd_panel_io_i80_config_t io_config = {
+      .cs_gpio_num = -1,
+      .pclk_hz = DMX_PARALLEL_PCLK_HZ,
+      .trans_queue_depth = 1,
+      .on_color_trans_done = dmx_parallel_isr,
+      .user_ctx = parallel,
+      .lcd_cmd_bits = 8,
+      .lcd_param_bits = 8,
+      .dc_levels = {.dc_data_level = 1},
+  };
+  err = esp_lcd_new_panel_io_i80(parallel->bus, &io_config, &parallel->io);
+  if (err) {
+    parallel->io = NULL;
+    dmx_parallel_delete();
+    DMX_ERR("parallel DMX bus error");
+    return false;
+  }
+
+  // Hold every DMX port at the mark level until the first packet is sent
+  for (int i = 0; i < DMX_PARALLEL_IDLE_SAMPLES; ++i) {
+    parallel->samples[i] = DMX_PARALLEL_MARK;
+  }
+  parallel->sample_count = DMX_PARALLEL_IDLE_SAMPLES;
+  err = esp_lcd_panel_io_tx_color(
+      parallel->io, -1, parallel->samples,
+      sizeof(dmx_parallel_sample_t) * DMX_PARALLEL_IDLE_SAMPLES);
+  if (err) {
+    xSemaphoreGive(parallel->idle);
+  }
+
+  return true;
+#else
+  DMX_ERR("parallel DMX ports are not supported");
+  return false;
+#endif
+}
+
+bool dmx_parallel_delete() {
+  DMX_CHECK(dmx_parallel_is_installed(), false,
+            "parallel ports are not installed");
+
+#ifdef DMX_PARALLEL_SUPPORTED
+  struct dmx_parallel_t *const parallel = &dmx_parallel;
+
+  // Block until the DMA transfer is done
+  if (parallel->io != NULL) {
+    xSemaphoreTake(parallel->idle, portMAX_DELAY);
+    esp_lcd_panel_io_del(parallel->io);
+    parallel->io = NULL;
+  }
+  if (parallel->bus != NULL) {
+    esp_lcd_del_i80_bus(parallel->bus);
+    parallel->bus = NULL;
+  }
+
+  // Free the semaphores and buffers
+  if (parallel->mux != NULL) {
+    vSemaphoreDelete(parallel->mux);
+    parallel->mux = NULL;
+  }
+  if (parallel->idle != NULL) {
+    vSemaphoreDelete(parallel->idle);
+    parallel->idle = NULL;
+  }
+  heap_caps_free(parallel->data);
+  parallel->data = NULL;
+  heap_caps_free(parallel->samples);
+  parallel->samples = NULL;
+
+  parallel->is_installed = false;
+#endif
+
+  return true;
+}
+
+bool dmx_parallel_is_installed() {
+#ifdef DMX_PARALLEL_SUPPORTED
+  return dmx_parallel.is_installed;
+#else
+  return false;
+#endif
+}
+
+size_t dmx_parallel_write_offset(dmx_port_t dmx_num, size_t offset,
+                                 const void *source, size_t size) {
+  assert(dmx_num_is_parallel(dmx_num) && dmx_num < DMX_NUM_MAX);
+  assert(offset < DMX_PACKET_SIZE_MAX);
+  assert(source != NULL);
+  DMX_CHECK(dmx_parallel_is_installed(), 0,
+            "parallel ports are not installed");
+
+#ifdef DMX_PARALLEL_SUPPORTED
+  struct dmx_parallel_t *const parallel = &dmx_parallel;
+
+  // Clamp size to the maximum packet size
+  if (size + offset > DMX_PACKET_SIZE_MAX) {
+    size = DMX_PACKET_SIZE_MAX - offset;
+  } else if (size == 0) {
+    return 0;
+  }
+
+  // Copy data from the source to the packet buffer of the DMX port
+  uint8_t *const data =
+      parallel->data + ((dmx_num - DMX_NUM_PARALLEL_0) * DMX_PACKET_SIZE_MAX);
+  xSemaphoreTake(parallel->mux, portMAX_DELAY);
+  memcpy(data + offset, source, size);
+  xSemaphoreGive(parallel->mux);
+
+  return size;
+#else
+  return 0;
+#endif
+}
+
+size_t dmx_parallel_send_num(dmx_port_t dmx_num, size_t size) {
+  assert(dmx_num_is_parallel(dmx_num) && dmx_num < DMX_NUM_MAX);
+  DMX_CHECK(dmx_parallel_is_installed(), 0,
+            "parallel ports are not installed");
+
+#ifdef DMX_PARALLEL_SUPPORTED
+  struct dmx_parallel_t *const parallel = &dmx_parallel;
+
+  // Block until the previous DMA transfer is done
+  xSemaphoreTake(parallel->mux, portMAX_DELAY);
+  const TickType_t wait_ticks = dmx_parallel_get_ticks(parallel->sample_count);
+  xSemaphoreGive(parallel->mux);
+  if (!xSemaphoreTake(parallel->idle, wait_ticks)) {
+    return 0;
+  }
+
+  // Encode the packets while no task is writing to them
+  xSemaphoreTake(parallel->mux, portMAX_DELAY);
+  const int lane = dmx_num - DMX_NUM_PARALLEL_0;
+  if (size > DMX_PACKET_SIZE_MAX) {
+    parallel->sizes[lane] = DMX_PACKET_SIZE_MAX;
+  } else if (size > 0) {
+    parallel->sizes[lane] = size;
+  }
+  size = parallel->sizes[lane];
+  const size_t sample_count = dmx_parallel_encode(parallel);
+  parallel->sample_count = sample_count;
+  xSemaphoreGive(parallel->mux);
+
+  // Hand the encoded packets to DMA
+  esp_err_t err =
+      esp_lcd_panel_io_tx_color(parallel->io, -1, parallel->samples,
+                                sizeof(dmx_parallel_sample_t) * sample_count);
+  if (err) {
+    xSemaphoreGive(parallel->idle);
+    return 0;
+  }
+
+  return size;
+#else
+  return 0;
+#endif
+}
+
+bool dmx_parallel_wait_sent(dmx_port_t dmx_num, TickType_t wait_ticks) {
+  assert(dmx_num_is_parallel(dmx_num) && dmx_num < DMX_NUM_MAX);
+  DMX_CHECK(dmx_parallel_is_installed(), false,
+            "parallel ports are not installed");
+
+#ifdef DMX_PARALLEL_SUPPORTED
+  struct dmx_parallel_t *const parallel = &dmx_parallel;
+
+  // Block until the DMA transfer is done
+  if (!xSemaphoreTake(parallel->idle, wait_ticks)) {
+    return false;
+  }
+  xSemaphoreGive(parallel->idle);
+
+  return true;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,75 @@
+/**
+ * @file dmx/parallel.h
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This file contains functions which allow many DMX universes to be
+ * output in parallel using the I80 LCD bus peripheral and DMA. The parallel
+ * DMX ports are numbered after the DMX ports which use a UART, so they are
+ * written and sent with dmx_write() and dmx_send() like any other DMX port.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "dmx/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief The configuration of the parallel DMX output ports.*/
+typedef struct dmx_parallel_config_t {
+  /** @brief An array of DMX_PARALLEL_NUM_MAX GPIO numbers. Each GPIO outputs
+     the DMX universe of one parallel DMX port, beginning with
+     DMX_NUM_PARALLEL_0.*/
+  const int *data_pins;
+  /** @brief The GPIO number of the I80 bus write clock. The clock is not
+     needed by DMX devices, but it must be routed to an otherwise unused
+     GPIO.*/
+  int clk_pin;
+  /** @brief The GPIO number of the I80 bus data/command signal. The signal is
+     not needed by DMX devices, but it must be routed to an otherwise unused
+     GPIO.*/
+  int dc_pin;
+} dmx_parallel_config_t;
+
+/**
+ * @brief Installs the parallel DMX output ports. Every parallel DMX port is
+ * sent at once from a single DMA transfer, in which the DMX break,
+ * mark-after-break, and slots of each DMX port are encoded as one data line
+ * of the I80 bus. Each parallel DMX port has its own packet buffer which is
+ * written with dmx_write(). Calling dmx_send() on any parallel DMX port sends
+ * the packets of all of the parallel DMX ports, so calling dmx_send() on each
+ * parallel DMX port in turn sends every packet once per call. Applications
+ * should write every parallel DMX port and then call dmx_send() on only one of
+ * them for each frame.
+ *
+ * @note The parallel DMX ports support output only. They cannot send or
+ * receive RDM and most DMX driver functions cannot be used on them. The
+ * DMX_PARALLEL_PORTS option must be enabled in the Kconfig.
+ *
+ * @param[in] config A pointer to the configuration of the parallel DMX ports.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_parallel_install(const dmx_parallel_config_t *config);
+
+/**
+ * @brief Deletes the parallel DMX output ports. This function blocks until
+ * the parallel DMX packets are done being sent.
+ *
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_parallel_delete();
+
+/**
+ * @brief Checks if the parallel DMX output ports are installed.
+ *
+ * @return true if the parallel DMX ports are installed.
+ * @return false if the parallel DMX ports are not installed.
+ */
+bool dmx_parallel_is_installed();
+
+#ifdef __cplusplus
+}
+#endif
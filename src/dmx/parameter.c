@@ -1,5 +1,6 @@
 #include "include/parameter.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "dmx/hal/include/nvs.h"
@@ -11,16 +12,20 @@ int dmx_sub_device_get_count(dmx_port_t dmx_num) {
   assert(dmx_num < DMX_NUM_MAX);
   assert(dmx_driver_is_installed(dmx_num));
 
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (dmx_responder_get_selected(driver) > 0) {
+    return 0;  // Virtual responders do not have sub-devices
+  }
+  return driver->device.sub_devices.count;
+}
 
-  int count = -1;  // Don't count root device
-  dmx_device_t *device = &driver->device.root;
-  do {
-    ++count;
-    device = device->next;
-  } while (device != NULL);
+bool dmx_sub_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(device_num > RDM_SUB_DEVICE_ROOT && device_num < RDM_SUB_DEVICE_MAX,
+            false, "device_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
-  return count;
+  return dmx_device_add(dmx_num, device_num);
 }
 
 bool dmx_sub_device_exists(dmx_port_t dmx_num, dmx_device_num_t device_num) {
@@ -49,26 +54,20 @@ rdm_pid_t dmx_parameter_at(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
   assert(sub_device < RDM_SUB_DEVICE_MAX);
   assert(dmx_driver_is_installed(dmx_num));
 
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
-
-  // Return early if the parameter index is out of bounds
-  if ((sub_device == RDM_SUB_DEVICE_ROOT &&
-       index > driver->device.parameter_count.root) ||
-      (sub_device > RDM_SUB_DEVICE_ROOT &&
-       index > driver->device.parameter_count.sub_devices)) {
-    return 0;
+  const dmx_device_t *device = dmx_device_get(dmx_num, sub_device);
+  if (device == NULL) {
+    return 0;  // Sub-device does not exist
   }
 
-  // Find the desired sub-device number
-  dmx_device_t *device = &driver->device.root;
-  while (device->num != sub_device) {
-    device = device->next;
-    if (device == NULL) {
-      return 0;  // Sub-device does not exist
-    }
+  // Parameters are returned in order of their PID
+  rdm_pid_t pid = 0;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (index < device->parameter_count) {
+    pid = device->parameters[device->index[index]].pid;
   }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
-  return device->parameters[index].pid;
+  return pid;
 }
 
 size_t dmx_parameter_size(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
@@ -120,10 +119,15 @@ size_t dmx_parameter_copy(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
     size = entry->size;
   }
 
-  // Copy the parameter
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  memcpy(destination, entry->data, size);
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  // Copy the parameter and retry if it was updated on the other core
+  const void *const data = entry->data;
+  uint32_t seq;
+  do {
+    while ((seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE)) & 1) {
+    }
+    memcpy(destination, data, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (seq != __atomic_load_n(&entry->seq, __ATOMIC_RELAXED));
 
   return size;
 }
@@ -151,18 +155,85 @@ size_t dmx_parameter_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
     size = entry->size;
   }
 
+  bool is_staged = false;
   taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
   memcpy(entry->data, source, size);
-  if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) {
-    entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED;
-    ++dmx_driver[dmx_num]->device.parameter_count.staged;
+  DMX_PARAMETER_WRITE_END(entry);
+  if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE ||
+      entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED) {
+    if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) {
+      entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED;
+      ++dmx_driver[dmx_num]->device.parameter_count.staged;
+    }
+    is_staged = true;
   }
+  ++dmx_driver[dmx_num]->device.generation;
   taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
+  // Repeated SETs of a staged parameter are coalesced into a single commit
+  if (is_staged) {
+    dmx_parameter_commit_schedule(dmx_num, false);
+  }
+
   return size;
 }
 
-rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num) {
+size_t dmx_parameter_set_all(dmx_port_t dmx_num, rdm_pid_t pid,
+                             const void *source, size_t size) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(pid > 0);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  // Return early if there is nothing to write
+  if (source == NULL || size == 0) {
+    return 0;
+  }
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Set the parameter on the root device and every sub-device in the table
+  size_t count = 0;
+  uint32_t index = 0;
+  for (int num = 0; num <= driver->device.sub_devices.max; ++num) {
+    dmx_device_t *const device = dmx_device_get(dmx_num, num);
+    if (device == NULL) {
+      continue;  // Sub-device does not exist
+    }
+
+    // Sub-devices support the same parameters so the index is usually reused
+    dmx_parameter_t *entry;
+    if (index < device->parameter_count &&
+        device->parameters[index].pid == pid) {
+      entry = &device->parameters[index];
+    } else {
+      entry = dmx_parameter_get_entry(dmx_num, num, pid);
+      if (entry == NULL) {
+        continue;  // Sub-device does not have the parameter
+      }
+      index = entry - device->parameters;
+    }
+    assert(entry->data != NULL);
+
+    const size_t write_size = size < entry->size ? size : entry->size;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_PARAMETER_WRITE_BEGIN(entry);
+    memcpy(entry->data, source, write_size);
+    DMX_PARAMETER_WRITE_END(entry);
+    if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) {
+      entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED;
+      ++driver->device.parameter_count.staged;
+    }
+    ++driver->device.generation;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    ++count;
+  }
+  dmx_parameter_commit_schedule(dmx_num, false);
+
+  return count;
+}
+
+size_t dmx_parameter_commit(dmx_port_t dmx_num) {
   assert(dmx_num < DMX_NUM_MAX);
   assert(dmx_driver_is_installed(dmx_num));
 
@@ -173,32 +244,205 @@ rdm_pid_t dmx_parameter_commit(dmx_port_t dmx_num) {
     return 0;
   }
 
-  rdm_sub_device_t sub_device;
-  rdm_pid_t pid = 0;
-  void *data = NULL;
-
-  // Iterate through parameters and commit the first found value to NVS
-  dmx_device_t *device = &driver->device.root;
-  for (; device != NULL && pid == 0; device = device->next) {
+  // Get the size of a copy of the staged parameters
+  size_t count = 0;
+  size_t size = 0;
+  const int device_count = dmx_device_count(dmx_num);
+  for (int index = 0; index < device_count; ++index) {
+    const dmx_device_t *device = dmx_device_at(dmx_num, index);
+    if (device == NULL) {
+      continue;  // Sub-device does not exist
+    }
     taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    for (int i = 0; i < driver->device.parameter_count.root; ++i) {
+    for (int i = 0; i < device->parameter_count; ++i) {
       if (device->parameters[i].type ==
           DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED) {
-        device->parameters[i].type = DMX_PARAMETER_TYPE_NON_VOLATILE;
-        --driver->device.parameter_count.staged;
-        sub_device = device->num;
-        pid = device->parameters[i].pid;
-        data = device->parameters[i].data;
+        ++count;
+        size += (device->parameters[i].size + DMX_PARAMETER_ALIGN - 1) &
+                ~(DMX_PARAMETER_ALIGN - 1);
+      }
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+  if (count == 0) {
+    return 0;
+  }
+  dmx_nvs_item_t *items = malloc(sizeof(*items) * count + size);
+  if (items == NULL) {
+    DMX_ERR("parameter commit malloc error");
+    return 0;
+  }
+
+  // Copy the staged parameters so that NVS is written without holding a lock
+  uint8_t *data = (uint8_t *)&items[count];
+  size_t committed = 0;
+  for (int index = 0; index < device_count; ++index) {
+    dmx_device_t *const device = dmx_device_at(dmx_num, index);
+    if (device == NULL) {
+      continue;  // Sub-device does not exist
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (int i = 0; i < device->parameter_count && committed < count; ++i) {
+      dmx_parameter_t *const entry = &device->parameters[i];
+      const size_t aligned_size =
+          (entry->size + DMX_PARAMETER_ALIGN - 1) & ~(DMX_PARAMETER_ALIGN - 1);
+      if (entry->type != DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED ||
+          aligned_size > size) {
+        continue;  // Parameter was staged after the copy was allocated
+      }
+      memcpy(data, entry->data, entry->size);
+      items[committed].sub_device = device->num;
+      items[committed].pid = entry->pid;
+      items[committed].param = data;
+      items[committed].size = entry->size;
+      entry->type = DMX_PARAMETER_TYPE_NON_VOLATILE;
+      --driver->device.parameter_count.staged;
+      data += aligned_size;
+      size -= aligned_size;
+      ++committed;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+
+  // Write every parameter in a single NVS transaction
+  if (!dmx_nvs_set_batch(dmx_num, items, committed)) {
+    DMX_ERR("parameter commit error");
+  }
+  free(items);
+
+  return committed;
+}
+
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+enum dmx_parameter_commit_event_t {
+  DMX_COMMIT_STAGED = (1 << 0),  // A non-volatile parameter was staged.
+  DMX_COMMIT_BUS_IDLE = (1 << 1),  // The DMX bus is idle.
+  DMX_COMMIT_EXIT = (1 << 2),  // The commit task should exit.
+};
+
+static void dmx_parameter_commit_task(void *arg) {
+  const dmx_port_t dmx_num = (dmx_port_t)(uintptr_t)arg;
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const TickType_t delay = dmx_ms_to_ticks(DMX_NVS_COMMIT_DELAY);
+
+  uint32_t events = 0;
+  while (!(events & DMX_COMMIT_EXIT)) {
+    xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+
+    // Wait for the parameters to stop changing so that a burst of SET requests
+    // is written at once, but never wait more than 10 commit delays
+    const TickType_t start = xTaskGetTickCount();
+    while (!(events & (DMX_COMMIT_BUS_IDLE | DMX_COMMIT_EXIT))) {
+      const TickType_t elapsed = xTaskGetTickCount() - start;
+      if (elapsed >= delay * 10) {
         break;
       }
+      const TickType_t remaining = delay * 10 - elapsed;
+      uint32_t more_events;
+      if (!xTaskNotifyWait(0, UINT32_MAX, &more_events,
+                           remaining < delay ? remaining : delay)) {
+        break;  // Parameters have stopped changing
+      }
+      events |= more_events;
     }
+
+    dmx_parameter_commit(dmx_num);
+  }
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->commit.task = NULL;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  vTaskDelete(NULL);
+}
+#endif
+
+bool dmx_parameter_commit_start(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (driver->commit.task == NULL) {
+    TaskHandle_t task;
+    if (xTaskCreate(dmx_parameter_commit_task, "dmx_commit", 4096,
+                    (void *)(uintptr_t)dmx_num, tskIDLE_PRIORITY + 1,
+                    &task) != pdPASS) {
+      return false;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->commit.task = task;
     taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
+#endif
 
-  if (pid > 0) {
-    dmx_nvs_set(dmx_num, sub_device, pid, data,
-                dmx_parameter_size(dmx_num, sub_device, pid));
+  return true;
+}
+
+void dmx_parameter_commit_stop(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  TaskHandle_t task;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  task = driver->commit.task;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (task == NULL) {
+    return;
   }
 
-  return pid;
+  // The task commits any staged parameters before it exits
+  xTaskNotify(task, DMX_COMMIT_EXIT, eSetBits);
+  while (task != NULL) {
+    vTaskDelay(1);
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    task = driver->commit.task;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+#endif
+}
+
+void dmx_parameter_commit_schedule(dmx_port_t dmx_num, bool bus_is_idle) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (driver->device.parameter_count.staged == 0) {
+    return;  // Nothing to commit
+  }
+
+#ifdef CONFIG_DMX_NVS_COMMIT_TASK
+  TaskHandle_t task;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  task = driver->commit.task;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (task != NULL) {
+    xTaskNotify(task, bus_is_idle ? DMX_COMMIT_BUS_IDLE : DMX_COMMIT_STAGED,
+                eSetBits);
+    return;
+  }
+#endif
+
+  if (bus_is_idle) {
+    dmx_parameter_commit(dmx_num);
+  }
+}
+
+bool dmx_parameter_get_memory(dmx_port_t dmx_num,
+                              dmx_parameter_memory_t *memory) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(memory != NULL, false, "memory is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memory->arena_size = driver->device.memory.size;
+  memory->arena_used = driver->device.memory.used;
+  memory->heap_used = driver->device.memory.heap;
+  memory->cache_used = driver->device.memory.cache;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
 }
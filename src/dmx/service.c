@@ -3,23 +3,227 @@
 #include <string.h>
 
 #include "dmx/include/driver.h"
+#include "rdm/include/uid.h"
+
+// Gets the entry of the sub-device table for a sub-device number.
+static dmx_device_t *dmx_device_get_slot(dmx_driver_t *driver,
+                                         dmx_device_num_t device_num) {
+  if (device_num == RDM_SUB_DEVICE_ROOT ||
+      device_num > driver->device.sub_devices.max) {
+    return NULL;
+  }
+  return (dmx_device_t *)(driver->device.sub_devices.table +
+                          (device_num - 1) * driver->device.sub_devices.stride);
+}
+
+bool dmx_device_add(dmx_port_t dmx_num, dmx_device_num_t device_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(device_num < RDM_SUB_DEVICE_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (device_num == RDM_SUB_DEVICE_ROOT) {
+    return true;  // The root device always exists
+  } else if (dmx_responder_get_selected(driver) > 0) {
+    return false;  // Virtual responders do not have sub-devices
+  }
+  dmx_device_t *const device = dmx_device_get_slot(driver, device_num);
+  if (device == NULL) {
+    return false;  // The sub-device table is too small
+  } else if (device->num == device_num) {
+    return true;  // Sub-device already exists
+  }
+
+  dmx_device_reset(device, driver->device.parameter_count.sub_devices);
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  device->num = device_num;
+  ++driver->device.sub_devices.count;
+  ++driver->device.generation;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
 
 dmx_device_t *dmx_device_get(dmx_port_t dmx_num, dmx_device_num_t device_num) {
   assert(dmx_num < DMX_NUM_MAX);
   assert(device_num < RDM_SUB_DEVICE_MAX);
   assert(dmx_driver_is_installed(dmx_num));
 
-  dmx_device_t *device = &dmx_driver[dmx_num]->device.root;
-  while (device->num != device_num) {
-    device = device->next;
-    if (device == NULL) {
-      return NULL;  // Sub-device does not exist
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const uint16_t selected = dmx_responder_get_selected(driver);
+  if (selected > 0) {
+    // Virtual responders only have a root device
+    if (device_num != RDM_SUB_DEVICE_ROOT) {
+      return NULL;
     }
+    return &((dmx_responder_t *)(driver->responders.table +
+                                 (selected - 1) * driver->responders.stride))
+                ->root;
+  } else if (device_num == RDM_SUB_DEVICE_ROOT) {
+    return &driver->device.root;
+  }
+  dmx_device_t *const device = dmx_device_get_slot(driver, device_num);
+  if (device == NULL || device->num != device_num) {
+    return NULL;  // Sub-device does not exist
   }
 
   return device;
 }
 
+dmx_device_t *dmx_device_at(dmx_port_t dmx_num, int index) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (index == 0) {
+    return &driver->device.root;
+  } else if (index <= driver->device.sub_devices.max) {
+    dmx_device_t *const device = dmx_device_get_slot(driver, index);
+    return device->num == index ? device : NULL;
+  }
+  index -= driver->device.sub_devices.max + 1;
+  if (index < 0 || index >= driver->responders.count) {
+    return NULL;
+  }
+
+  return &((dmx_responder_t *)(driver->responders.table +
+                               index * driver->responders.stride))
+              ->root;
+}
+
+int dmx_device_count(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  const dmx_driver_t *const driver = dmx_driver[dmx_num];
+  return driver->device.sub_devices.max + 1 + driver->responders.count;
+}
+
+int DMX_ISR_ATTR dmx_responder_find(const dmx_driver_t *driver,
+                                    const rdm_uid_t *uid) {
+  if (rdm_uid_is_eq(&driver->uid, uid)) {
+    return 0;
+  }
+
+  // Search the virtual responders, which are sorted by UID
+  const dmx_responder_index_t *const index = driver->responders.index;
+  uint32_t lower = 0;
+  uint32_t upper = driver->responders.count;
+  while (lower < upper) {
+    const uint32_t middle = lower + (upper - lower) / 2;
+    if (rdm_uid_is_lt(&index[middle].uid, uid)) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  if (lower < driver->responders.count &&
+      rdm_uid_is_eq(&index[lower].uid, uid)) {
+    return index[lower].num;
+  }
+
+  return -1;
+}
+
+uint16_t dmx_responder_get_selected(const dmx_driver_t *driver) {
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  const dmx_responder_selection_t *const selected = driver->responders.selected;
+  uint16_t num = 0;
+  taskENTER_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+  for (int i = 0; i < RDM_RESPONDER_SELECT_MAX + 1; ++i) {
+    if (selected[i].task == task) {
+      num = selected[i].num;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+
+  return num;
+}
+
+bool dmx_responder_set_selected(dmx_driver_t *driver, uint16_t responder_num,
+                                bool is_driver) {
+  const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  dmx_responder_selection_t *const selected = driver->responders.selected;
+  taskENTER_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+  int entry = -1;
+  int free_entry = -1;
+  int free_count = 0;
+  for (int i = 0; i < RDM_RESPONDER_SELECT_MAX + 1; ++i) {
+    if (selected[i].task == task) {
+      entry = i;
+    } else if (selected[i].task == NULL) {
+      free_entry = i;
+      ++free_count;
+    }
+  }
+
+  // Only the DMX driver may use the last free entry. It selects responders
+  // while it holds the driver mutex, so the entry is never needed twice.
+  if (entry < 0 && responder_num > 0 &&
+      (free_count > 1 || (is_driver && free_count > 0))) {
+    entry = free_entry;
+  }
+  if (entry >= 0) {
+    selected[entry].task = responder_num > 0 ? task : NULL;
+    selected[entry].num = responder_num;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+
+  return entry >= 0 || responder_num == 0;
+}
+
+void dmx_device_reset(dmx_device_t *device, uint32_t parameter_count) {
+  device->parameter_count = 0;
+  device->index = (uint16_t *)&device->parameters[parameter_count];
+}
+
+// Gets the position in the parameter index of the device of the first
+// parameter with a PID which is not less than the desired PID. Must be called
+// from within the critical section of the DMX port.
+static uint32_t dmx_parameter_lower_bound(const dmx_device_t *device,
+                                          rdm_pid_t pid) {
+  uint32_t lower = 0;
+  uint32_t upper = device->parameter_count;
+  while (lower < upper) {
+    const uint32_t middle = lower + (upper - lower) / 2;
+    if (device->parameters[device->index[middle]].pid < pid) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  return lower;
+}
+
+// Allocates parameter data from the parameter arena, or from the heap if the
+// arena is full.
+static void *dmx_parameter_alloc(dmx_port_t dmx_num, size_t size) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const size_t aligned_size =
+      (size + DMX_PARAMETER_ALIGN - 1) & ~(DMX_PARAMETER_ALIGN - 1);
+
+  void *data = NULL;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->device.memory.size - driver->device.memory.used >=
+      aligned_size) {
+    data = driver->device.memory.arena + driver->device.memory.used;
+    driver->device.memory.used += aligned_size;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  if (data == NULL) {
+    data = malloc(size);
+    if (data != NULL) {
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      driver->device.memory.heap += size;
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    }
+  }
+
+  return data;
+}
+
 bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num,
                        rdm_pid_t pid, int type, void *data, size_t size) {
   assert(dmx_num < DMX_NUM_MAX);
@@ -29,56 +233,88 @@ bool dmx_parameter_add(dmx_port_t dmx_num, dmx_device_num_t device_num,
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
 
+  // Add parameters one at a time so that each PID is only added once
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    return false;
+  }
+
   // Find the sub-device
   dmx_device_t *device = dmx_device_get(dmx_num, device_num);
   if (device == NULL) {
+    xSemaphoreGiveRecursive(driver->mux);
     return false;  // Device does not exist
   }
 
-  // Iterate through parameters until an empty parameter is found
+  // Find where the parameter belongs in the parameter index
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  const uint32_t index = dmx_parameter_lower_bound(device, pid);
+  const bool exists = index < device->parameter_count &&
+                      device->parameters[device->index[index]].pid == pid;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (exists) {
+    xSemaphoreGiveRecursive(driver->mux);
+    return true;  // Parameter already exists
+  }
   const uint32_t parameter_count =
       device_num == RDM_SUB_DEVICE_ROOT
           ? driver->device.parameter_count.root
           : driver->device.parameter_count.sub_devices;
-  for (int i = 0; i < parameter_count; ++i) {
-    if (device->parameters[i].pid == pid) {
-      return true;  // Parameter already exists
-    } else if (device->parameters[i].pid == 0) {
-      // Initialize parameter memory
-      switch (type) {
-        case DMX_PARAMETER_TYPE_DYNAMIC:
-        case DMX_PARAMETER_TYPE_NON_VOLATILE:
-          device->parameters[i].data = malloc(size);
-          if (device->parameters[i].data == NULL) {
-            DMX_ERR("parameter malloc error");
-            return false;
-          }
-          if (data == NULL) {
-            memset(device->parameters[i].data, 0, size);
-          } else {
-            memcpy(device->parameters[i].data, data, size);
-          }
-          break;
-        case DMX_PARAMETER_TYPE_STATIC:
-          device->parameters[i].data = data;
-          break;
-        case DMX_PARAMETER_TYPE_NULL:
-          device->parameters[i].data = NULL;
-          break;
-        default:
-          return false;
-      }
+  if (device->parameter_count == parameter_count) {
+    xSemaphoreGiveRecursive(driver->mux);
+    return false;  // No more parameters available on this sub-device
+  }
 
-      device->parameters[i].pid = pid;
-      device->parameters[i].size = size;
-      device->parameters[i].type = type;
-      device->parameters[i].definition = NULL;
-      device->parameters[i].callback = NULL;
-      return true;
-    }
+  // Initialize parameter memory
+  dmx_parameter_t parameter;
+  switch (type) {
+    case DMX_PARAMETER_TYPE_DYNAMIC:
+    case DMX_PARAMETER_TYPE_NON_VOLATILE:
+      parameter.data = dmx_parameter_alloc(dmx_num, size);
+      if (parameter.data == NULL) {
+        xSemaphoreGiveRecursive(driver->mux);
+        DMX_ERR("parameter malloc error");
+        return false;
+      }
+      if (data == NULL) {
+        memset(parameter.data, 0, size);
+      } else {
+        memcpy(parameter.data, data, size);
+      }
+      break;
+    case DMX_PARAMETER_TYPE_STATIC:
+      parameter.data = data;
+      break;
+    case DMX_PARAMETER_TYPE_NULL:
+      parameter.data = NULL;
+      break;
+    default:
+      xSemaphoreGiveRecursive(driver->mux);
+      return false;
   }
+  parameter.pid = pid;
+  parameter.size = size;
+  parameter.type = type;
+  parameter.seq = 0;
+  parameter.definition = NULL;
+  parameter.callback = NULL;
+  parameter.context = NULL;
+  parameter.cache_response = false;
+  parameter.cache_generation = 0;
+  parameter.cache = NULL;
+
+  // Append the parameter and insert it into the sorted parameter index
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  const uint32_t count = device->parameter_count;
+  device->parameters[count] = parameter;
+  memmove(&device->index[index + 1], &device->index[index],
+          (count - index) * sizeof(uint16_t));
+  device->index[index] = count;
+  ++device->parameter_count;
+  ++driver->device.generation;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  xSemaphoreGiveRecursive(driver->mux);
 
-  return false;  // No more parameters available on this sub-device
+  return true;
 }
 
 dmx_parameter_t *dmx_parameter_get_entry(dmx_port_t dmx_num,
@@ -94,18 +330,15 @@ dmx_parameter_t *dmx_parameter_get_entry(dmx_port_t dmx_num,
     return NULL;  // Sub-device does not exist
   }
 
-  // Get the parameter count for the requested device
-  const int param_count =
-      (device_num == RDM_SUB_DEVICE_ROOT)
-          ? dmx_driver[dmx_num]->device.parameter_count.root
-          : dmx_driver[dmx_num]->device.parameter_count.sub_devices;
-
-  // Iterate the device's parameters
-  for (int i = 0; i < param_count; ++i) {
-    if (device->parameters[i].pid == pid) {
-      return &device->parameters[i];
-    }
+  // Search the device's parameter index
+  dmx_parameter_t *entry = NULL;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  const uint32_t index = dmx_parameter_lower_bound(device, pid);
+  if (index < device->parameter_count &&
+      device->parameters[device->index[index]].pid == pid) {
+    entry = &device->parameters[device->index[index]];
   }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
-  return NULL;  // Parameter does not exist
+  return entry;  // NULL if the parameter does not exist
 }
@@ -1,9 +1,40 @@
 #include "dmx/sniffer.h"
 
+#include "dmx/hal/include/capture.h"
 #include "dmx/hal/include/gpio.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
 
+struct dmx_sniffer_hal_init_args_t {
+  dmx_port_t dmx_num;
+  int intr_pin;
+  TaskHandle_t caller;
+  bool result;
+};
+
+static bool dmx_sniffer_hal_init(dmx_port_t dmx_num, int intr_pin) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Prefer the capture hardware, falling back to an interrupt on every edge
+  driver->sniffer.uses_capture = dmx_capture_init(dmx_num, driver, intr_pin);
+  if (driver->sniffer.uses_capture) {
+    return true;
+  }
+
+  // Add the GPIO interrupt handler to the shared GPIO ISR service, which runs
+  // on the core that called gpio_install_isr_service()
+  return dmx_gpio_init(dmx_num, driver, intr_pin);
+}
+
+#if portNUM_PROCESSORS > 1 && !defined(CONFIG_FREERTOS_UNICORE)
+static void dmx_sniffer_hal_init_task(void *arg) {
+  struct dmx_sniffer_hal_init_args_t *args = arg;
+  args->result = dmx_sniffer_hal_init(args->dmx_num, args->intr_pin);
+  xTaskNotifyGive(args->caller);
+  vTaskDelete(NULL);
+}
+#endif
+
 bool dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
   DMX_CHECK(dmx_sniffer_pin_is_valid(intr_pin), false, "intr_pin error");
@@ -17,8 +48,34 @@ bool dmx_sniffer_enable(dmx_port_t dmx_num, int intr_pin) {
 
   dmx_driver[dmx_num]->sniffer.is_enabled = true;
 
-  // Add the GPIO interrupt handler
-  return dmx_gpio_init(dmx_num, driver, intr_pin);
+  // Initialize the hardware on the core which services the DMX interrupts
+  bool hal_init_ok;
+#if portNUM_PROCESSORS > 1 && !defined(CONFIG_FREERTOS_UNICORE)
+  if (driver->isr_core != xPortGetCoreID()) {
+    struct dmx_sniffer_hal_init_args_t args = {
+        .dmx_num = dmx_num,
+        .intr_pin = intr_pin,
+        .caller = xTaskGetCurrentTaskHandle(),
+        .result = false,
+    };
+    if (xTaskCreatePinnedToCore(dmx_sniffer_hal_init_task, "dmx_sniffer_init",
+                                4096, &args, uxTaskPriorityGet(NULL), NULL,
+                                driver->isr_core) != pdPASS) {
+      driver->sniffer.is_enabled = false;
+      DMX_CHECK(false, false, "DMX sniffer init task malloc error");
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    hal_init_ok = args.result;
+  } else
+#endif
+  {
+    hal_init_ok = dmx_sniffer_hal_init(dmx_num, intr_pin);
+  }
+  if (!hal_init_ok) {
+    driver->sniffer.is_enabled = false;
+  }
+
+  return hal_init_ok;
 }
 
 bool dmx_sniffer_disable(dmx_port_t dmx_num) {
@@ -26,10 +83,19 @@ bool dmx_sniffer_disable(dmx_port_t dmx_num) {
   DMX_CHECK(dmx_sniffer_is_enabled(dmx_num), false, "sniffer is not enabled");
 
   // Disable the interrupt and remove the interrupt handler
-  dmx_gpio_deinit(dmx_num);
+  if (dmx_driver[dmx_num]->sniffer.uses_capture) {
+    dmx_capture_deinit(dmx_num);
+  } else {
+    dmx_gpio_deinit(dmx_num);
+  }
 
   dmx_driver[dmx_num]->sniffer.is_enabled = false;
 
+  // Free the stream ring buffer if it was allocated
+  if (dmx_driver[dmx_num]->sniffer.stream.ring != NULL) {
+    dmx_sniffer_stream_disable(dmx_num);
+  }
+
   return true;
 }
 
@@ -51,3 +117,98 @@ bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata) {
 
   return true;
 }
+
+void DMX_ISR_ATTR dmx_sniffer_push(dmx_driver_t *driver) {
+  // Push the completed metadata to the stream, dropping it if it is full
+  struct dmx_driver_sniffer_stream_t *const stream = &driver->sniffer.stream;
+  if (stream->ring != NULL) {
+    const uint32_t head = stream->head;
+    if (head - __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE) <
+        stream->size) {
+      stream->ring[head & (stream->size - 1)] =
+          driver->sniffer.metadata[driver->sniffer.buffer_index];
+      __atomic_store_n(&stream->head, head + 1, __ATOMIC_RELEASE);
+    } else {
+      ++stream->dropped;
+    }
+  }
+}
+
+bool dmx_sniffer_stream_enable(dmx_port_t dmx_num, size_t size) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(size > 1 && (size & (size - 1)) == 0, false, "size error");
+  DMX_CHECK(dmx_sniffer_is_enabled(dmx_num), false, "sniffer is not enabled");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->sniffer.stream.ring == NULL, false,
+            "sniffer stream is already enabled");
+
+  dmx_metadata_t *ring =
+      heap_caps_malloc(sizeof(dmx_metadata_t) * size, MALLOC_CAP_8BIT);
+  if (ring == NULL) {
+    DMX_ERR("sniffer stream malloc error");
+    return false;
+  }
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->sniffer.stream.size = size;
+  driver->sniffer.stream.head = 0;
+  driver->sniffer.stream.tail = 0;
+  driver->sniffer.stream.dropped = 0;
+  driver->sniffer.stream.reported = 0;
+  driver->sniffer.stream.ring = ring;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool dmx_sniffer_stream_disable(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->sniffer.stream.ring != NULL, false,
+            "sniffer stream is not enabled");
+
+  // Detach the ring buffer from the sniffer ISR before freeing it
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  dmx_metadata_t *const ring = driver->sniffer.stream.ring;
+  driver->sniffer.stream.ring = NULL;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  heap_caps_free(ring);
+
+  return true;
+}
+
+size_t dmx_sniffer_stream_read(dmx_port_t dmx_num, dmx_metadata_t *metadata,
+                               size_t count, uint32_t *dropped) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(metadata != NULL || count == 0, 0, "metadata is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  struct dmx_driver_sniffer_stream_t *const stream = &driver->sniffer.stream;
+  DMX_CHECK(stream->ring != NULL, 0, "sniffer stream is not enabled");
+
+  // Copy the records which were pushed since the last read
+  const uint32_t tail = stream->tail;
+  const uint32_t head = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE);
+  size_t copied = head - tail;
+  if (copied > count) {
+    copied = count;
+  }
+  for (size_t i = 0; i < copied; ++i) {
+    metadata[i] = stream->ring[(tail + i) & (stream->size - 1)];
+  }
+  __atomic_store_n(&stream->tail, tail + copied, __ATOMIC_RELEASE);
+
+  // Report the records which were dropped since the last read
+  const uint32_t total_dropped =
+      __atomic_load_n(&stream->dropped, __ATOMIC_RELAXED);
+  if (dropped != NULL) {
+    *dropped = total_dropped - stream->reported;
+  }
+  stream->reported = total_dropped;
+
+  return copied;
+}
@@ -71,6 +71,46 @@ bool dmx_sniffer_is_enabled(dmx_port_t dmx_num);
  */
 bool dmx_sniffer_get_data(dmx_port_t dmx_num, dmx_metadata_t *metadata);
 
+/**
+ * @brief Enables streaming of DMX sniffer data. Each time the sniffer measures
+ * a DMX break and mark-after-break, the metadata is pushed into a ring buffer
+ * so that no packets are lost between reads. The ring buffer is read in batches
+ * with dmx_sniffer_stream_read(). The sniffer must be enabled first.
+ *
+ * @param dmx_num The DMX port number.
+ * @param size The number of dmx_metadata_t records in the ring buffer. Must be
+ * a power of two.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_sniffer_stream_enable(dmx_port_t dmx_num, size_t size);
+
+/**
+ * @brief Disables streaming of DMX sniffer data and frees the ring buffer. The
+ * ring buffer must not be read while it is being disabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool dmx_sniffer_stream_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Reads a batch of DMX sniffer data from the stream, oldest first. This
+ * function does not block. Only one task should read the stream of a DMX port
+ * at a time.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] metadata An array into which the metadata records are copied.
+ * @param count The maximum number of records to copy.
+ * @param[out] dropped A pointer to a value which is set to the number of
+ * records which were dropped since the last read because the ring buffer was
+ * full. May be NULL.
+ * @return The number of records which were copied.
+ */
+size_t dmx_sniffer_stream_read(dmx_port_t dmx_num, dmx_metadata_t *metadata,
+                               size_t count, uint32_t *dropped);
+
 #ifdef __cplusplus
 }
 #endif
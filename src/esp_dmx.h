@@ -56,6 +56,16 @@ extern "C" {
         ESP_DMX_VERSION_ID,           /*software_version_id*/         \
         ESP_DMX_VERSION_LABEL,        /*software_version_label*/      \
         32,                           /*queue_size_max*/              \
+        DMX_TX_MODE_FIFO,             /*tx_mode*/                     \
+        DMX_RX_MODE_FIFO,             /*rx_mode*/                     \
+        0,                            /*rx_intr_threshold*/           \
+        DMX_BREAK_MODE_TIMER,         /*break_mode*/                  \
+        DMX_ISR_CORE_CALLER,          /*isr_core*/                    \
+        0,                            /*sub_device_count*/            \
+        0,                            /*parameter_memory_size*/       \
+        0,                            /*packet_size_max*/             \
+        0,                            /*memory_caps*/                 \
+        0,                            /*virtual_responder_count*/     \
   }
 
 #ifdef __cplusplus
@@ -43,10 +43,25 @@ typedef struct rdm_ack_t {
   };
 } rdm_ack_t;
 
+/**
+ * @brief Type for constructing an RDM request. Contains all the necessary
+ * information needed to address a request on the RDM bus.
+ */
+typedef struct rdm_request_t {
+  const rdm_uid_t *dest_uid;    // The destination UID of the request.
+  rdm_sub_device_t sub_device;  // The target sub-device of the request.
+  rdm_cc_t cc;                  // The command class of the request.
+  rdm_pid_t pid;                // The parameter ID.
+  const char *format;           // The format string for the parameter data.
+  const void *pd;  // A pointer to the parameter data of the request.
+  size_t pdl;      // The parameter data length of the request.
+} rdm_request_t;
+
 #ifdef __cplusplus
 }
 #endif
 
+#include "rdm/controller/include/async.h"
 #include "rdm/controller/include/device_control.h"
 #include "rdm/controller/include/discovery.h"
 #include "rdm/controller/include/dmx_setup.h"
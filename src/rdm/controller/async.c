@@ -0,0 +1,169 @@
+#include "include/async.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx/include/driver.h"
+#include "dmx/include/service.h"
+#include "rdm/controller/include/utils.h"
+#include "rdm/include/driver.h"
+#include "rdm/include/uid.h"
+
+// An asynchronous RDM request which is waiting to be sent.
+typedef struct rdm_async_request_t {
+  rdm_async_handle_t handle;  // The handle of the request.
+  rdm_uid_t dest_uid;  // A copy of the destination UID of the request.
+  rdm_request_t request;  // The request with pointers into this struct.
+  const char *format;  // The format string for the response data.
+  rdm_async_cb_t cb;  // The callback which receives the result, or NULL.
+  QueueHandle_t queue;  // The queue which receives the result, or NULL.
+  void *context;  // The user context of the request.
+  uint8_t pd[RDM_PD_SIZE_MAX];  // A copy of the parameter data of the request.
+} rdm_async_request_t;
+
+static void rdm_async_task(void *arg) {
+  const dmx_port_t dmx_num = (dmx_port_t)(uintptr_t)arg;
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // The request and result are large so they are not kept on the task stack
+  rdm_async_request_t *request = malloc(sizeof(*request));
+  rdm_async_result_t *result = malloc(sizeof(*result));
+  if (request == NULL || result == NULL) {
+    DMX_ERR("RDM async task malloc error");
+    free(request);
+    free(result);
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->async.task = NULL;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    vTaskDelete(NULL);
+    return;
+  }
+
+  while (true) {
+    xQueueReceive(driver->async.requests, request, portMAX_DELAY);
+
+    // The queued request points into the old copy of itself
+    request->request.dest_uid = &request->dest_uid;
+    request->request.pd = request->request.pdl > 0 ? request->pd : NULL;
+
+    // Send the request and decode the response
+    result->handle = request->handle;
+    result->context = request->context;
+    result->ret = rdm_send_request(dmx_num, &request->request, request->format,
+                                   result->pd, sizeof(result->pd),
+                                   &result->ack);
+
+    // Deliver the result
+    if (request->cb != NULL) {
+      request->cb(dmx_num, result, request->context);
+    }
+    if (request->queue != NULL) {
+      xQueueSend(request->queue, result, 0);
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    --driver->async.pending;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+}
+
+rdm_async_handle_t rdm_send_request_async(dmx_port_t dmx_num,
+                                          const rdm_request_t *request,
+                                          const char *format, rdm_async_cb_t cb,
+                                          QueueHandle_t queue, void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(request != NULL, 0, "request is null");
+  DMX_CHECK(request->dest_uid != NULL, 0, "request->dest_uid is null");
+  DMX_CHECK(request->sub_device < RDM_SUB_DEVICE_MAX ||
+                request->sub_device == RDM_SUB_DEVICE_ALL,
+            0, "request->sub_device error");
+  DMX_CHECK(request->pid > 0, 0, "request->pid error");
+  DMX_CHECK(rdm_cc_is_valid(request->cc) && rdm_cc_is_request(request->cc), 0,
+            "request->cc error");
+  DMX_CHECK(request->sub_device != RDM_SUB_DEVICE_ALL ||
+                request->cc == RDM_CC_SET_COMMAND,
+            0, "request->sub_device error");
+  DMX_CHECK(rdm_format_is_valid(request->format), 0,
+            "request->format is invalid");
+  DMX_CHECK(request->pd != NULL || request->pdl == 0, 0,
+            "request->pd is null");
+  DMX_CHECK(request->pdl < RDM_PD_SIZE_MAX, 0, "request->pdl error");
+  DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Allocate the request queue the first time it is needed
+  if (driver->async.requests == NULL) {
+    QueueHandle_t requests =
+        xQueueCreate(RDM_ASYNC_QUEUE_SIZE, sizeof(rdm_async_request_t));
+    DMX_CHECK(requests != NULL, 0, "RDM async queue malloc error");
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (driver->async.requests == NULL) {
+      driver->async.requests = requests;
+      requests = NULL;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (requests != NULL) {
+      vQueueDelete(requests);  // Another task allocated the queue first
+    }
+  }
+
+  // Start the RDM controller task at the priority of the first caller
+  if (driver->async.task == NULL &&
+      xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    if (driver->async.task == NULL) {
+      TaskHandle_t task;
+      if (xTaskCreate(rdm_async_task, "rdm_async", 4096,
+                      (void *)(uintptr_t)dmx_num, uxTaskPriorityGet(NULL),
+                      &task) == pdPASS) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->async.task = task;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      }
+    }
+    xSemaphoreGiveRecursive(driver->mux);
+  }
+  DMX_CHECK(driver->async.task != NULL, 0, "RDM async task malloc error");
+
+  // Copy the request so that the caller's memory may be reused
+  rdm_async_request_t queued = {
+      .dest_uid = *request->dest_uid,
+      .request = *request,
+      .format = format,
+      .cb = cb,
+      .queue = queue,
+      .context = context,
+  };
+  if (request->pdl > 0) {
+    memcpy(queued.pd, request->pd, request->pdl);
+  }
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  queued.handle = driver->async.next_handle++;
+  if (driver->async.next_handle == 0) {
+    driver->async.next_handle = 1;  // Handles never evaluate to 0
+  }
+  ++driver->async.pending;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  // Queue the request without blocking
+  if (!xQueueSend(driver->async.requests, &queued, 0)) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    --driver->async.pending;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_CHECK(false, 0, "RDM async queue is full");
+  }
+
+  return queued.handle;
+}
+
+size_t rdm_async_get_pending(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  size_t pending;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  pending = dmx_driver[dmx_num]->async.pending;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return pending;
+}
@@ -1,7 +1,13 @@
 #include "include/discovery.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "dmx/hal/include/nvs.h"
+#include "dmx/hal/include/timer.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
+#include "rdm/controller/include/product_info.h"
 #include "rdm/controller/include/utils.h"
 #include "rdm/include/driver.h"
 #include "rdm/include/uid.h"
@@ -36,7 +42,7 @@ bool rdm_send_disc_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid,
                                  .pid = RDM_PID_DISC_MUTE};
 
   const char *format = "wv";
-  return rdm_send_request(dmx_num, &request, format, &mute, sizeof(*mute), ack);
+  return rdm_send_request(dmx_num, &request, format, mute, sizeof(*mute), ack);
 }
 
 bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid,
@@ -51,23 +57,115 @@ bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid,
                                  .pid = RDM_PID_DISC_UN_MUTE};
 
   const char *format = "wv";
-  return rdm_send_request(dmx_num, &request, format, &mute, sizeof(*mute), ack);
+  return rdm_send_request(dmx_num, &request, format, mute, sizeof(*mute), ack);
 }
 
-int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
-                               void *context) {
-  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(cb != NULL, 0, "cb is null");
-  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+// Returns true if a DISC_UNIQUE_BRANCH response was received from a single
+// device. Responses from multiple devices collide, which usually causes a DMX
+// error or an invalid encoding or checksum. A collision which happens to decode
+// with a valid checksum is caught because its UID is outside of the branch.
+static bool rdm_disc_response_is_clean(const rdm_ack_t *ack,
+                                       const rdm_disc_unique_branch_t *branch) {
+  return ack->err == DMX_OK && ack->type == RDM_RESPONSE_TYPE_ACK &&
+         ack->size >= 17 && ack->size <= 24 &&
+         rdm_uid_is_ge(&ack->src_uid, &branch->lower_bound) &&
+         rdm_uid_is_le(&ack->src_uid, &branch->upper_bound);
+}
 
-  // Allocate the instruction stack. The max binary tree depth is 49.
-#ifdef CONFIG_RDM_STATIC_DISCOVERY_INSTRUCTIONS
-  static rdm_disc_unique_branch_t stack[49]; 
-#else
-  rdm_disc_unique_branch_t *stack;
-  stack = malloc(sizeof(rdm_disc_unique_branch_t) * 49);
-  DMX_CHECK(stack != NULL, 0, "discovery malloc error");
-#endif
+// The statistics of the most recent discovery run on each DMX port.
+static rdm_disc_stats_t rdm_disc_stats[DMX_NUM_MAX] = {};
+
+// Chooses how many times a request which may have been lost is retried. The
+// rate of corrupted responses in this run and in the previous run is used to
+// estimate how likely it is that a response was lost to a bus error.
+static int rdm_disc_get_retries(const rdm_disc_stats_t *previous,
+                                const rdm_disc_stats_t *stats) {
+  const uint32_t requests = previous->branches + previous->mutes +
+                            stats->branches + stats->mutes;
+  const uint32_t errors = previous->partial + stats->partial;
+  if (requests < 32) {
+    return 2;  // Too few requests have been observed to trust the bus
+  } else if (errors * 100 < requests) {
+    return 0;
+  } else if (errors * 20 < requests) {
+    return 1;
+  }
+  return 2;
+}
+
+// Sends a DISC_UNIQUE_BRANCH request. A request is only retried when its
+// response may have been caused by a bus error rather than by the devices in
+// the branch. Collisions are not retried because the branch must be split.
+static void rdm_disc_branch(dmx_port_t dmx_num,
+                            const rdm_disc_unique_branch_t *branch,
+                            rdm_ack_t *ack, rdm_disc_stats_t *stats,
+                            int retries) {
+  for (int attempt = 0;; ++attempt) {
+    rdm_send_disc_unique_branch(dmx_num, branch, ack);
+    ++stats->branches;
+    int max_attempt;
+    if (ack->type == RDM_RESPONSE_TYPE_NONE) {
+      ++stats->empty;
+      max_attempt = retries;  // A response may have been lost
+    } else if (rdm_disc_response_is_clean(ack, branch)) {
+      ++stats->clean;
+      return;
+    } else if (ack->err != DMX_OK || ack->size < 17 || ack->size > 24) {
+      ++stats->partial;
+      max_attempt = retries > 0 ? retries : 1;  // Partial data may be noise
+    } else {
+      ++stats->collisions;
+      return;
+    }
+    if (attempt >= max_attempt) {
+      return;
+    }
+    ++stats->retries;
+  }
+}
+
+// Sends a DISC_MUTE request and retries it if no valid response is received.
+static void rdm_disc_mute(dmx_port_t dmx_num, const rdm_uid_t *uid,
+                          rdm_disc_mute_t *mute, rdm_ack_t *ack,
+                          rdm_disc_stats_t *stats, int retries) {
+  for (int attempt = 0;; ++attempt) {
+    rdm_send_disc_mute(dmx_num, uid, mute, ack);
+    ++stats->mutes;
+    if (ack->type == RDM_RESPONSE_TYPE_ACK) {
+      return;
+    } else if (ack->type != RDM_RESPONSE_TYPE_NONE) {
+      ++stats->partial;
+    }
+    if (attempt >= retries) {
+      return;
+    }
+    ++stats->retries;
+  }
+}
+
+// Performs the discovery algorithm. Devices are only un-muted first if desired
+// so that devices which are already muted are not discovered again.
+static int rdm_discover(dmx_port_t dmx_num, rdm_disc_cb_t cb, void *context,
+                        bool un_mute) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Wait for any other discovery on this port to finish using the stack
+  while (true) {
+    bool is_acquired = false;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (!driver->rdm.disc_is_active) {
+      driver->rdm.disc_is_active = true;
+      is_acquired = true;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (is_acquired) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+
+  // The instruction stack is allocated with the driver of each port
+  rdm_disc_unique_branch_t *const stack = driver->rdm.disc_stack;
 
   // Initialize the stack with the initial branch instruction
   int stack_size = 1;
@@ -79,24 +177,36 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
   rdm_ack_t ack;         // Request response information.
   int num_found = 0;
 
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
-  xSemaphoreTakeRecursive(driver->mux, 0);
+  // The retry policy is adapted to the bus error rate as discovery runs
+  rdm_disc_stats_t previous;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  previous = rdm_disc_stats[dmx_num];
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  rdm_disc_stats_t stats = {};
+  const int64_t start_timestamp = dmx_timer_get_micros_since_boot();
+
+  xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
 
   // Un-mute all devices
-  dest_uid = RDM_UID_BROADCAST_ALL;
-  rdm_send_disc_un_mute(dmx_num, &dest_uid, NULL, NULL);
+  if (un_mute) {
+    dest_uid = RDM_UID_BROADCAST_ALL;
+    rdm_send_disc_un_mute(dmx_num, &dest_uid, NULL, NULL);
+  }
 
   while (stack_size > 0) {
+    // Let the scheduler send DMX packets between discovery transactions
+    xSemaphoreGiveRecursive(driver->mux);
+    rdm_schedule_wait(dmx_num, RDM_PID_DISC_UNIQUE_BRANCH, 38, 24);
+    xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+
     // Pop a DISC_UNIQUE_BRANCH instruction parameter from the stack
     const rdm_disc_unique_branch_t *branch = &stack[--stack_size];
+    const int retries = rdm_disc_get_retries(&previous, &stats);
 
-    size_t attempts = 0;
     if (rdm_uid_is_eq(&branch->lower_bound, &branch->upper_bound)) {
       // Can't branch further so attempt to mute the device
       dest_uid = branch->lower_bound;
-      do {
-        rdm_send_disc_mute(dmx_num, &dest_uid, &mute, &ack);
-      } while (ack.type != RDM_RESPONSE_TYPE_ACK && ++attempts < 3);
+      rdm_disc_mute(dmx_num, &dest_uid, &mute, &ack, &stats, retries);
 
       // Call the callback function and report a device has been found
       if (ack.type == RDM_RESPONSE_TYPE_ACK) {
@@ -107,14 +217,11 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
       }
     } else {
       // Search the current branch in the RDM address space
-      do {
-        rdm_send_disc_unique_branch(dmx_num, branch, &ack);
-      } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
+      rdm_disc_branch(dmx_num, branch, &ack, &stats, retries);
       if (ack.type != RDM_RESPONSE_TYPE_NONE) {
         bool devices_remaining = true;
 
-#if false  // FIXME: This should temporarily allow discovery to work.
-// #ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
+#ifndef CONFIG_RDM_DEBUG_DEVICE_DISCOVERY
         /*
         Stop the RDM controller from branching all the way down to the
         individual address if it is not necessary. When debugging, this code
@@ -123,28 +230,29 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
         it is desired, but it isn't necessary unless the user makes changes to
         this function.
         */
-        if (ack.type == RDM_RESPONSE_TYPE_ACK) {
-          do {
-            // Attempt to mute the device
-            attempts = 0;
-            dest_uid = ack.src_uid;
-            do {
-              rdm_send_disc_mute(dmx_num, &dest_uid, &mute, &ack);
-            } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
-
-            // Call the callback function and report a device has been found
-            if (ack.type == RDM_RESPONSE_TYPE_ACK) {
-              cb(dmx_num, ack.src_uid, num_found, &mute, context);
-              ++num_found;
-            }
-
-            // Check if there are more devices in this branch
-            attempts = 0;
-            do {
-              rdm_send_disc_unique_branch(dmx_num, branch, &ack);
-            } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
-          } while (ack.type == RDM_RESPONSE_TYPE_ACK);
-          devices_remaining = (ack.err && ack.err != DMX_ERR_TIMEOUT);
+        while (rdm_disc_response_is_clean(&ack, branch)) {
+          // Attempt to mute the device
+          dest_uid = ack.src_uid;
+          rdm_disc_mute(dmx_num, &dest_uid, &mute, &ack, &stats, retries);
+          if (ack.type != RDM_RESPONSE_TYPE_ACK ||
+              !rdm_uid_is_eq(&ack.src_uid, &dest_uid)) {
+            break;  // The response may have been a collision so keep branching
+          }
+
+          // Call the callback function and report a device has been found
+          xSemaphoreGiveRecursive(driver->mux);
+          cb(dmx_num, dest_uid, num_found, &mute, context);
+          xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY);
+          ++num_found;
+
+          // Check if there are more devices in this branch
+          rdm_disc_branch(dmx_num, branch, &ack, &stats, retries);
+          if (ack.type == RDM_RESPONSE_TYPE_NONE) {
+            devices_remaining = false;  // Every device in the branch is muted
+          } else if (ack.type == RDM_RESPONSE_TYPE_ACK &&
+                     rdm_uid_is_eq(&ack.src_uid, &dest_uid)) {
+            break;  // The device did not stay muted so keep branching
+          }
         }
 #endif
 
@@ -176,13 +284,27 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
 
   xSemaphoreGiveRecursive(driver->mux);
 
-#ifndef CONFIG_RDM_STATIC_DISCOVERY_INSTRUCTIONS
-  free(stack);
-#endif
+  // Record the statistics of this run and release the stack
+  stats.found = num_found;
+  stats.retry_limit = rdm_disc_get_retries(&previous, &stats);
+  stats.duration = dmx_timer_get_micros_since_boot() - start_timestamp;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  rdm_disc_stats[dmx_num] = stats;
+  driver->rdm.disc_is_active = false;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return num_found;
 }
 
+int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
+                               void *context) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(cb != NULL, 0, "cb is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  return rdm_discover(dmx_num, cb, context, true);
+}
+
 struct rdm_disc_default_ctx {
   unsigned int num;
   rdm_uid_t *uids;
@@ -196,6 +318,18 @@ static void rdm_disc_cb(dmx_port_t dmx_num, rdm_uid_t uid, int num_found,
   }
 }
 
+bool rdm_discover_get_stats(dmx_port_t dmx_num, rdm_disc_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  *stats = rdm_disc_stats[dmx_num];
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
 int rdm_discover_devices_simple(dmx_port_t dmx_num, rdm_uid_t *uids,
                                 unsigned int num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
@@ -205,4 +339,403 @@ int rdm_discover_devices_simple(dmx_port_t dmx_num, rdm_uid_t *uids,
   int found = rdm_discover_with_callback(dmx_num, &rdm_disc_cb, &context);
 
   return found;
-}
\ No newline at end of file
+}
+
+// The discovery of a single DMX port when discovering every port in parallel.
+struct rdm_disc_port_ctx {
+  dmx_port_t dmx_num;
+  rdm_disc_cb_t cb;
+  void *context;
+  SemaphoreHandle_t done;  // Given when discovery of this port is complete.
+  int found;  // The number of devices found on this port.
+};
+
+static void rdm_disc_port_task(void *arg) {
+  struct rdm_disc_port_ctx *const port = arg;
+  port->found = rdm_discover(port->dmx_num, port->cb, port->context, true);
+  xSemaphoreGive(port->done);
+  vTaskDelete(NULL);
+}
+
+int rdm_discover_all_with_callback(rdm_disc_cb_t cb, void *context) {
+  DMX_CHECK(cb != NULL, 0, "cb is null");
+
+  SemaphoreHandle_t done = xSemaphoreCreateCounting(DMX_NUM_MAX, 0);
+  DMX_CHECK(done != NULL, 0, "discovery semaphore malloc error");
+
+  // Discover all but the first port in separate tasks
+  struct rdm_disc_port_ctx ports[DMX_NUM_MAX] = {};
+  struct rdm_disc_port_ctx *local = NULL;
+  int num_tasks = 0;
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    if (!dmx_driver_is_installed(dmx_num)) {
+      continue;
+    }
+    struct rdm_disc_port_ctx *const port = &ports[dmx_num];
+    *port = (struct rdm_disc_port_ctx){
+        .dmx_num = dmx_num, .cb = cb, .context = context, .done = done};
+    if (local == NULL) {
+      local = port;
+    } else if (xTaskCreate(rdm_disc_port_task, "rdm_disc", 4096, port,
+                           uxTaskPriorityGet(NULL), NULL) == pdPASS) {
+      ++num_tasks;
+    } else {
+      // Discover the port on this task if its task could not be created
+      DMX_WARN("discovery task malloc error");
+      port->found = rdm_discover(dmx_num, cb, context, true);
+    }
+  }
+
+  // Discover the first port on this task and then wait for the others
+  if (local != NULL) {
+    local->found = rdm_discover(local->dmx_num, cb, context, true);
+  }
+  for (int i = 0; i < num_tasks; ++i) {
+    xSemaphoreTake(done, portMAX_DELAY);
+  }
+  vSemaphoreDelete(done);
+
+  int found = 0;
+  for (dmx_port_t dmx_num = 0; dmx_num < DMX_NUM_MAX; ++dmx_num) {
+    found += ports[dmx_num].found;
+  }
+
+  return found;
+}
+
+struct rdm_disc_all_ctx {
+  dmx_spinlock_t spinlock;  // Guards the merged results.
+  unsigned int num;
+  unsigned int found;
+  rdm_uid_t *uids;
+  dmx_port_t *ports;
+};
+
+static void rdm_disc_all_cb(dmx_port_t dmx_num, rdm_uid_t uid, int num_found,
+                            const rdm_disc_mute_t *mute, void *context) {
+  struct rdm_disc_all_ctx *c = (struct rdm_disc_all_ctx *)context;
+  taskENTER_CRITICAL(&c->spinlock);
+  if (c->found < c->num) {
+    if (c->uids != NULL) {
+      c->uids[c->found] = uid;
+    }
+    if (c->ports != NULL) {
+      c->ports[c->found] = dmx_num;
+    }
+  }
+  ++c->found;
+  taskEXIT_CRITICAL(&c->spinlock);
+}
+
+int rdm_discover_all_devices_simple(rdm_uid_t *uids, dmx_port_t *ports,
+                                    unsigned int num) {
+  struct rdm_disc_all_ctx context = {.spinlock = DMX_SPINLOCK_INIT,
+                                     .num = num,
+                                     .uids = uids,
+                                     .ports = ports};
+  int found = rdm_discover_all_with_callback(&rdm_disc_all_cb, &context);
+
+  return found;
+}
+// The Table of Devices which is maintained by background discovery.
+struct rdm_tod_t {
+  TaskHandle_t task;  // The background discovery task, or NULL once it exits.
+  bool is_running;  // False once the background discovery task must exit.
+  bool is_dirty;  // True if the TOD has changed since it was last persisted.
+  rdm_tod_config_t config;  // The configuration of background discovery.
+  size_t count;  // The number of devices in the TOD.
+  rdm_tod_device_t devices[];  // The devices in the TOD.
+};
+
+// The TOD is persisted as a count followed by an array of devices. The PID of
+// RDM_PID_DISC_UNIQUE_BRANCH is used as the NVS key because it has no value.
+typedef struct rdm_tod_nvs_t {
+  uint32_t count;
+  rdm_tod_device_t devices[];
+} rdm_tod_nvs_t;
+
+// Loads the TOD from NVS. The TOD must not yet be visible to other tasks.
+static void rdm_tod_load(dmx_port_t dmx_num, struct rdm_tod_t *tod) {
+  const size_t size =
+      sizeof(rdm_tod_nvs_t) + sizeof(rdm_tod_device_t) * tod->config.max_devices;
+  rdm_tod_nvs_t *nvs = malloc(size);
+  if (nvs == NULL) {
+    DMX_WARN("RDM TOD malloc error");
+    return;
+  }
+  const size_t read =
+      dmx_nvs_get(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_DISC_UNIQUE_BRANCH, nvs,
+                  size);
+  if (read >= sizeof(rdm_tod_nvs_t)) {
+    size_t count = (read - sizeof(rdm_tod_nvs_t)) / sizeof(rdm_tod_device_t);
+    if (nvs->count < count) {
+      count = nvs->count;
+    }
+    memcpy(tod->devices, nvs->devices, count * sizeof(rdm_tod_device_t));
+    tod->count = count;
+  }
+  free(nvs);
+}
+
+// Saves the TOD to NVS if it has changed since it was last saved.
+static void rdm_tod_save(dmx_port_t dmx_num, struct rdm_tod_t *tod) {
+  if (!tod->config.persist || !tod->is_dirty) {
+    return;
+  }
+
+  // An empty TOD is stored with one unused device so that it is stored as a
+  // blob. Only the background discovery task modifies the TOD.
+  const size_t num = tod->count > 0 ? tod->count : 1;
+  const size_t size = sizeof(rdm_tod_nvs_t) + sizeof(rdm_tod_device_t) * num;
+  rdm_tod_nvs_t *nvs = calloc(1, size);
+  if (nvs == NULL) {
+    DMX_WARN("RDM TOD malloc error");
+    return;
+  }
+  nvs->count = tod->count;
+  memcpy(nvs->devices, tod->devices, tod->count * sizeof(rdm_tod_device_t));
+  if (dmx_nvs_set(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_DISC_UNIQUE_BRANCH, nvs,
+                  size)) {
+    tod->is_dirty = false;
+  } else {
+    DMX_WARN("unable to save the RDM TOD to NVS");
+  }
+  free(nvs);
+}
+
+// Adds a UID which was found by discovery to the TOD.
+static void rdm_tod_disc_cb(dmx_port_t dmx_num, rdm_uid_t uid, int num_found,
+                            const rdm_disc_mute_t *mute, void *context) {
+  struct rdm_tod_t *const tod = context;
+
+  // Only the background discovery task modifies the TOD
+  for (size_t i = 0; i < tod->count; ++i) {
+    if (rdm_uid_is_eq(&tod->devices[i].uid, &uid)) {
+      return;  // The device is already in the TOD
+    }
+  }
+  if (tod->count == tod->config.max_devices) {
+    DMX_WARN("RDM TOD is full");
+    return;
+  }
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  tod->devices[tod->count] = (rdm_tod_device_t){.uid = uid};
+  ++tod->count;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  tod->is_dirty = true;
+  rdm_cache_invalidate(dmx_num, &uid);
+
+  if (tod->config.cb != NULL) {
+    tod->config.cb(dmx_num, uid, RDM_TOD_DEVICE_ADDED, tod->config.context);
+  }
+}
+
+// Confirms the devices in the TOD and searches for devices added to the RDM
+// network. Known devices are muted directly so that only new devices respond
+// to discovery. A full pass un-mutes all devices first so that devices which
+// were muted by another controller are also found.
+static void rdm_tod_update(dmx_port_t dmx_num, struct rdm_tod_t *tod,
+                           bool is_full) {
+  if (is_full) {
+    rdm_send_disc_un_mute(dmx_num, &RDM_UID_BROADCAST_ALL, NULL, NULL);
+  }
+
+  // Mute each known device and remove the devices which do not respond
+  for (size_t i = 0; i < tod->count && tod->is_running;) {
+    const rdm_uid_t uid = tod->devices[i].uid;
+    rdm_disc_mute_t mute;
+    rdm_ack_t ack;
+    int attempts = 0;
+    do {
+      rdm_send_disc_mute(dmx_num, &uid, &mute, &ack);
+    } while (ack.type == RDM_RESPONSE_TYPE_NONE && ++attempts < 3);
+    if (ack.type != RDM_RESPONSE_TYPE_NONE) {
+      ++i;
+      continue;
+    }
+
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    --tod->count;
+    memmove(&tod->devices[i], &tod->devices[i + 1],
+            (tod->count - i) * sizeof(rdm_tod_device_t));
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    tod->is_dirty = true;
+    rdm_cache_invalidate(dmx_num, &uid);
+    if (tod->config.cb != NULL) {
+      tod->config.cb(dmx_num, uid, RDM_TOD_DEVICE_REMOVED,
+                     tod->config.context);
+    }
+  }
+
+  // Only devices which are not yet in the TOD respond to discovery
+  if (tod->is_running) {
+    rdm_discover(dmx_num, rdm_tod_disc_cb, tod, false);
+  }
+
+  // Get the device info of devices which were added to the TOD
+  for (size_t i = 0; i < tod->count && tod->is_running; ++i) {
+    if (tod->devices[i].has_device_info) {
+      continue;
+    }
+    const rdm_uid_t uid = tod->devices[i].uid;
+    rdm_device_info_t device_info;
+    rdm_ack_t ack;
+    if (rdm_send_get_device_info(dmx_num, &uid, RDM_SUB_DEVICE_ROOT,
+                                 &device_info, &ack)) {
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      tod->devices[i].device_info = device_info;
+      tod->devices[i].has_device_info = true;
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      tod->is_dirty = true;
+    }
+  }
+
+  rdm_tod_save(dmx_num, tod);
+}
+
+static void rdm_tod_task(void *arg) {
+  const dmx_port_t dmx_num = (dmx_port_t)(uintptr_t)arg;
+  struct rdm_tod_t *const tod = dmx_driver[dmx_num]->tod;
+
+  for (unsigned int pass = 0; tod->is_running; ++pass) {
+    const unsigned int interval = tod->config.full_discovery_interval;
+    const bool is_full = pass == 0 || (interval > 0 && pass % interval == 0);
+    rdm_tod_update(dmx_num, tod, is_full);
+
+    // Wait for the next pass or until background discovery is notified
+    ulTaskNotifyTake(pdTRUE, tod->config.period);
+  }
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  tod->task = NULL;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  vTaskDelete(NULL);
+}
+
+bool rdm_tod_start(dmx_port_t dmx_num, const rdm_tod_config_t *config) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(config != NULL, false, "config is null");
+  DMX_CHECK(config->max_devices > 0, false, "config->max_devices error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->tod == NULL, false, "RDM TOD is already started");
+
+  // Allocate the TOD
+  struct rdm_tod_t *tod =
+      malloc(sizeof(*tod) + sizeof(rdm_tod_device_t) * config->max_devices);
+  DMX_CHECK(tod != NULL, false, "RDM TOD malloc error");
+  tod->is_running = true;
+  tod->is_dirty = false;
+  tod->config = *config;
+  tod->count = 0;
+
+  // Devices in a persisted TOD may be addressed before they are confirmed
+  if (config->persist) {
+    rdm_tod_load(dmx_num, tod);
+  }
+  driver->tod = tod;
+
+  // Start background discovery at a low priority
+  if (xTaskCreate(rdm_tod_task, "rdm_tod", 4096, (void *)(uintptr_t)dmx_num,
+                  tskIDLE_PRIORITY + 1, &tod->task) != pdPASS) {
+    driver->tod = NULL;
+    free(tod);
+    DMX_CHECK(false, false, "RDM TOD task create error");
+  }
+
+  return true;
+}
+
+bool rdm_tod_stop(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  struct rdm_tod_t *const tod = driver->tod;
+  if (tod == NULL) {
+    return false;
+  }
+
+  // Wait for the current discovery transaction to finish and the task to exit
+  tod->is_running = false;
+  while (true) {
+    TaskHandle_t task;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    task = tod->task;
+    if (task != NULL) {
+      xTaskNotifyGive(task);
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (task == NULL) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+
+  driver->tod = NULL;
+  free(tod);
+
+  return true;
+}
+
+bool rdm_tod_refresh(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  struct rdm_tod_t *const tod = dmx_driver[dmx_num]->tod;
+  if (tod == NULL) {
+    return false;
+  }
+  TaskHandle_t task;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  task = tod->task;
+  if (task != NULL) {
+    xTaskNotifyGive(task);
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return task != NULL;
+}
+
+size_t rdm_tod_get(dmx_port_t dmx_num, rdm_uid_t *uids, size_t size) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(uids != NULL || size == 0, 0, "uids is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  struct rdm_tod_t *const tod = dmx_driver[dmx_num]->tod;
+  if (tod == NULL) {
+    return 0;
+  }
+
+  size_t count;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  count = tod->count;
+  for (size_t i = 0; i < count && i < size; ++i) {
+    uids[i] = tod->devices[i].uid;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+}
+
+size_t rdm_tod_get_devices(dmx_port_t dmx_num, rdm_tod_device_t *devices,
+                           size_t size) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(devices != NULL || size == 0, 0, "devices is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  struct rdm_tod_t *const tod = dmx_driver[dmx_num]->tod;
+  if (tod == NULL) {
+    return 0;
+  }
+
+  size_t count;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  count = tod->count;
+  memcpy(devices, tod->devices,
+         (count < size ? count : size) * sizeof(rdm_tod_device_t));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file rdm/controller/include/async.h
+ * @author Mitch Weisbrod
+ * @brief This file contains functions to send RDM controller requests without
+ * blocking the calling task. Requests are queued and sent in order by an RDM
+ * controller task on each DMX port. The results are delivered to a callback, a
+ * FreeRTOS queue, or both.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "dmx/include/types.h"
+#include "rdm/controller.h"
+#include "rdm/include/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief A handle to an asynchronous RDM request. Evaluates to 0 if the
+ * request could not be queued.*/
+typedef uint32_t rdm_async_handle_t;
+
+/** @brief The result of an asynchronous RDM request.*/
+typedef struct rdm_async_result_t {
+  /** @brief The handle which was returned when the request was queued.*/
+  rdm_async_handle_t handle;
+  /** @brief The value that rdm_send_request() would have returned. It is the
+     response PDL, or true if there was no parameter data, when an
+     RDM_RESPONSE_TYPE_ACK was received. It is 0 otherwise.*/
+  size_t ret;
+  /** @brief Information about the RDM response.*/
+  rdm_ack_t ack;
+  /** @brief The user context which was provided with the request.*/
+  void *context;
+  /** @brief The parameter data of the response, decoded with the response
+     format string.*/
+  uint8_t pd[RDM_PD_SIZE_MAX];
+} rdm_async_result_t;
+
+/**
+ * @brief A callback function type for use with rdm_send_request_async(). The
+ * callback is invoked from the RDM controller task of the DMX port. It should
+ * return quickly because the next request is not sent until it returns.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] result A pointer to the result of the request. It is only valid
+ * until the callback returns.
+ * @param[inout] context A pointer to a user context.
+ */
+typedef void (*rdm_async_cb_t)(dmx_port_t dmx_num,
+                               const rdm_async_result_t *result,
+                               void *context);
+
+/**
+ * @brief Queues an RDM controller request and returns without waiting for the
+ * response. Requests are sent in the order they were queued by an RDM
+ * controller task which is started when the first request is queued on a DMX
+ * port. The request and its parameter data are copied so they need not remain
+ * valid after this function returns, though the format strings must.
+ *
+ * When the transaction is complete, an rdm_async_result_t is passed to the
+ * callback and then sent to the queue, if either is provided. The queue must
+ * be created with an item size of sizeof(rdm_async_result_t). If the queue is
+ * full, the result is not sent to it.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] request A pointer to a request constructor.
+ * @param[in] format The RDM parameter format string for the response data.
+ * @param cb A callback which is invoked with the result. May be NULL.
+ * @param queue A queue which receives the result. May be NULL.
+ * @param[inout] context A pointer to a user context which is provided in the
+ * result.
+ * @return A handle to the request or 0 if the request could not be queued.
+ */
+rdm_async_handle_t rdm_send_request_async(dmx_port_t dmx_num,
+                                          const rdm_request_t *request,
+                                          const char *format, rdm_async_cb_t cb,
+                                          QueueHandle_t queue, void *context);
+
+/**
+ * @brief Gets the number of asynchronous RDM requests which have been queued
+ * on a DMX port but have not yet completed.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of pending requests.
+ */
+size_t rdm_async_get_pending(dmx_port_t dmx_num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,6 +31,91 @@ extern "C" {
 typedef void (*rdm_disc_cb_t)(dmx_port_t dmx_num, rdm_uid_t uid, int num_found,
                               const rdm_disc_mute_t *mute, void *context);
 
+/** @brief Statistics about a run of the RDM discovery algorithm.*/
+typedef struct rdm_disc_stats_t {
+  /** @brief The number of RDM_PID_DISC_UNIQUE_BRANCH requests which were sent,
+     including retries.*/
+  uint32_t branches;
+  /** @brief The number of RDM_PID_DISC_UNIQUE_BRANCH requests which received
+     no response.*/
+  uint32_t empty;
+  /** @brief The number of RDM_PID_DISC_UNIQUE_BRANCH requests which received a
+     response from a single device.*/
+  uint32_t clean;
+  /** @brief The number of RDM_PID_DISC_UNIQUE_BRANCH requests which received
+     colliding responses from multiple devices.*/
+  uint32_t collisions;
+  /** @brief The number of responses which were partial or corrupted by a DMX
+     error. Used to estimate the bus error rate.*/
+  uint32_t partial;
+  /** @brief The number of RDM_PID_DISC_MUTE requests which were sent, including
+     retries.*/
+  uint32_t mutes;
+  /** @brief The number of requests which were retried.*/
+  uint32_t retries;
+  /** @brief The number of devices which were found.*/
+  uint32_t found;
+  /** @brief The number of retries that the bus error rate allowed at the end of
+     the run.*/
+  int retry_limit;
+  /** @brief The duration of the run in microseconds.*/
+  int64_t duration;
+} rdm_disc_stats_t;
+
+/** @brief The events which are raised when the Table of Devices changes.*/
+typedef enum rdm_tod_event_t {
+  /** @brief A device was added to the Table of Devices.*/
+  RDM_TOD_DEVICE_ADDED,
+  /** @brief A device was removed from the Table of Devices.*/
+  RDM_TOD_DEVICE_REMOVED,
+} rdm_tod_event_t;
+
+/**
+ * @brief A callback function type for use with rdm_tod_start(). It is called
+ * from the background discovery task.
+ *
+ * @param dmx_num The DMX port number.
+ * @param uid The UID of the device which was added or removed.
+ * @param event The change to the Table of Devices.
+ * @param[inout] context A pointer to a user context.
+ */
+typedef void (*rdm_tod_cb_t)(dmx_port_t dmx_num, rdm_uid_t uid,
+                             rdm_tod_event_t event, void *context);
+
+/** @brief The configuration of background discovery and its Table of
+ * Devices.*/
+typedef struct rdm_tod_config_t {
+  /** @brief The maximum number of devices in the Table of Devices.*/
+  size_t max_devices;
+  /** @brief The number of FreeRTOS ticks to wait between discovery passes.*/
+  TickType_t period;
+  /** @brief The number of passes between full discoveries, which un-mute all
+     devices before searching. The first pass is always a full discovery. Set
+     to 0 to never perform another full discovery.*/
+  unsigned int full_discovery_interval;
+  /** @brief A callback which is called when a device is added or removed. May
+     be NULL.*/
+  rdm_tod_cb_t cb;
+  /** @brief A pointer to a user context which is passed to the callback.*/
+  void *context;
+  /** @brief True to persist the Table of Devices in non-volatile storage. The
+     stored devices are loaded when background discovery is started so that
+     they may be addressed before the first discovery pass completes. Devices
+     which are no longer present are removed by the first pass.*/
+  bool persist;
+} rdm_tod_config_t;
+
+/** @brief A device in the Table of Devices.*/
+typedef struct rdm_tod_device_t {
+  /** @brief The UID of the device.*/
+  rdm_uid_t uid;
+  /** @brief True if the device info of the device has been received.*/
+  bool has_device_info;
+  /** @brief The device info of the root device, which was received when the
+     device was added to the Table of Devices.*/
+  rdm_device_info_t device_info;
+} rdm_tod_device_t;
+
 /**
  * @brief Sends an RDM discovery unique branch request and reads the response,
  * if any.
@@ -107,9 +192,9 @@ bool rdm_send_disc_un_mute(dmx_port_t dmx_num, const rdm_uid_t *dest_uid,
  * the standards document algorithm because it is iterative instead of
  * recursive. This significantly reduces the memory needed to perform the
  * discovery algorithm which allows it to be safely performed on an embedded
- * platform. However, the iterative algorithm still requires the allocation of
- * 588 bytes. By default, this is heap allocated but may be allocated on the
- * stack by configuring settings in this library's Kconfig.
+ * platform. The 588 bytes that the iterative algorithm requires are allocated
+ * with the DMX driver of each port, so discovery may run on several ports at
+ * once. Concurrent discoveries on the same port are run one at a time.
  *
  * @param dmx_num The DMX port number.
  * @param cb A callback function which is called when a new device is found.
@@ -129,9 +214,9 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
  * the standards document algorithm because it is iterative instead of
  * recursive. This significantly reduces the memory needed to perform the
  * discovery algorithm which allows it to be safely performed on an embedded
- * platform. However, the iterative algorithm still requires the allocation of
- * 588 bytes. By default, this is heap allocated but may be allocated on the
- * stack by configuring settings in this library's Kconfig.
+ * platform. The 588 bytes that the iterative algorithm requires are allocated
+ * with the DMX driver of each port, so discovery may run on several ports at
+ * once. Concurrent discoveries on the same port are run one at a time.
  *
  * @param dmx_num The DMX port number.
  * @param[out] uids An array of UIDs used to store found device UIDs.
@@ -141,6 +226,118 @@ int rdm_discover_with_callback(dmx_port_t dmx_num, rdm_disc_cb_t cb,
 int rdm_discover_devices_simple(dmx_port_t dmx_num, rdm_uid_t *uids,
                                 unsigned int num);
 
+/**
+ * @brief Performs the RDM device discovery algorithm on every installed DMX
+ * port in parallel and executes a callback function whenever a new device is
+ * discovered. The first port is discovered on the calling task and each other
+ * port is discovered on a task at the priority of the calling task. Because
+ * the ports are discovered in parallel, the callback may be called from
+ * several tasks at once. This function returns once discovery is complete on
+ * every port.
+ *
+ * @param cb A callback function which is called when a new device is found.
+ * @param[inout] context Context which is passed to the callback function when a
+ * new device is found.
+ * @return The total number of devices found on every port.
+ */
+int rdm_discover_all_with_callback(rdm_disc_cb_t cb, void *context);
+
+/**
+ * @brief Performs the RDM device discovery algorithm on every installed DMX
+ * port in parallel and merges the UIDs of the found devices into a single
+ * array. The DMX port on which each device was found is stored at the same
+ * index of an optional array of ports.
+ *
+ * @param[out] uids An array of UIDs used to store found device UIDs.
+ * @param[out] ports An array used to store the DMX port of each found device.
+ * May be NULL.
+ * @param num The number of elements of the provided arrays.
+ * @return The total number of devices found on every port.
+ */
+int rdm_discover_all_devices_simple(rdm_uid_t *uids, dmx_port_t *ports,
+                                    unsigned int num);
+
+/**
+ * @brief Gets statistics about the most recent run of the RDM discovery
+ * algorithm on the DMX port, including runs made by background discovery.
+ *
+ * Discovery adapts its retry policy to the bus. Requests which receive no
+ * response are only retried when responses are being corrupted by bus errors,
+ * partial responses are retried at least once, and collisions are never
+ * retried because they are resolved by branching. Up to two retries are used
+ * until enough requests have been observed to estimate the bus error rate.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer which stores the statistics.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_discover_get_stats(dmx_port_t dmx_num, rdm_disc_stats_t *stats);
+
+/**
+ * @brief Starts background discovery, which maintains a Table of Devices (TOD)
+ * on the DMX port. A low priority task performs a full discovery and then
+ * periodically confirms each device in the TOD with an RDM_PID_DISC_MUTE
+ * request. Devices which do not respond are removed from the TOD. Because known
+ * devices are muted, the search for new devices which follows only needs to
+ * branch toward devices which are not yet in the TOD. Discovery traffic is
+ * therefore proportional to the changes on the RDM network rather than to its
+ * size. The device info of each device is requested when the device is added.
+ * Other discovery functions should not be called on the DMX port while
+ * background discovery is running.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] config A pointer to the configuration of background discovery.
+ * @return true if background discovery was started.
+ * @return false on failure.
+ */
+bool rdm_tod_start(dmx_port_t dmx_num, const rdm_tod_config_t *config);
+
+/**
+ * @brief Stops background discovery and frees the Table of Devices. This
+ * function blocks until the current discovery transaction is complete.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if background discovery was stopped.
+ * @return false if background discovery was not running.
+ */
+bool rdm_tod_stop(dmx_port_t dmx_num);
+
+/**
+ * @brief Wakes background discovery so that the Table of Devices is updated
+ * without waiting for the next discovery pass.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true if background discovery was woken.
+ * @return false if background discovery is not running.
+ */
+bool rdm_tod_refresh(dmx_port_t dmx_num);
+
+/**
+ * @brief Copies the UIDs in the Table of Devices.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] uids An array which stores the UIDs in the Table of Devices.
+ * @param size The number of elements in the array.
+ * @return The number of UIDs in the Table of Devices, which may be larger than
+ * the number of UIDs that were copied.
+ */
+size_t rdm_tod_get(dmx_port_t dmx_num, rdm_uid_t *uids, size_t size);
+
+/**
+ * @brief Copies the devices in the Table of Devices, including their device
+ * info.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] devices An array which stores the devices in the Table of
+ * Devices.
+ * @param size The number of elements in the array.
+ * @return The number of devices in the Table of Devices, which may be larger
+ * than the number of devices that were copied.
+ */
+size_t rdm_tod_get_devices(dmx_port_t dmx_num, rdm_tod_device_t *devices,
+                           size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,27 +16,16 @@
 extern "C" {
 #endif
 
-/**
- * @brief Type for constructing an RDM request. Contains all the necessary
- * information needed to address a request on the RDM bus.
- */
-typedef struct rdm_request_t {
-  const rdm_uid_t *dest_uid;    // The destination UID of the request.
-  rdm_sub_device_t sub_device;  // The target sub-device of the request.
-  rdm_cc_t cc;                  // The command class of the request.
-  rdm_pid_t pid;                // The parameter ID.
-  const char *format;           // The format string for the parameter data.
-  const void *pd;  // A pointer to the parameter data of the request.
-  size_t pdl;      // The parameter data length of the request.
-} rdm_request_t;
-
 /**
  * @brief Sends an RDM controller request and processes the response. This
  * function writes, sends, receives, and reads a request and response RDM
  * packet. It performs error checking on the written packet to ensure that it
  * adheres to RDM specification and prevents RDM bus errors. Any parameter data
  * received in the RDM response must be read by using rdm_read_pd(). An
- * rdm_ack_t is provided to process DMX and RDM errors.
+ * rdm_ack_t is provided to process DMX and RDM errors. If the responder replies
+ * with RDM_RESPONSE_TYPE_ACK_OVERFLOW, the request is repeated until the final
+ * page is received and the parameter data of every page is concatenated into
+ * the pd array, so the pd array may need to be larger than a single RDM packet.
  * - ack.err will evaluate to true if an error occurred during the sending or
  *   receiving of raw DMX data. RDM data will not be processed if an error
  *   occurred. If a response was expected but none was received, ack.err will
@@ -58,7 +47,7 @@ typedef struct rdm_request_t {
  * - ack.pdl, ack.timer and ack.nack_reason are a union which should be read
  * depending on the value of ack.type. If ack.type is RDM_RESPONSE_TYPE_ACK,
  * ack.pdl should be read. ack.pdl is the parameter data length of the RDM
- * response. If ack.type is RDM_RESPONSE_TYPE_ACK_TIMER, ack.timer should be
+ * response, summed across all pages of an overflowed response. If ack.type is RDM_RESPONSE_TYPE_ACK_TIMER, ack.timer should be
  * read. ack.timer is the estimated amount of time in FreeRTOS ticks until the
  * responder is able to provide a response to the request. If ack.type is
  * RDM_RESPONSE_TYPE_NACK_REASON, ack.nack_reason should be read to get the NACK
@@ -81,6 +70,110 @@ size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
                         const char *format, void *pd, size_t size,
                         rdm_ack_t *ack);
 
+/**
+ * @brief Sends a batch of RDM controller requests back-to-back. The driver
+ * mutex is taken, continuous sending is paused, and the DMX packet of the
+ * application is swapped out only once for the whole batch. Each request is
+ * sent as soon as the RDM packet spacing allows. Requests which differ from the
+ * previous request only by their destination UID reuse its encoded packet, so
+ * sweeping a PID across many responders needs no packet encoding after the
+ * first request. The results of each request are written to the corresponding
+ * element of the output arrays. See rdm_send_request() for more information.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] requests An array of request constructors.
+ * @param count The number of requests in the array.
+ * @param[in] format The RDM parameter format string for the response data of
+ * every request.
+ * @param[out] pds An array of count elements of size bytes which stores the
+ * parameter data received in each response. May be NULL if size is 0.
+ * @param size The size of each element of the pds array.
+ * @param[out] acks An array of count rdm_ack_t which stores information about
+ * each response. May be NULL.
+ * @return The number of requests which received an RDM_RESPONSE_TYPE_ACK.
+ */
+size_t rdm_send_request_batch(dmx_port_t dmx_num,
+                              const rdm_request_t *requests, size_t count,
+                              const char *format, void *pds, size_t size,
+                              rdm_ack_t *acks);
+
+/**
+ * @brief Enables the cache of GET responses of the RDM controller. While the
+ * cache is enabled, rdm_send_request() answers GET requests for parameters
+ * which describe a responder, such as RDM_PID_DEVICE_INFO, labels,
+ * RDM_PID_SUPPORTED_PARAMETERS, and personality or sensor descriptions, from
+ * the cache instead of sending them on the RDM bus. Responses are cached by
+ * UID, sub-device, PID, and request parameter data. The cached responses of a
+ * responder are invalidated when a SET request is sent to it, when its
+ * response has a message count which is not 0, and when it is added to or
+ * removed from the Table of Devices. When every entry is in use, the entry
+ * which was least recently used is replaced.
+ *
+ * @note Responses with more than 231 bytes of parameter data and responses to
+ * requests with more than 4 bytes of parameter data are not cached.
+ *
+ * @param dmx_num The DMX port number.
+ * @param count The number of responses which may be cached.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_cache_enable(dmx_port_t dmx_num, size_t count);
+
+/**
+ * @brief Disables the cache of GET responses of the RDM controller and frees
+ * the cached responses.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_cache_disable(dmx_port_t dmx_num);
+
+/**
+ * @brief Invalidates the cached responses of the RDM controller which were
+ * received from a responder. A broadcast UID invalidates the cached responses
+ * of every responder which it addresses. This function does nothing if the
+ * cache is disabled.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid A pointer to the UID of the responder.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_cache_invalidate(dmx_port_t dmx_num, const rdm_uid_t *uid);
+
+/**
+ * @brief Reads the counters of the cache of GET responses of the RDM
+ * controller.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] stats A pointer to an rdm_cache_stats_t into which the counters
+ * are copied.
+ * @return true on success.
+ * @return false on failure or if the cache is disabled.
+ */
+bool rdm_cache_get_stats(dmx_port_t dmx_num, rdm_cache_stats_t *stats);
+
+/**
+ * @brief Configures how RDM requests are interleaved with DMX packets which
+ * are sent on the DMX port. When enabled, each call to rdm_send_request() waits
+ * until the configured number of DMX packets have been sent since the last RDM
+ * transaction so that RDM traffic does not collapse the DMX refresh rate. When
+ * a minimum DMX refresh rate is provided, additional DMX packets are sent
+ * between RDM transactions as needed to keep the average refresh rate above it.
+ * Requests are not delayed while DMX packets are not being sent.
+ *
+ * @param dmx_num The DMX port number.
+ * @param dmx_frames_per_rdm The number of DMX packets to send between RDM
+ * transactions or 0 to send RDM transactions as soon as they are requested.
+ * @param min_refresh_rate The minimum DMX refresh rate in hertz or 0 to not
+ * preserve a minimum refresh rate.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_set_schedule(dmx_port_t dmx_num, uint32_t dmx_frames_per_rdm,
+                      uint32_t min_refresh_rate);
+
 /**
  * @brief Get the transaction number of the RDM controller. This number is
  * included in every RDM controller request. It is incremented after every RDM
@@ -92,6 +185,52 @@ size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
  */
 uint32_t rdm_get_transaction_num(dmx_port_t dmx_num);
 
+/**
+ * @brief Reads the round-trip statistics of the RDM requests which were sent to
+ * each responder UID. Statistics are kept for up to RDM_LATENCY_UIDS UIDs. When
+ * every entry is in use, the UID which was least recently sent a request is
+ * replaced. Requests which were broadcast without expecting a response and
+ * RDM_PID_DISC_UNIQUE_BRANCH requests are not measured. Each page of an
+ * RDM_RESPONSE_TYPE_ACK_OVERFLOW response is measured as its own request.
+ *
+ * @note The RDM_LATENCY_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] entries An array of count rdm_uid_latency_t into which the
+ * statistics are copied.
+ * @param count The number of entries in the array.
+ * @return The number of entries which were copied.
+ */
+size_t rdm_get_uid_latency(dmx_port_t dmx_num, rdm_uid_latency_t *entries,
+                           size_t count);
+
+/**
+ * @brief Reads the round-trip statistics of the RDM requests which were sent
+ * for each PID. Statistics are kept for up to RDM_LATENCY_PIDS PIDs. When every
+ * entry is in use, the PID which was least recently requested is replaced.
+ *
+ * @note The RDM_LATENCY_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] entries An array of count rdm_pid_latency_t into which the
+ * statistics are copied.
+ * @param count The number of entries in the array.
+ * @return The number of entries which were copied.
+ */
+size_t rdm_get_pid_latency(dmx_port_t dmx_num, rdm_pid_latency_t *entries,
+                           size_t count);
+
+/**
+ * @brief Resets the round-trip statistics of every responder UID and PID.
+ *
+ * @note The RDM_LATENCY_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_reset_controller_latency(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
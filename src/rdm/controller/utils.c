@@ -1,15 +1,500 @@
 #include "rdm/controller/include/utils.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#include "dmx/hal/include/timer.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
 #include "rdm/include/driver.h"
 #include "rdm/include/uid.h"
 
-size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
-                        const char *format, void *pd, size_t size,
-                        rdm_ack_t *ack) {
+// Swaps the RDM request buffer with the DMX buffer of the driver so that RDM
+// requests neither overwrite nor copy the DMX packet of the application.
+static void rdm_swap_buffers(dmx_port_t dmx_num, bool request_is_active) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  assert(driver->rdm.request_is_active != request_is_active);
+  uint8_t *const data = driver->dmx.data;
+  driver->dmx.data = driver->rdm.data;
+  driver->rdm.data = data;
+  driver->rdm.request_is_active = request_is_active;
+  DMX_RDM_HEADER_INVALIDATE(driver);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+
+// Returns true if the request may be sent by an RDM controller.
+static bool rdm_request_is_valid(const rdm_request_t *request) {
+  return request->dest_uid != NULL &&
+         (request->sub_device < RDM_SUB_DEVICE_MAX ||
+          request->sub_device == RDM_SUB_DEVICE_ALL) &&
+         request->pid > 0 && rdm_cc_is_valid(request->cc) &&
+         rdm_cc_is_request(request->cc) &&
+         (request->sub_device != RDM_SUB_DEVICE_ALL ||
+          request->cc == RDM_CC_SET_COMMAND) &&
+         rdm_format_is_valid(request->format) &&
+         (request->format != NULL || request->pd == NULL) &&
+         (request->pd != NULL || request->pdl == 0) &&
+         request->pdl < RDM_PD_SIZE_MAX;
+}
+
+// Returns true if two requests encode to the same RDM packet except for their
+// destination UIDs and transaction numbers.
+static bool rdm_request_is_similar(const rdm_request_t *a,
+                                   const rdm_request_t *b) {
+  return a->sub_device == b->sub_device && a->cc == b->cc &&
+         a->pid == b->pid && a->pdl == b->pdl &&
+         (a->format == b->format ||
+          (a->format != NULL && b->format != NULL &&
+           strcmp(a->format, b->format) == 0)) &&
+         (a->pd == b->pd || memcmp(a->pd, b->pd, a->pdl) == 0);
+}
+
+// Replaces the destination UID and transaction number of an encoded RDM request
+// and updates its checksum without summing the rest of the packet.
+static void rdm_patch_request(uint8_t *data, size_t size,
+                              const rdm_uid_t *dest_uid, uint8_t tn) {
+  const uint8_t uid[6] = {dest_uid->man_id >> 8,  dest_uid->man_id,
+                          dest_uid->dev_id >> 24, dest_uid->dev_id >> 16,
+                          dest_uid->dev_id >> 8,  dest_uid->dev_id};
+  uint16_t checksum = (data[size - 2] << 8) | data[size - 1];
+  for (int i = 0; i < sizeof(uid); ++i) {
+    checksum += uid[i] - data[3 + i];
+    data[3 + i] = uid[i];
+  }
+  checksum += tn - data[15];
+  data[15] = tn;
+  data[size - 2] = checksum >> 8;
+  data[size - 1] = checksum;
+}
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+// Updates round-trip statistics with a request which received a response after
+// the round-trip time, or which timed out if the round-trip time is negative.
+static void rdm_latency_update(rdm_latency_t *latency, int64_t rtt,
+                               bool is_nack, int64_t now) {
+  ++latency->request_count;
+  latency->timestamp = now;
+  if (rtt < 0) {
+    ++latency->timeout_count;
+    return;
+  }
+  ++latency->response_count;
+  if (is_nack) {
+    ++latency->nack_count;
+  }
+  const uint32_t micros = rtt > UINT32_MAX ? UINT32_MAX : rtt;
+  if (latency->response_count == 1) {
+    latency->rtt_min = micros;
+    latency->rtt_avg = micros;
+    latency->rtt_max = micros;
+  } else {
+    if (micros < latency->rtt_min) {
+      latency->rtt_min = micros;
+    }
+    if (micros > latency->rtt_max) {
+      latency->rtt_max = micros;
+    }
+    // Exponential moving average with a weight of 1/16 per response
+    latency->rtt_avg = latency->rtt_avg - (latency->rtt_avg >> 4) + (micros >> 4);
+  }
+}
+
+// Records the round-trip time of an RDM request to its destination UID and its
+// PID. The entry which was least recently used is replaced when every entry is
+// in use. The packet must be NULL if no valid response was received.
+static void rdm_latency_record(dmx_driver_t *driver,
+                               const rdm_request_t *request,
+                               const dmx_packet_t *packet, bool is_nack) {
+  int64_t rtt = -1;
+  if (packet != NULL) {
+    dmx_driver_state_t state;
+    dmx_driver_get_state(driver, &state);
+    rtt = packet->eop_timestamp > state.controller_eop_timestamp
+              ? packet->eop_timestamp - state.controller_eop_timestamp
+              : 0;
+  }
+  const int64_t now = dmx_timer_get_micros_since_boot();
+  struct dmx_driver_latency_t *const latency = &driver->latency;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+
+  // Find the entry of the UID, or else a free or the least recently used entry.
+  // Discovery requests are addressed to a range of UIDs so they are skipped.
+  int oldest = 0;
+  if (request->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+    int u = -1;
+    for (int i = 0; i < latency->uid_count && u < 0; ++i) {
+      if (rdm_uid_is_eq(&latency->uids[i].uid, request->dest_uid)) {
+        u = i;
+      } else if (latency->uids[i].latency.timestamp <
+                 latency->uids[oldest].latency.timestamp) {
+        oldest = i;
+      }
+    }
+    if (u < 0) {
+      u = latency->uid_count < RDM_LATENCY_UIDS ? latency->uid_count++
+                                                  : oldest;
+      memset(&latency->uids[u], 0, sizeof(latency->uids[u]));
+      latency->uids[u].uid = *request->dest_uid;
+    }
+    rdm_latency_update(&latency->uids[u].latency, rtt, is_nack, now);
+  }
+
+  // Find the entry of the PID in the same way
+  int p = -1;
+  oldest = 0;
+  for (int i = 0; i < latency->pid_count && p < 0; ++i) {
+    if (latency->pids[i].pid == request->pid) {
+      p = i;
+    } else if (latency->pids[i].latency.timestamp <
+               latency->pids[oldest].latency.timestamp) {
+      oldest = i;
+    }
+  }
+  if (p < 0) {
+    p = latency->pid_count < RDM_LATENCY_PIDS ? latency->pid_count++ : oldest;
+    memset(&latency->pids[p], 0, sizeof(latency->pids[p]));
+    latency->pids[p].pid = request->pid;
+  }
+  rdm_latency_update(&latency->pids[p].latency, rtt, is_nack, now);
+
+  taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+}
+#endif
+
+// The maximum parameter data length of a request which may have its response
+// cached. Descriptive PIDs are requested with at most a 32-bit index.
+#define RDM_CACHE_KEY_PD_MAX (4)
+
+// A cached RDM response and the request to which it was received.
+typedef struct rdm_cache_entry_t {
+  rdm_uid_t uid;                 // The UID of the responder.
+  rdm_sub_device_t sub_device;   // The sub-device of the request.
+  rdm_pid_t pid;                 // The PID of the request.
+  uint8_t request_pdl;           // The parameter data length of the request.
+  uint8_t request_pd[RDM_CACHE_KEY_PD_MAX];  // The encoded request data.
+  uint32_t last_used;  // The use count when the entry was used, or 0 if free.
+  uint8_t pdl;         // The parameter data length of the response.
+  uint8_t pd[RDM_PD_SIZE_MAX];  // The parameter data of the response.
+} rdm_cache_entry_t;
+
+struct rdm_cache_t {
+  uint32_t uses;             // Increments each time an entry is used.
+  rdm_cache_stats_t stats;   // The counters which are read by the user.
+  size_t count;              // The number of entries of the cache.
+  rdm_cache_entry_t entries[];  // The entries of the cache.
+};
+
+// Returns true if the response to an RDM request may be cached. Only GET
+// requests for parameters which describe a responder are cached.
+static bool rdm_request_is_cacheable(const rdm_request_t *request) {
+  if (request->cc != RDM_CC_GET_COMMAND ||
+      rdm_uid_is_broadcast(request->dest_uid) ||
+      request->sub_device == RDM_SUB_DEVICE_ALL ||
+      request->pdl > RDM_CACHE_KEY_PD_MAX) {
+    return false;
+  }
+  switch (request->pid) {
+    case RDM_PID_SUPPORTED_PARAMETERS:
+    case RDM_PID_PARAMETER_DESCRIPTION:
+    case RDM_PID_DEVICE_INFO:
+    case RDM_PID_PRODUCT_DETAIL_ID_LIST:
+    case RDM_PID_DEVICE_MODEL_DESCRIPTION:
+    case RDM_PID_MANUFACTURER_LABEL:
+    case RDM_PID_DEVICE_LABEL:
+    case RDM_PID_LANGUAGE_CAPABILITIES:
+    case RDM_PID_SOFTWARE_VERSION_LABEL:
+    case RDM_PID_BOOT_SOFTWARE_VERSION_ID:
+    case RDM_PID_BOOT_SOFTWARE_VERSION_LABEL:
+    case RDM_PID_DMX_PERSONALITY:
+    case RDM_PID_DMX_PERSONALITY_DESCRIPTION:
+    case RDM_PID_DMX_START_ADDRESS:
+    case RDM_PID_SLOT_INFO:
+    case RDM_PID_SLOT_DESCRIPTION:
+    case RDM_PID_DEFAULT_SLOT_VALUE:
+    case RDM_PID_SENSOR_DEFINITION:
+    case RDM_PID_STATUS_ID_DESCRIPTION:
+    case RDM_PID_SELF_TEST_DESCRIPTION:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if the cache entry holds the response to the RDM request. The
+// request parameter data is compared in the format in which it is sent on the
+// RDM bus so that requests which were encoded in different ways are equal.
+static bool rdm_cache_entry_is_match(const rdm_cache_entry_t *entry,
+                                     const rdm_request_t *request,
+                                     const uint8_t *request_pd,
+                                     size_t request_pdl) {
+  return entry->last_used > 0 && entry->pid == request->pid &&
+         entry->sub_device == request->sub_device &&
+         entry->request_pdl == request_pdl &&
+         rdm_uid_is_eq(&entry->uid, request->dest_uid) &&
+         (request_pdl == 0 ||
+          memcmp(entry->request_pd, request_pd, request_pdl) == 0);
+}
+
+// Copies the cached parameter data of the response to an RDM request into a
+// buffer. Returns the parameter data length of the response, or -1 if the
+// response is not cached. The cache is left untouched if it is disabled.
+static int rdm_cache_lookup(dmx_port_t dmx_num, const rdm_request_t *request,
+                            const uint8_t *request_pd, size_t request_pdl,
+                            uint8_t *pd) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  int pdl = -1;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  struct rdm_cache_t *const cache = driver->cache;
+  if (cache != NULL) {
+    for (int i = 0; i < cache->count; ++i) {
+      rdm_cache_entry_t *const entry = &cache->entries[i];
+      if (rdm_cache_entry_is_match(entry, request, request_pd, request_pdl)) {
+        entry->last_used = ++cache->uses;
+        pdl = entry->pdl;
+        memcpy(pd, entry->pd, pdl);
+        break;
+      }
+    }
+    if (pdl < 0) {
+      ++cache->stats.miss_count;
+    } else {
+      ++cache->stats.hit_count;
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return pdl;
+}
+
+// Stores the parameter data of the response to an RDM request in the cache.
+// The entry which was least recently used is replaced when every entry is in
+// use.
+static void rdm_cache_insert(dmx_port_t dmx_num, const rdm_request_t *request,
+                             const uint8_t *request_pd, size_t request_pdl,
+                             const uint8_t *pd, size_t pdl) {
+  assert(request_pdl <= RDM_CACHE_KEY_PD_MAX);
+  assert(pdl < RDM_PD_SIZE_MAX);
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  struct rdm_cache_t *const cache = driver->cache;
+  if (cache != NULL && cache->count > 0) {
+    int e = 0;
+    for (int i = 0; i < cache->count; ++i) {
+      if (rdm_cache_entry_is_match(&cache->entries[i], request, request_pd,
+                                   request_pdl)) {
+        e = i;
+        break;
+      } else if (cache->entries[i].last_used <
+                 cache->entries[e].last_used) {
+        e = i;
+      }
+    }
+    rdm_cache_entry_t *const entry = &cache->entries[e];
+    entry->uid = *request->dest_uid;
+    entry->sub_device = request->sub_device;
+    entry->pid = request->pid;
+    entry->request_pdl = request_pdl;
+    memcpy(entry->request_pd, request_pd, request_pdl);
+    entry->last_used = ++cache->uses;
+    entry->pdl = pdl;
+    memcpy(entry->pd, pd, pdl);
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+
+// Sends the RDM request which has been written into the DMX buffer and
+// processes the response. If the responder replies with
+// RDM_RESPONSE_TYPE_ACK_OVERFLOW, the request is sent again with a new
+// transaction number until every page of the parameter data has been received.
+// The driver mutex must be held and the RDM buffer must be swapped into the DMX
+// driver.
+static size_t rdm_transact(dmx_port_t dmx_num, const rdm_request_t *request,
+                           const char *format, void *pd, size_t size,
+                           rdm_ack_t *ack) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Keep a copy of the request in case it must be sent again
+  uint8_t request_data[RDM_PD_SIZE_MAX + 26];
+  const size_t request_size = driver->dmx.data[2] + 2;  // Include checksum
+  memcpy(request_data, driver->dmx.data, request_size);
+
+  // A SET request may change the responses which were cached
+  if (request->cc == RDM_CC_SET_COMMAND) {
+    rdm_cache_invalidate(dmx_num, request->dest_uid);
+  }
+
+  // The raw parameter data of every page is kept so it may be cached
+  const bool is_cacheable = rdm_request_is_cacheable(request) &&
+                            request_data[23] <= RDM_CACHE_KEY_PD_MAX;
+  uint8_t raw_pd[RDM_PD_SIZE_MAX];
+  bool raw_pd_fits = true;
+
+  size_t pdl = 0;  // The parameter data length of all received pages
+  size_t decoded = 0;  // The number of bytes which were decoded into pd
+  rdm_header_t header;
+  for (int page = 0;; ++page) {
+    // Send the RDM request
+    if (!dmx_send(dmx_num)) {
+      if (ack != NULL) {
+        ack->err = DMX_OK;
+        ack->size = 0;
+        ack->src_uid = (rdm_uid_t){0, 0};
+        ack->pid = 0;
+        ack->type = RDM_RESPONSE_TYPE_NONE;
+        ack->message_count = 0;
+        ack->pdl = 0;
+      }
+      return 0;
+    }
+
+    // Return early if no response is expected
+    if (rdm_uid_is_broadcast(request->dest_uid) &&
+        request->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+      dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
+      if (ack != NULL) {
+        ack->err = DMX_OK;
+        ack->size = 0;
+        ack->src_uid = (rdm_uid_t){0, 0};
+        ack->pid = 0;
+        ack->type = RDM_RESPONSE_TYPE_NONE;
+        ack->message_count = 0;
+        ack->pdl = 0;
+      }
+      return 0;
+    }
+
+    // Attempt to receive the RDM response
+    dmx_packet_t packet;
+    dmx_receive(dmx_num, &packet, dmx_ms_to_ticks(23));
+    if (ack != NULL) {
+      ack->err = packet.err;
+      ack->size = packet.size;
+    }
+
+    // Return early if no response was received
+    if (packet.size == 0) {
+#ifdef CONFIG_RDM_LATENCY_STATS
+      rdm_latency_record(driver, request, NULL, false);
+#endif
+      if (ack != NULL) {
+        ack->src_uid = (rdm_uid_t){0, 0};
+        ack->pid = 0;
+        ack->type = RDM_RESPONSE_TYPE_NONE;
+        ack->message_count = 0;
+        ack->pdl = 0;
+      }
+      return 0;
+    }
+
+    // Return early if the response checksum was invalid
+    if (!rdm_read_header(dmx_num, &header)) {
+#ifdef CONFIG_RDM_LATENCY_STATS
+      rdm_latency_record(driver, request, NULL, false);
+#endif
+      if (ack != NULL) {
+        ack->src_uid = (rdm_uid_t){0, 0};
+        ack->pid = 0;
+        ack->type = RDM_RESPONSE_TYPE_INVALID;
+        ack->message_count = 0;
+        ack->pdl = 0;
+      }
+      return 0;
+    }
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+    rdm_latency_record(
+        driver, request, &packet,
+        header.response_type == RDM_RESPONSE_TYPE_NACK_REASON);
+#endif
+
+    // Append the parameter data of this page to the output
+    if (header.response_type == RDM_RESPONSE_TYPE_ACK ||
+        header.response_type == RDM_RESPONSE_TYPE_ACK_OVERFLOW) {
+      if (pd != NULL && decoded < size &&
+          header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+        decoded += rdm_read_pd(dmx_num, format, (uint8_t *)pd + decoded,
+                               size - decoded);
+      }
+      if (is_cacheable && raw_pd_fits) {
+        raw_pd_fits = pdl + header.pdl < RDM_PD_SIZE_MAX;
+        if (raw_pd_fits) {
+          taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+          memcpy(raw_pd + pdl, driver->dmx.data + 24, header.pdl);
+          taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+        }
+      }
+      pdl += header.pdl;
+    }
+
+    // Request the next page; the page count is limited by the responder
+    if (header.response_type != RDM_RESPONSE_TYPE_ACK_OVERFLOW ||
+        page == UINT8_MAX) {
+      break;
+    }
+    rdm_patch_request(request_data, request_size, request->dest_uid,
+                      rdm_get_transaction_num(dmx_num));
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    memcpy(driver->dmx.data, request_data, request_size);
+    DMX_RDM_HEADER_INVALIDATE(driver);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+
+  // Copy the results into the ack struct
+  if (ack != NULL) {
+    memcpy(&ack->src_uid, &header.src_uid, sizeof(rdm_uid_t));
+    ack->pid = header.pid;
+    if (!rdm_response_type_is_valid(header.response_type)) {
+      ack->type = RDM_RESPONSE_TYPE_INVALID;
+      ack->pdl = header.pdl;
+    } else {
+      const char *word_format = "w";
+      ack->type = header.response_type;
+      if (header.response_type == RDM_RESPONSE_TYPE_ACK_TIMER) {
+        uint16_t timer;
+        rdm_read_pd(dmx_num, word_format, &timer, sizeof(timer));
+        ack->timer = dmx_ms_to_ticks(timer * 100);  // Timer is in 100ms units
+      } else if (header.response_type == RDM_RESPONSE_TYPE_NACK_REASON) {
+        uint16_t nack_reason;
+        rdm_read_pd(dmx_num, word_format, &nack_reason, sizeof(nack_reason));
+        ack->nack_reason = nack_reason;
+      } else {
+        ack->pdl = pdl;
+      }
+    }
+    ack->message_count = header.message_count;
+  }
+
+  // Queued messages may change the responses which were cached
+  if (header.message_count > 0) {
+    rdm_cache_invalidate(dmx_num, &header.src_uid);
+  } else if (is_cacheable && raw_pd_fits &&
+             header.response_type == RDM_RESPONSE_TYPE_ACK &&
+             rdm_uid_is_eq(&header.src_uid, request->dest_uid)) {
+    rdm_cache_insert(dmx_num, request, &request_data[24], request_data[23],
+                     raw_pd, pdl);
+  }
+
+  // Return the PDL or true on success
+  if (header.response_type == RDM_RESPONSE_TYPE_ACK) {
+    if (pdl == 0) {
+      return 1;
+    } else {
+      return pdl;
+    }
+  } else {
+    return 0;
+  }
+}
+
+static size_t rdm_send_request_paused(dmx_port_t dmx_num,
+                                      const rdm_request_t *request,
+                                      const char *format, void *pd,
+                                      size_t size, rdm_ack_t *ack) {
   assert(dmx_num < DMX_NUM_MAX);
   assert(request != NULL);
   assert(request->dest_uid != NULL);
@@ -51,130 +536,289 @@ size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
   memcpy(&header.dest_uid, request->dest_uid, sizeof(header.dest_uid));
   memcpy(&header.src_uid, rdm_uid_get(dmx_num), sizeof(header.src_uid));
 
-  // Copy the old data in the DMX buffer to a temporary buffer
-  uint8_t old_data[257];
-  const size_t packet_size = header.message_len + 2; 
-  dmx_read(dmx_num, old_data, packet_size);
+  // Swap the RDM buffer in place of the DMX packet of the application
+  dmx_lease_publish(dmx_num);
+  rdm_swap_buffers(dmx_num, true);
 
   // Write and send the RDM request
   rdm_write(dmx_num, &header, request->format, request->pd);
-  if (!dmx_send(dmx_num)) {
-    dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-    xSemaphoreGiveRecursive(driver->mux);
-    if (ack != NULL) {
-      ack->err = DMX_OK;
-      ack->size = 0;
-      ack->src_uid = (rdm_uid_t){0, 0};
-      ack->pid = 0;
-      ack->type = RDM_RESPONSE_TYPE_NONE;
-      ack->message_count = 0;
-      ack->pdl = 0;
-    }
+  const size_t ret = rdm_transact(dmx_num, request, format, pd, size, ack);
+
+  // Swap the DMX packet of the application back into the DMX driver
+  rdm_swap_buffers(dmx_num, false);
+
+  // Give the mutex back
+  xSemaphoreGiveRecursive(driver->mux);
+  return ret;
+}
+
+size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
+                        const char *format, void *pd, size_t size,
+                        rdm_ack_t *ack) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (driver->packet_size_max < RDM_PACKET_SIZE_MAX) {
+    DMX_ERR("packet_size_max is too small to send RDM requests");
     return 0;
   }
 
-  // Return early if no response is expected
-  if (rdm_uid_is_broadcast(request->dest_uid) &&
-      request->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-    dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
-    dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-    xSemaphoreGiveRecursive(driver->mux);
-    if (ack != NULL) {
-      ack->err = DMX_OK;
-      ack->size = 0;
-      ack->src_uid = (rdm_uid_t){0, 0};
-      ack->pid = 0;
-      ack->type = RDM_RESPONSE_TYPE_NONE;
-      ack->message_count = 0;
-      ack->pdl = 0;
+  // Answer the request from the cache if its response was cached
+  if (rdm_request_is_cacheable(request)) {
+    uint8_t request_pd[RDM_CACHE_KEY_PD_MAX];
+    const size_t request_pdl =
+        rdm_encode_pd(request->format, request_pd, request->pd, request->pdl);
+    uint8_t cached_pd[RDM_PD_SIZE_MAX];
+    const int cached_pdl = rdm_cache_lookup(dmx_num, request, request_pd,
+                                            request_pdl, cached_pd);
+    if (cached_pdl >= 0) {
+      if (pd != NULL && cached_pdl > 0) {
+        rdm_decode_pd(format, pd, size, cached_pd, cached_pdl);
+      }
+      if (ack != NULL) {
+        ack->err = DMX_OK;
+        ack->size = 26 + cached_pdl;
+        ack->src_uid = *request->dest_uid;
+        ack->pid = request->pid;
+        ack->type = RDM_RESPONSE_TYPE_ACK;
+        ack->message_count = 0;
+        ack->pdl = cached_pdl;
+      }
+      return cached_pdl > 0 ? cached_pdl : 1;
     }
-    return 0;
   }
 
-  // Attempt to receive the RDM response
-  dmx_packet_t packet;
-  dmx_receive(dmx_num, &packet, dmx_ms_to_ticks(23));
-  if (ack != NULL) {
-    ack->err = packet.err;
-    ack->size = packet.size;
-  }
+  // Wait for the scheduler to place the request between DMX packets
+  const bool expects_response = !rdm_uid_is_broadcast(request->dest_uid) ||
+                                request->pid == RDM_PID_DISC_UNIQUE_BRANCH;
+  rdm_schedule_wait(dmx_num, request->pid, 26 + request->pdl,
+                    expects_response ? 26 + size : 0);
 
-  // Return early if no response was received
-  if (packet.size == 0) {
-    dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-    xSemaphoreGiveRecursive(driver->mux);
-    if (ack != NULL) {
-      ack->src_uid = (rdm_uid_t){0, 0};
-      ack->pid = 0;
-      ack->type = RDM_RESPONSE_TYPE_NONE;
-      ack->message_count = 0;
-      ack->pdl = 0;
-    }
+  // Pause continuous sending so that the request may be sent between packets
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
     return 0;
   }
+  rdm_ack_t local_ack;
+  if (ack == NULL) {
+    ack = &local_ack;  // The ack is needed to follow ACK_TIMER responses
+  }
+  const bool was_continuous = dmx_continuous_pause(dmx_num);
+  size_t ret = rdm_send_request_paused(dmx_num, request, format, pd, size, ack);
+  if (was_continuous) {
+    dmx_continuous_resume(dmx_num);
+  }
+  xSemaphoreGiveRecursive(driver->mux);
 
-  // Return early if the response checksum was invalid
-  if (!rdm_read_header(dmx_num, &header)) {
-    dmx_write(dmx_num, old_data, packet_size);  // Write old data back
-    xSemaphoreGiveRecursive(driver->mux);
-    if (ack != NULL) {
-      ack->src_uid = (rdm_uid_t){0, 0};
-      ack->pid = 0;
-      ack->type = RDM_RESPONSE_TYPE_INVALID;
-      ack->message_count = 0;
-      ack->pdl = 0;
+  // Collect responses which the responder deferred with an ACK_TIMER
+  const TickType_t timer_max = dmx_ms_to_ticks(RDM_ACK_TIMER_MAX_DELAY);
+  TickType_t waited = 0;
+  while (ack->type == RDM_RESPONSE_TYPE_ACK_TIMER && expects_response &&
+         request->pid != RDM_PID_QUEUED_MESSAGE &&
+         waited + ack->timer <= timer_max) {
+    const TickType_t timer = ack->timer > 0 ? ack->timer : 1;
+    vTaskDelay(timer);
+    waited += timer;
+
+    // The deferred response is retrieved with RDM_PID_QUEUED_MESSAGE
+    const uint8_t status_type = RDM_STATUS_ERROR;
+    const rdm_request_t queued_message = {
+        .dest_uid = request->dest_uid,
+        .sub_device = RDM_SUB_DEVICE_ROOT,
+        .cc = RDM_CC_GET_COMMAND,
+        .pid = RDM_PID_QUEUED_MESSAGE,
+        .format = "b$",
+        .pd = &status_type,
+        .pdl = sizeof(status_type),
+    };
+    ret = rdm_send_request(dmx_num, &queued_message, format, pd, size, ack);
+    if (ack->type == RDM_RESPONSE_TYPE_ACK && ack->pid != request->pid) {
+      ret = 0;  // The responder sent a different queued message
     }
+  }
+
+  return ret;
+}
+
+size_t rdm_send_request_batch(dmx_port_t dmx_num,
+                              const rdm_request_t *requests, size_t count,
+                              const char *format, void *pds, size_t size,
+                              rdm_ack_t *acks) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(requests != NULL || count == 0, 0, "requests is null");
+  DMX_CHECK(pds != NULL || size == 0, 0, "pds is null");
+  DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(dmx_driver[dmx_num]->packet_size_max >= RDM_PACKET_SIZE_MAX, 0,
+            "packet_size_max is too small to send RDM requests");
+  for (size_t i = 0; i < count; ++i) {
+    DMX_CHECK(rdm_request_is_valid(&requests[i]), 0, "requests[%i] is invalid",
+              (int)i);
+  }
+  if (count == 0) {
     return 0;
   }
 
-  // Copy the parameter data into the output
-  if (header.response_type == RDM_RESPONSE_TYPE_ACK &&
-      header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
-    if (pd == NULL) {
-      rdm_read_pd(dmx_num, format, pd, size);
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Wait for the scheduler to place the batch between DMX packets
+  rdm_schedule_wait(dmx_num, requests[0].pid, 26 + requests[0].pdl, 26 + size);
+
+  // Take the mutex and pause continuous sending for the whole batch
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    return 0;
+  }
+  const bool was_continuous = dmx_continuous_pause(dmx_num);
+  if (!dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23))) {
+    if (was_continuous) {
+      dmx_continuous_resume(dmx_num);
     }
+    xSemaphoreGiveRecursive(driver->mux);
+    return 0;
   }
+  dmx_lease_publish(dmx_num);
+  rdm_swap_buffers(dmx_num, true);
 
-  // Copy the results into the ack struct
-  if (ack != NULL) {
-    memcpy(&ack->src_uid, &header.src_uid, sizeof(rdm_uid_t));
-    ack->pid = header.pid;
-    if (!rdm_response_type_is_valid(header.response_type)) {
-      ack->type = RDM_RESPONSE_TYPE_INVALID;
-      ack->pdl = header.pdl;
+  // The last encoded request is kept because responses overwrite the buffer
+  uint8_t encoded[RDM_PD_SIZE_MAX + 26];
+  size_t encoded_size = 0;
+  const rdm_request_t *encoded_request = NULL;
+
+  size_t acked = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const rdm_request_t *request = &requests[i];
+    const uint8_t tn = rdm_get_transaction_num(dmx_num);
+
+    if (encoded_request != NULL &&
+        rdm_request_is_similar(encoded_request, request)) {
+      // Reuse the encoded request with a new destination UID and TN
+      rdm_patch_request(encoded, encoded_size, request->dest_uid, tn);
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      memcpy(driver->dmx.data, encoded, encoded_size);
+      DMX_RDM_HEADER_INVALIDATE(driver);
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     } else {
-      const char *word_format = "w";
-      ack->type = header.response_type;
-      if (header.response_type == RDM_RESPONSE_TYPE_ACK_TIMER) {
-        uint16_t timer;
-        rdm_read_pd(dmx_num, word_format, &timer, sizeof(timer));
-        ack->timer = dmx_ms_to_ticks(timer * 10);
-      } else if (header.response_type == RDM_RESPONSE_TYPE_NACK_REASON) {
-        uint16_t nack_reason;
-        rdm_read_pd(dmx_num, word_format, &nack_reason, sizeof(nack_reason));
-        ack->nack_reason = nack_reason;
-      } else {
-        rdm_read_pd(dmx_num, format, pd, size);
-        ack->pdl = header.pdl;
-      }
+      rdm_header_t header = {
+          .message_len = 24 + request->pdl,
+          .tn = tn,
+          .port_id = dmx_num + 1,
+          .message_count = 0,
+          .sub_device = request->sub_device,
+          .cc = request->cc,
+          .pid = request->pid,
+          .pdl = request->pdl,
+      };
+      memcpy(&header.dest_uid, request->dest_uid, sizeof(header.dest_uid));
+      memcpy(&header.src_uid, rdm_uid_get(dmx_num), sizeof(header.src_uid));
+      encoded_size = rdm_write(dmx_num, &header, request->format, request->pd);
+      memcpy(encoded, driver->dmx.data, encoded_size);
+      encoded_request = request;
     }
-    ack->message_count = header.message_count;
-  }
 
-  // Write the old data from before the request back into the DMX driver
-  dmx_write(dmx_num, old_data, packet_size);
+    // Send the request and read the response into the output arrays
+    rdm_ack_t ack;
+    void *pd = size > 0 ? (uint8_t *)pds + (i * size) : NULL;
+    if (rdm_transact(dmx_num, request, format, pd, size,
+                     acks != NULL ? &acks[i] : &ack) > 0) {
+      ++acked;
+    }
+  }
 
-  // Give the mutex back and return the PDL or true on success
+  // Swap the DMX packet of the application back and resume sending
+  rdm_swap_buffers(dmx_num, false);
+  if (was_continuous) {
+    dmx_continuous_resume(dmx_num);
+  }
   xSemaphoreGiveRecursive(driver->mux);
-  if (header.response_type == RDM_RESPONSE_TYPE_ACK) {
-    if (header.pdl == 0) {
-      return 1;
+
+  return acked;
+}
+
+bool rdm_set_schedule(dmx_port_t dmx_num, uint32_t dmx_frames_per_rdm,
+                      uint32_t min_refresh_rate) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(min_refresh_rate <= 1000000 / (DMX_BREAK_LEN_MIN_US +
+                                           DMX_MAB_LEN_MIN_US + 44),
+            false, "min_refresh_rate error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  driver->schedule.dmx_frames_per_rdm = dmx_frames_per_rdm;
+  driver->schedule.min_refresh_rate = min_refresh_rate;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+void rdm_schedule_wait(dmx_port_t dmx_num, rdm_pid_t pid, size_t request_size,
+                       size_t response_size) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  struct dmx_driver_schedule_t *const schedule = &driver->schedule;
+
+  // DMX packets cannot be sent while this task holds the driver mutex
+  if (xSemaphoreGetMutexHolder(driver->mux) == xTaskGetCurrentTaskHandle()) {
+    return;
+  }
+
+  // Estimate the duration of the RDM transaction. Each slot is 44us long.
+  uint32_t duration = driver->break_len + driver->mab_len + request_size * 44;
+  if (pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    duration += RDM_TIMING_CONTROLLER_DISCOVERY_TRANSACTION_MIN;
+  } else if (response_size > 0) {
+    duration += RDM_TIMING_CONTROLLER_RESPONSE_LOST_MIN + response_size * 44;
+  } else {
+    duration += RDM_TIMING_CONTROLLER_REQUEST_TO_REQUEST_MIN;
+  }
+
+  while (true) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    const uint32_t period = schedule->dmx_period;
+    uint32_t frames_needed = schedule->dmx_frames_per_rdm;
+    if (schedule->min_refresh_rate > 0 && period > 0) {
+      /* Sending one RDM transaction every n DMX packets keeps the average DMX
+        refresh rate above the minimum when n * budget >= n * period + duration,
+        where budget is the longest allowed time between DMX packets. If DMX
+        packets are sent too slowly for any RDM to fit, the ratio is used.*/
+      const uint32_t budget = 1000000 / schedule->min_refresh_rate;
+      if (budget > period) {
+        const uint32_t slack = budget - period;
+        const uint32_t n = (duration + slack - 1) / slack;
+        if (n > frames_needed) {
+          frames_needed = n;
+        }
+      }
+    }
+    const int64_t idle = dmx_timer_get_micros_since_boot() -
+                         schedule->dmx_timestamp;
+    const bool is_ready = frames_needed == 0 ||
+                          schedule->dmx_frames >= frames_needed ||
+                          period == 0 || idle > period * 2;
+    if (is_ready) {
+      schedule->dmx_frames = 0;
+      schedule->rdm_is_waiting = false;
     } else {
-      return header.pdl;
+      schedule->rdm_is_waiting = true;
+    }
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (is_ready) {
+      break;
     }
-  } else {
 
-    return 0;
+    // Block until the next DMX packet is sent or DMX sending has stopped
+    const TickType_t timeout = dmx_ms_to_ticks((period * 2) / 1000 + 1);
+    if (!xSemaphoreTake(schedule->grant, timeout)) {
+      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      schedule->dmx_period = 0;  // DMX packets are no longer being sent
+      schedule->dmx_frames = 0;
+      schedule->rdm_is_waiting = false;
+      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      break;
+    }
   }
 }
 
@@ -189,3 +833,150 @@ uint32_t rdm_get_transaction_num(dmx_port_t dmx_num) {
 
   return tn;
 }
+
+size_t rdm_get_uid_latency(dmx_port_t dmx_num, rdm_uid_latency_t *entries,
+                           size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(entries != NULL || count == 0, 0, "entries is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  struct dmx_driver_latency_t *const latency = &dmx_driver[dmx_num]->latency;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (count > latency->uid_count) {
+    count = latency->uid_count;
+  }
+  memcpy(entries, latency->uids, count * sizeof(*entries));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+#else
+  DMX_WARN("RDM latency statistics are disabled in the Kconfig");
+  return 0;
+#endif
+}
+
+size_t rdm_get_pid_latency(dmx_port_t dmx_num, rdm_pid_latency_t *entries,
+                           size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(entries != NULL || count == 0, 0, "entries is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  struct dmx_driver_latency_t *const latency = &dmx_driver[dmx_num]->latency;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (count > latency->pid_count) {
+    count = latency->pid_count;
+  }
+  memcpy(entries, latency->pids, count * sizeof(*entries));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+#else
+  DMX_WARN("RDM latency statistics are disabled in the Kconfig");
+  return 0;
+#endif
+}
+
+bool rdm_reset_controller_latency(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  struct dmx_driver_latency_t *const latency = &dmx_driver[dmx_num]->latency;
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  latency->uid_count = 0;
+  latency->pid_count = 0;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("RDM latency statistics are disabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool rdm_cache_enable(dmx_port_t dmx_num, size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(count > 0, false, "count error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  struct rdm_cache_t *cache =
+      malloc(sizeof(*cache) + count * sizeof(rdm_cache_entry_t));
+  if (cache == NULL) {
+    DMX_ERR("RDM cache malloc error");
+    return false;
+  }
+  memset(cache, 0, sizeof(*cache) + count * sizeof(rdm_cache_entry_t));
+  cache->count = count;
+
+  // Replace the previous cache, if any
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  struct rdm_cache_t *const previous = driver->cache;
+  driver->cache = cache;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  free(previous);
+
+  return true;
+}
+
+bool rdm_cache_disable(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  struct rdm_cache_t *const cache = driver->cache;
+  driver->cache = NULL;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  free(cache);
+
+  return true;
+}
+
+bool rdm_cache_invalidate(dmx_port_t dmx_num, const rdm_uid_t *uid) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(uid != NULL, false, "uid is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  struct rdm_cache_t *const cache = driver->cache;
+  if (cache != NULL) {
+    for (int i = 0; i < cache->count; ++i) {
+      rdm_cache_entry_t *const entry = &cache->entries[i];
+      if (entry->last_used > 0 && rdm_uid_is_target(&entry->uid, uid)) {
+        entry->last_used = 0;
+        ++cache->stats.invalidate_count;
+      }
+    }
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+}
+
+bool rdm_cache_get_stats(dmx_port_t dmx_num, rdm_cache_stats_t *stats) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(stats != NULL, false, "stats is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  bool ret = false;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (driver->cache != NULL) {
+    *stats = driver->cache->stats;
+    ret = true;
+  }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return ret;
+}
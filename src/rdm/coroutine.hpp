@@ -0,0 +1,95 @@
+/**
+ * @file rdm/coroutine.hpp
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This header contains an optional C++ layer which exposes RDM
+ * controller requests as C++20 awaitables. Requests are queued with
+ * rdm_send_request_async() and the awaiting coroutine is resumed by a dmx_loop
+ * when the response is received, so that many RDM transactions can be in
+ * flight from coroutines which all run on one FreeRTOS task. This header
+ * requires C++20.
+ */
+#pragma once
+
+#if !defined(__cplusplus) || __cplusplus < 202002L
+#error "rdm/coroutine.hpp requires C++20 or later"
+#endif
+
+#include <stddef.h>
+
+#include <coroutine>
+
+#include "dmx/coroutine.hpp"
+#include "dmx/include/types.h"
+#include "rdm/controller/include/async.h"
+#include "rdm/include/types.h"
+
+namespace esp_dmx {
+
+/**
+ * @brief An awaitable which queues an RDM controller request and resumes when
+ * the transaction is complete. It is created with rdm_send_request_async().
+ * The result of the co_await expression is the rdm_async_result_t of the
+ * request. If the request could not be queued, the handle of the result is 0
+ * and the coroutine is not suspended.
+ */
+class rdm_request_awaitable {
+ public:
+  rdm_request_awaitable(dmx_loop &loop, dmx_port_t dmx_num,
+                        const rdm_request_t *request,
+                        const char *format) noexcept
+      : loop_(loop), dmx_num_(dmx_num), request_(request), format_(format) {}
+
+  bool await_ready() noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle) noexcept {
+    handle_ = handle;
+    const rdm_async_handle_t h = ::rdm_send_request_async(
+        dmx_num_, request_, format_, on_complete, nullptr, this);
+    if (h == 0) {
+      result_.handle = 0;
+      result_.ret = 0;
+      result_.ack = {};
+      result_.ack.type = RDM_RESPONSE_TYPE_NONE;
+      return false;  // Resume right away if the request was not queued
+    }
+    return true;
+  }
+  rdm_async_result_t await_resume() noexcept { return result_; }
+
+ private:
+  // Called from the RDM controller task of the DMX port
+  static void on_complete(dmx_port_t dmx_num,
+                          const rdm_async_result_t *result, void *context) {
+    rdm_request_awaitable *const self =
+        static_cast<rdm_request_awaitable *>(context);
+    self->result_ = *result;
+    self->loop_.post(dmx_num, self->handle_.address());
+  }
+
+  dmx_loop &loop_;
+  dmx_port_t dmx_num_;
+  const rdm_request_t *request_;
+  const char *format_;
+  std::coroutine_handle<> handle_;
+  rdm_async_result_t result_;
+};
+
+/**
+ * @brief Awaits an RDM controller request. This is the awaitable equivalent of
+ * rdm_send_request(). The request is copied when it is queued, but the format
+ * strings of the request and the response must remain valid until the
+ * coroutine is resumed.
+ *
+ * @param loop The loop which resumes the coroutine.
+ * @param dmx_num The DMX port number.
+ * @param[in] request A pointer to a request constructor.
+ * @param[in] format The RDM parameter format string for the response data.
+ * @return An awaitable which resumes with the rdm_async_result_t of the
+ * request.
+ */
+inline rdm_request_awaitable rdm_send_request_async(
+    dmx_loop &loop, dmx_port_t dmx_num, const rdm_request_t *request,
+    const char *format) noexcept {
+  return rdm_request_awaitable(loop, dmx_num, request, format);
+}
+
+}  // namespace esp_dmx
@@ -1,4 +1,3 @@
-#include <ctype.h>
 #include <string.h>
 
 #include "dmx/hal/include/timer.h"
@@ -10,51 +9,251 @@
 #include "rdm/include/driver.h"
 #include "rdm/include/uid.h"
 
+#define RDM_FORMAT_OPS_MAX (2 * 231 + 1)  // The maximum size of a codec.
+#define RDM_FORMAT_CACHE_SIZE 32  // The number of codecs which can be cached.
+#define RDM_FORMAT_POOL_SIZE 2048  // The bytes available for cached codecs.
+
+/* A codec is a format string which has been compiled into a sequence of
+  opcodes. Each opcode is a single byte, except for RDM_FORMAT_OP_LITERAL which
+  is followed by the value of the literal. The sequence is always ended by
+  RDM_FORMAT_OP_STOP or RDM_FORMAT_OP_REPEAT. */
+enum rdm_format_op_t {
+  RDM_FORMAT_OP_STOP = 0,  // The codec is terminated.
+  RDM_FORMAT_OP_REPEAT,    // The codec repeats until the source is exhausted.
+  RDM_FORMAT_OP_BYTE,      // An 8-bit integer.
+  RDM_FORMAT_OP_WORD,      // A 16-bit integer.
+  RDM_FORMAT_OP_DWORD,     // A 32-bit integer.
+  RDM_FORMAT_OP_UID,       // A UID.
+  RDM_FORMAT_OP_OPTIONAL_UID,  // An optional UID. Terminates the codec.
+  RDM_FORMAT_OP_ASCII,     // An ASCII string. Terminates the codec.
+  RDM_FORMAT_OP_LITERAL,   // An 8-bit literal.
+};
+
+static struct rdm_format_cache_t {
+  const char *format;  // The format string, or NULL if the entry is unused.
+  uint16_t offset;  // The offset of the format string copy in the pool.
+  uint16_t ops_offset;  // The offset of the codec in the pool.
+} rdm_format_cache[RDM_FORMAT_CACHE_SIZE] = {};
+static uint8_t rdm_format_pool[RDM_FORMAT_POOL_SIZE];
+static size_t rdm_format_pool_len = 0;
+static dmx_spinlock_t rdm_format_spinlock = DMX_SPINLOCK_INIT;
+
+static int rdm_format_hex_to_int(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Compiles a format string into a codec. Returns the size of the codec or 0 if
+// the format string is invalid.
+static size_t rdm_format_compile(const char *format, uint8_t *ops) {
+  assert(format != NULL);
+  assert(ops != NULL);
+
+  size_t parameter_size = 0;
+  size_t ops_len = 0;
+  bool format_is_terminated = false;
+  for (char c = *format; c != '\0'; c = *(++format)) {
+    // Skip spaces
+    if (c == ' ') {
+      continue;
+    }
+
+    // Get the opcode and size of the current token
+    size_t token_size;
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';  // Convert token to lowercase
+    }
+    switch (c) {
+      case 'b':
+        token_size = sizeof(uint8_t);
+        ops[ops_len++] = RDM_FORMAT_OP_BYTE;
+        break;
+      case 'w':
+        token_size = sizeof(uint16_t);
+        ops[ops_len++] = RDM_FORMAT_OP_WORD;
+        break;
+      case 'd':
+        token_size = sizeof(uint32_t);
+        ops[ops_len++] = RDM_FORMAT_OP_DWORD;
+        break;
+      case 'u':
+        token_size = sizeof(rdm_uid_t);
+        ops[ops_len++] = RDM_FORMAT_OP_UID;
+        break;
+      case 'v':
+        token_size = sizeof(rdm_uid_t);
+        ops[ops_len++] = RDM_FORMAT_OP_OPTIONAL_UID;
+        format_is_terminated = true;
+        break;
+      case 'x': {
+        token_size = sizeof(uint8_t);
+        const int hi = rdm_format_hex_to_int(*(++format));
+        const int lo = hi < 0 ? -1 : rdm_format_hex_to_int(*(++format));
+        if (lo < 0) {
+          return 0;  // Hex literals must be 2 characters wide
+        }
+        ops[ops_len++] = RDM_FORMAT_OP_LITERAL;
+        ops[ops_len++] = (hi << 4) | lo;
+        break;
+      }
+      case 'a':
+        token_size = 32;  // ASCII fields can be up to 32 bytes
+        ops[ops_len++] = RDM_FORMAT_OP_ASCII;
+        format_is_terminated = true;
+        break;
+      case '$':
+        token_size = 0;
+        format_is_terminated = true;
+        break;
+      default:
+        return 0;  // Unknown symbol
+    }
+
+    // Update the parameter size with the new token
+    parameter_size += token_size;
+    if (parameter_size > 231) {
+      return 0;  // Parameter size is too big
+    }
+
+    // End loop if parameter is terminated
+    if (format_is_terminated) {
+      break;
+    }
+  }
+
+  if (format_is_terminated) {
+    ++format;
+    if (*format != '\0' && *format != '$') {
+      return 0;  // Invalid token after terminator
+    }
+  }
+  if (parameter_size == 0) {
+    return 0;  // The format string encodes no data
+  }
+  ops[ops_len++] = format_is_terminated ? RDM_FORMAT_OP_STOP
+                                        : RDM_FORMAT_OP_REPEAT;
+
+  return ops_len;
+}
+
+// Gets the codec of a format string. Codecs are cached by the address of the
+// format string, which is usually a string literal in flash, so that each
+// format string is only compiled once. If the codec cannot be cached it is
+// compiled into the buffer which is provided. Returns NULL if the format string
+// is invalid.
+static const uint8_t *rdm_format_get_codec(const char *format, uint8_t *buf) {
+  assert(format != NULL);
+  assert(buf != NULL);
+
+  // Search the cache for the format string
+  const size_t hash = ((uintptr_t)format >> 2) % RDM_FORMAT_CACHE_SIZE;
+  size_t i = hash;
+  do {
+    struct rdm_format_cache_t *entry = &rdm_format_cache[i];
+    const char *cached = __atomic_load_n(&entry->format, __ATOMIC_ACQUIRE);
+    if (cached == NULL) {
+      break;  // The format string has not been cached
+    } else if (cached == format) {
+      // Guard against format strings which have been modified since caching
+      if (strcmp((const char *)&rdm_format_pool[entry->offset], format) == 0) {
+        return &rdm_format_pool[entry->ops_offset];
+      }
+      break;
+    }
+    i = (i + 1) % RDM_FORMAT_CACHE_SIZE;
+  } while (i != hash);
+
+  // Compile the format string
+  const size_t ops_len = rdm_format_compile(format, buf);
+  if (ops_len == 0) {
+    return NULL;
+  }
+
+  // Attempt to add the codec to the cache
+  const size_t format_len = strlen(format) + 1;
+  taskENTER_CRITICAL(&rdm_format_spinlock);
+  if (rdm_format_pool_len + format_len + ops_len <= RDM_FORMAT_POOL_SIZE) {
+    i = hash;
+    do {
+      struct rdm_format_cache_t *entry = &rdm_format_cache[i];
+      if (entry->format == format) {
+        break;  // Another task cached the format string first
+      } else if (entry->format == NULL) {
+        entry->offset = rdm_format_pool_len;
+        memcpy(&rdm_format_pool[rdm_format_pool_len], format, format_len);
+        rdm_format_pool_len += format_len;
+        entry->ops_offset = rdm_format_pool_len;
+        memcpy(&rdm_format_pool[rdm_format_pool_len], buf, ops_len);
+        rdm_format_pool_len += ops_len;
+        __atomic_store_n(&entry->format, format, __ATOMIC_RELEASE);
+        break;
+      }
+      i = (i + 1) % RDM_FORMAT_CACHE_SIZE;
+    } while (i != hash);
+  }
+  taskEXIT_CRITICAL(&rdm_format_spinlock);
+
+  return buf;
+}
+
 static size_t rdm_format_encode(void *restrict dest,
-                                const char *restrict format,
+                                const uint8_t *restrict ops,
                                 const void *restrict src, size_t src_size,
                                 bool encode_nulls) {
   assert(dest != NULL);
-  assert(rdm_format_is_valid(format));
+  assert(ops != NULL);
   assert(src != NULL);
 
   size_t encoded = 0;
-  while (src_size > 0) {
-    const char *f = format;
-    for (char c = *f; c != '\0'; c = *(++f)) {
-      // Skip whitespaces
-      if (c == ' ') {
-        continue;
-      }
-
-      // Check for terminator
-      if (c == '$') {
+  const uint8_t *op = ops;
+  // An optional UID is encoded as a null UID when the source is exhausted
+  while (src_size > 0 || *op == RDM_FORMAT_OP_OPTIONAL_UID) {
+    // Copy the token to the destination buffer
+    size_t token_size;
+    switch (*op) {
+      case RDM_FORMAT_OP_STOP:
         return encoded;
-      }
-
-      // Copy the token to the destination buffer
-      size_t token_size;
-      if (c >= 'A' && c <= 'Z') {
-        c += 'A';  // Convert token to lowercase
-      }
-      if (c == 'b') {
+      case RDM_FORMAT_OP_REPEAT:
+        op = ops;
+        continue;
+      case RDM_FORMAT_OP_BYTE:
         token_size = sizeof(uint8_t);
-        memcpy(dest, src, token_size);
-        // Don't need to swap endianness on single byte
-        encoded += token_size;
-      } else if (c == 'w') {
+        if (src_size < token_size) {
+          return encoded;
+        }
+        *(uint8_t *)dest = *(const uint8_t *)src;
+        break;
+      case RDM_FORMAT_OP_WORD: {
         token_size = sizeof(uint16_t);
-        memcpy(dest, src, token_size);
-        *(uint16_t *)dest = bswap16(*(uint16_t *)dest);
-        encoded += token_size;
-      } else if (c == 'd') {
+        if (src_size < token_size) {
+          return encoded;
+        }
+        uint16_t word;
+        memcpy(&word, src, token_size);
+        word = bswap16(word);
+        memcpy(dest, &word, token_size);
+        break;
+      }
+      case RDM_FORMAT_OP_DWORD: {
         token_size = sizeof(uint32_t);
-        memcpy(dest, src, token_size);
-        *(uint32_t *)dest = bswap32(*(uint32_t *)dest);
-        encoded += token_size;
-      } else if (c == 'u' || c == 'v') {
+        if (src_size < token_size) {
+          return encoded;
+        }
+        uint32_t dword;
+        memcpy(&dword, src, token_size);
+        dword = bswap32(dword);
+        memcpy(dest, &dword, token_size);
+        break;
+      }
+      case RDM_FORMAT_OP_OPTIONAL_UID:
         token_size = sizeof(rdm_uid_t);
-        if (c == 'v' && (src_size < token_size || rdm_uid_is_null(src))) {
+        if (src_size < token_size || rdm_uid_is_null(src)) {
           // Handle condition where an optional UID was not provided
           if (encode_nulls) {
             memset(dest, 0, token_size);
@@ -62,15 +261,22 @@ static size_t rdm_format_encode(void *restrict dest,
           }
           return encoded;
         }
+        // Fall through
+      case RDM_FORMAT_OP_UID: {
+        token_size = sizeof(rdm_uid_t);
+        if (src_size < token_size) {
+          return encoded;
+        }
         memcpy(dest, src, token_size);
         rdm_uid_t *const uid = dest;
         uid->man_id = bswap16(uid->man_id);
         uid->dev_id = bswap32(uid->dev_id);
-        encoded += token_size;
-        if (c == 'v') {
-          return encoded;
+        if (*op == RDM_FORMAT_OP_OPTIONAL_UID) {
+          return encoded + token_size;
         }
-      } else if (c == 'a') {
+        break;
+      }
+      case RDM_FORMAT_OP_ASCII:
         token_size = strnlen(src, (src_size < 32 ? src_size : 32));
         memcpy(dest, src, token_size);
         if (encode_nulls) {
@@ -78,41 +284,31 @@ static size_t rdm_format_encode(void *restrict dest,
           ((uint8_t *)dest)[token_size] = '\0';
           token_size += 1;
         }
-        encoded += token_size;
-        return encoded;
-      } else if (c == 'x') {
-        // Copy the hex literal format string to a null-terminated string
-        char str[3];
-        str[2] = '\0';
-        memcpy(str, (f + 1), 2);
-
-        // Get the hex literal as an integer and copy it to the destination
+        return encoded + token_size;
+      case RDM_FORMAT_OP_LITERAL:
         token_size = sizeof(uint8_t);
-        const uint8_t literal = (uint8_t)strtol(str, NULL, 16);
-        memcpy(dest, &literal, token_size);
-        encoded += token_size;
-        // Don't need to swap endianness on single byte
-        f += 2;  // Skip to the next token
-      } else {
-        __unreachable();  // Unknown symbol
-      }
-
-      // Update cursor
-      dest += token_size;
-      src += token_size;
-      src_size -= token_size;
+        ++op;
+        *(uint8_t *)dest = *op;
+        break;
+      default:
+        __unreachable();  // Unknown opcode
     }
+
+    // Update cursor
+    ++op;
+    encoded += token_size;
+    dest += token_size;
+    src += token_size;
+    src_size -= token_size;
   }
 
   return encoded;
 }
 
-bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
-  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(dmx_driver[dmx_num] != NULL, 0, "driver is not installed");
-
-  dmx_driver_t *const driver = dmx_driver[dmx_num];
-
+// Decodes and verifies the RDM header of the packet in the DMX buffer. Returns
+// true if the packet is an RDM packet with a valid checksum.
+static bool DMX_ISR_ATTR rdm_decode_header(const dmx_driver_t *driver,
+                                           rdm_header_t *header) {
   const uint8_t *data = driver->dmx.data;
   uint16_t checksum = 0;
 
@@ -120,15 +316,21 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
   if (*(uint16_t *)data == (RDM_SC | (RDM_SUB_SC << 8))) {
     // Verify checksum
     const uint8_t message_len = data[2];
-    for (int i = 0; i < message_len; ++i) {
-      checksum += data[i];
+    if (message_len + 2 > driver->packet_size_max) {
+      return false;  // The packet does not fit in the DMX buffer
+    } else if (driver->dmx.rx_checksum_len == message_len) {
+      checksum = driver->dmx.rx_checksum;  // Summed as the slots were received
+    } else {
+      for (int i = 0; i < message_len; ++i) {
+        checksum += data[i];
+      }
     }
     if (checksum != bswap16(*(uint16_t *)(data + message_len))) {
       return false;
     }
 
     // Copy the header without function calls for IRAM ISR
-    if (header != NULL) {
+    {
       for (int i = 0; i < sizeof(rdm_header_t); ++i) {
         ((uint8_t *)header)[i] = data[i];
       }
@@ -152,6 +354,13 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
     }
     data += preamble_len + 1;
 
+    // Verify the encoding, which colliding responses usually corrupt
+    for (int i = 0; i < 16; i += 2) {
+      if ((data[i] & 0xaa) != 0xaa || (data[i + 1] & 0x55) != 0x55) {
+        return false;
+      }
+    }
+
     // Verify checksum
     for (int i = 0; i < 12; ++i) {
       checksum += data[i];
@@ -161,7 +370,7 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
     }
 
     // Copy the header without function calls for IRAM ISR
-    if (header != NULL) {
+    {
       // Decode the EUID
       uint8_t euid_buf[6];
       for (int i = 0, j = 0; i < sizeof(euid_buf); ++i, j += 2) {
@@ -191,31 +400,95 @@ bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
   return false;
 }
 
+bool DMX_ISR_ATTR rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver[dmx_num] != NULL, 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Only decode and verify the packet the first time its header is read
+  if (!driver->dmx.rdm_header_is_cached) {
+    driver->dmx.rdm_header_is_valid =
+        rdm_decode_header(driver, &driver->dmx.rdm_header);
+    driver->dmx.rdm_header_is_cached = true;
+  }
+
+  // Copy the header without function calls for IRAM ISR
+  if (header != NULL && driver->dmx.rdm_header_is_valid) {
+    for (int i = 0; i < sizeof(rdm_header_t); ++i) {
+      ((uint8_t *)header)[i] = ((uint8_t *)&driver->dmx.rdm_header)[i];
+    }
+  }
+
+  return driver->dmx.rdm_header_is_valid;
+}
+
 size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination,
                    size_t size) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  const uint8_t *ops = format ? rdm_format_get_codec(format, buf) : NULL;
+  DMX_CHECK(format == NULL || ops != NULL, 0, "format is invalid");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
 
   // Guard against invalid PDL
   const size_t pdl = driver->dmx.data[23];
-  if (pdl == 0 || pdl > 231) {
+  if (pdl == 0 || pdl > 231 || pdl + 24 > driver->packet_size_max) {
     return 0;
   }
 
   // Deserialize the parameter data into the destination buffer
-  if (destination != NULL) {
+  if (destination != NULL && ops != NULL) {
     size = pdl < size ? pdl : size;
     const bool encode_nulls = true;
     const uint8_t *pd = &driver->dmx.data[24];
-    rdm_format_encode(destination, format, pd, size, encode_nulls);
+    rdm_format_encode(destination, ops, pd, size, encode_nulls);
   }
 
   return pdl;
 }
 
+size_t rdm_decode_pd(const char *format, void *destination, size_t size,
+                     const void *pd, size_t pdl) {
+  DMX_CHECK(pd != NULL || pdl == 0, 0, "pd is null");
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  const uint8_t *ops = format ? rdm_format_get_codec(format, buf) : NULL;
+  DMX_CHECK(format == NULL || ops != NULL, 0, "format is invalid");
+
+  // Guard against invalid PDL
+  if (pdl == 0 || pdl > 231) {
+    return 0;
+  }
+
+  // Deserialize the parameter data into the destination buffer
+  if (destination != NULL && ops != NULL) {
+    size = pdl < size ? pdl : size;
+    const bool encode_nulls = true;
+    rdm_format_encode(destination, ops, pd, size, encode_nulls);
+  }
+
+  return pdl;
+}
+
+size_t rdm_encode_pd(const char *format, void *destination, const void *pd,
+                     size_t pdl) {
+  DMX_CHECK(destination != NULL, 0, "destination is null");
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  const uint8_t *ops = format ? rdm_format_get_codec(format, buf) : NULL;
+  DMX_CHECK(format == NULL || ops != NULL, 0, "format is invalid");
+
+  // Guard against invalid PDL
+  if (pd == NULL || ops == NULL || pdl == 0 || pdl > 231) {
+    return 0;
+  }
+
+  // Serialize the parameter data into the destination buffer
+  const bool encode_nulls = false;
+  return rdm_format_encode(destination, ops, pd, pdl, encode_nulls);
+}
+
 size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header,
                  const char *format, const void *pd) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
@@ -234,12 +507,18 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header,
     DMX_CHECK(rdm_response_type_is_valid(header->response_type), 0,
               "header->response_type error");
   }
-  DMX_CHECK(rdm_format_is_valid(format), 0, "format is invalid");
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  const uint8_t *ops = format ? rdm_format_get_codec(format, buf) : NULL;
+  DMX_CHECK(format == NULL || ops != NULL, 0, "format is invalid");
   DMX_CHECK(header->pdl == 0 || (format != NULL && pd != NULL), 0,
             "pd or format is null");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+  DMX_CHECK(header->message_len + 2 <= dmx_driver[dmx_num]->packet_size_max, 0,
+            "packet_size_max is too small for the RDM packet");
 
   dmx_driver_t *const driver = dmx_driver[dmx_num];
+  dmx_lease_publish(dmx_num);  // Do not overwrite a released write buffer
+  DMX_RDM_HEADER_INVALIDATE(driver);  // The packet in the buffer is replaced
 
   // Encode a standard RDM packet or a RDM_CC_DISC_COMMAND_RESPONSE packet
   size_t written;
@@ -273,15 +552,23 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header,
     // Update written size
     written = preamble_len + 1 + 16;
   } else {
-    // Serialize the header and pd into the driver buffer
-    const char *header_format = "xCCx01buubbbwbwb";
-    rdm_format_encode(driver->dmx.data, header_format, header, sizeof(*header),
-                      encode_nulls);
+    // Serialize the header into the driver buffer using its fixed layout
+    rdm_header_t *const packet = (rdm_header_t *)driver->dmx.data;
+    memcpy(packet, header, sizeof(*header));
+    driver->dmx.data[0] = RDM_SC;
+    driver->dmx.data[1] = RDM_SUB_SC;
+    packet->dest_uid.man_id = bswap16(header->dest_uid.man_id);
+    packet->dest_uid.dev_id = bswap32(header->dest_uid.dev_id);
+    packet->src_uid.man_id = bswap16(header->src_uid.man_id);
+    packet->src_uid.dev_id = bswap32(header->src_uid.dev_id);
+    packet->sub_device = bswap16(header->sub_device);
+    packet->pid = bswap16(header->pid);
+
+    // Serialize the pd into the driver buffer
     size_t message_len;
     void *data = &driver->dmx.data[24];
     if (pd != NULL && header->pdl > 0) {
-      size_t pdl =
-          rdm_format_encode(data, format, pd, header->pdl, encode_nulls);
+      size_t pdl = rdm_format_encode(data, ops, pd, header->pdl, encode_nulls);
       if (header->pdl != pdl) {
         message_len = 24 + pdl;
         driver->dmx.data[2] = message_len;  // Encode updated message_len
@@ -313,83 +600,56 @@ bool rdm_format_is_valid(const char *format) {
     return true;
   }
 
-  size_t parameter_size = 0;
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  return rdm_format_get_codec(format, buf) != NULL;
+}
 
-  bool format_is_terminated = false;
-  for (char c = *format; c != '\0'; c = *(++format)) {
-    // Skip spaces
-    if (c == ' ') {
-      continue;
-    }
+size_t rdm_format_get_size(const char *format, bool *repeats) {
+  if (repeats != NULL) {
+    *repeats = false;
+  }
+  if (format == NULL) {
+    return 0;
+  }
+  uint8_t buf[RDM_FORMAT_OPS_MAX];
+  const uint8_t *op = rdm_format_get_codec(format, buf);
+  if (op == NULL) {
+    return 0;
+  }
 
-    // Get the size of the current token
-    size_t token_size;
-    switch (c) {
-      case 'b':
-      case 'B':
-        token_size = sizeof(uint8_t);
-        break;
-      case 'w':
-      case 'W':
-        token_size = sizeof(uint16_t);
-        break;
-      case 'd':
-      case 'D':
-        token_size = sizeof(uint32_t);
+  // Sum the size of each token until the codec is terminated
+  size_t size = 0;
+  for (;; ++op) {
+    switch (*op) {
+      case RDM_FORMAT_OP_STOP:
+        return size;
+      case RDM_FORMAT_OP_REPEAT:
+        if (repeats != NULL) {
+          *repeats = true;
+        }
+        return size;
+      case RDM_FORMAT_OP_BYTE:
+        size += sizeof(uint8_t);
         break;
-      case 'u':
-      case 'U':
-        token_size = sizeof(rdm_uid_t);
+      case RDM_FORMAT_OP_WORD:
+        size += sizeof(uint16_t);
         break;
-      case 'v':
-      case 'V':
-        token_size = sizeof(rdm_uid_t);
-        format_is_terminated = true;
+      case RDM_FORMAT_OP_DWORD:
+        size += sizeof(uint32_t);
         break;
-      case 'x':
-      case 'X':
-        token_size = sizeof(uint8_t);
-        for (int i = 0; i < 2; ++i) {
-          c = *(++format);
-          if (!isxdigit(c)) {
-            return false;  // Hex literals must be 2 characters wide
-          }
-        }
+      case RDM_FORMAT_OP_UID:
+      case RDM_FORMAT_OP_OPTIONAL_UID:
+        size += sizeof(rdm_uid_t);
         break;
-      case 'a':
-      case 'A':
-        token_size = 32;  // ASCII fields can be up to 32 bytes
-        format_is_terminated = true;
+      case RDM_FORMAT_OP_ASCII:
+        size += 32;
         break;
-      case '$':
-        token_size = 0;
-        format_is_terminated = true;
+      case RDM_FORMAT_OP_LITERAL:
+        size += sizeof(uint8_t);
+        ++op;
         break;
       default:
-        return false;  // Unknown symbol
-    }
-
-    // Update the parameter size with the new token
-    parameter_size += token_size;
-    if (parameter_size > 231) {
-      return false;  // Parameter size is too big
-    }
-
-    // End loop if parameter is terminated
-    if (format_is_terminated) {
-      break;
+        __unreachable();  // Unknown opcode
     }
   }
-
-  if (format_is_terminated) {
-    ++format;
-    if (*format != '\0' && *format != '$') {
-      return false;  // Invalid token after terminator
-    }
-  } else {
-    // Get the maximum possible size if parameter is unterminated
-    parameter_size = 231 - (231 % parameter_size);
-  }
-
-  return parameter_size > 0;
 }
@@ -0,0 +1,463 @@
+/**
+ * @file rdm/format.hpp
+ * @author Mitch Weisbrod (mitch@theweisbrods.com)
+ * @brief This header contains an optional C++ layer which compiles RDM
+ * parameter format strings at compile time. Each format string is checked and
+ * turned into an inlined encoder and decoder for its parameter layout, so an
+ * invalid format string is a build error instead of a runtime assert. The
+ * wrappers in this header send and receive parameter data in its wire format
+ * so that the format string is never interpreted at runtime. More information
+ * about RDM parameter format strings can be found in the documentation on the
+ * rdm_read_pd() and rdm_write() functions. This header requires C++17.
+ */
+#pragma once
+
+#if !defined(__cplusplus) || __cplusplus < 201703L
+#error "rdm/format.hpp requires C++17 or later"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+
+#include "dmx/include/types.h"
+#include "rdm/controller/include/utils.h"
+#include "rdm/include/driver.h"
+#include "rdm/include/types.h"
+#include "rdm/responder/include/utils.h"
+
+namespace esp_dmx {
+
+namespace detail {
+
+/** @brief The types of the fields of a compiled RDM format string.*/
+enum class rdm_token : uint8_t {
+  byte,          // An 8-bit integer.
+  word,          // A 16-bit integer.
+  dword,         // A 32-bit integer.
+  uid,           // A UID.
+  optional_uid,  // An optional UID. Terminates the parameter.
+  ascii,         // An ASCII string. Terminates the parameter.
+  literal,       // An 8-bit literal.
+};
+
+/** @brief An RDM format string which has been compiled at compile time.*/
+struct rdm_format_info {
+  bool is_valid;   // True if the format string is valid.
+  bool repeats;    // True if the parameter repeats until the data is exhausted.
+  size_t size;     // The size of one parameter. ASCII fields count as 32 bytes.
+  size_t count;    // The number of fields in the parameter.
+  rdm_token tokens[RDM_PD_SIZE_MAX];   // The type of each field.
+  uint8_t offsets[RDM_PD_SIZE_MAX];    // The offset of each field.
+  uint8_t literals[RDM_PD_SIZE_MAX];   // The value of each literal field.
+};
+
+constexpr int rdm_hex_to_int(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Compiles a format string using the same rules as the C library. The returned
+// info is invalid if the format string is invalid.
+constexpr rdm_format_info rdm_format_compile(const char *format) {
+  rdm_format_info info{};
+  if (format == nullptr) {
+    return info;
+  }
+
+  bool is_terminated = false;
+  for (char c = *format; c != '\0'; c = *(++format)) {
+    // Skip spaces
+    if (c == ' ') {
+      continue;
+    }
+
+    // Get the type and size of the current token
+    size_t token_size = 0;
+    rdm_token token = rdm_token::byte;
+    uint8_t literal = 0;
+    if (c >= 'A' && c <= 'Z') {
+      c += 'a' - 'A';  // Convert token to lowercase
+    }
+    switch (c) {
+      case 'b':
+        token_size = sizeof(uint8_t);
+        break;
+      case 'w':
+        token_size = sizeof(uint16_t);
+        token = rdm_token::word;
+        break;
+      case 'd':
+        token_size = sizeof(uint32_t);
+        token = rdm_token::dword;
+        break;
+      case 'u':
+        token_size = sizeof(rdm_uid_t);
+        token = rdm_token::uid;
+        break;
+      case 'v':
+        token_size = sizeof(rdm_uid_t);
+        token = rdm_token::optional_uid;
+        is_terminated = true;
+        break;
+      case 'x': {
+        token_size = sizeof(uint8_t);
+        token = rdm_token::literal;
+        const int hi = rdm_hex_to_int(*(++format));
+        const int lo = hi < 0 ? -1 : rdm_hex_to_int(*(++format));
+        if (lo < 0) {
+          return rdm_format_info{};  // Hex literals must be 2 characters wide
+        }
+        literal = (hi << 4) | lo;
+        break;
+      }
+      case 'a':
+        token_size = 32;  // ASCII fields can be up to 32 bytes
+        token = rdm_token::ascii;
+        is_terminated = true;
+        break;
+      case '$':
+        is_terminated = true;
+        break;
+      default:
+        return rdm_format_info{};  // Unknown symbol
+    }
+
+    // Add the token to the parameter
+    if (token_size > 0) {
+      if (info.size + token_size > 231) {
+        return rdm_format_info{};  // Parameter size is too big
+      }
+      info.tokens[info.count] = token;
+      info.offsets[info.count] = info.size;
+      info.literals[info.count] = literal;
+      ++info.count;
+      info.size += token_size;
+    }
+
+    // End loop if parameter is terminated
+    if (is_terminated) {
+      break;
+    }
+  }
+
+  if (is_terminated) {
+    ++format;
+    if (*format != '\0' && *format != '$') {
+      return rdm_format_info{};  // Invalid token after terminator
+    }
+  }
+  if (info.size == 0) {
+    return rdm_format_info{};  // The format string encodes no data
+  }
+  info.repeats = !is_terminated;
+  info.is_valid = true;
+
+  return info;
+}
+
+/** @brief The format string used to pass wire-format parameter data through
+ * the C library unchanged.*/
+inline constexpr char rdm_raw_format[] = "b";
+
+}  // namespace detail
+
+/**
+ * @brief An RDM parameter codec which is specialized at compile time for an
+ * RDM format string. The format string must be a constexpr character array
+ * with static storage duration, such as a static constexpr class member or a
+ * namespace-scope constexpr array. The format string may be nullptr if there is
+ * no parameter data.
+ *
+ * @code
+ * static constexpr char device_info_format[] = "x01x00wwdwbbwwb$";
+ * using device_info_codec = esp_dmx::rdm_codec<device_info_format>;
+ * @endcode
+ *
+ * @tparam Format The RDM format string.
+ */
+template <const char *Format>
+class rdm_codec {
+  static constexpr detail::rdm_format_info info =
+      detail::rdm_format_compile(Format);
+  static_assert(Format == nullptr || info.is_valid,
+                "RDM format string is invalid");
+
+  using token_sequence = std::make_index_sequence<info.count>;
+
+  static void bswap_copy(uint8_t *dest, const uint8_t *src, size_t size) {
+    if (size == sizeof(uint16_t)) {
+      uint16_t word;
+      memcpy(&word, src, sizeof(word));
+      word = __builtin_bswap16(word);
+      memcpy(dest, &word, sizeof(word));
+    } else {
+      uint32_t dword;
+      memcpy(&dword, src, sizeof(dword));
+      dword = __builtin_bswap32(dword);
+      memcpy(dest, &dword, sizeof(dword));
+    }
+  }
+
+  // Copies one field of a parameter. Returns false if the parameter has ended.
+  template <size_t I>
+  static bool copy_token(uint8_t *dest, const uint8_t *src, size_t src_size,
+                         bool encode_nulls, size_t &copied) {
+    constexpr detail::rdm_token token = info.tokens[I];
+    constexpr size_t offset = info.offsets[I];
+    dest += offset;
+    src += offset;
+    const size_t remaining = src_size - offset;
+    if constexpr (token != detail::rdm_token::optional_uid) {
+      if (remaining == 0) {
+        return false;
+      }
+    }
+    if constexpr (token == detail::rdm_token::ascii) {
+      const char *const str = reinterpret_cast<const char *>(src);
+      const size_t len = strnlen(str, remaining < 32 ? remaining : 32);
+      memmove(dest, src, len);
+      copied += len;
+      if (encode_nulls) {
+        // Only null-terminate the string if desired by the caller
+        dest[len] = '\0';
+        copied += 1;
+      }
+      return false;
+    } else if constexpr (token == detail::rdm_token::optional_uid) {
+      if (remaining < sizeof(rdm_uid_t) ||
+          memcmp(src, "\0\0\0\0\0\0", sizeof(rdm_uid_t)) == 0) {
+        // Handle condition where an optional UID was not provided
+        if (encode_nulls) {
+          memset(dest, 0, sizeof(rdm_uid_t));
+          copied += sizeof(rdm_uid_t);
+        }
+        return false;
+      }
+      bswap_copy(dest, src, sizeof(uint16_t));
+      bswap_copy(dest + sizeof(uint16_t), src + sizeof(uint16_t),
+                 sizeof(uint32_t));
+      copied += sizeof(rdm_uid_t);
+      return false;
+    } else {
+      constexpr size_t token_size =
+          token == detail::rdm_token::word    ? sizeof(uint16_t)
+          : token == detail::rdm_token::dword ? sizeof(uint32_t)
+          : token == detail::rdm_token::uid   ? sizeof(rdm_uid_t)
+                                              : sizeof(uint8_t);
+      if (remaining < token_size) {
+        return false;
+      }
+      if constexpr (token == detail::rdm_token::literal) {
+        *dest = info.literals[I];
+      } else if constexpr (token == detail::rdm_token::byte) {
+        *dest = *src;
+      } else if constexpr (token == detail::rdm_token::uid) {
+        bswap_copy(dest, src, sizeof(uint16_t));
+        bswap_copy(dest + sizeof(uint16_t), src + sizeof(uint16_t),
+                   sizeof(uint32_t));
+      } else {
+        bswap_copy(dest, src, token_size);
+      }
+      copied += token_size;
+      return true;
+    }
+  }
+
+  template <size_t... I>
+  static size_t copy_parameter(uint8_t *dest, const uint8_t *src,
+                               size_t src_size, bool encode_nulls,
+                               std::index_sequence<I...>) {
+    size_t copied = 0;
+    (void)(copy_token<I>(dest, src, src_size, encode_nulls, copied) && ...);
+    return copied;
+  }
+
+  static size_t copy(void *dest, const void *src, size_t src_size,
+                     bool encode_nulls) {
+    if constexpr (info.count == 0) {
+      return 0;  // The format string is NULL
+    } else {
+      uint8_t *d = static_cast<uint8_t *>(dest);
+      const uint8_t *s = static_cast<const uint8_t *>(src);
+      size_t copied = 0;
+      // An optional UID is copied as a null UID when the source is exhausted
+      while (src_size > 0 ||
+             info.tokens[0] == detail::rdm_token::optional_uid) {
+        const size_t n =
+            copy_parameter(d, s, src_size, encode_nulls, token_sequence{});
+        copied += n;
+        if (!info.repeats || n < info.size || n >= src_size) {
+          break;
+        }
+        d += n;
+        s += n;
+        src_size -= n;
+      }
+      return copied;
+    }
+  }
+
+ public:
+  /** @brief The size of one parameter. ASCII fields count as 32 bytes.*/
+  static constexpr size_t size = info.size;
+
+  /** @brief True if the parameter repeats until the data is exhausted.*/
+  static constexpr bool repeats = info.repeats;
+
+  /** @brief True if the parameter ends with an ASCII string, which is
+     null-terminated when it is decoded.*/
+  static constexpr bool has_string =
+      info.count > 0 &&
+      info.tokens[info.count - 1] == detail::rdm_token::ascii;
+
+  /**
+   * @brief Encodes parameter data into its big-endian wire format. Fields are
+   * encoded as long as they fit within the size of the source. Optional UIDs
+   * which are 0000:00000000 and null terminators are not encoded.
+   *
+   * @param[out] dest The destination buffer. It must be at least as large as
+   * the source. It may be the same as the source.
+   * @param[in] src The parameter data to encode.
+   * @param src_size The size of the parameter data.
+   * @return The number of bytes encoded.
+   */
+  static size_t encode(void *dest, const void *src, size_t src_size) {
+    return copy(dest, src, src_size, false);
+  }
+
+  /**
+   * @brief Decodes parameter data from its big-endian wire format. Missing
+   * optional UIDs are decoded as 0000:00000000 and ASCII strings are
+   * null-terminated.
+   *
+   * @param[out] dest The destination buffer. It must be at least one byte
+   * larger than the source if the parameter ends with an ASCII string. It may
+   * be the same as the source.
+   * @param[in] src The parameter data to decode.
+   * @param src_size The size of the parameter data.
+   * @return The number of bytes decoded.
+   */
+  static size_t decode(void *dest, const void *src, size_t src_size) {
+    return copy(dest, src, src_size, true);
+  }
+};
+
+/**
+ * @brief Sends an RDM controller request and processes the response using
+ * codecs which are specialized at compile time. This function is otherwise
+ * the same as rdm_send_request(). The format field of the request is ignored.
+ *
+ * @tparam RequestFormat The RDM format string of the request parameter data.
+ * @tparam ResponseFormat The RDM format string of the response parameter data.
+ * @param dmx_num The DMX port number.
+ * @param[in] request A pointer to a request constructor.
+ * @param[out] pd A pointer to an array which will store the parameter data
+ * received in the response. This value may be NULL if no data is expected.
+ * @param size The size of the pd array.
+ * @param[out] ack A pointer to an rdm_ack_t which stores information about the
+ * RDM response.
+ * @return When an RDM_RESPONSE_TYPE_ACK response is received, the response PDL
+ * is returned or true if there is no parameter data received. 0 on failure.
+ */
+template <const char *RequestFormat, const char *ResponseFormat>
+size_t rdm_send_request(dmx_port_t dmx_num, const rdm_request_t *request,
+                        void *pd, size_t size, rdm_ack_t *ack) {
+  using request_codec = rdm_codec<RequestFormat>;
+  using response_codec = rdm_codec<ResponseFormat>;
+
+  // Encode the request parameter data into its wire format
+  uint8_t request_pd[RDM_PD_SIZE_MAX];
+  rdm_request_t raw_request = *request;
+  raw_request.format = detail::rdm_raw_format;
+  if (request->pd != nullptr && request->pdl > 0 &&
+      request->pdl < RDM_PD_SIZE_MAX) {
+    raw_request.pd = request_pd;
+    raw_request.pdl = request_codec::encode(request_pd, request->pd,
+                                            request->pdl);
+  }
+
+  // Leave room for the null terminator of a string
+  size_t raw_size = size;
+  if (response_codec::has_string && raw_size > 0) {
+    --raw_size;
+  }
+
+  // Receive the response in its wire format and decode it in place
+  rdm_ack_t raw_ack = {};
+  rdm_ack_t *const a = ack != nullptr ? ack : &raw_ack;
+  const size_t ret = ::rdm_send_request(dmx_num, &raw_request,
+                                        detail::rdm_raw_format, pd, raw_size,
+                                        a);
+  if (pd != nullptr && ret > 0 && a->pdl > 0) {
+    response_codec::decode(pd, pd, a->pdl < raw_size ? a->pdl : raw_size);
+  }
+
+  return ret;
+}
+
+/**
+ * @brief Reads RDM parameter data from the DMX driver buffer using a codec
+ * which is specialized at compile time. This function is otherwise the same
+ * as rdm_read_pd().
+ *
+ * @tparam Format The RDM format string of the parameter data.
+ * @param dmx_num The DMX port number.
+ * @param[out] destination A pointer to a destination buffer into which to copy
+ * parameter data.
+ * @param size The size of the destination buffer.
+ * @return The size of the RDM parameter data or 0 on error.
+ */
+template <const char *Format>
+size_t rdm_read_pd(dmx_port_t dmx_num, void *destination, size_t size) {
+  using codec = rdm_codec<Format>;
+
+  // Leave room for the null terminator of a string
+  size_t raw_size = size;
+  if (codec::has_string && raw_size > 0) {
+    --raw_size;
+  }
+
+  const size_t pdl =
+      ::rdm_read_pd(dmx_num, detail::rdm_raw_format, destination, raw_size);
+  if (destination != nullptr && pdl > 0) {
+    codec::decode(destination, destination, pdl < raw_size ? pdl : raw_size);
+  }
+
+  return pdl;
+}
+
+/**
+ * @brief Writes an ACK packet response to a RDM request packet using a codec
+ * which is specialized at compile time. This function is otherwise the same
+ * as rdm_write_ack().
+ *
+ * @tparam Format The RDM format string of the parameter data.
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param[in] pd A pointer to the parameter data for the RDM ACK packet.
+ * @param pdl The parameter data length of the RDM ack packet.
+ * @return The number of bytes written.
+ */
+template <const char *Format>
+size_t rdm_write_ack(dmx_port_t dmx_num, const rdm_header_t *header,
+                     const void *pd, size_t pdl) {
+  // Encode the parameter data into its wire format
+  uint8_t raw_pd[RDM_PD_SIZE_MAX];
+  if (pd != nullptr && pdl > 0 && pdl < RDM_PD_SIZE_MAX) {
+    pdl = rdm_codec<Format>::encode(raw_pd, pd, pdl);
+    pd = raw_pd;
+  }
+
+  return ::rdm_write_ack(dmx_num, header, detail::rdm_raw_format, pd, pdl);
+}
+
+}  // namespace esp_dmx
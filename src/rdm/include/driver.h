@@ -3,9 +3,16 @@
 #include "dmx/include/types.h"
 #include "rdm/include/types.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Returns the 48-bit unique ID of the desired DMX port. The specified
- * DMX driver must be installed before calling this function.
+ * DMX driver must be installed before calling this function. While the calling
+ * task has selected a virtual responder with rdm_responder_select(), or while
+ * an RDM response callback of a virtual responder is called, the UID of the
+ * virtual responder is returned instead.
  *
  * @param dmx_num The DMX port number.
  * @return A pointer to the DMX driver's RDM UID or NULL on failure.
@@ -74,6 +81,36 @@ bool rdm_read_header(dmx_port_t dmx_num, rdm_header_t *header);
 size_t rdm_read_pd(dmx_port_t dmx_num, const char *format, void *destination,
                    size_t size);
 
+/**
+ * @brief Reads RDM parameter data from a buffer instead of from the DMX driver
+ * buffer. The parameter data is read in the same way as rdm_read_pd().
+ *
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[out] destination A pointer to a destination buffer into which to copy
+ * parameter data.
+ * @param size The size of the destination buffer.
+ * @param[in] pd A pointer to the RDM parameter data as it is sent on the RDM
+ * bus.
+ * @param pdl The parameter data length.
+ * @return The parameter data length or 0 on error.
+ */
+size_t rdm_decode_pd(const char *format, void *destination, size_t size,
+                     const void *pd, size_t pdl);
+
+/**
+ * @brief Writes RDM parameter data into a buffer as it is sent on the RDM bus.
+ * The parameter data is written in the same way as rdm_write().
+ *
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[out] destination A pointer to a destination buffer into which to
+ * write the parameter data. It must be at least pdl bytes long.
+ * @param[in] pd A pointer to the parameter data.
+ * @param pdl The parameter data length.
+ * @return The number of bytes which were written or 0 on error.
+ */
+size_t rdm_encode_pd(const char *format, void *destination, const void *pd,
+                     size_t pdl);
+
 /**
  * @brief Writes an RDM packet into the DMX driver buffer so it may be sent with
  * dmx_send().
@@ -131,4 +168,19 @@ size_t rdm_write(dmx_port_t dmx_num, const rdm_header_t *header,
  * @return true if the RDM format string is valid.
  * @return false if it is not valid.
  */
-bool rdm_format_is_valid(const char *format);
\ No newline at end of file
+bool rdm_format_is_valid(const char *format);
+
+/**
+ * @brief Gets the number of parameter data bytes described by an RDM format
+ * string. If the format string repeats, this is the size of one repetition.
+ * ASCII fields are counted at their maximum size of 32 bytes.
+ *
+ * @param format The RDM format string.
+ * @param[out] repeats Set to true if the format string repeats. May be NULL.
+ * @return The size of the format string or 0 if it is invalid or NULL.
+ */
+size_t rdm_format_get_size(const char *format, bool *repeats);
+
+#ifdef __cplusplus
+}
+#endif
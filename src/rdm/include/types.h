@@ -44,6 +44,14 @@ extern "C" {
 /** @brief The maximum RDM sensor number.*/
 #define RDM_SENSOR_NUM_MAX (0xff)
 
+/** @brief The number of buckets in the histogram of RDM responder latencies.*/
+#define RDM_LATENCY_HISTOGRAM_SIZE (8)
+
+/** @brief The width in microseconds of each bucket of the histogram of RDM
+ * responder latencies. The first four buckets are within the 2000 microsecond
+ * responder deadline.*/
+#define RDM_LATENCY_HISTOGRAM_BUCKET_US (500)
+
 /** @brief The parameter ID (PID) is a 16-bit number that identifies a specific
  * type of parameter data. The PID may represent either a well known parameter
  * such as those defined in the RDM standard document, or a
@@ -1002,6 +1010,82 @@ typedef struct __attribute__((packed)) rdm_sensor_value_t {
   int16_t recorded_value;
 } rdm_sensor_value_t;
 
+/** @brief Latency statistics of the RDM responses which were sent by an RDM
+ * responder. Latency is measured from the end-of-packet of the request to the
+ * start of the response.*/
+typedef struct rdm_responder_latency_t {
+  /** @brief The number of RDM responses which were sent.*/
+  uint32_t response_count;
+  /** @brief The number of RDM responses which were sent later than 2000
+     microseconds after the end of the request.*/
+  uint32_t late_count;
+  /** @brief The number of RDM responses which could not be sent because the
+     responder missed its deadline.*/
+  uint32_t missed_count;
+  /** @brief The shortest latency in microseconds.*/
+  uint32_t latency_min;
+  /** @brief The moving average latency in microseconds.*/
+  uint32_t latency_avg;
+  /** @brief The longest latency in microseconds.*/
+  uint32_t latency_max;
+  /** @brief A histogram of latencies. Bucket n counts the latencies from
+     n * RDM_LATENCY_HISTOGRAM_BUCKET_US up to, but not including,
+     (n + 1) * RDM_LATENCY_HISTOGRAM_BUCKET_US microseconds. The last bucket
+     also counts every longer latency.*/
+  uint32_t histogram[RDM_LATENCY_HISTOGRAM_SIZE];
+} rdm_responder_latency_t;
+
+/** @brief Round-trip statistics of the RDM requests which were sent by an RDM
+ * controller. The round-trip time is measured from the end-of-packet of the
+ * request to the end-of-packet of the response.*/
+typedef struct rdm_latency_t {
+  /** @brief The number of requests which expected a response.*/
+  uint32_t request_count;
+  /** @brief The number of requests which received a valid response.*/
+  uint32_t response_count;
+  /** @brief The number of requests which did not receive a valid response.*/
+  uint32_t timeout_count;
+  /** @brief The number of responses which were RDM_RESPONSE_TYPE_NACK_REASON.*/
+  uint32_t nack_count;
+  /** @brief The shortest round-trip time in microseconds.*/
+  uint32_t rtt_min;
+  /** @brief The moving average round-trip time in microseconds.*/
+  uint32_t rtt_avg;
+  /** @brief The longest round-trip time in microseconds.*/
+  uint32_t rtt_max;
+  /** @brief The time in microseconds since boot at which the last request was
+     sent.*/
+  int64_t timestamp;
+} rdm_latency_t;
+
+/** @brief The RDM controller round-trip statistics of one responder UID.*/
+typedef struct rdm_uid_latency_t {
+  /** @brief The UID of the responder.*/
+  rdm_uid_t uid;
+  /** @brief The round-trip statistics of the requests sent to the UID.*/
+  rdm_latency_t latency;
+} rdm_uid_latency_t;
+
+/** @brief The RDM controller round-trip statistics of one PID.*/
+typedef struct rdm_pid_latency_t {
+  /** @brief The PID of the requests.*/
+  rdm_pid_t pid;
+  /** @brief The round-trip statistics of the requests for the PID.*/
+  rdm_latency_t latency;
+} rdm_pid_latency_t;
+
+/** @brief Counters of the RDM controller cache of GET responses. Each counter
+ * wraps around on overflow.*/
+typedef struct rdm_cache_stats_t {
+  /** @brief The number of requests which were answered from the cache.*/
+  uint32_t hit_count;
+  /** @brief The number of cacheable requests which were sent on the RDM bus
+     because their response was not cached.*/
+  uint32_t miss_count;
+  /** @brief The number of cached responses which were invalidated.*/
+  uint32_t invalidate_count;
+} rdm_cache_stats_t;
+
 /** @brief UID which indicates an RDM packet is being broadcast to all devices
  * regardless of manufacturer. Responders shall not respond to RDM broadcast
  * messages.*/
@@ -1,108 +1,232 @@
 #include "rdm/responder.h"
 
+#include <stdlib.h>
 #include <string.h>
 
+#include "dmx/hal/include/nvs.h"
 #include "dmx/hal/include/timer.h"
 #include "dmx/hal/include/uart.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
+#include "rdm/include/driver.h"
 #include "rdm/include/types.h"
 #include "rdm/include/uid.h"
 
-bool rdm_send_response(dmx_port_t dmx_num) {
-  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
-  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+// Patches a byte of a cached response and updates its checksum.
+static void rdm_cache_patch(uint8_t *data, int offset, uint8_t value,
+                            uint16_t *checksum) {
+  *checksum += value - data[offset];
+  data[offset] = value;
+}
 
+// Writes the cached response to a GET request, if there is a valid one. Only
+// the destination UID, transaction number, and message count are patched.
+static size_t rdm_cache_write(dmx_port_t dmx_num, const dmx_parameter_t *entry,
+                              const rdm_header_t *header) {
   dmx_driver_t *const driver = dmx_driver[dmx_num];
+  if (entry->cache == NULL ||
+      entry->cache_generation != driver->device.generation) {
+    return 0;
+  }
+  const size_t size = entry->cache[0] + 2;  // Message length plus checksum
+  uint8_t *const data = driver->dmx.data;
+  dmx_lease_publish(dmx_num);  // Do not overwrite a released write buffer
+  DMX_RDM_HEADER_INVALIDATE(driver);  // The packet in the buffer is replaced
+  memcpy(data, &entry->cache[1], size);
 
-  if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
-    return false;
+  uint16_t checksum = (data[size - 2] << 8) | data[size - 1];
+  const uint16_t man_id = header->src_uid.man_id;
+  const uint32_t dev_id = header->src_uid.dev_id;
+  rdm_cache_patch(data, 3, man_id >> 8, &checksum);
+  rdm_cache_patch(data, 4, man_id, &checksum);
+  rdm_cache_patch(data, 5, dev_id >> 24, &checksum);
+  rdm_cache_patch(data, 6, dev_id >> 16, &checksum);
+  rdm_cache_patch(data, 7, dev_id >> 8, &checksum);
+  rdm_cache_patch(data, 8, dev_id, &checksum);
+  rdm_cache_patch(data, 15, header->tn, &checksum);
+  rdm_cache_patch(data, 17, rdm_queue_size(dmx_num), &checksum);
+  data[size - 2] = checksum >> 8;
+  data[size - 1] = checksum;
+
+  return size;
+}
+
+// Stores the response to a GET request so that it may be sent again without
+// calling the response handler. Only complete RDM_RESPONSE_TYPE_ACK responses
+// are cached.
+static void rdm_cache_store(dmx_port_t dmx_num, dmx_parameter_t *entry,
+                            size_t packet_size) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const uint8_t *const data = driver->dmx.data;
+  if (packet_size < sizeof(rdm_header_t) + 2 ||
+      data[16] != RDM_RESPONSE_TYPE_ACK || packet_size != data[2] + 2) {
+    return;
   }
+  if (entry->cache == NULL) {
+    entry->cache = malloc(RDM_PD_SIZE_MAX + sizeof(rdm_header_t) + 1);
+    if (entry->cache == NULL) {
+      return;
+    }
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->device.memory.cache += RDM_PD_SIZE_MAX + sizeof(rdm_header_t) + 1;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+  entry->cache[0] = data[2];
+  memcpy(&entry->cache[1], data, packet_size);
+  entry->cache_generation = driver->device.generation;
+}
 
-  // Get the RDM header information and update miscellaneous RDM driver fields
-  bool is_rdm;
-  rdm_header_t header;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  is_rdm = rdm_read_header(dmx_num, &header);
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  if (!rdm_cc_is_valid(header.cc)) {
-    is_rdm = false;  // Packet is not RDM if CC is invalid
+// Gets the parameter entry which handles a request. Requests addressed to
+// RDM_SUB_DEVICE_ALL are handled by the first device supporting the parameter.
+static dmx_parameter_t *rdm_get_request_entry(
+    dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid) {
+  if (sub_device < RDM_SUB_DEVICE_MAX) {
+    return dmx_parameter_get_entry(dmx_num, sub_device, pid);
+  } else if (sub_device != RDM_SUB_DEVICE_ALL) {
+    return NULL;
   }
-  const rdm_uid_t *this_uid = rdm_uid_get(dmx_num);
-  if (is_rdm) {
-    // Packet is an RDM request packet
-    if (rdm_uid_is_target(this_uid, &header.dest_uid)) {
-      if (header.pid == driver->dmx.last_request_pid) {
-        ++driver->dmx.last_request_pid_repeats;
-      } else {
-        driver->dmx.last_request_pid_repeats = 0;
+  const dmx_driver_t *const driver = dmx_driver[dmx_num];
+  for (int num = 0; num <= driver->device.sub_devices.max; ++num) {
+    if (dmx_device_get(dmx_num, num) != NULL) {
+      dmx_parameter_t *entry = dmx_parameter_get_entry(dmx_num, num, pid);
+      if (entry != NULL) {
+        return entry;
       }
     }
   }
+  return NULL;
+}
 
-  // Return early if this packet isn't relevant to this device
-  if (!is_rdm || !rdm_uid_is_target(this_uid, &header.dest_uid)) {
-    xSemaphoreGiveRecursive(driver->mux);
-    return false;
+#ifdef CONFIG_RDM_LATENCY_STATS
+// Updates the responder latency statistics with a response which was started
+// after the latency, or which was missed if the latency is negative.
+static void rdm_responder_measure(dmx_driver_t *driver, int64_t latency) {
+  rdm_responder_latency_t *const stats = &driver->latency.responder;
+  taskENTER_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+  if (latency < 0) {
+    ++stats->missed_count;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+    return;
+  }
+  const uint32_t micros = latency > UINT32_MAX ? UINT32_MAX : latency;
+  ++stats->response_count;
+  if (micros > RDM_TIMING_RESPONDER_MAX) {
+    ++stats->late_count;
+  }
+  if (stats->response_count == 1) {
+    stats->latency_min = micros;
+    stats->latency_avg = micros;
+    stats->latency_max = micros;
+  } else {
+    if (micros < stats->latency_min) {
+      stats->latency_min = micros;
+    }
+    if (micros > stats->latency_max) {
+      stats->latency_max = micros;
+    }
+    // Exponential moving average with a weight of 1/16 per response
+    stats->latency_avg =
+        stats->latency_avg - (stats->latency_avg >> 4) + (micros >> 4);
   }
+  const uint32_t bucket = micros / RDM_LATENCY_HISTOGRAM_BUCKET_US;
+  ++stats->histogram[bucket < RDM_LATENCY_HISTOGRAM_SIZE
+                         ? bucket
+                         : RDM_LATENCY_HISTOGRAM_SIZE - 1];
+  taskEXIT_CRITICAL(DMX_SPINLOCK(driver->dmx_num));
+}
+#endif
 
-  // Update PID of the last request to target this device
-  driver->dmx.last_request_pid = header.pid;
+// Returns true if an RDM request targets the responder of the DMX port or one
+// of its virtual responders.
+static bool rdm_responder_is_target(const dmx_driver_t *driver,
+                                    const rdm_header_t *header) {
+  if (rdm_uid_is_target(&driver->uid, &header->dest_uid)) {
+    return true;
+  } else if (!rdm_uid_is_broadcast(&header->dest_uid)) {
+    return dmx_responder_find(driver, &header->dest_uid) > 0;
+  }
+  for (int i = 0; i < driver->responders.count; ++i) {
+    if (rdm_uid_is_target(&driver->responders.index[i].uid,
+                          &header->dest_uid)) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  // Get parameter definition
+// Handles an RDM request with the selected responder, then sends its response
+// and calls the after-response callback. Returns true if a response was sent.
+static bool rdm_respond(dmx_port_t dmx_num, rdm_header_t *header) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // Get the parameter entry, which includes its definition and callback
   size_t packet_size;  // Size of the response packet
+  dmx_parameter_t *parameter =
+      rdm_get_request_entry(dmx_num, header->sub_device, header->pid);
   const rdm_parameter_definition_t *def =
-      rdm_definition_get(dmx_num, header.sub_device, header.pid);
+      parameter != NULL ? parameter->definition : NULL;
   if (def == NULL) {
     // Unknown PID
-    packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_UNKNOWN_PID);
-  } else if ((header.sub_device >= RDM_SUB_DEVICE_MAX &&
-              header.sub_device != RDM_SUB_DEVICE_ALL) ||
-             header.pdl >= RDM_PD_SIZE_MAX) {
+    packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_UNKNOWN_PID);
+  } else if ((header->sub_device >= RDM_SUB_DEVICE_MAX &&
+              header->sub_device != RDM_SUB_DEVICE_ALL) ||
+             header->pdl >= RDM_PD_SIZE_MAX) {
     // Header format is invalid
-    packet_size = rdm_write_nack_reason(dmx_num, &header, RDM_NR_FORMAT_ERROR);
+    packet_size = rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
   } else {
     // Request is valid, handle the response
 
     // Validate the header against definition information
     const rdm_pid_cc_t pid_cc = def->pid_cc;
-    if (pid_cc == RDM_CC_DISC && header.cc != RDM_CC_DISC_COMMAND) {
+    if (pid_cc == RDM_CC_DISC && header->cc != RDM_CC_DISC_COMMAND) {
       packet_size = 0;  // Cannot send NACK to RDM_CC_DISC_COMMAND
-    } else if ((pid_cc == RDM_CC_GET_SET && header.cc == RDM_CC_DISC_COMMAND) ||
-               (pid_cc == RDM_CC_GET && header.cc != RDM_CC_GET_COMMAND) ||
-               (pid_cc == RDM_CC_SET && header.cc != RDM_CC_SET_COMMAND)) {
+    } else if ((pid_cc == RDM_CC_GET_SET &&
+                header->cc == RDM_CC_DISC_COMMAND) ||
+               (pid_cc == RDM_CC_GET && header->cc != RDM_CC_GET_COMMAND) ||
+               (pid_cc == RDM_CC_SET && header->cc != RDM_CC_SET_COMMAND)) {
       // Unsupported command class
-      packet_size = rdm_write_nack_reason(dmx_num, &header,
+      packet_size = rdm_write_nack_reason(dmx_num, header,
                                           RDM_NR_UNSUPPORTED_COMMAND_CLASS);
     } else {
       // Call the response handler for the parameter
-      if (header.cc == RDM_CC_SET_COMMAND) {
-        packet_size = def->set.handler(dmx_num, def, &header);
+      const bool is_cacheable = parameter->cache_response &&
+                                header->cc == RDM_CC_GET_COMMAND &&
+                                header->pdl == 0 &&
+                                header->sub_device < RDM_SUB_DEVICE_MAX;
+      if (header->cc == RDM_CC_SET_COMMAND) {
+        packet_size = def->set.handler(dmx_num, def, header);
+      } else if (is_cacheable) {
+        // Send the cached response or cache the response of the handler
+        packet_size = rdm_cache_write(dmx_num, parameter, header);
+        if (packet_size == 0) {
+          packet_size = def->get.handler(dmx_num, def, header);
+          rdm_cache_store(dmx_num, parameter, packet_size);
+        }
       } else {
         // RDM_CC_DISC_COMMAND uses get.handler()
-        packet_size = def->get.handler(dmx_num, def, &header);
+        packet_size = def->get.handler(dmx_num, def, header);
       }
 
       // Validate the response
-      if (header.pid == RDM_PID_DISC_UNIQUE_BRANCH &&
+      if (header->pid == RDM_PID_DISC_UNIQUE_BRANCH &&
           ((packet_size > 0 && packet_size < 17) || packet_size > 24)) {
         // Invalid RDM_CC_DISC_COMMAND_RESPONSE packet size
         packet_size = 0;  // Silence invalid discovery responses
         rdm_set_boot_loader(dmx_num);
       } else if (packet_size > 255 ||
                  (packet_size == 0 &&
-                  !rdm_uid_is_broadcast(&header.dest_uid))) {
+                  !rdm_uid_is_broadcast(&header->dest_uid))) {
         // Response size is too large or zero after a non-broadcast request
         packet_size =
-            rdm_write_nack_reason(dmx_num, &header, RDM_NR_HARDWARE_FAULT);
+            rdm_write_nack_reason(dmx_num, header, RDM_NR_HARDWARE_FAULT);
         rdm_set_boot_loader(dmx_num);
       }
     }
   }
 
   // Do not send a response to non-discovery broadcast packets
-  if (rdm_uid_is_broadcast(&header.dest_uid) &&
-      header.pid != RDM_PID_DISC_UNIQUE_BRANCH) {
+  if (rdm_uid_is_broadcast(&header->dest_uid) &&
+      header->pid != RDM_PID_DISC_UNIQUE_BRANCH) {
     packet_size = 0;
   }
 
@@ -110,36 +234,343 @@ bool rdm_send_response(dmx_port_t dmx_num) {
   if (packet_size > 0) {
     if (!dmx_send_num(dmx_num, packet_size)) {
       rdm_set_boot_loader(dmx_num);
+#ifdef CONFIG_RDM_LATENCY_STATS
+      rdm_responder_measure(driver, -1);
+#endif
       // Generate information for the warning message if a response wasn't sent
       const int64_t micros_elapsed = dmx_timer_get_micros_since_boot() -
                                      driver->dmx.controller_eop_timestamp;
-      const char *cc_str = header.cc == RDM_CC_GET_COMMAND   ? "GET"
-                           : header.cc == RDM_CC_SET_COMMAND ? "SET"
+      const char *cc_str = header->cc == RDM_CC_GET_COMMAND   ? "GET"
+                           : header->cc == RDM_CC_SET_COMMAND ? "SET"
                                                              : "DISC";
       DMX_WARN(
           "PID 0x%04x did not send a response (cc: %s, size: %i, time: %lli "
           "us)",
-          header.pid, cc_str, packet_size, micros_elapsed);
+          header->pid, cc_str, packet_size, micros_elapsed);
     } else {
+#ifdef CONFIG_RDM_LATENCY_STATS
+      // The response is started when dmx_send_num() returns
+      dmx_driver_state_t state;
+      dmx_driver_get_state(driver, &state);
+      rdm_responder_measure(driver, dmx_timer_get_micros_since_boot() -
+                                        state.controller_eop_timestamp);
+#endif
       dmx_wait_sent(dmx_num, dmx_ms_to_ticks(23));
       taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+      DMX_STATE_WRITE_BEGIN(driver);
       driver->dmx.head = DMX_HEAD_WAITING_FOR_BREAK;
+      DMX_STATE_WRITE_END(driver);
       dmx_uart_set_rts(dmx_num, 1);
+      driver->dmx.tx_break_was_sent = false;
       taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
   }
 
   // Call the after-response callback
-  const dmx_parameter_t *parameter =
-      dmx_parameter_get_entry(dmx_num, header.sub_device, header.pid);
-  if (parameter != NULL && parameter->callback != NULL) {
+  rdm_callback_t callback = NULL;
+  void *context = NULL;
+  if (parameter != NULL) {
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    callback = parameter->callback;
+    context = parameter->context;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+  if (callback != NULL) {
     rdm_header_t response_header;
     if (!rdm_read_header(dmx_num, &response_header)) {
       // Set the response header to NULL if an RDM header can't be read
       memset(&response_header, 0, sizeof(response_header));
     }
-    parameter->callback(dmx_num, &header, &response_header, parameter->context);
+    callback(dmx_num, header, &response_header, context);
   }
 
   return (packet_size > 0);
-}
\ No newline at end of file
+}
+
+bool rdm_send_response(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  if (!xSemaphoreTakeRecursive(driver->mux, 0)) {
+    return false;
+  }
+
+  // Get the RDM header information and update miscellaneous RDM driver fields
+  bool is_rdm;
+  rdm_header_t header;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  is_rdm = rdm_read_header(dmx_num, &header);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (!rdm_cc_is_valid(header.cc)) {
+    is_rdm = false;  // Packet is not RDM if CC is invalid
+  }
+  const bool is_broadcast = rdm_uid_is_broadcast(&header.dest_uid);
+  const bool is_target = is_rdm && rdm_responder_is_target(driver, &header);
+  if (is_target) {
+    // Only count repeats which request the next page of an ACK overflow
+    if (header.pid == driver->dmx.last_request_pid &&
+        driver->dmx.last_response_was_overflow) {
+      ++driver->dmx.last_request_pid_repeats;
+    } else {
+      driver->dmx.last_request_pid_repeats = 0;
+    }
+    driver->dmx.last_response_was_overflow = false;
+  }
+
+  // Return early if this packet isn't relevant to this device
+  if (!is_target) {
+    xSemaphoreGiveRecursive(driver->mux);
+    return false;
+  }
+
+  // Update PID of the last request to target this device
+  driver->dmx.last_request_pid = header.pid;
+
+  // The responder which handles the request is selected for this task
+  bool ret = false;
+  const uint16_t selected = dmx_responder_get_selected(driver);
+  if (!is_broadcast) {
+    // Unicast requests are handled by the responder which has the UID
+    dmx_responder_set_selected(
+        driver, dmx_responder_find(driver, &header.dest_uid), true);
+    ret = rdm_respond(dmx_num, &header);
+  } else if (driver->responders.count == 0) {
+    dmx_responder_set_selected(driver, 0, true);
+    ret = rdm_respond(dmx_num, &header);
+  } else {
+    // Keep a copy of the request because responses overwrite it
+    uint8_t request[RDM_PACKET_SIZE_MAX];
+    const size_t request_size = header.message_len + 2;  // Include checksum
+    memcpy(request, driver->dmx.data, request_size);
+
+    // Discovery requests are only handled by responders within the branch
+    rdm_disc_unique_branch_t branch;
+    const bool is_disc = header.pid == RDM_PID_DISC_UNIQUE_BRANCH;
+    if (is_disc && !rdm_read_pd(dmx_num, "uu$", &branch, sizeof(branch))) {
+      xSemaphoreGiveRecursive(driver->mux);
+      return false;  // Don't send a response on error
+    }
+    const rdm_uid_t lower_bound = branch.lower_bound;
+    const rdm_uid_t upper_bound = branch.upper_bound;
+
+    // Handle the request with the responder of the DMX port and then with the
+    // virtual responders in UID order. Only one discovery response is sent.
+    const dmx_responder_index_t *const index = driver->responders.index;
+    bool is_first = true;
+    for (int i = -1; i < (int)driver->responders.count && !ret; ++i) {
+      const rdm_uid_t *uid = i < 0 ? &driver->uid : &index[i].uid;
+      if (!rdm_uid_is_target(uid, &header.dest_uid)) {
+        continue;
+      } else if (is_disc && (rdm_uid_is_lt(uid, &lower_bound) ||
+                             rdm_uid_is_gt(uid, &upper_bound))) {
+        if (i >= 0 && rdm_uid_is_gt(uid, &upper_bound)) {
+          break;  // No more virtual responders are within the branch
+        }
+        continue;
+      }
+
+      // Restore the request which was overwritten by the previous response
+      if (!is_first) {
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        DMX_RDM_HEADER_INVALIDATE(driver);
+        memcpy(driver->dmx.data, request, request_size);
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      }
+      is_first = false;
+
+      rdm_header_t request_header = header;
+      dmx_responder_set_selected(driver, i < 0 ? 0 : index[i].num, true);
+      ret = rdm_respond(dmx_num, &request_header);
+    }
+  }
+  dmx_responder_set_selected(driver, selected, true);
+
+  xSemaphoreGiveRecursive(driver->mux);
+
+  return ret;
+}
+
+bool rdm_get_responder_latency(dmx_port_t dmx_num,
+                               rdm_responder_latency_t *latency) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(latency != NULL, false, "latency is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(latency, &driver->latency.responder, sizeof(*latency));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("RDM latency statistics are disabled in the Kconfig");
+  return false;
+#endif
+}
+
+bool rdm_reset_responder_latency(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+#ifdef CONFIG_RDM_LATENCY_STATS
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memset(&driver->latency.responder, 0, sizeof(driver->latency.responder));
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return true;
+#else
+  DMX_WARN("RDM latency statistics are disabled in the Kconfig");
+  return false;
+#endif
+}
+
+int rdm_responder_add(dmx_port_t dmx_num, const rdm_uid_t *uid) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(uid != NULL, 0, "uid is null");
+  DMX_CHECK(!rdm_uid_is_null(uid) && !rdm_uid_is_broadcast(uid), 0,
+            "uid error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(driver->responders.max > 0, 0,
+            "virtual responders are not enabled");
+
+  // Take the mutex so that requests are not handled while the table changes
+  if (!xSemaphoreTakeRecursive(driver->mux, portMAX_DELAY)) {
+    return 0;
+  }
+  if (driver->responders.count == driver->responders.max) {
+    xSemaphoreGiveRecursive(driver->mux);
+    DMX_CHECK(false, 0, "virtual responder table is full");
+  } else if (dmx_responder_find(driver, uid) >= 0) {
+    xSemaphoreGiveRecursive(driver->mux);
+    DMX_CHECK(false, 0, "uid is already in use");
+  }
+
+  // Initialize the next entry of the virtual responder table
+  const int num = driver->responders.count + 1;
+  dmx_responder_t *const responder =
+      (dmx_responder_t *)(driver->responders.table +
+                          (num - 1) * driver->responders.stride);
+  responder->uid = *uid;
+  responder->root.num = RDM_SUB_DEVICE_MAX + num - 1;
+  dmx_device_reset(&responder->root, driver->device.parameter_count.root);
+
+  // Copy the parameters of the root device of the DMX port. Parameter data is
+  // copied so that each responder has its own state.
+  const uint16_t selected = dmx_responder_get_selected(driver);
+  const dmx_device_t *const source = &driver->device.root;
+  dmx_responder_set_selected(driver, num, true);
+  bool ok = true;
+  for (int i = 0; i < source->parameter_count && ok; ++i) {
+    const dmx_parameter_t *const parameter = &source->parameters[i];
+    const int type =
+        parameter->type == DMX_PARAMETER_TYPE_NON_VOLATILE_STAGED
+            ? DMX_PARAMETER_TYPE_NON_VOLATILE
+            : parameter->type;
+    ok = dmx_parameter_add(dmx_num, RDM_SUB_DEVICE_ROOT, parameter->pid, type,
+                           parameter->data, parameter->size);
+    if (ok) {
+      dmx_parameter_t *const entry = &responder->root.parameters[i];
+      entry->definition = parameter->definition;
+      entry->callback = parameter->callback;
+      entry->context = parameter->context;
+      entry->cache_response = parameter->cache_response;
+    }
+  }
+  dmx_responder_set_selected(driver, selected, true);
+
+  for (int i = 0; i < responder->root.parameter_count && ok; ++i) {
+    dmx_parameter_t *const entry = &responder->root.parameters[i];
+    if (entry->type == DMX_PARAMETER_TYPE_STATIC) {
+      // Static parameters which alias another parameter, such as
+      // RDM_PID_DISC_UN_MUTE, must alias the copy of that parameter
+      for (int j = 0; j < source->parameter_count; ++j) {
+        if (j != i && source->parameters[j].data == entry->data &&
+            source->parameters[j].type != DMX_PARAMETER_TYPE_STATIC) {
+          entry->data = responder->root.parameters[j].data;
+          break;
+        }
+      }
+    } else if (entry->pid == RDM_PID_DISC_MUTE) {
+      memset(entry->data, 0, entry->size);  // New responders are not muted
+    } else if (entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) {
+      // Use the value which was stored for this responder, if there is one
+      uint8_t value[RDM_PD_SIZE_MAX];
+      if (entry->size <= sizeof(value) &&
+          dmx_nvs_get(dmx_num, responder->root.num, entry->pid, value,
+                      entry->size) == entry->size) {
+        memcpy(entry->data, value, entry->size);
+      }
+    }
+  }
+
+  if (ok) {
+    // Insert the responder into the index so that it remains sorted by UID
+    dmx_responder_index_t *const index = driver->responders.index;
+    int i = driver->responders.count;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    for (; i > 0 && rdm_uid_is_gt(&index[i - 1].uid, uid); --i) {
+      index[i] = index[i - 1];
+    }
+    index[i].uid = *uid;
+    index[i].num = num;
+    ++driver->responders.count;
+    ++driver->device.generation;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  } else {
+    // Free the parameters which were copied before the error
+    for (int i = 0; i < responder->root.parameter_count; ++i) {
+      const dmx_parameter_t *const entry = &responder->root.parameters[i];
+      const uint8_t *data = entry->data;
+      if ((entry->type == DMX_PARAMETER_TYPE_DYNAMIC ||
+           entry->type == DMX_PARAMETER_TYPE_NON_VOLATILE) &&
+          (data < driver->device.memory.arena ||
+           data >= driver->device.memory.arena + driver->device.memory.size)) {
+        free(entry->data);
+        taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+        driver->device.memory.heap -= entry->size;
+        taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+      }
+    }
+    responder->root.parameter_count = 0;
+    DMX_ERR("virtual responder parameter error");
+  }
+
+  xSemaphoreGiveRecursive(driver->mux);
+  return ok ? num : 0;
+}
+
+bool rdm_responder_select(dmx_port_t dmx_num, int responder_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  DMX_CHECK(responder_num >= 0 && responder_num <= driver->responders.count,
+            false, "responder_num error");
+
+  DMX_CHECK(dmx_responder_set_selected(driver, responder_num, false), false,
+            "too many tasks have selected a virtual responder");
+
+  return true;
+}
+
+int rdm_responder_get_selected(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, -1, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), -1, "driver is not installed");
+
+  return dmx_responder_get_selected(dmx_driver[dmx_num]);
+}
+
+int rdm_responder_get_count(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  return dmx_driver[dmx_num]->responders.count;
+}
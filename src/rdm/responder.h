@@ -43,6 +43,97 @@ typedef void (*rdm_callback_t)(dmx_port_t dmx_num, rdm_header_t *request_header,
  */
 bool rdm_send_response(dmx_port_t dmx_num);
 
+/**
+ * @brief Reads the latency statistics of the RDM responses which were sent by
+ * rdm_send_response(). Latency is measured from the end-of-packet of each
+ * request to the start of its response and is binned into a histogram against
+ * the 2000 microsecond responder deadline.
+ *
+ * @note The RDM_LATENCY_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[out] latency A pointer to an rdm_responder_latency_t into which the
+ * statistics are copied.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_get_responder_latency(dmx_port_t dmx_num,
+                               rdm_responder_latency_t *latency);
+
+/**
+ * @brief Resets the latency statistics of the RDM responses which were sent by
+ * rdm_send_response().
+ *
+ * @note The RDM_LATENCY_STATS option must be enabled in the Kconfig.
+ *
+ * @param dmx_num The DMX port number.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_reset_responder_latency(dmx_port_t dmx_num);
+
+/**
+ * @brief Adds a virtual RDM responder to the DMX port. The virtual responder
+ * responds to RDM requests which are addressed to its UID as if it were a
+ * separate device on the RDM bus. It receives a copy of each parameter which
+ * is registered on the root device of the DMX port when it is added, so it
+ * should be added after the parameters of the DMX port are registered. Each
+ * virtual responder then has its own parameter values, including its
+ * discovery mute state and its DMX start address. The parameters of a virtual
+ * responder are read and written by selecting it with rdm_responder_select()
+ * and calling the usual parameter functions.
+ *
+ * @note Virtual responders do not have sub-devices. The virtual responder
+ * table must be allocated with the virtual_responder_count field of the
+ * dmx_config_t when the DMX driver is installed.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] uid A pointer to the UID of the virtual responder.
+ * @return The responder number of the virtual responder, beginning at 1, or 0
+ * on failure.
+ */
+int rdm_responder_add(dmx_port_t dmx_num, const rdm_uid_t *uid);
+
+/**
+ * @brief Selects the responder of the DMX port which is used by the RDM
+ * parameter functions, such as rdm_get_device_label() or
+ * rdm_set_dmx_start_address(), on the calling task. Responder number 0 is the
+ * responder of the DMX port itself. RDM response callbacks are called while
+ * the responder which handled the request is selected.
+ *
+ * The selection does not hold a lock, so other tasks are not blocked while a
+ * virtual responder is selected. Up to RDM_RESPONDER_SELECT_MAX tasks may have
+ * a virtual responder selected at once, which can be set in the Kconfig. A
+ * task should select responder 0 once it is done with a virtual responder, and
+ * before it is deleted, so that its selection is freed for other tasks.
+ *
+ * @param dmx_num The DMX port number.
+ * @param responder_num The responder number returned by rdm_responder_add(),
+ * or 0 to select the responder of the DMX port.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_responder_select(dmx_port_t dmx_num, int responder_num);
+
+/**
+ * @brief Gets the number of the responder which is selected on the DMX port
+ * for the calling task.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The selected responder number, 0 if the responder of the DMX port is
+ * selected, or -1 on failure.
+ */
+int rdm_responder_get_selected(dmx_port_t dmx_num);
+
+/**
+ * @brief Gets the number of virtual responders which have been added to the
+ * DMX port.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of virtual responders.
+ */
+int rdm_responder_get_count(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
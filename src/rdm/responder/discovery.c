@@ -8,6 +8,29 @@
 #include "rdm/include/driver.h"
 #include "rdm/include/uid.h"
 
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+// Keeps a copy of a discovery response which was encoded with rdm_write() so
+// that the DMX interrupt may send it again without waking the task.
+static void rdm_disc_isr_store(dmx_port_t dmx_num, const rdm_header_t *header,
+                               size_t packet_size) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  uint8_t *const is_muted = dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT,
+                                                   RDM_PID_DISC_MUTE);
+  struct dmx_driver_disc_isr_t *const disc = &driver->disc_isr;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (header->pid == RDM_PID_DISC_UNIQUE_BRANCH) {
+    if (packet_size == sizeof(disc->unique_branch)) {
+      memcpy(disc->unique_branch, driver->dmx.data, packet_size);
+    }
+  } else if (packet_size > 0 && packet_size <= sizeof(disc->mute)) {
+    memcpy(disc->mute, driver->dmx.data, packet_size);
+  }
+  disc->is_muted = is_muted;
+  disc->generation = driver->device.generation;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+}
+#endif
+
 static size_t rdm_rhd_discovery(dmx_port_t dmx_num,
                                 const rdm_parameter_definition_t *definition,
                                 const rdm_header_t *header) {
@@ -22,6 +45,9 @@ static size_t rdm_rhd_discovery(dmx_port_t dmx_num,
     dmx_parameter_copy(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_DISC_MUTE,
                        &is_muted, sizeof(is_muted));
     if (is_muted) {
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+      rdm_disc_isr_store(dmx_num, header, 0);
+#endif
       return 0;
     }
 
@@ -36,10 +62,17 @@ static size_t rdm_rhd_discovery(dmx_port_t dmx_num,
     const rdm_uid_t *this_uid = rdm_uid_get(dmx_num);
     if (rdm_uid_is_lt(this_uid, &branch.lower_bound) ||
         rdm_uid_is_gt(this_uid, &branch.upper_bound)) {
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+      rdm_disc_isr_store(dmx_num, header, 0);
+#endif
       return 0;  // Request not for this device
     }
 
-    return rdm_write_ack(dmx_num, header, NULL, NULL, 0);
+    const size_t packet_size = rdm_write_ack(dmx_num, header, NULL, NULL, 0);
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+    rdm_disc_isr_store(dmx_num, header, packet_size);
+#endif
+    return packet_size;
   } else {
     // Set or unset the mute parameter
     const uint8_t set_mute = (header->pid == RDM_PID_DISC_MUTE);
@@ -71,8 +104,13 @@ static size_t rdm_rhd_discovery(dmx_port_t dmx_num,
     mute.boot_loader = rdm_get_boot_loader(dmx_num);
     mute.proxied_device = 0;  // TODO: proxied device flag
 
-    return rdm_write_ack(dmx_num, header, definition->get.response.format,
-                         &mute, sizeof(mute));
+    const size_t packet_size =
+        rdm_write_ack(dmx_num, header, definition->get.response.format, &mute,
+                      sizeof(mute));
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+    rdm_disc_isr_store(dmx_num, header, packet_size);
+#endif
+    return packet_size;
   }
 }
 
@@ -12,6 +12,12 @@
 static size_t rdm_rhd_set_dmx_personality(
     dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
     const rdm_header_t *header) {
+  // Personalities are only supported by the root device
+  if (header->sub_device == RDM_SUB_DEVICE_ALL) {
+    return rdm_write_nack_reason(dmx_num, header,
+                                 RDM_NR_SUB_DEVICE_OUT_OF_RANGE);
+  }
+
   // Get the personality number from the packet
   uint8_t personality_num;
   if (!rdm_read_pd(dmx_num, definition->set.request.format, &personality_num,
@@ -110,8 +116,10 @@ bool rdm_register_dmx_personality(dmx_port_t dmx_num, uint8_t personality_count,
   const rdm_pid_t pid = RDM_PID_DMX_PERSONALITY;
 
   // Attempt to load the value from NVS
+  const rdm_sub_device_t device_num =
+      dmx_device_get(dmx_num, RDM_SUB_DEVICE_ROOT)->num;
   rdm_dmx_personality_t personality;
-  if (!dmx_nvs_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &personality,
+  if (!dmx_nvs_get(dmx_num, device_num, pid, &personality,
                    sizeof(personality)) ||
       personality.count != personality_count) {
     personality.current = 1;
@@ -236,8 +244,10 @@ bool rdm_register_dmx_start_address(dmx_port_t dmx_num, rdm_callback_t cb,
   const rdm_pid_t pid = RDM_PID_DMX_START_ADDRESS;
 
   // Attempt to load the value from NVS
+  const rdm_sub_device_t device_num =
+      dmx_device_get(dmx_num, RDM_SUB_DEVICE_ROOT)->num;
   uint16_t dmx_start_address;
-  if (!dmx_nvs_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &dmx_start_address,
+  if (!dmx_nvs_get(dmx_num, device_num, pid, &dmx_start_address,
                    sizeof(dmx_start_address))) {
     dmx_start_address = 1;
   }
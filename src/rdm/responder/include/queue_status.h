@@ -36,8 +36,30 @@ extern "C" {
 bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count,
                                  rdm_callback_t cb, void *context);
 
+/**
+ * @brief Registers the default response to RDM_PID_STATUS_MESSAGE and
+ * RDM_PID_CLEAR_STATUS_ID requests. Status messages are pushed with
+ * rdm_status_push() and are drained by RDM controllers, as many per response as
+ * fit in the parameter data. Status messages are also returned in responses to
+ * RDM_PID_QUEUED_MESSAGE requests when the RDM queue is empty.
+ *
+ * @param dmx_num The DMX port number.
+ * @param max_count The maximum number of status messages that can be waiting
+ * to be collected. It is rounded up to a power of two.
+ * @param cb A callback which is called after receiving a request for this
+ * parameter.
+ * @param[inout] context A pointer to context which is used in the user
+ * callback.
+ * @return true if the parameter was registered.
+ * @return false on failure.
+ */
+bool rdm_register_status_messages(dmx_port_t dmx_num, uint32_t max_count,
+                                  rdm_callback_t cb, void *context);
+
 /**
  * @brief Push a parameter ID to the RDM queue, if it has been instantiated.
+ * The RDM queue is lock-free so this function may be called from any task on
+ * either core without blocking the RDM responder.
  *
  * @param dmx_num The DMX port number.
  * @param pid The parameter ID to push to the RDM queue.
@@ -46,6 +68,18 @@ bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count,
  */
 bool rdm_queue_push(dmx_port_t dmx_num, rdm_pid_t pid);
 
+/**
+ * @brief Push a parameter ID to the RDM queue from an ISR. This function does
+ * not log errors. It is placed in IRAM when the DMX driver ISR is placed in
+ * IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param pid The parameter ID to push to the RDM queue.
+ * @return true if the PID was pushed to the queue.
+ * @return false on failure.
+ */
+bool rdm_queue_push_from_isr(dmx_port_t dmx_num, rdm_pid_t pid);
+
 /**
  * @brief Pops a parameter ID from the RDM queue, if it exists.
  *
@@ -74,6 +108,40 @@ uint8_t rdm_queue_size(dmx_port_t dmx_num);
  */
 rdm_pid_t rdm_queue_previous(dmx_port_t dmx_num);
 
+/**
+ * @brief Pushes a status message so that it may be collected by an RDM
+ * controller with RDM_PID_STATUS_MESSAGE, if it has been registered. Status
+ * messages are lock-free so this function may be called from any task on
+ * either core without blocking the RDM responder.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] message A pointer to the status message to push.
+ * @return true if the status message was pushed.
+ * @return false on failure or if too many status messages are waiting.
+ */
+bool rdm_status_push(dmx_port_t dmx_num, const rdm_status_message_t *message);
+
+/**
+ * @brief Pushes a status message from an ISR. This function does not log
+ * errors or validate the status message. It is placed in IRAM when the DMX
+ * driver ISR is placed in IRAM.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] message A pointer to the status message to push.
+ * @return true if the status message was pushed.
+ * @return false on failure or if too many status messages are waiting.
+ */
+bool rdm_status_push_from_isr(dmx_port_t dmx_num,
+                              const rdm_status_message_t *message);
+
+/**
+ * @brief Gets the number of status messages which are waiting to be collected.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The number of status messages or 0 on failure.
+ */
+size_t rdm_status_get_count(dmx_port_t dmx_num);
+
 #ifdef __cplusplus
 }
 #endif
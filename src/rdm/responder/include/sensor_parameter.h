@@ -109,6 +109,36 @@ size_t rdm_sensor_get(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 bool rdm_sensor_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                     uint8_t sensor_num, int16_t value);
 
+/**
+ * @brief Sets the values of many sensors at once. Each element of values is
+ * written to the sensor given by its sensor_num field, including the lowest,
+ * highest, and recorded values. The values are written in a single critical
+ * section so that RDM controllers and rdm_sensor_get_values() never observe a
+ * partially applied update. No values are written if any sensor_num is
+ * invalid.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sub_device The sub-device number.
+ * @param[in] values An array of sensor values to write.
+ * @param count The number of elements in values.
+ * @return The number of sensors which were written.
+ */
+size_t rdm_sensor_set_values(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                             const rdm_sensor_value_t *values, size_t count);
+
+/**
+ * @brief Copies a consistent snapshot of the values of the first count sensors
+ * into a user buffer. The sensors are copied in a single critical section.
+ *
+ * @param dmx_num The DMX port number.
+ * @param sub_device The sub-device number.
+ * @param[out] values An array into which to copy the sensor values.
+ * @param count The number of elements in values.
+ * @return The number of sensor values which were copied.
+ */
+size_t rdm_sensor_get_values(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                             rdm_sensor_value_t *values, size_t count);
+
 /**
  * @brief Records the current value set in a specified sensor. The value
  * recorded on the sensor is the last value that was set using rdm_sensor_set().
@@ -84,18 +84,75 @@ size_t rdm_write_ack(dmx_port_t dmx_num, const rdm_header_t *header,
 size_t rdm_write_nack_reason(dmx_port_t dmx_num, const rdm_header_t *header,
                              rdm_nr_t nack_reason);
 
-/*
-// TODO: implement rdm_write_ack_timer()
+/**
+ * @brief Writes an ACK timer response to a RDM request packet. This function
+ * should be used by response handlers which cannot complete the request before
+ * the RDM response deadline, such as handlers which write to non-volatile
+ * storage. The handler returns the value of this function and completes the
+ * request afterwards, such as in another task. When the request is complete,
+ * rdm_queue_push() must be called with the PID of the request so that the
+ * controller can collect the response with RDM_PID_QUEUED_MESSAGE. Until then,
+ * RDM_PID_QUEUED_MESSAGE requests are answered with the remaining time.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param ready_ticks The estimated number of FreeRTOS ticks until the response
+ * will be ready. It is rounded up to the nearest 100 milliseconds.
+ * @return The number of bytes written.
+ */
 size_t rdm_write_ack_timer(dmx_port_t dmx_num, const rdm_header_t *header,
                            TickType_t ready_ticks);
-*/
 
-/*
-// TODO: implement rdm_write_ack_overflow()
+/**
+ * @brief Writes a single page of an ACK overflow response to a RDM request
+ * packet. Every page except the last page is sent with a response type of
+ * RDM_RESPONSE_TYPE_ACK_OVERFLOW. The last page is sent with a response type of
+ * RDM_RESPONSE_TYPE_ACK. This function should be used by response handlers
+ * which generate their own pages. Most response handlers should use
+ * rdm_write_ack_overflow() instead.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[in] pd A pointer to the parameter data of the page.
+ * @param pdl The parameter data length of the page.
+ * @param is_last_page True if this is the last page of the parameter data.
+ * @return The number of bytes written.
+ */
+size_t rdm_write_ack_page(dmx_port_t dmx_num, const rdm_header_t *header,
+                          const char *format, const void *pd, size_t pdl,
+                          bool is_last_page);
+
+/**
+ * @brief Writes an ACK overflow response to a RDM request packet. Parameter
+ * data which is too large to fit in a single RDM packet is split into pages,
+ * and the requested page is written. When the format string repeats, pages
+ * hold a whole number of repetitions. Controllers request each following page
+ * by repeating the request, so the page argument should usually be the value
+ * returned by rdm_get_ack_overflow_page(). If the parameter data fits in a
+ * single page, an ordinary RDM_RESPONSE_TYPE_ACK is written.
+ *
+ * @param dmx_num The DMX port number.
+ * @param[in] header A pointer to the header of the RDM request packet.
+ * @param[in] format The format string of the RDM parameter data.
+ * @param[in] pd A pointer to all of the parameter data of the parameter.
+ * @param pdl The parameter data length of all of the parameter data.
+ * @param page The index of the page to write.
+ * @return The number of bytes written.
+ */
 size_t rdm_write_ack_overflow(dmx_port_t dmx_num, const rdm_header_t *header,
                               const char *format, const void *pd, size_t pdl,
                               int page);
-*/
+
+/**
+ * @brief Gets the index of the ACK overflow page which is requested by the RDM
+ * request currently being handled. This is 0 unless the request repeats the
+ * PID of a request which received an RDM_RESPONSE_TYPE_ACK_OVERFLOW response.
+ *
+ * @param dmx_num The DMX port number.
+ * @return The index of the requested page.
+ */
+int rdm_get_ack_overflow_page(dmx_port_t dmx_num);
 
 /**
  * @brief Gets the RDM boot-loader flag. The boot-loader flag is true when the
@@ -155,6 +212,24 @@ bool rdm_definition_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 const rdm_parameter_definition_t *rdm_definition_get(
     dmx_port_t dmx_num, rdm_sub_device_t sub_device, rdm_pid_t pid);
 
+/**
+ * @brief Allows the encoded GET responses of the desired DMX parameter to be
+ * cached. A cached response is sent by copying it and patching its destination
+ * UID, transaction number, message count, and checksum, so the parameter's
+ * response handler is not called. Cached responses are invalidated whenever a
+ * parameter is added or set with dmx_parameter_set(). This should only be
+ * enabled for parameters whose GET response depends only on parameter data
+ * which is updated with dmx_parameter_set().
+ *
+ * @param dmx_num The DMX port number.
+ * @param sub_device The sub-device number.
+ * @param pid The parameter ID of the desired parameter.
+ * @return true on success.
+ * @return false on failure.
+ */
+bool rdm_response_cache_enable(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                               rdm_pid_t pid);
+
 /**
  * @brief Sets the callback function and context for requests to the desired
  * sub-device and parameter ID. The callback function is handled after a
@@ -15,8 +15,10 @@ bool rdm_register_device_hours(dmx_port_t dmx_num, rdm_callback_t cb,
   const rdm_pid_t pid = RDM_PID_DEVICE_HOURS;
 
   // Attempt to load the value from NVS
+  const rdm_sub_device_t device_num =
+      dmx_device_get(dmx_num, RDM_SUB_DEVICE_ROOT)->num;
   uint32_t device_hours;
-  if (!dmx_nvs_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &device_hours,
+  if (!dmx_nvs_get(dmx_num, device_num, pid, &device_hours,
                    sizeof(device_hours))) {
     device_hours = 0;
   }
@@ -84,9 +86,10 @@ bool rdm_register_lamp_hours(dmx_port_t dmx_num, rdm_callback_t cb,
   const rdm_pid_t pid = RDM_PID_LAMP_HOURS;
 
   // Attempt to load the value from NVS
+  const rdm_sub_device_t device_num =
+      dmx_device_get(dmx_num, RDM_SUB_DEVICE_ROOT)->num;
   uint32_t lamp_hours;
-  if (!dmx_nvs_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &lamp_hours,
-                   sizeof(lamp_hours))) {
+  if (!dmx_nvs_get(dmx_num, device_num, pid, &lamp_hours, sizeof(lamp_hours))) {
     lamp_hours = 0;
   }
 
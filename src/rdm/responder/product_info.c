@@ -93,6 +93,7 @@ bool rdm_register_device_info(dmx_port_t dmx_num, uint16_t model_id,
       .description = NULL};
   rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
+  rdm_response_cache_enable(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
@@ -241,6 +242,7 @@ bool rdm_register_software_version_label(dmx_port_t dmx_num,
       .description = NULL};
   rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
+  rdm_response_cache_enable(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
@@ -296,6 +298,7 @@ bool rdm_register_manufacturer_label(dmx_port_t dmx_num,
       .description = NULL};
   rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
+  rdm_response_cache_enable(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
@@ -352,6 +355,7 @@ bool rdm_register_device_model_description(dmx_port_t dmx_num,
       .description = NULL};
   rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
+  rdm_response_cache_enable(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
@@ -1,26 +1,185 @@
 #include "include/queue_status.h"
 
+#include <string.h>
+
+#include "dmx/hal/include/timer.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
 #include "rdm/include/driver.h"
 #include "rdm/responder/include/utils.h"
 
 /**
- * @brief The implementation for the RDM queue. The RDM queue is implemented
- * using a deque with an additional field to recall the previous PID which was
- * popped from the deque.
+ * @brief The implementation for the RDM queue and the status messages. Both are
+ * lock-free rings which may be pushed into from any task, from either core, or
+ * from an ISR. Each slot has a sequence number which tells producers and
+ * consumers whether the slot is free or full, so that the indices are claimed
+ * with a compare-and-swap instead of a critical section. The number of slots is
+ * a power of two. The sequence numbers are followed by the items of the ring.
  */
-typedef struct rdm_queue_t {
-  uint16_t head;       // The head of the deque.
-  uint16_t tail;       // The tail of the deque.
+typedef struct rdm_ring_t {
+  uint32_t head;       // The number of slots which have been claimed by producers.
+  uint32_t tail;       // The number of slots which have been claimed by consumers.
+  uint32_t mask;       // The number of slots in the ring minus one.
+  uint16_t item_size;  // The size of each item in bytes.
   rdm_pid_t previous;  // The PID that was previously popped from the RDM queue.
-  uint16_t max_size;   // The maximum size of the RDM queue.
-  rdm_pid_t data[];    // The buffer containing the RDM queue information.
-} rdm_queue_t;
+  uint32_t data[];     // The sequence number of each slot followed by the items.
+} rdm_ring_t;
+
+/** @brief The most status messages which fit in a single response.*/
+#define RDM_STATUS_MESSAGES_MAX \
+  ((RDM_PD_SIZE_MAX - 1) / sizeof(rdm_status_message_t))
+
+// The last response to RDM_PID_STATUS_MESSAGE. It is stored after the items of
+// the status message ring so that it may be sent again.
+typedef struct rdm_status_last_t {
+  uint8_t count;  // The number of status messages in the last response.
+  rdm_status_message_t messages[RDM_STATUS_MESSAGES_MAX];
+} rdm_status_last_t;
+
+static uint32_t rdm_ring_get_slots(uint32_t max_count) {
+  uint32_t slots = 1;
+  while (slots < max_count && slots < 0x8000) {
+    slots <<= 1;
+  }
+  return slots;
+}
+
+static size_t rdm_ring_get_size(uint32_t slots, size_t item_size) {
+  return sizeof(rdm_ring_t) + (slots * (sizeof(uint32_t) + item_size));
+}
+
+static void rdm_ring_init(rdm_ring_t *ring, uint32_t slots, size_t item_size) {
+  ring->head = 0;
+  ring->tail = 0;
+  ring->mask = slots - 1;
+  ring->item_size = item_size;
+  ring->previous = 0;
+  for (uint32_t i = 0; i < slots; ++i) {
+    ring->data[i] = i;
+  }
+}
+
+static DMX_ISR_ATTR uint8_t *rdm_ring_get_item(rdm_ring_t *ring,
+                                               uint32_t pos) {
+  return (uint8_t *)&ring->data[ring->mask + 1] +
+         ((pos & ring->mask) * ring->item_size);
+}
+
+static bool DMX_ISR_ATTR rdm_ring_push(rdm_ring_t *ring, const void *item) {
+  // Claim the slot at the head of the ring
+  uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  while (true) {
+    const uint32_t seq =
+        __atomic_load_n(&ring->data[pos & ring->mask], __ATOMIC_ACQUIRE);
+    const int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // The ring is full
+    } else {
+      pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+  }
+
+  // Write the item and then publish it to consumers
+  memcpy(rdm_ring_get_item(ring, pos), item, ring->item_size);
+  __atomic_store_n(&ring->data[pos & ring->mask], pos + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+static bool rdm_ring_pop(rdm_ring_t *ring, void *item) {
+  // Claim the slot at the tail of the ring
+  uint32_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  while (true) {
+    const uint32_t seq =
+        __atomic_load_n(&ring->data[pos & ring->mask], __ATOMIC_ACQUIRE);
+    const int32_t diff = (int32_t)(seq - (pos + 1));
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // The ring is empty
+    } else {
+      pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    }
+  }
+
+  // Read the item and then free the slot for producers
+  memcpy(item, rdm_ring_get_item(ring, pos), ring->item_size);
+  __atomic_store_n(&ring->data[pos & ring->mask], pos + ring->mask + 1,
+                   __ATOMIC_RELEASE);
+
+  return true;
+}
+
+static uint32_t rdm_ring_get_count(const rdm_ring_t *ring) {
+  const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  const int32_t count = (int32_t)(head - tail);
+  return count > 0 ? count : 0;
+}
+
+// Returns true if the PID is in the RDM queue. Slots which are changed while
+// they are being read are skipped, so a PID may occasionally be queued twice.
+static bool DMX_ISR_ATTR rdm_queue_contains(rdm_ring_t *ring, rdm_pid_t pid) {
+  const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t pos = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  for (; (int32_t)(head - pos) > 0; ++pos) {
+    const uint32_t *seq = &ring->data[pos & ring->mask];
+    if (__atomic_load_n(seq, __ATOMIC_ACQUIRE) != pos + 1) {
+      continue;  // The slot is not full
+    }
+    rdm_pid_t queued;
+    memcpy(&queued, rdm_ring_get_item(ring, pos), sizeof(queued));
+    if (queued == pid && __atomic_load_n(seq, __ATOMIC_ACQUIRE) == pos + 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool DMX_ISR_ATTR rdm_queue_push_pid(dmx_driver_t *driver,
+                                            rdm_pid_t pid) {
+  rdm_ring_t *const queue = driver->rdm.queue;
+  if (queue == NULL) {
+    return false;
+  }
+
+  // A response which was deferred with an ACK_TIMER is now ready
+  rdm_pid_t deferred_pid = pid;
+  __atomic_compare_exchange_n(&driver->rdm.deferred_pid, &deferred_pid, 0,
+                              false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+  // Push the new PID if it isn't already queued
+  if (rdm_queue_contains(queue, pid)) {
+    return true;
+  } else if (!rdm_ring_push(queue, &pid)) {
+    return false;
+  }
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+  // The encoded mute response has a stale message count
+  driver->disc_isr.mute[0] = 0;
+#endif
+
+  return true;
+}
+
+static bool DMX_ISR_ATTR rdm_status_push_message(
+    dmx_driver_t *driver, const rdm_status_message_t *message) {
+  rdm_ring_t *const status = driver->rdm.status;
+  return status != NULL && rdm_ring_push(status, message);
+}
 
-static rdm_queue_t *rdm_get_queue(dmx_port_t dmx_num) {
-  return dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT,
-                           RDM_PID_QUEUED_MESSAGE);
+static rdm_status_last_t *rdm_status_get_last(rdm_ring_t *status) {
+  const uint32_t slots = status->mask + 1;
+  return (rdm_status_last_t *)((uint8_t *)&status->data[slots] +
+                               (slots * status->item_size));
 }
 
 static size_t rdm_rhd_get_queued_message(
@@ -44,14 +203,29 @@ static size_t rdm_rhd_get_queued_message(
   }
 
   // Determine what the response will be depending on the RDM queue size
-  rdm_pid_t pid;
+  rdm_pid_t pid = rdm_queue_pop(dmx_num);
   rdm_header_t response_header = *header;
   const rdm_parameter_definition_t *response_definition;
-  if (rdm_queue_size(dmx_num) > 0) {
-    pid = rdm_queue_pop(dmx_num);
+  if (pid != 0) {
     response_definition = rdm_definition_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
     assert(response_definition != NULL);
   } else {
+    // Ask the controller to wait if a deferred response is not yet ready
+    dmx_driver_t *const driver = dmx_driver[dmx_num];
+    rdm_pid_t deferred_pid;
+    int64_t deferred_timestamp;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    deferred_pid = driver->rdm.deferred_pid;
+    deferred_timestamp = driver->rdm.deferred_timestamp;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+    if (deferred_pid != 0) {
+      const int64_t remaining =
+          deferred_timestamp - dmx_timer_get_micros_since_boot();
+      const TickType_t ready_ticks =
+          remaining > 0 ? dmx_ms_to_ticks(remaining / 1000) : 0;
+      return rdm_write_ack_timer(dmx_num, header, ready_ticks);
+    }
+
     pid = RDM_PID_STATUS_MESSAGE;
     response_definition = rdm_definition_get(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
     if (response_definition == NULL) {
@@ -61,34 +235,109 @@ static size_t rdm_rhd_get_queued_message(
   }
 
   response_header.pid = pid;
+  if (response_definition->get.handler == NULL) {
+    // Parameters which only support SET have no data to report
+    return rdm_write_ack(dmx_num, &response_header, NULL, NULL, 0);
+  }
   return response_definition->get.handler(dmx_num, response_definition,
                                           &response_header);
 }
 
+static size_t rdm_rhd_get_status_messages(
+    dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
+    const rdm_header_t *header) {
+  if (header->sub_device != RDM_SUB_DEVICE_ROOT) {
+    // Requests may only be made to the root device
+    return rdm_write_nack_reason(dmx_num, header,
+                                 RDM_NR_SUB_DEVICE_OUT_OF_RANGE);
+  }
+
+  // Verify status type is valid
+  uint8_t status_type;
+  if (!rdm_read_pd(dmx_num, definition->get.request.format, &status_type,
+                   sizeof(status_type))) {
+    return rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
+  }
+  if (status_type < definition->min_value ||
+      status_type > definition->max_value) {
+    return rdm_write_nack_reason(dmx_num, header, RDM_NR_DATA_OUT_OF_RANGE);
+  }
+
+  // Drain as many messages of the requested severity as fit in the response.
+  // Messages of a lower severity are discarded.
+  rdm_ring_t *const status = dmx_driver[dmx_num]->rdm.status;
+  rdm_status_last_t *const last = rdm_status_get_last(status);
+  if (status_type != RDM_STATUS_GET_LAST_MESSAGE) {
+    last->count = 0;
+    rdm_status_message_t message;
+    while (status_type != RDM_STATUS_NONE &&
+           last->count < RDM_STATUS_MESSAGES_MAX &&
+           rdm_ring_pop(status, &message)) {
+      if ((message.type & 0x0f) >= status_type) {
+        last->messages[last->count] = message;
+        ++last->count;
+      }
+    }
+  }
+
+  return rdm_write_ack(dmx_num, header, definition->get.response.format,
+                       last->messages,
+                       last->count * sizeof(rdm_status_message_t));
+}
+
+static size_t rdm_rhd_set_clear_status_id(
+    dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
+    const rdm_header_t *header) {
+  if (header->sub_device != RDM_SUB_DEVICE_ROOT &&
+      header->sub_device != RDM_SUB_DEVICE_ALL) {
+    // Sub-devices share the status messages of the root device
+    return rdm_write_nack_reason(dmx_num, header,
+                                 RDM_NR_SUB_DEVICE_OUT_OF_RANGE);
+  }
+
+  // Discard every status message
+  rdm_ring_t *const status = dmx_driver[dmx_num]->rdm.status;
+  rdm_status_message_t message;
+  while (rdm_ring_pop(status, &message)) {
+    continue;
+  }
+  rdm_status_get_last(status)->count = 0;
+
+  return rdm_write_ack(dmx_num, header, NULL, NULL, 0);
+}
+
 bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count,
                                  rdm_callback_t cb, void *context) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
   DMX_CHECK(max_count > 0, false, "max_count error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
   const rdm_pid_t pid = RDM_PID_QUEUED_MESSAGE;
 
   // Add the parameter
-  const size_t size = sizeof(rdm_queue_t) + (sizeof(rdm_pid_t) * max_count);
+  const uint32_t slots = rdm_ring_get_slots(max_count);
+  const size_t size = rdm_ring_get_size(slots, sizeof(rdm_pid_t));
   if (!dmx_parameter_add(dmx_num, RDM_SUB_DEVICE_ROOT, pid,
                          DMX_PARAMETER_TYPE_DYNAMIC, NULL, size)) {
     return false;
   }
-  rdm_queue_t *queue = rdm_get_queue(dmx_num);
-  assert(queue != NULL);
-  queue->max_size = max_count;
+  if (driver->rdm.queue == NULL) {
+    rdm_ring_t *queue =
+        dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
+    assert(queue != NULL);
+    rdm_ring_init(queue, slots, sizeof(rdm_pid_t));
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.queue = queue;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
 
   // Define the parameter
   static const rdm_parameter_definition_t definition = {
       .pid_cc = RDM_CC_GET,
       .ds = RDM_DS_NOT_DEFINED,
       .get = {.handler = rdm_rhd_get_queued_message,
-              .request.format = NULL,
+              .request.format = "b$",
               .response.format = "b$"},
       .set = {.handler = NULL, .request.format = NULL, .response.format = NULL},
       .pdl_size = sizeof(uint8_t),
@@ -102,64 +351,101 @@ bool rdm_register_queued_message(dmx_port_t dmx_num, uint32_t max_count,
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
-bool rdm_queue_push(dmx_port_t dmx_num, rdm_pid_t pid) {
+bool rdm_register_status_messages(dmx_port_t dmx_num, uint32_t max_count,
+                                  rdm_callback_t cb, void *context) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
-  DMX_CHECK(pid > 0, false, "pid error");
+  DMX_CHECK(max_count > 0, false, "max_count error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
-  rdm_queue_t *queue = rdm_get_queue(dmx_num);
-  if (queue == NULL) {
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  const rdm_pid_t pid = RDM_PID_STATUS_MESSAGE;
+
+  // Add the parameter followed by the last response which was sent
+  const uint32_t slots = rdm_ring_get_slots(max_count);
+  const size_t size = rdm_ring_get_size(slots, sizeof(rdm_status_message_t)) +
+                      sizeof(rdm_status_last_t);
+  if (!dmx_parameter_add(dmx_num, RDM_SUB_DEVICE_ROOT, pid,
+                         DMX_PARAMETER_TYPE_DYNAMIC, NULL, size) ||
+      !dmx_parameter_add(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_CLEAR_STATUS_ID,
+                         DMX_PARAMETER_TYPE_NULL, NULL, 0)) {
     return false;
   }
-
-  bool success = false;
-  bool already_queued = false;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  // Iterate the queue to ensure that the PID isn't already queued
-  for (int i = queue->tail; i != queue->head; ++i) {
-    if (i == queue->max_size) {
-      i = 0;
-    }
-    if (queue->data[i] == pid) {
-      already_queued = true;
-      success = true;
-      break;
-    }
+  if (driver->rdm.status == NULL) {
+    rdm_ring_t *status =
+        dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
+    assert(status != NULL);
+    rdm_ring_init(status, slots, sizeof(rdm_status_message_t));
+    rdm_status_get_last(status)->count = 0;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.status = status;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
 
-  // Push the new PID and increment the queue head
-  if (!already_queued && (queue->head + 1) % queue->max_size != queue->tail) {
-    queue->data[queue->head] = pid;
-    ++queue->head;
-    if (queue->head == queue->max_size) {
-      queue->head = 0;
-    }
-    success = true;
+  // Define the parameters
+  static const rdm_parameter_definition_t definition = {
+      .pid_cc = RDM_CC_GET,
+      .ds = RDM_DS_NOT_DEFINED,
+      .get = {.handler = rdm_rhd_get_status_messages,
+              .request.format = "b$",
+              .response.format = "wbwww"},
+      .set = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+      .pdl_size = sizeof(uint8_t),
+      .max_value = RDM_STATUS_ERROR,
+      .min_value = RDM_STATUS_NONE,
+      .units = RDM_UNITS_NONE,
+      .prefix = RDM_PREFIX_NONE,
+      .description = NULL};
+  rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
+  static const rdm_parameter_definition_t clear_definition = {
+      .pid_cc = RDM_CC_SET,
+      .ds = RDM_DS_NOT_DEFINED,
+      .get = {.handler = NULL, .request.format = NULL, .response.format = NULL},
+      .set = {.handler = rdm_rhd_set_clear_status_id,
+              .request.format = NULL,
+              .response.format = NULL},
+      .pdl_size = 0,
+      .max_value = 0,
+      .min_value = 0,
+      .units = RDM_UNITS_NONE,
+      .prefix = RDM_PREFIX_NONE,
+      .description = NULL};
+  rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_CLEAR_STATUS_ID,
+                     &clear_definition);
+
+  return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
+}
+
+bool rdm_queue_push(dmx_port_t dmx_num, rdm_pid_t pid) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(pid > 0, false, "pid error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  return rdm_queue_push_pid(dmx_driver[dmx_num], pid);
+}
+
+bool DMX_ISR_ATTR rdm_queue_push_from_isr(dmx_port_t dmx_num, rdm_pid_t pid) {
+  if (dmx_num >= DMX_NUM_MAX || pid == 0 || dmx_driver[dmx_num] == NULL) {
+    return false;
   }
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
-  return success;
+  return rdm_queue_push_pid(dmx_driver[dmx_num], pid);
 }
 
 rdm_pid_t rdm_queue_pop(dmx_port_t dmx_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+  rdm_ring_t *const queue = driver->rdm.queue;
   rdm_pid_t pid;
-  if (rdm_queue_size(dmx_num) > 0) {
-    rdm_queue_t *queue = rdm_get_queue(dmx_num);
-    assert(queue != NULL);
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    pid = queue->data[queue->tail];
-    ++queue->tail;
-    if (queue->tail == queue->max_size) {
-      queue->tail = 0;
-    }
-    queue->previous = pid;
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  } else {
-    pid = 0;
+  if (queue == NULL || !rdm_ring_pop(queue, &pid)) {
+    return 0;
   }
+  __atomic_store_n(&queue->previous, pid, __ATOMIC_RELAXED);
+#ifdef CONFIG_RDM_RESPONDER_DISC_IN_ISR
+  // The encoded mute response has a stale message count
+  driver->disc_isr.mute[0] = 0;
+#endif
 
   return pid;
 }
@@ -168,44 +454,56 @@ uint8_t rdm_queue_size(dmx_port_t dmx_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  rdm_queue_t *queue = rdm_get_queue(dmx_num);
+  const rdm_ring_t *const queue = dmx_driver[dmx_num]->rdm.queue;
   if (queue == NULL) {
     return 0;
   }
 
-  // Get the queue size by comparing the head and tail
-  uint16_t head;
-  uint16_t tail;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  head = queue->head;
-  tail = queue->tail;
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  int32_t size = -tail + head;
-  if (size < 0) {
-    size += queue->max_size;
-  }
-
   // Clamp the queue size to 255
-  if (size > 255) {
-    size = 255;
-  }
-
-  return size;
+  const uint32_t size = rdm_ring_get_count(queue);
+  return size > 255 ? 255 : size;
 }
 
 rdm_pid_t rdm_queue_previous(dmx_port_t dmx_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
   DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
 
-  rdm_queue_t *queue = rdm_get_queue(dmx_num);
+  const rdm_ring_t *const queue = dmx_driver[dmx_num]->rdm.queue;
   if (queue == NULL) {
     return 0;
   }
 
-  rdm_pid_t pid;
-  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-  pid = queue->previous;
-  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  return __atomic_load_n(&queue->previous, __ATOMIC_RELAXED);
+}
 
-  return pid;
-}
\ No newline at end of file
+bool rdm_status_push(dmx_port_t dmx_num, const rdm_status_message_t *message) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
+  DMX_CHECK(message != NULL, false, "message is null");
+  DMX_CHECK(message->sub_device < RDM_SUB_DEVICE_MAX, false,
+            "message->sub_device error");
+  DMX_CHECK((message->type & 0x0f) >= RDM_STATUS_ADVISORY &&
+                (message->type & 0x0f) <= RDM_STATUS_ERROR &&
+                (message->type & 0xe0) == 0,
+            false, "message->type error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
+
+  return rdm_status_push_message(dmx_driver[dmx_num], message);
+}
+
+bool DMX_ISR_ATTR rdm_status_push_from_isr(dmx_port_t dmx_num,
+                                           const rdm_status_message_t *message) {
+  if (dmx_num >= DMX_NUM_MAX || message == NULL ||
+      dmx_driver[dmx_num] == NULL) {
+    return false;
+  }
+
+  return rdm_status_push_message(dmx_driver[dmx_num], message);
+}
+
+size_t rdm_status_get_count(dmx_port_t dmx_num) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  const rdm_ring_t *const status = dmx_driver[dmx_num]->rdm.status;
+  return status != NULL ? rdm_ring_get_count(status) : 0;
+}
@@ -13,10 +13,12 @@ static size_t rdm_rhd_get_supported_parameters(
   int pid_count = 0;
   uint16_t pids[115];
 
-  // Handle situation where parameters overflowed last request
-  int i = 0;  // TODO: handle ACK overflow
+  // Skip the PIDs which were sent in previous ACK overflow pages
+  const int first = rdm_get_ack_overflow_page(dmx_num) * 115;
+  int reported = 0;  // The number of PIDs which have been found to report
+  bool is_last_page = true;
 
-  for (; i < 115; ++i) {
+  for (int i = 0;; ++i) {
     uint16_t pid = dmx_parameter_at(dmx_num, header->sub_device, i);
     if (pid == 0) {
       break;
@@ -33,13 +35,19 @@ static size_t rdm_rhd_get_supported_parameters(
       case RDM_PID_IDENTIFY_DEVICE:
         continue;  // Minimum required PIDs are not reported
     }
+    if (reported++ < first) {
+      continue;  // PID was sent in a previous page
+    } else if (pid_count == 115) {
+      is_last_page = false;  // PIDs remain to be sent in the next page
+      break;
+    }
     pids[pid_count] = pid;
     ++pid_count;
   }
 
   const size_t pdl = pid_count * sizeof(uint16_t);
-  return rdm_write_ack(dmx_num, header, definition->get.response.format, pids,
-                       pdl);
+  return rdm_write_ack_page(dmx_num, header, definition->get.response.format,
+                            pids, pdl, is_last_page);
 }
 
 static size_t rdm_rhd_get_parameter_description(
@@ -117,6 +125,7 @@ bool rdm_register_supported_parameters(dmx_port_t dmx_num, rdm_callback_t cb,
       .description = NULL};
   rdm_definition_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, &definition);
 
+  rdm_response_cache_enable(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
   return rdm_callback_set(dmx_num, RDM_SUB_DEVICE_ROOT, pid, cb, context);
 }
 
@@ -19,6 +19,28 @@ static rdm_sensors_t *rdm_get_sensors(dmx_port_t dmx_num,
   return dmx_parameter_get_data(dmx_num, sub_device, RDM_PID_SENSOR_VALUE);
 }
 
+// Gets the parameter which holds the sensors so that they can be written
+// between DMX_PARAMETER_WRITE_BEGIN() and DMX_PARAMETER_WRITE_END().
+static dmx_parameter_t *rdm_get_sensors_entry(dmx_port_t dmx_num,
+                                              rdm_sub_device_t sub_device) {
+  return dmx_parameter_get_entry(dmx_num, sub_device, RDM_PID_SENSOR_VALUE);
+}
+
+// Resets the values of one sensor, or all sensors if sensor_num is
+// RDM_SENSOR_NUM_MAX. Must be called within a critical section, between
+// DMX_PARAMETER_WRITE_BEGIN() and DMX_PARAMETER_WRITE_END().
+static void rdm_sensor_clear(rdm_sensors_t *sensors, uint8_t sensor_num) {
+  int i = sensor_num == RDM_SENSOR_NUM_MAX ? 0 : sensor_num;
+  const int end = sensor_num == RDM_SENSOR_NUM_MAX ? sensors->sensor_count
+                                                   : sensor_num + 1;
+  for (; i < end; ++i) {
+    sensors->sensor_value[i].present_value = 0;
+    sensors->sensor_value[i].lowest_value = 0;
+    sensors->sensor_value[i].highest_value = 0;
+    sensors->sensor_value[i].recorded_value = 0;
+  }
+}
+
 static size_t rdm_rhd_get_set_sensor_value(
     dmx_port_t dmx_num, const rdm_parameter_definition_t *definition,
     const rdm_header_t *header) {
@@ -36,49 +58,35 @@ static size_t rdm_rhd_get_set_sensor_value(
                    sizeof(sensor_num))) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
   }
-  if (sensor_num > rdm_sensor_get_count(dmx_num, header->sub_device) &&
+  if (sensor_num >= rdm_sensor_get_count(dmx_num, header->sub_device) &&
       sensor_num != RDM_SENSOR_NUM_MAX) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_DATA_OUT_OF_RANGE);
   }
 
-  rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, header->sub_device);
-  rdm_sensor_value_t *value;
-  assert(sensors != NULL);
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, header->sub_device);
+  assert(entry != NULL);
+  rdm_sensors_t *sensors = entry->data;
 
-  if (header->cc == RDM_CC_GET_COMMAND) {
-    // Cannot GET all sensors
-    if (sensor_num == RDM_SENSOR_NUM_MAX) {
-      return rdm_write_nack_reason(dmx_num, header,
-                                   RDM_NR_UNSUPPORTED_COMMAND_CLASS);
-    }
+  // Cannot GET all sensors
+  if (header->cc == RDM_CC_GET_COMMAND && sensor_num == RDM_SENSOR_NUM_MAX) {
+    return rdm_write_nack_reason(dmx_num, header,
+                                 RDM_NR_UNSUPPORTED_COMMAND_CLASS);
+  }
 
-    // Get the requested sensor value
-    value = &sensors->sensor_value[sensor_num];
-    assert(value != NULL);
-  } else {
-    if (sensor_num == RDM_SENSOR_NUM_MAX) {
-      // Reset all the sensors
-      for (int i = 0; i < sensors->sensor_count; ++i) {
-        sensors->sensor_value[i].present_value = 0;
-        sensors->sensor_value[i].lowest_value = 0;
-        sensors->sensor_value[i].highest_value = 0;
-        sensors->sensor_value[i].recorded_value = 0;
-      }
-      value = &sensors->sensor_value[0];
-      assert(value != NULL);
-    } else {
-      // Get the requested sensor value and reset it
-      value = &sensors->sensor_value[sensor_num];
-      assert(value != NULL);
-      value->present_value = 0;
-      value->lowest_value = 0;
-      value->highest_value = 0;
-      value->recorded_value = 0;
-    }
+  // Copy the requested sensor value, resetting it first on SET requests
+  rdm_sensor_value_t value;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (header->cc == RDM_CC_SET_COMMAND) {
+    DMX_PARAMETER_WRITE_BEGIN(entry);
+    rdm_sensor_clear(sensors, sensor_num);
+    DMX_PARAMETER_WRITE_END(entry);
   }
+  value = sensors->sensor_value[sensor_num == RDM_SENSOR_NUM_MAX ? 0
+                                                                  : sensor_num];
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
-  return rdm_write_ack(dmx_num, header, command->response.format, value,
-                       sizeof(*value));
+  return rdm_write_ack(dmx_num, header, command->response.format, &value,
+                       sizeof(value));
 }
 
 static size_t rdm_rhd_set_record_sensors(
@@ -90,7 +98,7 @@ static size_t rdm_rhd_set_record_sensors(
                    sizeof(sensor_num))) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
   }
-  if (sensor_num > rdm_sensor_get_count(dmx_num, header->sub_device) &&
+  if (sensor_num >= rdm_sensor_get_count(dmx_num, header->sub_device) &&
       sensor_num != RDM_SENSOR_NUM_MAX) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_DATA_OUT_OF_RANGE);
   }
@@ -112,7 +120,7 @@ static size_t rdm_rhd_get_sensor_definition(
                    sizeof(sensor_num))) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_FORMAT_ERROR);
   }
-  if (sensor_num > rdm_sensor_get_count(dmx_num, header->sub_device) &&
+  if (sensor_num >= rdm_sensor_get_count(dmx_num, header->sub_device) &&
       sensor_num != RDM_SENSOR_NUM_MAX) {
     return rdm_write_nack_reason(dmx_num, header, RDM_NR_DATA_OUT_OF_RANGE);
   }
@@ -152,12 +160,17 @@ bool rdm_register_sensor_definition(dmx_port_t dmx_num, rdm_callback_t cb,
 
   // Set sensor definition numbers to 0xff to flag they haven't been defined
   if (first_time_func_called) {
-    rdm_sensor_definition_t *sensor_defs =
-        dmx_parameter_get_data(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
-    assert(sensor_defs != NULL);
+    dmx_parameter_t *entry =
+        dmx_parameter_get_entry(dmx_num, RDM_SUB_DEVICE_ROOT, pid);
+    assert(entry != NULL);
+    rdm_sensor_definition_t *sensor_defs = entry->data;
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    DMX_PARAMETER_WRITE_BEGIN(entry);
     for (int i = 0; i < sensor_count; ++i) {
       sensor_defs[i].num = 0xff;
     }
+    DMX_PARAMETER_WRITE_END(entry);
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   }
 
   // Define the parameter
@@ -193,12 +206,17 @@ bool rdm_register_sensor_value(dmx_port_t dmx_num, uint8_t sensor_count,
                          DMX_PARAMETER_TYPE_DYNAMIC, NULL, size)) {
     return false;
   }
-  rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, RDM_SUB_DEVICE_ROOT);
-  assert(sensors != NULL);
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, RDM_SUB_DEVICE_ROOT);
+  assert(entry != NULL);
+  rdm_sensors_t *sensors = entry->data;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
   sensors->sensor_count = sensor_count;
   for (int i = 0; i < sensor_count; ++i) {
     sensors->sensor_value[i].sensor_num = i;
   }
+  DMX_PARAMETER_WRITE_END(entry);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   // Define the parameter
   static const rdm_parameter_definition_t definition = {
@@ -295,28 +313,83 @@ bool rdm_sensor_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
   // Validate the sensor_num
-  rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
-  if (sensors == NULL || (sensor_num > sensors->sensor_count &&
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, sub_device);
+  rdm_sensors_t *sensors = entry != NULL ? entry->data : NULL;
+  if (sensors == NULL || (sensor_num >= sensors->sensor_count &&
                           sensor_num != RDM_SENSOR_NUM_MAX)) {
     return false;
   }
 
   // Set the sensor value
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
   if (sensor_num != RDM_SENSOR_NUM_MAX) {
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
     sensors->sensor_value[sensor_num].present_value = value;
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
   } else {
     for (int i = 0; i < sensors->sensor_count; ++i) {
-      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
       sensors->sensor_value[i].present_value = value;
-      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
     }
   }
+  DMX_PARAMETER_WRITE_END(entry);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return true;
 }
 
+size_t rdm_sensor_set_values(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                             const rdm_sensor_value_t *values, size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(sub_device < RDM_SUB_DEVICE_MAX, 0, "sub_device error");
+  DMX_CHECK(values != NULL || count == 0, 0, "values is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, sub_device);
+  if (entry == NULL) {
+    return 0;
+  }
+  rdm_sensors_t *sensors = entry->data;
+
+  // Validate every sensor number before any values are written
+  for (size_t i = 0; i < count; ++i) {
+    if (values[i].sensor_num >= sensors->sensor_count) {
+      return 0;
+    }
+  }
+
+  // Write all the values at once so that readers never see a partial update
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
+  for (size_t i = 0; i < count; ++i) {
+    sensors->sensor_value[values[i].sensor_num] = values[i];
+  }
+  DMX_PARAMETER_WRITE_END(entry);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+}
+
+size_t rdm_sensor_get_values(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                             rdm_sensor_value_t *values, size_t count) {
+  DMX_CHECK(dmx_num < DMX_NUM_MAX, 0, "dmx_num error");
+  DMX_CHECK(sub_device < RDM_SUB_DEVICE_MAX, 0, "sub_device error");
+  DMX_CHECK(values != NULL || count == 0, 0, "values is null");
+  DMX_CHECK(dmx_driver_is_installed(dmx_num), 0, "driver is not installed");
+
+  const rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
+  if (sensors == NULL) {
+    return 0;
+  }
+  if (count > sensors->sensor_count) {
+    count = sensors->sensor_count;
+  }
+
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  memcpy(values, sensors->sensor_value, sizeof(*values) * count);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+
+  return count;
+}
+
 bool rdm_sensor_record(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                        uint8_t sensor_num) {
   DMX_CHECK(dmx_num < DMX_NUM_MAX, false, "dmx_num error");
@@ -325,25 +398,25 @@ bool rdm_sensor_record(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
   // Validate the sensor_num
-  rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
-  if (sensors == NULL || (sensor_num > sensors->sensor_count &&
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, sub_device);
+  rdm_sensors_t *sensors = entry != NULL ? entry->data : NULL;
+  if (sensors == NULL || (sensor_num >= sensors->sensor_count &&
                           sensor_num != RDM_SENSOR_NUM_MAX)) {
     return false;
   }
 
-  if (sensor_num == 0xff) {
-    for (int i = sensors->sensor_count; i >= 0; --i) {
-      rdm_sensor_value_t *sensor = &sensors->sensor_value[i];
-      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-      sensor->recorded_value = sensor->present_value;
-      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    }
-  } else {
-    rdm_sensor_value_t *sensor = &sensors->sensor_value[sensor_num];
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    sensor->recorded_value = sensor->present_value;
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  // Record the sensors in a single critical section for a consistent set
+  int i = sensor_num == RDM_SENSOR_NUM_MAX ? 0 : sensor_num;
+  const int end = sensor_num == RDM_SENSOR_NUM_MAX ? sensors->sensor_count
+                                                   : sensor_num + 1;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
+  for (; i < end; ++i) {
+    sensors->sensor_value[i].recorded_value =
+        sensors->sensor_value[i].present_value;
   }
+  DMX_PARAMETER_WRITE_END(entry);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return true;
 }
@@ -356,31 +429,18 @@ bool rdm_sensor_reset(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
   DMX_CHECK(dmx_driver_is_installed(dmx_num), false, "driver is not installed");
 
   // Validate the sensor_num
-  rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
-  if (sensors == NULL || (sensor_num > sensors->sensor_count &&
+  dmx_parameter_t *entry = rdm_get_sensors_entry(dmx_num, sub_device);
+  rdm_sensors_t *sensors = entry != NULL ? entry->data : NULL;
+  if (sensors == NULL || (sensor_num >= sensors->sensor_count &&
                           sensor_num != RDM_SENSOR_NUM_MAX)) {
     return false;
   }
 
-  if (sensor_num == 0xff) {
-    for (int i = sensors->sensor_count; i >= 0; --i) {
-      rdm_sensor_value_t *sensor = &sensors->sensor_value[i];
-      taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-      sensor->present_value = 0;
-      sensor->lowest_value = 0;
-      sensor->highest_value = 0;
-      sensor->recorded_value = 0;
-      taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-    }
-  } else {
-    rdm_sensor_value_t *sensor = &sensors->sensor_value[sensor_num];
-    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
-    sensor->present_value = 0;
-    sensor->lowest_value = 0;
-    sensor->highest_value = 0;
-    sensor->recorded_value = 0;
-    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
-  }
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  DMX_PARAMETER_WRITE_BEGIN(entry);
+  rdm_sensor_clear(sensors, sensor_num);
+  DMX_PARAMETER_WRITE_END(entry);
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return true;
 }
@@ -395,26 +455,31 @@ bool rdm_sensor_definition_add(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
 
   // Validate the definition sensor number
   rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
-  if (sensors == NULL || definition->num > sensors->sensor_count) {
+  if (sensors == NULL || definition->num >= sensors->sensor_count) {
     return false;
   }
 
   // Validate that sensor definitions have been registered
-  rdm_sensor_definition_t *sensor_defs = dmx_parameter_get_data(
+  dmx_parameter_t *entry = dmx_parameter_get_entry(
       dmx_num, RDM_SUB_DEVICE_ROOT, RDM_PID_SENSOR_DEFINITION);
-  if (sensor_defs == NULL) {
+  if (entry == NULL) {
     return false;
   }
+  rdm_sensor_definition_t *sensor_defs = entry->data;
 
-  // Validate that the sensor hasn't already been defined
-  if (sensor_defs[definition->num].num != 0xff) {
-    return false;
+  // Copy the definition to the parameter data if the sensor hasn't already
+  // been defined
+  bool is_defined = false;
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+  if (sensor_defs[definition->num].num == 0xff) {
+    DMX_PARAMETER_WRITE_BEGIN(entry);
+    memcpy(&sensor_defs[definition->num], definition, sizeof(*definition));
+    DMX_PARAMETER_WRITE_END(entry);
+    is_defined = true;
   }
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
-  // Copy the definition to the parameter data
-  memcpy(&sensor_defs[definition->num], definition, sizeof(*definition));
-
-  return true;
+  return is_defined;
 }
 
 const rdm_sensor_definition_t *rdm_sensor_definition_get(
@@ -426,7 +491,7 @@ const rdm_sensor_definition_t *rdm_sensor_definition_get(
 
   // Validate the definition sensor number
   rdm_sensors_t *sensors = rdm_get_sensors(dmx_num, sub_device);
-  if (sensors == NULL || sensor_num > sensors->sensor_count) {
+  if (sensors == NULL || sensor_num >= sensors->sensor_count) {
     return NULL;
   }
 
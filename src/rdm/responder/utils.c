@@ -2,6 +2,7 @@
 
 #include <string.h>
 
+#include "dmx/hal/include/timer.h"
 #include "dmx/include/driver.h"
 #include "dmx/include/service.h"
 #include "rdm/include/uid.h"
@@ -61,13 +62,113 @@ size_t rdm_write_nack_reason(dmx_port_t dmx_num, const rdm_header_t *header,
 
 size_t rdm_write_ack_timer(dmx_port_t dmx_num, const rdm_header_t *header,
                            TickType_t ready_ticks) {
-  return 0;  // TODO: implement write_ack_timer()
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(header != NULL);
+  assert(rdm_cc_is_request(header->cc));
+  assert(dmx_driver_is_installed(dmx_num));
+
+  dmx_driver_t *const driver = dmx_driver[dmx_num];
+
+  // The estimated response time is sent in 100ms units and must not be 0
+  uint32_t timer = ((uint32_t)ready_ticks * portTICK_PERIOD_MS + 99) / 100;
+  if (timer == 0) {
+    timer = 1;
+  } else if (timer > UINT16_MAX) {
+    timer = UINT16_MAX;
+  }
+  const uint16_t pd = timer;
+  const size_t pdl = sizeof(uint16_t);
+
+  // Record the deferred response unless a queued message is being deferred
+  if (header->pid != RDM_PID_QUEUED_MESSAGE) {
+    const int64_t now = dmx_timer_get_micros_since_boot();
+    taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
+    driver->rdm.deferred_pid = header->pid;
+    driver->rdm.deferred_timestamp = now + (int64_t)timer * 100000;
+    taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
+  }
+
+  // Build the response header
+  rdm_header_t response_header = {
+      .message_len = 24 + pdl,
+      .dest_uid = header->src_uid,
+      .src_uid = *rdm_uid_get(dmx_num),
+      .tn = header->tn,
+      .response_type = RDM_RESPONSE_TYPE_ACK_TIMER,
+      .message_count = rdm_queue_size(dmx_num),
+      .sub_device = header->sub_device,
+      .cc = (header->cc | 0x1),  // Set to RDM_CC_x_COMMAND_RESPONSE
+      .pid = header->pid,
+      .pdl = pdl};
+
+  return rdm_write(dmx_num, &response_header, "w", &pd);
+}
+
+size_t rdm_write_ack_page(dmx_port_t dmx_num, const rdm_header_t *header,
+                          const char *format, const void *pd, size_t pdl,
+                          bool is_last_page) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(header != NULL);
+  assert(rdm_cc_is_request(header->cc));
+  assert(rdm_format_is_valid(format));
+  assert(format != NULL || pd == NULL);
+  assert(pd != NULL || pdl == 0);
+  assert(pdl < 231);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  // Build the response header
+  rdm_header_t response_header = {
+      .message_len = 24 + pdl,
+      .dest_uid = header->src_uid,
+      .src_uid = *rdm_uid_get(dmx_num),
+      .tn = header->tn,
+      .response_type = is_last_page ? RDM_RESPONSE_TYPE_ACK
+                                    : RDM_RESPONSE_TYPE_ACK_OVERFLOW,
+      .message_count = rdm_queue_size(dmx_num),
+      .sub_device = header->sub_device,
+      .cc = (header->cc | 0x1),  // Set to RDM_CC_x_COMMAND_RESPONSE
+      .pid = header->pid,
+      .pdl = pdl};
+
+  // The next request for this PID will request the following page
+  dmx_driver[dmx_num]->dmx.last_response_was_overflow = !is_last_page;
+
+  return rdm_write(dmx_num, &response_header, format, pd);
 }
 
 size_t rdm_write_ack_overflow(dmx_port_t dmx_num, const rdm_header_t *header,
                               const char *format, const void *pd, size_t pdl,
                               int page) {
-  return 0;  // TODO: implement write_ack_overflow()
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(header != NULL);
+  assert(rdm_format_is_valid(format));
+  assert(pd != NULL || pdl == 0);
+  assert(page >= 0);
+
+  // Pages must hold a whole number of repetitions of the format string
+  bool repeats;
+  const size_t format_size = rdm_format_get_size(format, &repeats);
+  size_t page_size = 230;
+  if (repeats && format_size > 0) {
+    page_size -= page_size % format_size;
+  }
+
+  // Restart from the first page if a page beyond the last page is requested
+  const int page_count = pdl > 0 ? (pdl + page_size - 1) / page_size : 1;
+  page %= page_count;
+  const size_t offset = page * page_size;
+  const size_t page_pdl = pdl - offset < page_size ? pdl - offset : page_size;
+
+  return rdm_write_ack_page(dmx_num, header, format,
+                            page_pdl > 0 ? (const uint8_t *)pd + offset : NULL,
+                            page_pdl, page == page_count - 1);
+}
+
+int rdm_get_ack_overflow_page(dmx_port_t dmx_num) {
+  assert(dmx_num < DMX_NUM_MAX);
+  assert(dmx_driver_is_installed(dmx_num));
+
+  return dmx_driver[dmx_num]->dmx.last_request_pid_repeats;
 }
 
 bool rdm_get_boot_loader(dmx_port_t dmx_num) {
@@ -115,6 +216,11 @@ size_t rdm_simple_response_handler(dmx_port_t dmx_num,
       const void *pd =
           dmx_parameter_get_data(dmx_num, header->sub_device, header->pid);
       format = definition->get.response.format;
+      if (pdl > 230) {
+        // The parameter must be sent in multiple pages
+        const int page = rdm_get_ack_overflow_page(dmx_num);
+        return rdm_write_ack_overflow(dmx_num, header, format, pd, pdl, page);
+      }
       return rdm_write_ack(dmx_num, header, format, pd, pdl);
     } else {
       // Get the parameter from the request and write it to the RDM driver
@@ -137,9 +243,7 @@ size_t rdm_simple_response_handler(dmx_port_t dmx_num,
     uint8_t pd[231];
     format = definition->set.request.format;
     size_t size = rdm_read_pd(dmx_num, format, pd, header->pdl);
-    for (int i = RDM_SUB_DEVICE_ROOT; i < RDM_SUB_DEVICE_MAX; ++i) {
-      dmx_parameter_set(dmx_num, i, header->pid, pd, size);
-    }
+    dmx_parameter_set_all(dmx_num, header->pid, pd, size);
     return rdm_write_ack(dmx_num, header, NULL, NULL, 0);
   }
 }
@@ -175,7 +279,10 @@ bool rdm_definition_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
     return false;
   }
 
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
   entry->definition = definition;
+  ++dmx_driver[dmx_num]->device.generation;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return true;
 }
@@ -192,6 +299,20 @@ const rdm_parameter_definition_t *rdm_definition_get(
   return entry->definition;
 }
 
+bool rdm_response_cache_enable(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
+                               rdm_pid_t pid) {
+  assert(pid > 0);
+
+  dmx_parameter_t *entry = dmx_parameter_get_entry(dmx_num, sub_device, pid);
+  if (entry == NULL) {
+    return false;
+  }
+
+  entry->cache_response = true;
+
+  return true;
+}
+
 bool rdm_callback_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
                       rdm_pid_t pid, rdm_callback_t callback, void *context) {
   assert(pid > 0);
@@ -201,8 +322,11 @@ bool rdm_callback_set(dmx_port_t dmx_num, rdm_sub_device_t sub_device,
     return false;
   }
 
+  // The callback and its context are read together by rdm_send_response()
+  taskENTER_CRITICAL(DMX_SPINLOCK(dmx_num));
   entry->callback = callback;
   entry->context = context;
+  taskEXIT_CRITICAL(DMX_SPINLOCK(dmx_num));
 
   return true;
 }